@@ -36,7 +36,7 @@ CNode*	CChunkPropertyNodeTransformation::Simplify( CObjectPropertyNode* inPropNo
 		{
 			std::string	propName;
 			inPropNode->GetSymbolName( propName );
-			CGetChunkPropertyNode	*	chunkRefExpr = new CGetChunkPropertyNode( inPropNode->GetParseTree(), propName, constChunkExpr->GetLineNum() );
+			CGetChunkPropertyNode	*	chunkRefExpr = inPropNode->GetParseTree()->NewNode<CGetChunkPropertyNode>( propName, constChunkExpr->GetLineNum() );
 			for( size_t x = 0; x < constChunkExpr->GetParamCount(); x++ )
 			{
 				CValueNode	*	theParam = constChunkExpr->GetParamAtIndex(x);
@@ -54,16 +54,12 @@ CNode*	CChunkPropertyNodeTransformation::Simplify( CObjectPropertyNode* inPropNo
 			for( size_t x = 0; x < keyPath2->GetItemCount(); x++ )
 			{
 				keyPath->AddItem( keyPath2->GetItem( x ) );
-				keyPath2->SetItemAtIndex( NULL, x );	// Make sure it gives up ownership.
 			}
-			delete keyPath2;
 			
 			CValueNode * actualTarget = objectPropNode->GetParamAtIndex(0);
-			objectPropNode->SetParamAtIndex( 0, NULL );	// Make objectPropNode give up ownership of actualTarget.
 			inPropNode->SetParamAtIndex( 0, actualTarget );	// Replace objectPropNode in our target slot with actualTarget.
 			inPropNode->SetPropertyNameValue( keyPath );
-			
-			delete objectPropNode;	// Free no longer needed objectPropNode.
+			inPropNode->GetParseTree()->NodeWasChanged( inPropNode );
 		}
 	}
 	
@@ -88,7 +84,7 @@ CNode*	CChunkPropertyPutNodeTransformation::Simplify( CPutCommandNode* inPutNode
 			if( !chunkTypeVal )
 				return inPutNode;
 
-			COperatorNode	*	setChunkPropNode = new COperatorNode( inPutNode->GetParseTree(), SET_CHUNK_PROPERTY_INSTR, inPutNode->GetLineNum() );
+			COperatorNode	*	setChunkPropNode = inPutNode->GetParseTree()->NewNode<COperatorNode>( SET_CHUNK_PROPERTY_INSTR, inPutNode->GetLineNum() );
 			setChunkPropNode->SetInstructionParams( BACK_OF_STACK, chunkTypeVal->GetAsInt() );
 			
 			for( size_t x = 0; x < chunkExpr->GetParamCount(); x++ )
@@ -105,7 +101,7 @@ CNode*	CChunkPropertyPutNodeTransformation::Simplify( CPutCommandNode* inPutNode
 			
 			std::string		propName;
 			chunkExpr->GetSymbolName( propName );
-			setChunkPropNode->AddParam( new CStringValueNode( inPutNode->GetParseTree(), propName, inPutNode->GetLineNum() ) );
+			setChunkPropNode->AddParam( inPutNode->GetParseTree()->NewNode<CStringValueNode>( propName, inPutNode->GetLineNum() ) );
 			
 			return setChunkPropNode;
 		}
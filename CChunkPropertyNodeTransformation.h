@@ -20,7 +20,7 @@ class CChunkPropertyNodeTransformation : public CNodeTransformation<CObjectPrope
 public:
 	virtual CNode*	Simplify( CObjectPropertyNode* inPropNode );
 
-	static void		Initialize()	{ sNodeTransformations.push_back( new CChunkPropertyNodeTransformation ); };
+	static void		Initialize()	{ Register( new CChunkPropertyNodeTransformation ); };
 };
 
 class CChunkPropertyPutNodeTransformation : public CNodeTransformation<CPutCommandNode>
@@ -28,7 +28,7 @@ class CChunkPropertyPutNodeTransformation : public CNodeTransformation<CPutComma
 public:
 	virtual CNode*	Simplify( CPutCommandNode* inPropNode );
 
-	static void		Initialize()	{ sNodeTransformations.push_back( new CChunkPropertyPutNodeTransformation ); };
+	static void		Initialize()	{ Register( new CChunkPropertyPutNodeTransformation ); };
 };
 
 } // namespace Carlson
\ No newline at end of file
@@ -22,21 +22,136 @@ extern "C"
 namespace Carlson
 {
 
+#pragma mark CHandlerBuilder
+
+uint32_t	CHandlerBuilder::AddString( const std::string& inString )
+{
+	std::map<std::string,uint32_t>::iterator	foundString = mStringIndexes.find( inString );
+	if( foundString != mStringIndexes.end() )
+		return foundString->second;
+	
+	uint32_t	stringIndex = (uint32_t) mStrings.size();
+	mStrings.push_back( inString );
+	mStringIndexes[inString] = stringIndex;
+	return stringIndex;
+}
+
+
+uint32_t	CHandlerBuilder::AddHandlerName( const std::string& inHandlerName )
+{
+	std::map<std::string,uint32_t>::iterator	foundName = mHandlerNameIndexes.find( inHandlerName );
+	if( foundName != mHandlerNameIndexes.end() )
+		return foundName->second;
+	
+	uint32_t	nameIndex = (uint32_t) mHandlerNames.size();
+	mHandlerNames.push_back( inHandlerName );
+	mHandlerNameIndexes[inHandlerName] = nameIndex;
+	return nameIndex;
+}
+
+
+#pragma mark - CCodeBlock
+
 CCodeBlock::CCodeBlock( LEOContextGroup * inGroup, LEOScript* inScript, uint16_t inFileID )
-	: mGroup(NULL), mCurrentHandler(NULL), mScript(NULL), mFileID(inFileID)
+	: mGroup(NULL), mCurrentHandler(NULL), mScript(NULL), mBuilder(NULL), mNumLocals(0), mFileID(inFileID)
 {
 	mScript = LEOScriptRetain( inScript );
 	mGroup = LEOContextGroupRetain( inGroup );
 }
 
 
+CCodeBlock::CCodeBlock( CHandlerBuilder* inBuilder, uint16_t inFileID )
+	: mGroup(NULL), mCurrentHandler(NULL), mScript(NULL), mBuilder(inBuilder), mNumLocals(0), mFileID(inFileID)
+{
+	
+}
+
+
 CCodeBlock::~CCodeBlock()
 {
-	LEOScriptRelease( mScript );
+	if( mScript )
+		LEOScriptRelease( mScript );
 	mCurrentHandler = NULL;
 	mScript = NULL;
-	LEOContextGroupRelease( mGroup );
+	if( mGroup )
+		LEOContextGroupRelease( mGroup );
 	mGroup = NULL;
+	mBuilder = NULL;
+}
+
+
+void	CCodeBlock::AddInstruction( LEOInstructionID inInstructionID, uint16_t inParam1, uint32_t inParam2 )
+{
+	if( mBuilder )
+	{
+		LEOInstruction	newInstruction = { inInstructionID, inParam1, inParam2 };
+		mBuilder->mInstructions.push_back( newInstruction );
+	}
+	else
+		LEOHandlerAddInstruction( mCurrentHandler, inInstructionID, inParam1, inParam2 );
+}
+
+
+uint32_t	CCodeBlock::AddString( const std::string& inString )
+{
+	if( mBuilder )
+		return mBuilder->AddString( inString );
+	
+	std::map<std::string,uint32_t>::iterator	foundString = mStringIndexes.find( inString );
+	if( foundString != mStringIndexes.end() )
+		return foundString->second;
+	
+	size_t	stringIndex = LEOScriptAddString( mScript, inString.c_str() );
+	assert( stringIndex <= UINT32_MAX );
+	mStringIndexes[inString] = (uint32_t) stringIndex;
+	return (uint32_t) stringIndex;
+}
+
+
+void	CCodeBlock::AddHandlerFromBuilder( const CHandlerBuilder& inBuilder )
+{
+	LEOHandlerID handlerID = LEOContextGroupHandlerIDForHandlerName( mGroup, inBuilder.mName.c_str() );
+	if( inBuilder.mIsCommand )
+		mCurrentHandler = LEOScriptAddCommandHandlerWithID( mScript, handlerID );
+	else
+		mCurrentHandler = LEOScriptAddFunctionHandlerWithID( mScript, handlerID );
+	
+	// Add everything the builder only recorded, in the order a serial build would have, and remember where it ended up:
+	std::vector<uint32_t>	stringIndexes;
+	for( const std::string& currString : inBuilder.mStrings )
+		stringIndexes.push_back( AddString( currString ) );
+	std::vector<LEOHandlerID>	handlerIDs;
+	for( const std::string& currName : inBuilder.mHandlerNames )
+		handlerIDs.push_back( LEOContextGroupHandlerIDForHandlerName( mGroup, currName.c_str() ) );
+	std::vector<uint32_t>	errorIndexes;
+	for( const CHandlerBuilder::CSyntaxError& currError : inBuilder.mSyntaxErrors )
+	{
+		uint16_t	fileID = LEOFileIDForFileName( currError.mFileName.c_str() );
+		size_t		errorIndex = LEOScriptAddSyntaxError( mScript, currError.mErrorMessage.c_str(), fileID, currError.mLineNum, currError.mOffset );
+		assert( errorIndex <= UINT32_MAX );
+		errorIndexes.push_back( (uint32_t) errorIndex );
+	}
+	
+	std::vector<LEOInstruction>		instructions( inBuilder.mInstructions );
+	for( const std::pair<size_t,std::string>& currMarker : inBuilder.mLineMarkerFileNames )
+		instructions[currMarker.first].param1 = LEOFileIDForFileName( currMarker.second.c_str() );
+	
+	// Now rebase all table indexes and add the instructions:
+	for( LEOInstruction& currInstruction : instructions )
+	{
+		if( currInstruction.instructionID == PUSH_STR_FROM_TABLE_INSTR || currInstruction.instructionID == PUSH_STR_VARIANT_FROM_TABLE_INSTR )
+			currInstruction.param2 = stringIndexes[currInstruction.param2];
+		else if( currInstruction.instructionID == CALL_HANDLER_INSTR )
+			currInstruction.param2 = handlerIDs[currInstruction.param2];
+		else if( currInstruction.instructionID == PARSE_ERROR_INSTR )
+			currInstruction.param2 = errorIndexes[currInstruction.param2];
+		LEOHandlerAddInstruction( mCurrentHandler, currInstruction.instructionID, currInstruction.param1, currInstruction.param2 );
+	}
+	
+	for( const CHandlerBuilder::CVariableNameMapping& currMapping : inBuilder.mVariableNameMappings )
+		LEOHandlerAddVariableNameMapping( mCurrentHandler, currMapping.mName.c_str(), currMapping.mRealName.c_str(), currMapping.mBPRelativeOffset );
+	
+	mCurrentHandler = NULL;
 }
 
 
@@ -49,11 +164,19 @@ static bool CompareBPOffsets( const std::pair<std::string,CVariableEntry> &a, co
 void	CCodeBlock::GenerateFunctionPrologForName( bool isCommand, const std::string& inName, const std::map<std::string,CVariableEntry>& inLocals, size_t lineNumber )
 {
 	// Create the handler:
-	LEOHandlerID handlerID = LEOContextGroupHandlerIDForHandlerName( mGroup, inName.c_str() );
-	if( isCommand )
-		mCurrentHandler = LEOScriptAddCommandHandlerWithID( mScript, handlerID );
+	if( mBuilder )
+	{
+		mBuilder->mIsCommand = isCommand;
+		mBuilder->mName = inName;
+	}
 	else
-		mCurrentHandler = LEOScriptAddFunctionHandlerWithID( mScript, handlerID );
+	{
+		LEOHandlerID handlerID = LEOContextGroupHandlerIDForHandlerName( mGroup, inName.c_str() );
+		if( isCommand )
+			mCurrentHandler = LEOScriptAddCommandHandlerWithID( mScript, handlerID );
+		else
+			mCurrentHandler = LEOScriptAddFunctionHandlerWithID( mScript, handlerID );
+	}
 	
 	// Sort all variables in their BP-relative order so we can just push values
 	//	to allocate space and initial values in order:
@@ -65,8 +188,8 @@ void	CCodeBlock::GenerateFunctionPrologForName( bool isCommand, const std::strin
 	std::sort( locals.begin(), locals.end(), CompareBPOffsets );
 	
 	// Actually generate the code now that we have the proper order:
-	LEOHandlerAddInstruction( mCurrentHandler, LINE_MARKER_INSTR, mFileID, (uint32_t)lineNumber );
-	size_t	emptyStringIndex = LEOScriptAddString( mScript, "" );
+	AddInstruction( LINE_MARKER_INSTR, mFileID, (uint32_t)lineNumber );
+	uint32_t	emptyStringIndex = AddString( "" );
 	mNumLocals = 0;
 	std::vector< std::pair<std::string,CVariableEntry> >::const_iterator		itty;
 	
@@ -77,16 +200,22 @@ void	CCodeBlock::GenerateFunctionPrologForName( bool isCommand, const std::strin
 			//printf( "%s: %s BP offset %ld\n", inName.c_str(), itty->second.mRealName.c_str(), itty->second.mBPRelativeOffset );
 			if( itty->second.mIsGlobal )
 			{
-				size_t	stringIndex = LEOScriptAddString( mScript, itty->second.mRealName.c_str() );
-				LEOHandlerAddInstruction( mCurrentHandler, PUSH_STR_VARIANT_FROM_TABLE_INSTR, 0, (uint32_t)stringIndex );
-				LEOHandlerAddInstruction( mCurrentHandler, PUSH_GLOBAL_REFERENCE_INSTR, 0, 0 );
+				uint32_t	stringIndex = AddString( itty->second.mRealName );
+				AddInstruction( PUSH_STR_VARIANT_FROM_TABLE_INSTR, 0, stringIndex );
+				AddInstruction( PUSH_GLOBAL_REFERENCE_INSTR, 0, 0 );
 			}
 			else
 			{
-				size_t	stringIndex = itty->second.mInitWithName ? LEOScriptAddString( mScript, itty->second.mRealName.c_str() ) : emptyStringIndex;
-				LEOHandlerAddInstruction( mCurrentHandler, PUSH_STR_VARIANT_FROM_TABLE_INSTR, 0, (uint32_t)stringIndex );
+				uint32_t	stringIndex = itty->second.mInitWithName ? AddString( itty->second.mRealName ) : emptyStringIndex;
+				AddInstruction( PUSH_STR_VARIANT_FROM_TABLE_INSTR, 0, stringIndex );
+			}
+			if( mBuilder )
+			{
+				CHandlerBuilder::CVariableNameMapping	mapping = { itty->first, itty->second.mRealName, (size_t)itty->second.mBPRelativeOffset };
+				mBuilder->mVariableNameMappings.push_back( mapping );
 			}
-			LEOHandlerAddVariableNameMapping( mCurrentHandler, itty->first.c_str(), itty->second.mRealName.c_str(), itty->second.mBPRelativeOffset );
+			else
+				LEOHandlerAddVariableNameMapping( mCurrentHandler, itty->first.c_str(), itty->second.mRealName.c_str(), itty->second.mBPRelativeOffset );
 			mNumLocals++;
 		}
 		else
@@ -97,11 +226,11 @@ void	CCodeBlock::GenerateFunctionPrologForName( bool isCommand, const std::strin
 
 void	CCodeBlock::PrepareToExitFunction( size_t lineNumber )
 {
-	LEOHandlerAddInstruction( mCurrentHandler, LINE_MARKER_INSTR, mFileID, (uint32_t)lineNumber );
+	AddInstruction( LINE_MARKER_INSTR, mFileID, (uint32_t)lineNumber );
 	// Get rid of stack space allocated for our local variables:
 	std::map<std::string,CVariableEntry>::const_iterator		itty;
 	for( size_t	x = 0; x < mNumLocals; x++ )
-		LEOHandlerAddInstruction( mCurrentHandler, POP_VALUE_INSTR, BACK_OF_STACK, 0 );
+		AddInstruction( POP_VALUE_INSTR, BACK_OF_STACK, 0 );
 }
 
 
@@ -112,7 +241,7 @@ void	CCodeBlock::GenerateFunctionEpilogForName( bool isCommand, const std::strin
 	// Make sure we return an empty result, even if there's no return statement at the end of the handler:
 	GeneratePushUnsetValueInstruction();
 	GenerateSetReturnValueInstruction();
-	LEOHandlerAddInstruction( mCurrentHandler, RETURN_FROM_HANDLER_INSTR, BACK_OF_STACK, 0 );	// Make sure we return from this handler even if there's no explicit return statement.
+	AddInstruction( RETURN_FROM_HANDLER_INSTR, BACK_OF_STACK, 0 );	// Make sure we return from this handler even if there's no explicit return statement.
 	
 	mCurrentHandler = NULL;	// Be paranoid. Don't want to accidentally add stuff to a finished handler.
 	mNumLocals = 0;
@@ -121,24 +250,34 @@ void	CCodeBlock::GenerateFunctionEpilogForName( bool isCommand, const std::strin
 
 void	CCodeBlock::GenerateFunctionCallInstruction( bool isCommand, bool isMessagePassing, const std::string& inName )
 {
-	LEOHandlerID handlerID = LEOContextGroupHandlerIDForHandlerName( mGroup, inName.c_str() );
-	LEOHandlerAddInstruction( mCurrentHandler, CALL_HANDLER_INSTR, (isCommand ? kLEOCallHandler_IsCommandFlag : kLEOCallHandler_IsFunctionFlag) | (isMessagePassing ? kLEOCallHandler_PassMessage : 0), handlerID );
+	LEOHandlerID handlerID = mBuilder ? mBuilder->AddHandlerName( inName ) : LEOContextGroupHandlerIDForHandlerName( mGroup, inName.c_str() );
+	AddInstruction( CALL_HANDLER_INSTR, (isCommand ? kLEOCallHandler_IsCommandFlag : kLEOCallHandler_IsFunctionFlag) | (isMessagePassing ? kLEOCallHandler_PassMessage : 0), handlerID );
 }
 
 
 void	CCodeBlock::GenerateParseErrorInstruction( std::string errMsg, std::string inFileName, size_t inLine, size_t inOffset )
 {
-	uint16_t	fileID = LEOFileIDForFileName( inFileName.c_str() );
-	size_t		errorIndex = LEOScriptAddSyntaxError( mScript, errMsg.c_str(), fileID, inLine, inOffset );
+	size_t		errorIndex = 0;
+	if( mBuilder )
+	{
+		CHandlerBuilder::CSyntaxError	syntaxError = { errMsg, inFileName, inLine, inOffset };
+		errorIndex = mBuilder->mSyntaxErrors.size();
+		mBuilder->mSyntaxErrors.push_back( syntaxError );
+	}
+	else
+	{
+		uint16_t	fileID = LEOFileIDForFileName( inFileName.c_str() );
+		errorIndex = LEOScriptAddSyntaxError( mScript, errMsg.c_str(), fileID, inLine, inOffset );
+	}
 	assert( errorIndex <= UINT32_MAX );
-	LEOHandlerAddInstruction( mCurrentHandler, PARSE_ERROR_INSTR, 0, (*(uint32_t*)&errorIndex) );
+	AddInstruction( PARSE_ERROR_INSTR, 0, (*(uint32_t*)&errorIndex) );
 }
 
 
 void	CCodeBlock::GeneratePushIntInstruction( int inNumber, LEOUnit inUnit )
 {
 	assert( sizeof(inNumber) <= sizeof(uint32_t) );
-	LEOHandlerAddInstruction( mCurrentHandler, PUSH_INTEGER_INSTR, inUnit, (*(uint32_t*)&inNumber) );
+	AddInstruction( PUSH_INTEGER_INSTR, inUnit, (*(uint32_t*)&inNumber) );
 }
 
 
@@ -149,13 +288,13 @@ void	CCodeBlock::GeneratePushInt64Instruction( int64_t inNumber, LEOUnit inUnit
 		uint64_t	theNum = (uint64_t)inNumber;
 		uint32_t	firstHalf = (theNum & 0xffffffff00000000) >> 32;
 		uint32_t	secondHalf = theNum & 0x00000000ffffffff;
-		LEOHandlerAddInstruction( mCurrentHandler, PUSH_INTEGER_START_INSTR, inUnit, firstHalf );
-		LEOHandlerAddInstruction( mCurrentHandler, ASSIGN_INTEGER_END_INSTR, inUnit, secondHalf );
+		AddInstruction( PUSH_INTEGER_START_INSTR, inUnit, firstHalf );
+		AddInstruction( ASSIGN_INTEGER_END_INSTR, inUnit, secondHalf );
 	}
 	else
 	{
 		int32_t		theShortInt = (int32_t)inNumber;
-		LEOHandlerAddInstruction( mCurrentHandler, PUSH_INTEGER_INSTR, inUnit, (uint32_t)theShortInt );
+		AddInstruction( PUSH_INTEGER_INSTR, inUnit, (uint32_t)theShortInt );
 	}
 }
 
@@ -163,209 +302,224 @@ void	CCodeBlock::GeneratePushInt64Instruction( int64_t inNumber, LEOUnit inUnit
 void	CCodeBlock::GeneratePushFloatInstruction( float inNumber, LEOUnit inUnit )
 {
 	assert( sizeof(inNumber) <= sizeof(uint32_t) );
-	LEOHandlerAddInstruction( mCurrentHandler, PUSH_NUMBER_INSTR, inUnit, (*(uint32_t*)&inNumber) );
+	AddInstruction( PUSH_NUMBER_INSTR, inUnit, (*(uint32_t*)&inNumber) );
 }
 
 
 void	CCodeBlock::GeneratePushBoolInstruction( bool inBoolean )
 {
-	LEOHandlerAddInstruction( mCurrentHandler, PUSH_BOOLEAN_INSTR, 0, inBoolean );
+	AddInstruction( PUSH_BOOLEAN_INSTR, 0, inBoolean );
 }
 
 
 void	CCodeBlock::GeneratePushStringInstruction( const std::string& inString )
 {
-	size_t	stringIndex = LEOScriptAddString( mScript, inString.c_str() );
-	assert( stringIndex <= UINT32_MAX );
-	LEOHandlerAddInstruction( mCurrentHandler, PUSH_STR_FROM_TABLE_INSTR, 0, (uint32_t)stringIndex );
+	uint32_t	stringIndex = AddString( inString );
+	AddInstruction( PUSH_STR_FROM_TABLE_INSTR, 0, stringIndex );
 }
 
 
 void	CCodeBlock::GeneratePushUnsetValueInstruction()
 {
-	LEOHandlerAddInstruction( mCurrentHandler, PUSH_UNSET_VALUE_INSTR, 0, 0 );
+	AddInstruction( PUSH_UNSET_VALUE_INSTR, 0, 0 );
 }
 
 
 void	CCodeBlock::GeneratePushVariableInstruction( int16_t bpRelativeOffset )
 {
-	LEOHandlerAddInstruction( mCurrentHandler, PUSH_REFERENCE_INSTR, (*(uint16_t*)&bpRelativeOffset), 0 );
+	AddInstruction( PUSH_REFERENCE_INSTR, (*(uint16_t*)&bpRelativeOffset), 0 );
 }
 
 
 void	CCodeBlock::GeneratePopSimpleValueIntoVariableInstruction( int16_t bpRelativeOffset )
 {
-	LEOHandlerAddInstruction( mCurrentHandler, POP_SIMPLE_VALUE_INSTR, (*(uint16_t*)&bpRelativeOffset), 0 );
+	AddInstruction( POP_SIMPLE_VALUE_INSTR, (*(uint16_t*)&bpRelativeOffset), 0 );
 }
 
 
 void	CCodeBlock::GeneratePopIntoVariableInstruction( int16_t bpRelativeOffset )
 {
-	LEOHandlerAddInstruction( mCurrentHandler, POP_VALUE_INSTR, (*(uint16_t*)&bpRelativeOffset), 0 );
+	AddInstruction( POP_VALUE_INSTR, (*(uint16_t*)&bpRelativeOffset), 0 );
 }
 
 
 void	CCodeBlock::GeneratePopValueInstruction()
 {
-	LEOHandlerAddInstruction( mCurrentHandler, POP_VALUE_INSTR, BACK_OF_STACK, 0 );
+	AddInstruction( POP_VALUE_INSTR, BACK_OF_STACK, 0 );
 }
 
 
 void	CCodeBlock::GenerateAssignParamValueToVariableInstruction( int16_t bpRelativeOffset, uint32_t paramNum )
 {
-	LEOHandlerAddInstruction( mCurrentHandler, PARAMETER_INSTR, (*(uint16_t*)&bpRelativeOffset), paramNum +1 );
+	AddInstruction( PARAMETER_INSTR, (*(uint16_t*)&bpRelativeOffset), paramNum +1 );
 }
 
 
 void	CCodeBlock::GenerateAssignParamToVariableInstruction( int16_t bpRelativeOffset, uint32_t paramNum )
 {
-	LEOHandlerAddInstruction( mCurrentHandler, PARAMETER_KEEPREFS_INSTR, (*(uint16_t*)&bpRelativeOffset), paramNum +1 );
+	AddInstruction( PARAMETER_KEEPREFS_INSTR, (*(uint16_t*)&bpRelativeOffset), paramNum +1 );
 }
 
 
 void	CCodeBlock::GenerateReturnInstruction()
 {
-	LEOHandlerAddInstruction( mCurrentHandler, RETURN_FROM_HANDLER_INSTR, 0, 0 );
+	AddInstruction( RETURN_FROM_HANDLER_INSTR, 0, 0 );
 }
 
 
 void	CCodeBlock::GenerateSetReturnValueInstruction()
 {
-	LEOHandlerAddInstruction( mCurrentHandler, SET_RETURN_VALUE_INSTR, 0, 0 );
+	AddInstruction( SET_RETURN_VALUE_INSTR, 0, 0 );
 }
 
 
 void	CCodeBlock::GenerateOperatorInstruction( LEOInstructionID inInstructionID, uint16_t inParam1, uint32_t inParam2 )
 {
-	LEOHandlerAddInstruction( mCurrentHandler, inInstructionID, inParam1, inParam2 );
+	AddInstruction( inInstructionID, inParam1, inParam2 );
 }
 
 
 size_t	CCodeBlock::GetNextInstructionOffset() const
 {
+	if( mBuilder )
+		return mBuilder->mInstructions.size();
 	return mCurrentHandler->numInstructions;
 }
 
 
 void	CCodeBlock::GenerateJumpRelativeInstruction( int32_t numInstructions )
 {
-	LEOHandlerAddInstruction( mCurrentHandler, JUMP_RELATIVE_INSTR, BACK_OF_STACK,
+	AddInstruction( JUMP_RELATIVE_INSTR, BACK_OF_STACK,
 								(*(uint32_t*)&numInstructions) );
 }
 
 
 void	CCodeBlock::GenerateJumpRelativeIfFalseInstruction( int32_t numInstructions )
 {
-	LEOHandlerAddInstruction( mCurrentHandler, JUMP_RELATIVE_IF_FALSE_INSTR, BACK_OF_STACK,
+	AddInstruction( JUMP_RELATIVE_IF_FALSE_INSTR, BACK_OF_STACK,
 								(*(uint32_t*)&numInstructions) );
 }
 
 
 void	CCodeBlock::SetJumpAddressOfInstructionAtIndex( size_t idx, int32_t offs )
 {
-	assert( mCurrentHandler->instructions[idx].instructionID == JUMP_RELATIVE_INSTR
-			|| mCurrentHandler->instructions[idx].instructionID == JUMP_RELATIVE_IF_FALSE_INSTR );
+	LEOInstruction*	instructions = mBuilder ? mBuilder->mInstructions.data() : mCurrentHandler->instructions;
+	assert( instructions[idx].instructionID == JUMP_RELATIVE_INSTR
+			|| instructions[idx].instructionID == JUMP_RELATIVE_IF_FALSE_INSTR );
 	
-	mCurrentHandler->instructions[idx].param2 = (*(uint32_t*)&offs);
+	instructions[idx].param2 = (*(uint32_t*)&offs);
 }
 
 
 void	CCodeBlock::GenerateAddNumberInstruction( int16_t bpRelativeOffset, LEONumber inNumber )
 {
-	LEOHandlerAddInstruction( mCurrentHandler, ADD_NUMBER_INSTR, (*(uint16_t*)&bpRelativeOffset), (*(uint32_t*)&inNumber) );
+	AddInstruction( ADD_NUMBER_INSTR, (*(uint16_t*)&bpRelativeOffset), (*(uint32_t*)&inNumber) );
 }
 
 
 void	CCodeBlock::GenerateAddIntegerInstruction( int16_t bpRelativeOffset, LEOInteger inNumber )
 {
-	LEOHandlerAddInstruction( mCurrentHandler, ADD_INTEGER_INSTR, (*(uint16_t*)&bpRelativeOffset), (*(uint32_t*)&inNumber) );
+	AddInstruction( ADD_INTEGER_INSTR, (*(uint16_t*)&bpRelativeOffset), (*(uint32_t*)&inNumber) );
 }
 
 
 void	CCodeBlock::GenerateLineMarkerInstruction( uint32_t inLineNum, uint16_t inFileID )
 {
-	LEOHandlerAddInstruction( mCurrentHandler, LINE_MARKER_INSTR, (inFileID != 65535) ? inFileID : mFileID, inLineNum );
+	AddInstruction( LINE_MARKER_INSTR, (inFileID != 65535) ? inFileID : mFileID, inLineNum );
+}
+
+
+void	CCodeBlock::GenerateLineMarkerInstruction( uint32_t inLineNum, const std::string& inFileName )
+{
+	if( mBuilder )	// Can't look up the file ID on this thread, do that when the handler gets added.
+	{
+		mBuilder->mLineMarkerFileNames.push_back( std::make_pair( mBuilder->mInstructions.size(), inFileName ) );
+		AddInstruction( LINE_MARKER_INSTR, mFileID, inLineNum );
+	}
+	else
+		GenerateLineMarkerInstruction( inLineNum, LEOFileIDForFileName( inFileName.c_str() ) );
 }
 
 
 void	CCodeBlock::GenerateAssignChunkArrayInstruction( int16_t bpRelativeOffset, uint32_t inChunkType )
 {
-	LEOHandlerAddInstruction( mCurrentHandler, ASSIGN_CHUNK_ARRAY_INSTR, bpRelativeOffset, inChunkType );
+	AddInstruction( ASSIGN_CHUNK_ARRAY_INSTR, bpRelativeOffset, inChunkType );
 }
 
 
 void	CCodeBlock::GeneratePushChunkRefInstruction( int16_t bpRelativeOffset, uint32_t inChunkType )
 {
-	LEOHandlerAddInstruction( mCurrentHandler, PUSH_CHUNK_REFERENCE_INSTR, bpRelativeOffset, inChunkType );
+	AddInstruction( PUSH_CHUNK_REFERENCE_INSTR, bpRelativeOffset, inChunkType );
 }
 
 
 void	CCodeBlock::GeneratePushChunkConstInstruction( int16_t bpRelativeOffset, uint32_t inChunkType )
 {
-	LEOHandlerAddInstruction( mCurrentHandler, PUSH_CHUNK_INSTR, bpRelativeOffset, inChunkType );
+	AddInstruction( PUSH_CHUNK_INSTR, bpRelativeOffset, inChunkType );
 }
 
 
 void	CCodeBlock::GenerateSetChunkPropertyInstruction( int16_t bpRelativeOffset, uint32_t inChunkType )
 {
-	LEOHandlerAddInstruction( mCurrentHandler, SET_CHUNK_PROPERTY_INSTR, bpRelativeOffset, inChunkType );
+	AddInstruction( SET_CHUNK_PROPERTY_INSTR, bpRelativeOffset, inChunkType );
 }
 
 
 void	CCodeBlock::GeneratePushChunkPropertyInstruction( int16_t bpRelativeOffset, uint32_t inChunkType )
 {
-	LEOHandlerAddInstruction( mCurrentHandler, PUSH_CHUNK_PROPERTY_INSTR, bpRelativeOffset, inChunkType );
+	AddInstruction( PUSH_CHUNK_PROPERTY_INSTR, bpRelativeOffset, inChunkType );
 }
 
 
 void	CCodeBlock::GenerateGetArrayItemCountInstruction( int16_t bpRelativeOffset )
 {
-	LEOHandlerAddInstruction( mCurrentHandler, GET_ARRAY_ITEM_COUNT_INSTR, bpRelativeOffset, 0 );
+	AddInstruction( GET_ARRAY_ITEM_COUNT_INSTR, bpRelativeOffset, 0 );
 }
 
 
 void	CCodeBlock::GenerateGetArrayItemInstruction( int16_t bpRelativeOffset )
 {
-	LEOHandlerAddInstruction( mCurrentHandler, GET_ARRAY_ITEM_INSTR, bpRelativeOffset, 0 );
+	AddInstruction( GET_ARRAY_ITEM_INSTR, bpRelativeOffset, 0 );
 }
 
 
 void	CCodeBlock::GenerateSetStringInstruction( int16_t bpRelativeOffset )
 {
-	LEOHandlerAddInstruction( mCurrentHandler, SET_STRING_INSTR, bpRelativeOffset, 0 );
+	AddInstruction( SET_STRING_INSTR, bpRelativeOffset, 0 );
 }
 
 
 void	CCodeBlock::GeneratePutValueIntoValueInstruction()
 {
-	LEOHandlerAddInstruction( mCurrentHandler, PUT_VALUE_INTO_VALUE_INSTR, 0, 0 );
+	AddInstruction( PUT_VALUE_INTO_VALUE_INSTR, 0, 0 );
 }
 
 
 void	CCodeBlock::GeneratePushPropertyOfObjectInstruction()
 {
 	assert(kFirstPropertyInstruction != 0);
-	LEOHandlerAddInstruction( mCurrentHandler, kFirstPropertyInstruction +PUSH_PROPERTY_OF_OBJECT_INSTR, 0, 0 );
+	AddInstruction( kFirstPropertyInstruction +PUSH_PROPERTY_OF_OBJECT_INSTR, 0, 0 );
 }
 
 
 void	CCodeBlock::GenerateSetPropertyOfObjectInstruction()
 {
 	assert(kFirstPropertyInstruction != 0);
-	LEOHandlerAddInstruction( mCurrentHandler, kFirstPropertyInstruction +SET_PROPERTY_OF_OBJECT_INSTR, 0, 0 );
+	AddInstruction( kFirstPropertyInstruction +SET_PROPERTY_OF_OBJECT_INSTR, 0, 0 );
 }
 
 
 void	CCodeBlock::GeneratePushMeInstruction()
 {
 	assert(kFirstPropertyInstruction != 0);
-	LEOHandlerAddInstruction( mCurrentHandler, kFirstPropertyInstruction +PUSH_ME_INSTR, 0, 0 );
+	AddInstruction( kFirstPropertyInstruction +PUSH_ME_INSTR, 0, 0 );
 }
 
 	
 void CCodeBlock::DebugPrint()
 {
-	LEODebugPrintScript( mGroup, mScript );
+	if( mScript )
+		LEODebugPrintScript( mGroup, mScript );
 }
 
 
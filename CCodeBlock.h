@@ -10,6 +10,7 @@
 #include <string>
 #include "CVariableEntry.h"
 #include <map>
+#include <vector>
 extern "C" {
 #include "LEOInterpreter.h"
 }
@@ -23,12 +24,59 @@ namespace Carlson
 
 class CCodeBlock;
 
+
+// The instructions of one handler, generated by a CCodeBlock that isn't
+//	attached to a LEOScript. Strings, handler names, file names and syntax
+//	errors only go into local tables here, because adding them to the script,
+//	context group or file list isn't thread safe. Pass this to
+//	CCodeBlock::AddHandlerFromBuilder() to add the handler to a script.
+class CHandlerBuilder
+{
+public:
+	CHandlerBuilder() : mIsCommand(false) {}
+	
+	uint32_t	AddString( const std::string& inString );			// Returns local index, deduplicated.
+	uint32_t	AddHandlerName( const std::string& inHandlerName );	// Returns local index, deduplicated.
+	
+	struct CVariableNameMapping
+	{
+		std::string		mName;
+		std::string		mRealName;
+		size_t			mBPRelativeOffset;
+	};
+	
+	struct CSyntaxError
+	{
+		std::string		mErrorMessage;
+		std::string		mFileName;
+		size_t			mLineNum;
+		size_t			mOffset;
+	};
+	
+	bool									mIsCommand;
+	std::string								mName;
+	std::vector<LEOInstruction>				mInstructions;			// String, handler name and syntax error params are indexes into our tables below.
+	std::vector<std::string>				mStrings;
+	std::map<std::string,uint32_t>			mStringIndexes;
+	std::vector<std::string>				mHandlerNames;
+	std::map<std::string,uint32_t>			mHandlerNameIndexes;
+	std::vector<CSyntaxError>				mSyntaxErrors;
+	std::vector<std::pair<size_t,std::string>>	mLineMarkerFileNames;	// Instruction index and name of file whose ID goes in its param1.
+	std::vector<CVariableNameMapping>		mVariableNameMappings;
+};
+
+
 class CCodeBlock
 {
 public:
 	CCodeBlock( LEOContextGroup * inGroup, LEOScript* inScript, uint16_t inFileID );
+	CCodeBlock( CHandlerBuilder* inBuilder, uint16_t inFileID );	// Generate code for one handler into inBuilder instead of a script.
 	virtual ~CCodeBlock();
 	
+	uint16_t	GetFileID() const		{ return mFileID; };
+	
+	void		AddHandlerFromBuilder( const CHandlerBuilder& inBuilder );	// Must be attached to a script. Adds the builder's handler, strings etc. to it.
+	
 	void		GenerateFunctionPrologForName( bool isCommand, const std::string& inName, const std::map<std::string,CVariableEntry>& inLocals, size_t lineNumber );
 	void		PrepareToExitFunction( size_t lineNumber );
 	void		GenerateFunctionEpilogForName( bool isCommand, const std::string& inName, const std::map<std::string,CVariableEntry>& inLocals, size_t lineNumber );	// Calls PrepareToExitFunction.
@@ -63,6 +111,7 @@ public:
 	void		GenerateOperatorInstruction( LEOInstructionID inInstructionID, uint16_t inParam1 = 0, uint32_t inParam2 = 0 );
 	
 	void		GenerateLineMarkerInstruction( uint32_t inLineNum, uint16_t inFileID );
+	void		GenerateLineMarkerInstruction( uint32_t inLineNum, const std::string& inFileName );
 	
 	void		GeneratePushChunkRefInstruction( int16_t bpRelativeOffset, uint32_t inChunkType );
 	void		GeneratePushChunkConstInstruction( int16_t bpRelativeOffset, uint32_t inChunkType );
@@ -82,9 +131,14 @@ public:
 	void		DebugPrint();
 	
 protected:
+	void		AddInstruction( LEOInstructionID inInstructionID, uint16_t inParam1, uint32_t inParam2 );
+	uint32_t	AddString( const std::string& inString );
+	
 	LEOScript*				mScript;
 	LEOContextGroup*		mGroup;
 	LEOHandler*				mCurrentHandler;
+	CHandlerBuilder*		mBuilder;			// If this is not NULL, mScript, mGroup and mCurrentHandler are.
+	std::map<std::string,uint32_t>	mStringIndexes;	// Cache of strings we added to mScript.
 	size_t					mNumLocals;
 	uint16_t				mFileID;
 };
@@ -58,7 +58,7 @@ void	CCodeBlockNodeBase::Simplify()
 	{
 		CNode	*	originalNode = *itty;
 		originalNode->Simplify();	// Give subnodes a chance to apply transformations first. Might expose simpler sub-nodes we can then simplify.
-		CNode* newNode = CNodeTransformationBase::Apply( originalNode );	// Returns either originalNode, or a totally new object, in which case we delete the old one.
+		CNode* newNode = CNodeTransformationBase::Apply( originalNode );	// Returns either originalNode, or a totally new object, which replaces it.
 		if( newNode != originalNode )
 			*itty = newNode;
 	}
@@ -85,18 +85,6 @@ void	CCodeBlockNodeBase::GenerateCode( CCodeBlock* inCodeBlock )
 }
 
 
-CCodeBlockNodeBase::~CCodeBlockNodeBase()
-{
-	std::vector<CNode*>::iterator itty;
-	
-	for( itty = mCommands.begin(); itty != mCommands.end(); itty++ )
-	{
-		delete *itty;
-		*itty = NULL;
-	}
-}
-
-
 void	CCodeBlockNode::AddLocalVar( const std::string& inName, const std::string& inUserName,
 								TVariantType theType, bool initWithName,
 								bool isParam, bool isGlobal,
@@ -29,10 +29,11 @@ class CCodeBlockNodeBase : public CNode
 public:
 	CCodeBlockNodeBase( CParseTree* inTree, size_t inLineNum, const std::string &inFileName )
 		: CNode(inTree), mLineNum( inLineNum ), mFileName(inFileName) {};
-	virtual ~CCodeBlockNodeBase();
+	virtual ~CCodeBlockNodeBase() {};
 	
-	virtual void	AddCommand( CNode* inCmd )	{ mCommands.push_back( inCmd ); mParseTree->NodeWasAdded( inCmd ); };	// Function node now owns this command and will delete it!
+	virtual void	AddCommand( CNode* inCmd )	{ mCommands.push_back( inCmd ); mParseTree->NodeWasAdded( inCmd ); };	// inCmd must belong to the same parse tree.
 	virtual size_t	GetCommandsCount()	{ return mCommands.size(); };
+	virtual std::vector<CNode*>&	GetCommands()	{ return mCommands; };	// For CParseTreePasses that rearrange commands. Call NodeWasChanged() on this block when you do.
 	
 	virtual void	AddLocalVar( const std::string& inName, const std::string& inUserName,
 									TVariantType theType, bool initWithName = false,
@@ -58,6 +59,7 @@ public:
 
 	virtual CCodeBlockNodeBase*	GetContainingFunction()				{ return NULL; };
 	size_t			GetLineNum()	{ return mLineNum; };
+	const std::string&	GetFileName()	{ return mFileName; };
 	
 protected:
 	size_t									mLineNum;
@@ -80,6 +82,9 @@ public:
 	};
 	virtual ~CCodeBlockNode()	{};
 
+	static const TNodeKind	kNodeKind = ECodeBlockNodeKind;
+	virtual TNodeKind	GetNodeKind()	{ return kNodeKind; };
+
 	virtual void	AddLocalVar( const std::string& inName, const std::string& inUserName,
 									TVariantType theType, bool initWithName = false,
 									bool isParam = false, bool isGlobal = false,
@@ -92,6 +97,7 @@ public:
 	virtual std::map<std::string,CVariableEntry>&		GetGlobals()			{ return *mGlobals; };
 
 	virtual CCodeBlockNodeBase*	GetContainingFunction()				{ return mOwningBlock->GetContainingFunction(); };
+	CCodeBlockNodeBase*			GetOwningBlock()					{ return mOwningBlock; };
 	
 protected:
 	std::map<std::string,CVariableEntry>*	mLocals;
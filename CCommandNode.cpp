@@ -54,7 +54,7 @@ void	CCommandNode::Simplify()
 		if( !originalNode )
 			continue;
 		originalNode->Simplify();	// Give subnodes a chance to apply transformations first. Might expose simpler sub-nodes we can then simplify.
-		CNode* newNode = CNodeTransformationBase::Apply( originalNode );	// Returns either originalNode, or a totally new object, in which case we delete the old one.
+		CNode* newNode = CNodeTransformationBase::Apply( originalNode );	// Returns either originalNode, or a totally new object, which replaces it.
 		if( newNode != originalNode )
 		{
 			assert( dynamic_cast<CValueNode*>(newNode) != NULL );
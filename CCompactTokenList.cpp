@@ -0,0 +1,160 @@
+//
+//  CCompactTokenList.cpp
+//  Forge
+//
+//  Created on 2026-10-17.
+//
+//
+
+#include "CCompactTokenList.h"
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+
+
+namespace Carlson
+{
+
+CCompactTokenList::CCompactTokenList( const char* inSource, size_t inLength, bool webPageEmbedMode )
+	: mSource(inSource), mSourceLength(inLength)
+{
+	if( inLength > UINT32_MAX )
+		throw std::runtime_error( "Script is too large to be tokenized." );
+
+	mTokens.reserve( inLength / 4 );
+
+	CTokenizer::TokenizeText( inSource, inLength, webPageEmbedMode, *this );
+
+	mTokens.shrink_to_fit();
+}
+
+
+void	CCompactTokenList::AddToken( TTokenType type, TIdentifierSubtype subtype, size_t offs, size_t lineN, const std::string& str, const std::string& comment, long long n )
+{
+	uint32_t		tokenIndex = (uint32_t) mTokens.size();
+	CCompactToken	newToken = { (uint8_t) type, 0, (uint16_t) subtype, (uint32_t) offs, (uint32_t) str.length(), kNoIdentifierAtom };
+
+	if( offs > mSourceLength || str.length() > (mSourceLength - offs) || memcmp( mSource + offs, str.data(), str.length() ) != 0 )
+	{
+		newToken.mFlags |= kCompactTokenTextInPool;
+		mPooledTexts.push_back( AddToPool( tokenIndex, str ) );
+	}
+
+	if( type == ENumberToken )
+	{
+		newToken.mValue = (uint32_t) mNumbers.size();
+		mNumbers.push_back( n );
+	}
+	else if( type == EIdentifierToken )
+		newToken.mValue = (subtype == ELastIdentifier_Sentinel) ? CToken::AtomFromOriginalText( str ) : (TIdentifierAtom) subtype;
+
+	if( mLineStarts.empty() || mLineStarts.back().mLineNum != lineN )
+	{
+		CLineStart	lineStart = { tokenIndex, (uint32_t) lineN };
+		mLineStarts.push_back( lineStart );
+	}
+
+	if( comment.length() > 0 )
+	{
+		// Comments usually only get attached to one token, but where they aren't, share the text:
+		if( mComments.size() > 0 && comment.length() == mComments.back().mLength
+			&& mStringPool.compare( mComments.back().mPoolOffset, mComments.back().mLength, comment ) == 0 )
+		{
+			CPoolSpan	sharedComment = mComments.back();
+			sharedComment.mTokenIndex = tokenIndex;
+			mComments.push_back( sharedComment );
+		}
+		else
+			mComments.push_back( AddToPool( tokenIndex, comment ) );
+	}
+
+	mTokens.push_back( newToken );
+}
+
+
+CCompactTokenList::CPoolSpan	CCompactTokenList::AddToPool( uint32_t inTokenIndex, const std::string& inText )
+{
+	if( (mStringPool.length() + inText.length()) > UINT32_MAX )
+		throw std::runtime_error( "Script is too large to be tokenized." );
+
+	CPoolSpan	span = { inTokenIndex, (uint32_t) mStringPool.length(), (uint32_t) inText.length() };
+	mStringPool.append( inText );
+	return span;
+}
+
+
+const CCompactTokenList::CPoolSpan*	CCompactTokenList::FindSpan( const std::vector<CPoolSpan>& inSpans, size_t idx ) const
+{
+	std::vector<CPoolSpan>::const_iterator	foundSpan = std::lower_bound( inSpans.begin(), inSpans.end(), idx, []( const CPoolSpan& inSpan, size_t inIndex ) { return inSpan.mTokenIndex < inIndex; } );
+	if( foundSpan == inSpans.end() || foundSpan->mTokenIndex != idx )
+		return NULL;
+	return &(*foundSpan);
+}
+
+
+CTokenText	CCompactTokenList::GetText( size_t idx ) const
+{
+	const CCompactToken&	token = mTokens[idx];
+	CTokenText				text = { mSource + token.mTextOffset, token.mTextLength };
+	if( token.mFlags & kCompactTokenTextInPool )
+	{
+		const CPoolSpan*	span = FindSpan( mPooledTexts, idx );
+		text.mText = mStringPool.data() + span->mPoolOffset;
+	}
+	return text;
+}
+
+
+size_t	CCompactTokenList::GetLineNum( size_t idx ) const
+{
+	std::vector<CLineStart>::const_iterator	foundLine = std::upper_bound( mLineStarts.begin(), mLineStarts.end(), idx, []( size_t inIndex, const CLineStart& inLineStart ) { return inIndex < inLineStart.mTokenIndex; } );
+	if( foundLine == mLineStarts.begin() )
+		return 1;
+	return (foundLine -1)->mLineNum;
+}
+
+
+long long	CCompactTokenList::GetNumberValue( size_t idx ) const
+{
+	if( mTokens[idx].mType != ENumberToken )
+		return 0;
+	return mNumbers[ mTokens[idx].mValue ];
+}
+
+
+CTokenText	CCompactTokenList::GetComment( size_t idx ) const
+{
+	CTokenText			text = { "", 0 };
+	const CPoolSpan*	span = FindSpan( mComments, idx );
+	if( span )
+	{
+		text.mText = mStringPool.data() + span->mPoolOffset;
+		text.mLength = span->mLength;
+	}
+	return text;
+}
+
+
+TIdentifierAtom	CCompactTokenList::GetAtom( size_t idx ) const
+{
+	const CCompactToken&	token = mTokens[idx];
+	if( token.mType != EIdentifierToken )
+		return kNoIdentifierAtom;
+	return token.mValue;
+}
+
+
+CToken	CCompactTokenList::MakeToken( size_t idx ) const
+{
+	const CCompactToken&	token = mTokens[idx];
+	return CToken( (TTokenType) token.mType, (TIdentifierSubtype) token.mSubType, GetAtom( idx ), token.mTextOffset, GetLineNum( idx ), GetText( idx ).GetString(), GetComment( idx ).GetString(), GetNumberValue( idx ) );
+}
+
+
+size_t	CCompactTokenList::GetMemoryUsage() const
+{
+	return sizeof(*this) + mTokens.capacity() * sizeof(CCompactToken) + (mPooledTexts.capacity() + mComments.capacity()) * sizeof(CPoolSpan)
+			+ mLineStarts.capacity() * sizeof(CLineStart) + mNumbers.capacity() * sizeof(long long) + mStringPool.capacity();
+}
+
+} // namespace Carlson
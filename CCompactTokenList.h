@@ -0,0 +1,117 @@
+//
+//  CCompactTokenList.h
+//  Forge
+//
+//  Created on 2026-10-17.
+//
+//
+
+#pragma once
+
+/*
+	CCompactTokenList is an alternative to the std::deque<CToken> that
+	CTokenizer::TokenListFromText() returns. Every CToken owns two std::strings
+	and carries its line number and number value around. CCompactTokens are
+	16-byte PODs that own no memory. Instead, a token's text is a span into the
+	source text the list was created from. Identifiers are stored as the
+	same atoms CToken uses, so they can be compared without looking at their text.
+	Everything most tokens don't need (documentation comments, line numbers,
+	number values and the rare token whose text isn't a verbatim copy of the
+	source) lives in side tables of the list.
+
+	The parser reads a CCompactTokenList through a CCompactTokenCursor, which
+	only turns the tokens around the parser's current position into CTokens.
+
+	The list does NOT copy the source text, so the text passed to the
+	constructor must stay around and unchanged for as long as the list exists.
+	Once created, a list never changes, so any number of threads may read it.
+*/
+
+#include "CToken.h"
+#include <vector>
+#include <string>
+#include <stdint.h>
+
+
+namespace Carlson
+{
+
+enum
+{
+	kCompactTokenTextInPool	= (1 << 0)	// Token's text isn't a verbatim span of the source, it's in the list's string pool. mTextOffset is the token's offset in the source.
+};
+
+
+struct CCompactToken
+{
+	uint8_t		mType;			// TTokenType.
+	uint8_t		mFlags;			// kCompactTokenTextInPool etc.
+	uint16_t	mSubType;		// TIdentifierSubtype.
+	uint32_t	mTextOffset;	// Offset of this token's text in the source. Also the token's offset.
+	uint32_t	mTextLength;	// Length of this token's text in bytes.
+	uint32_t	mValue;			// TIdentifierAtom for identifiers, index into number table for numbers.
+};
+
+static_assert( sizeof(CCompactToken) == 16, "CCompactToken should stay 16 bytes." );
+
+
+// A piece of text in the source or the string pool. Our stand-in for a string view:
+struct CTokenText
+{
+	const char*	mText;
+	size_t		mLength;
+
+	std::string	GetString() const						{ return std::string( mText, mLength ); }
+	bool		IsEqual( const std::string& inStr ) const	{ return inStr.length() == mLength && inStr.compare( 0, mLength, mText, mLength ) == 0; }
+};
+
+
+class CCompactTokenList : public CTokenSink
+{
+public:
+	CCompactTokenList( const char* inSource, size_t inLength, bool webPageEmbedMode = false );	// Tokenizes inSource, which must outlive this list.
+
+	size_t					size() const						{ return mTokens.size(); }
+	const CCompactToken&	operator[]( size_t idx ) const		{ return mTokens[idx]; }
+
+	CTokenText				GetText( size_t idx ) const;		// Original text of the token, as entered by the user.
+	size_t					GetOffset( size_t idx ) const		{ return mTokens[idx].mTextOffset; }
+	size_t					GetLineNum( size_t idx ) const;
+	long long				GetNumberValue( size_t idx ) const;
+	CTokenText				GetComment( size_t idx ) const;		// Documentation comment preceding the token, empty if there is none.
+	TIdentifierAtom			GetAtom( size_t idx ) const;		// kNoIdentifierAtom unless this is an identifier. Same atom as CToken::GetIdentifierAtom().
+
+	CToken					MakeToken( size_t idx ) const;		// Builds the same CToken CTokenizer::TokenListFromText() would have, for the parser.
+	size_t					GetMemoryUsage() const;				// Approximate number of bytes, not counting the source text.
+
+// CTokenSink:
+	virtual void	AddToken( TTokenType type, TIdentifierSubtype subtype, size_t offs, size_t lineN, const std::string& str, const std::string& comment, long long n = 0 );
+
+protected:
+	struct CPoolSpan
+	{
+		uint32_t	mTokenIndex;	// Index of the token this span belongs to.
+		uint32_t	mPoolOffset;
+		uint32_t	mLength;
+	};
+
+	struct CLineStart
+	{
+		uint32_t	mTokenIndex;	// Index of the first token on this line.
+		uint32_t	mLineNum;
+	};
+
+	CPoolSpan				AddToPool( uint32_t inTokenIndex, const std::string& inText );
+	const CPoolSpan*		FindSpan( const std::vector<CPoolSpan>& inSpans, size_t idx ) const;
+
+	const char*										mSource;
+	size_t											mSourceLength;
+	std::vector<CCompactToken>						mTokens;
+	std::vector<CPoolSpan>							mPooledTexts;	// Text of tokens with kCompactTokenTextInPool, sorted by token index.
+	std::vector<CPoolSpan>							mComments;		// Sorted by token index.
+	std::vector<CLineStart>							mLineStarts;	// Line numbers only ever go up, so we only record where they change.
+	std::vector<long long>							mNumbers;
+	std::string										mStringPool;
+};
+
+} // namespace Carlson
@@ -21,7 +21,7 @@ public:
 	
 	virtual LEOInstructionID	GetInstructionID();
 	
-	static void		Initialize()	{ sNodeTransformations.push_back( new CConcatOperatorNodeTransformation ); };
+	static void		Initialize()	{ Register( new CConcatOperatorNodeTransformation ); };
 };
 
 
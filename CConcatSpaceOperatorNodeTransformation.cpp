@@ -33,16 +33,16 @@ CNode*	CConcatSpaceOperatorNodeTransformation::Simplify( COperatorNode* inOperat
 				std::string	newString = firstParamStr;
 				newString.append( 1, ' ' );
 				newString.append( secondParamStr );
-				return new CStringValueNode( inOperatorNode->GetParseTree(), newString, inOperatorNode->GetLineNum() );
+				return inOperatorNode->GetParseTree()->NewNode<CStringValueNode>( newString, inOperatorNode->GetLineNum() );
 			}
 			else if( firstParam->IsConstant() )	// Fold the space into the leading constant:
 			{
 				std::string	firstParamStr = firstParam->GetAsString();
 				std::string	newString = firstParamStr;
 				newString.append( 1, ' ' );
-				CStringValueNode	*	newFirstParamNode = new CStringValueNode( inOperatorNode->GetParseTree(), newString, firstParam->GetLineNum() );
+				CStringValueNode	*	newFirstParamNode = inOperatorNode->GetParseTree()->NewNode<CStringValueNode>( newString, firstParam->GetLineNum() );
 				CValueNode			*	newSecondParamNode = secondParam->Copy();
-				COperatorNode		*	newOperationNode = new COperatorNode( inOperatorNode->GetParseTree(), CONCATENATE_VALUES_INSTR, inOperatorNode->GetLineNum() );
+				COperatorNode		*	newOperationNode = inOperatorNode->GetParseTree()->NewNode<COperatorNode>( CONCATENATE_VALUES_INSTR, inOperatorNode->GetLineNum() );
 				newOperationNode->AddParam( newFirstParamNode );
 				newOperationNode->AddParam( newSecondParamNode );
 				return newOperationNode;
@@ -52,9 +52,9 @@ CNode*	CConcatSpaceOperatorNodeTransformation::Simplify( COperatorNode* inOperat
 				std::string	secondParamStr = secondParam->GetAsString();
 				std::string	newString( " " );
 				newString.append( secondParamStr );
-				CStringValueNode	*	newSecondParamNode = new CStringValueNode( inOperatorNode->GetParseTree(), newString, secondParam->GetLineNum() );
+				CStringValueNode	*	newSecondParamNode = inOperatorNode->GetParseTree()->NewNode<CStringValueNode>( newString, secondParam->GetLineNum() );
 				CValueNode			*	newFirstParamNode = firstParam->Copy();
-				COperatorNode		*	newOperationNode = new COperatorNode( inOperatorNode->GetParseTree(), CONCATENATE_VALUES_INSTR, inOperatorNode->GetLineNum() );
+				COperatorNode		*	newOperationNode = inOperatorNode->GetParseTree()->NewNode<COperatorNode>( CONCATENATE_VALUES_INSTR, inOperatorNode->GetLineNum() );
 				newOperationNode->AddParam( newFirstParamNode );
 				newOperationNode->AddParam( newSecondParamNode );
 				return newOperationNode;
@@ -0,0 +1,122 @@
+//
+//  CConstantFoldingNodeTransformation.cpp
+//  Forge
+//
+//  Created on 2026-10-18.
+//
+//
+
+#include "CConstantFoldingNodeTransformation.h"
+#include "CValueNode.h"
+#include "CCodeBlock.h"
+#include "LEOInstructions.h"
+extern "C" {
+#include "LEOContextGroup.h"
+#include "LEOInterpreter.h"
+}
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+
+
+namespace Carlson
+{
+
+// Operators that only look at their operands, so running them at compile time gives the same result as at runtime:
+static const LEOInstructionID	sFoldableInstructions[] =
+{
+	ADD_OPERATOR_INSTR,
+	SUBTRACT_OPERATOR_INSTR,
+	MULTIPLY_OPERATOR_INSTR,
+	DIVIDE_OPERATOR_INSTR,
+	MODULO_OPERATOR_INSTR,
+	POWER_OPERATOR_INSTR,
+	NEGATE_NUMBER_INSTR,
+	NEGATE_BOOL_INSTR,
+	AND_INSTR,
+	OR_INSTR,
+	EQUAL_OPERATOR_INSTR,
+	NOT_EQUAL_OPERATOR_INSTR,
+	LESS_THAN_OPERATOR_INSTR,
+	LESS_THAN_EQUAL_OPERATOR_INSTR,
+	GREATER_THAN_OPERATOR_INSTR,
+	GREATER_THAN_EQUAL_OPERATOR_INSTR
+};
+
+
+// Returns NULL if inValue can't be expressed as a constant node that pushes the exact same value:
+static CValueNode*	ConstantNodeForValue( LEOValuePtr inValue, LEOContext* inContext, CParseTree* inTree, size_t inLineNum )
+{
+	LEOUnit		unit = kLEOUnitNone;
+	if( inValue->base.isa == &kLeoValueTypeInteger )
+	{
+		LEOInteger		theInteger = LEOGetValueAsInteger( inValue, &unit, inContext );
+		CIntValueNode*	intNode = inTree->NewNode<CIntValueNode>( theInteger, inLineNum );
+		intNode->SetUnit( unit );
+		return intNode;
+	}
+	else if( inValue->base.isa == &kLeoValueTypeNumber )
+	{
+		LEONumber	theNumber = LEOGetValueAsNumber( inValue, &unit, inContext );
+		if( !(fabs(theNumber) <= FLT_MAX) || (LEONumber)(float)theNumber != theNumber )
+			return NULL;	// CFloatValueNode only holds a float, and this would get rounded (or is NaN).
+		CFloatValueNode*	floatNode = inTree->NewNode<CFloatValueNode>( (float)theNumber, inLineNum );
+		floatNode->SetUnit( unit );
+		return floatNode;
+	}
+	else if( inValue->base.isa == &kLeoValueTypeBoolean )
+		return inTree->NewNode<CBoolValueNode>( LEOGetValueAsBoolean( inValue, inContext ), inLineNum );
+
+	return NULL;
+}
+
+
+CNode*	CConstantFoldingNodeTransformation::Simplify( COperatorNode* inOperatorNode )
+{
+	const LEOInstructionID*	foldableInstructionsEnd = sFoldableInstructions + (sizeof(sFoldableInstructions) / sizeof(LEOInstructionID));
+	if( std::find( sFoldableInstructions, foldableInstructionsEnd, inOperatorNode->GetInstructionID() ) == foldableInstructionsEnd )
+		return inOperatorNode;
+	if( inOperatorNode->GetParamCount() == 0 )
+		return inOperatorNode;
+	for( size_t x = 0; x < inOperatorNode->GetParamCount(); x++ )
+	{
+		CValueNode	*	currParam = inOperatorNode->GetParamAtIndex(x);
+		if( dynamic_cast<CNumericValueNodeBase*>(currParam) == NULL && dynamic_cast<CBoolValueNode*>(currParam) == NULL )
+			return inOperatorNode;
+	}
+
+	// Generate the instructions the script would run:
+	CHandlerBuilder		builder;
+	CCodeBlock			codeBlock( &builder, 0 );
+	inOperatorNode->GenerateCode( &codeBlock );
+	for( const LEOInstruction& currInstruction : builder.mInstructions )
+	{
+		if( currInstruction.instructionID >= gNumInstructions )
+			return inOperatorNode;	// Leonie hasn't been set up yet?
+	}
+
+	// Run them on a context of our own. Each instruction advances currentInstruction, or jumps (e.g. a short-circuiting "and"):
+	LEOInstruction	*	instructionsStart = builder.mInstructions.data();
+	LEOInstruction	*	instructionsEnd = instructionsStart +builder.mInstructions.size();
+	LEOContextGroup	*	group = LEOContextGroupCreate( NULL, NULL );
+	LEOContext		*	context = LEOContextCreate( group, NULL, NULL );
+	context->flags |= kLEOContextKeepRunning;
+	context->currentInstruction = instructionsStart;
+	while( (context->flags & kLEOContextKeepRunning) != 0	// Stops when an instruction fails.
+			&& context->currentInstruction >= instructionsStart && context->currentInstruction < instructionsEnd )
+		gInstructions[context->currentInstruction->instructionID].proc( context );
+
+	CValueNode	*	resultNode = NULL;
+	if( (context->flags & kLEOContextKeepRunning) != 0 && context->currentInstruction == instructionsEnd
+		&& (context->stackEndPtr -context->stack) == 1 )
+		resultNode = ConstantNodeForValue( context->stack, context, inOperatorNode->GetParseTree(), inOperatorNode->GetLineNum() );
+
+	LEOCleanUpStackToPtr( context, context->stack );
+	LEOContextRelease( context );
+	LEOContextGroupRelease( group );
+
+	return resultNode ? resultNode : inOperatorNode;
+}
+
+
+} // namespace Carlson
@@ -0,0 +1,41 @@
+//
+//  CConstantFoldingNodeTransformation.h
+//  Forge
+//
+//  Created on 2026-10-18.
+//
+//
+
+#pragma once
+
+/*
+	Replaces arithmetic, comparisons and boolean operators whose operands are
+	all number or boolean constants with their result.
+
+	To be sure the result is exactly what the script would have calculated,
+	including units and what happens when an integer overflows, we don't
+	calculate it ourselves. Instead, we generate the code for the operator
+	and run it using Leonie's own instructions. If that fails (e.g. a
+	division by zero, or units that can't be combined), or the result can't
+	be turned back into a constant node without changing it, we leave the
+	operator alone so the script behaves just like it would without us.
+*/
+
+#include "CNodeTransformation.h"
+#include "COperatorNode.h"
+
+
+namespace Carlson
+{
+
+
+class CConstantFoldingNodeTransformation : public CNodeTransformation<COperatorNode>
+{
+public:
+	virtual CNode*	Simplify( COperatorNode* inOperatorNode );
+
+	static void		Initialize()	{ Register( new CConstantFoldingNodeTransformation ); };
+};
+
+
+} // namespace Carlson
@@ -0,0 +1,146 @@
+//
+//  CDeadCodeNodeTransformation.cpp
+//  Forge
+//
+//  Created on 2026-10-18.
+//
+//
+
+#include "CDeadCodeNodeTransformation.h"
+#include "CParseTree.h"
+#include "CValueNode.h"
+#include "CLineMarkerNode.h"
+#include "CReturnCommandNode.h"
+#include <algorithm>
+
+
+namespace Carlson
+{
+
+// Appends the line markers in inNode (or inNode itself, if it is one) to ioCommands, in line order:
+static void	AppendLineMarkers( CNode* inNode, std::vector<CNode*>& ioCommands )
+{
+	std::vector<CLineMarkerNode*>	lineMarkers;
+	inNode->Visit( [&lineMarkers]( CNode* inVisitedNode )
+	{
+		CLineMarkerNode*	lineMarker = dynamic_cast<CLineMarkerNode*>( inVisitedNode );
+		if( lineMarker )
+			lineMarkers.push_back( lineMarker );
+	} );
+	std::stable_sort( lineMarkers.begin(), lineMarkers.end(), []( CLineMarkerNode* a, CLineMarkerNode* b ) { return a->GetLineNum() < b->GetLineNum(); } );	// Visit() gives us an "if"'s else block before its commands.
+	ioCommands.insert( ioCommands.end(), lineMarkers.begin(), lineMarkers.end() );
+}
+
+
+// An empty block that can take inNode's place. CUnreachableCodePass merges it into the containing block:
+static CCodeBlockNode*	NewReplacementBlock( CCodeBlockNode* inNode )
+{
+	return inNode->GetParseTree()->NewNode<CCodeBlockNode>( inNode->GetLineNum(), inNode->GetFileName(), inNode->GetOwningBlock() );
+}
+
+
+CNode*	CDeadIfNodeTransformation::Simplify( CIfNode* inIfNode )
+{
+	CBoolValueNode	*	condition = dynamic_cast<CBoolValueNode*>( inIfNode->GetCondition() );
+	if( !condition )
+		return inIfNode;
+
+	CCodeBlockNode		*	newBlock = NewReplacementBlock( inIfNode );
+	std::vector<CNode*>&	newCommands = newBlock->GetCommands();
+	bool					keepLineMarkers = inIfNode->GetParseTree()->GetKeepLineMarkersInDeadCode();
+	if( condition->GetAsBool() )
+	{
+		newCommands = inIfNode->GetCommands();
+		if( keepLineMarkers && inIfNode->GetElseBlock() )
+			AppendLineMarkers( inIfNode->GetElseBlock(), newCommands );
+	}
+	else
+	{
+		if( keepLineMarkers )
+		{
+			for( CNode* currCommand : inIfNode->GetCommands() )
+				AppendLineMarkers( currCommand, newCommands );
+		}
+		if( inIfNode->GetElseBlock() )
+			newCommands.insert( newCommands.end(), inIfNode->GetElseBlock()->GetCommands().begin(), inIfNode->GetElseBlock()->GetCommands().end() );
+	}
+
+	return newBlock;
+}
+
+
+CNode*	CDeadWhileLoopNodeTransformation::Simplify( CWhileLoopNode* inLoopNode )
+{
+	CBoolValueNode	*	condition = dynamic_cast<CBoolValueNode*>( inLoopNode->GetCondition() );
+	if( !condition || condition->GetAsBool() )
+		return inLoopNode;
+
+	CCodeBlockNode	*	newBlock = NewReplacementBlock( inLoopNode );
+	if( inLoopNode->GetParseTree()->GetKeepLineMarkersInDeadCode() )
+	{
+		for( CNode* currCommand : inLoopNode->GetCommands() )
+			AppendLineMarkers( currCommand, newBlock->GetCommands() );
+	}
+
+	return newBlock;
+}
+
+
+void	CUnreachableCodePass::Run( CParseTree& inTree )
+{
+	// Visit() gives us the blocks inside a block before the block itself, so
+	//	by the time we merge a block into its container, it's been cleaned up:
+	bool								keepLineMarkers = inTree.GetKeepLineMarkersInDeadCode();
+	std::vector<CCodeBlockNodeBase*>	blocks;
+	inTree.Visit( [&blocks]( CNode* inNode )
+	{
+		CCodeBlockNodeBase*	block = dynamic_cast<CCodeBlockNodeBase*>( inNode );
+		if( block )
+			blocks.push_back( block );
+	} );
+
+	for( CCodeBlockNodeBase* currBlock : blocks )
+	{
+		std::vector<CNode*>&	commands = currBlock->GetCommands();
+		std::vector<CNode*>		newCommands;
+		bool					changed = false;
+
+		for( CNode* currCommand : commands )
+		{
+			if( currCommand->GetNodeKind() == ECodeBlockNodeKind )	// Left behind by a dead "if" or loop.
+			{
+				std::vector<CNode*>&	mergedCommands = static_cast<CCodeBlockNode*>(currCommand)->GetCommands();
+				newCommands.insert( newCommands.end(), mergedCommands.begin(), mergedCommands.end() );
+				changed = true;
+			}
+			else
+				newCommands.push_back( currCommand );
+		}
+
+		std::vector<CNode*>::iterator	firstReturn = std::find_if( newCommands.begin(), newCommands.end(), []( CNode* inCommand ) { return dynamic_cast<CReturnCommandNode*>(inCommand) != NULL; } );
+		if( firstReturn != newCommands.end() )
+		{
+			std::vector<CNode*>	unreachableCommands( firstReturn +1, newCommands.end() );
+			newCommands.erase( firstReturn +1, newCommands.end() );
+			for( CNode* currCommand : unreachableCommands )
+			{
+				if( keepLineMarkers && dynamic_cast<CLineMarkerNode*>(currCommand) != NULL )
+					newCommands.push_back( currCommand );	// Kept last time.
+				else
+				{
+					if( keepLineMarkers )
+						AppendLineMarkers( currCommand, newCommands );
+					changed = true;
+				}
+			}
+		}
+
+		if( changed )
+		{
+			commands.swap( newCommands );
+			inTree.NodeWasChanged( currBlock );
+		}
+	}
+}
+
+} // namespace Carlson
@@ -0,0 +1,69 @@
+//
+//  CDeadCodeNodeTransformation.h
+//  Forge
+//
+//  Created on 2026-10-18.
+//
+//
+
+#pragma once
+
+/*
+	Removes code that can never run:
+
+	CDeadIfNodeTransformation replaces an "if" whose condition is a constant
+	true or false with the block that would be taken (or an empty block).
+
+	CDeadWhileLoopNodeTransformation replaces a "repeat while false" (or a
+	loop whose condition got simplified into that) with an empty block.
+
+	CUnreachableCodePass removes the commands after a "return", "exit <handler>"
+	or "pass" in a block, and merges the blocks the transformations above
+	leave behind into their containing block, so a "return" inside an
+	"if true" also gets rid of the commands after the "if".
+
+	When you're going to debug the script, call SetKeepLineMarkersInDeadCode( true )
+	on its CParseTree before simplifying it, and the removed code will leave its
+	line markers behind, so a debugger still sees each line of the script.
+*/
+
+#include "CNodeTransformation.h"
+#include "CParseTreePass.h"
+#include "CIfNode.h"
+#include "CWhileLoopNode.h"
+
+
+namespace Carlson
+{
+
+
+class CDeadIfNodeTransformation : public CNodeTransformation<CIfNode>
+{
+public:
+	virtual CNode*	Simplify( CIfNode* inIfNode );
+
+	static void		Initialize()	{ Register( new CDeadIfNodeTransformation ); };
+};
+
+
+class CDeadWhileLoopNodeTransformation : public CNodeTransformation<CWhileLoopNode>
+{
+public:
+	virtual CNode*	Simplify( CWhileLoopNode* inLoopNode );
+
+	static void		Initialize()	{ Register( new CDeadWhileLoopNodeTransformation ); };
+};
+
+
+class CUnreachableCodePass : public CParseTreePass
+{
+public:
+	virtual const char*					GetName()			{ return "unreachable-code"; };
+	virtual std::vector<std::string>	GetDependencies()	{ return std::vector<std::string>( 1, "simplify" ); };	// Needs the dead "if"s gone first.
+	virtual void						Run( CParseTree& inTree );
+
+	static void		Initialize()	{ Register( new CUnreachableCodePass ); };
+};
+
+
+} // namespace Carlson
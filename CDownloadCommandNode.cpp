@@ -21,8 +21,8 @@ void	CDownloadCommandNode::EnsureBlockNameParamsAreSet()
 {
 	if( !mBlockNamesAdded )
 	{
-		AddParam( new CStringValueNode( mParseTree, mProgressBlockName, GetLineNum() ) );
-		AddParam( new CStringValueNode( mParseTree, mCompletionBlockName, GetLineNum() ) );
+		AddParam( mParseTree->NewNode<CStringValueNode>( mProgressBlockName, GetLineNum() ) );
+		AddParam( mParseTree->NewNode<CStringValueNode>( mCompletionBlockName, GetLineNum() ) );
 		mBlockNamesAdded = true;
 	}
 }
@@ -61,7 +61,7 @@ void	CDownloadCommandNode::DebugPrint( std::ostream& destStream, size_t indentLe
 CCodeBlockNodeBase*	CDownloadCommandNode::CreateProgressBlock( size_t inLineNum )
 {
 	mProgressBlockName = mParseTree->GetUniqueIdentifierBasedOn("::downloadProgress:");
-	mProgressBlock = new CFunctionDefinitionNode( mParseTree, true, mProgressBlockName, mProgressBlockName, inLineNum, mFileName );
+	mProgressBlock = mParseTree->NewNode<CFunctionDefinitionNode>( true, mProgressBlockName, mProgressBlockName, inLineNum, mFileName );
 	mParseTree->AddNode( mProgressBlock );
 		
 	return mProgressBlock;
@@ -71,7 +71,7 @@ CCodeBlockNodeBase*	CDownloadCommandNode::CreateProgressBlock( size_t inLineNum
 CCodeBlockNodeBase*	CDownloadCommandNode::CreateCompletionBlock( size_t inLineNum )
 {
 	mCompletionBlockName = mParseTree->GetUniqueIdentifierBasedOn("::downloadCompletion:");
-	mCompletionBlock = new CFunctionDefinitionNode( mParseTree, true, mCompletionBlockName, mCompletionBlockName, inLineNum, mFileName );
+	mCompletionBlock = mParseTree->NewNode<CFunctionDefinitionNode>( true, mCompletionBlockName, mCompletionBlockName, inLineNum, mFileName );
 	mParseTree->AddNode( mCompletionBlock );
 
 	return mCompletionBlock;
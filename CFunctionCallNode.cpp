@@ -21,7 +21,7 @@ namespace Carlson
 
 CValueNode*	CFunctionCallNode::Copy()
 {
-	CFunctionCallNode	*	nodeCopy = new CFunctionCallNode( mParseTree, mIsCommand, mSymbolName, mLineNum );
+	CFunctionCallNode	*	nodeCopy = mParseTree->NewNode<CFunctionCallNode>( mIsCommand, mSymbolName, mLineNum );
 	
 	std::vector<CValueNode*>::const_iterator	itty;
 	for( itty = mParams.begin(); itty != mParams.end(); itty++ )
@@ -68,7 +68,7 @@ void	CFunctionCallNode::Simplify()
 	{
 		CValueNode	*	originalNode = *itty;
 		originalNode->Simplify();	// Give subnodes a chance to apply transformations first. Might expose simpler sub-nodes we can then simplify.
-		CNode* newNode = CNodeTransformationBase::Apply( originalNode );	// Returns either originalNode, or a totally new object, in which case we delete the old one.
+		CNode* newNode = CNodeTransformationBase::Apply( originalNode );	// Returns either originalNode, or a totally new object, which replaces it.
 		if( newNode != originalNode )
 		{
 			assert( dynamic_cast<CValueNode*>(newNode) != NULL );
@@ -82,7 +82,8 @@ void	CFunctionCallNode::GenerateCode( CCodeBlock* inCodeBlock )
 {
 	LEOInstructionID	instructionID = INVALID_INSTR;
 	
-	TBuiltInFunctionEntry *foundFunction = CParser::GetBuiltInFunctionWithName( mSymbolName );
+	const CParserGrammar		*grammar = mParseTree->GetGrammar();	// Handlers may be generated in parallel, so avoid GetCurrent()'s lock where we can.
+	const TBuiltInFunctionEntry *foundFunction = grammar ? grammar->GetBuiltInFunctionWithName( mSymbolName ) : CParser::GetBuiltInFunctionWithName( mSymbolName );
 	if( foundFunction && foundFunction->mParamCount == mParams.size()
 	   && foundFunction->mParam1 == 0 && foundFunction->mParam2 == 0  )
 	{
@@ -23,7 +23,7 @@ class CFunctionCallNode : public CValueNode
 {
 public:
 	CFunctionCallNode( CParseTree* inTree, bool isCommand, const std::string& inSymbolName, size_t inLineNum )
-		: CValueNode(inTree,inLineNum), mSymbolName(inSymbolName), mIsCommand(isCommand) {};
+		: CValueNode(inTree,inLineNum), mSymbolName(inSymbolName), mIsCommand(isCommand), mIsMessagePassing(false) {};
 	virtual ~CFunctionCallNode() {};
 	
 	virtual void		GetSymbolName( std::string& outSymbolName )		{ outSymbolName = mSymbolName; };
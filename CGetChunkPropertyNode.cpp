@@ -16,7 +16,7 @@ namespace Carlson
 		
 CValueNode*	CGetChunkPropertyNode::Copy()
 {
-	CGetChunkPropertyNode	*	nodeCopy = new CGetChunkPropertyNode( mParseTree, mSymbolName, mLineNum );
+	CGetChunkPropertyNode	*	nodeCopy = mParseTree->NewNode<CGetChunkPropertyNode>( mSymbolName, mLineNum );
 	
 	std::vector<CValueNode*>::const_iterator	itty;
 	for( itty = mParams.begin(); itty != mParams.end(); itty++ )
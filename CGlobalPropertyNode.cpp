@@ -53,7 +53,7 @@ void	CGlobalPropertyNode::Simplify()
 	{
 		CValueNode	*	originalNode = *itty;
 		originalNode->Simplify();	// Give subnodes a chance to apply transformations first. Might expose simpler sub-nodes we can then simplify.
-		CNode* newNode = CNodeTransformationBase::Apply( originalNode );	// Returns either originalNode, or a totally new object, in which case we delete the old one.
+		CNode* newNode = CNodeTransformationBase::Apply( originalNode );	// Returns either originalNode, or a totally new object, which replaces it.
 		if( newNode != originalNode )
 		{
 			assert( dynamic_cast<CValueNode*>(newNode) != NULL );
@@ -74,7 +74,7 @@ void	CGlobalPropertyNode::Visit( std::function<void(CNode*)> visitorBlock )
 
 CValueNode*	CGlobalPropertyNode::Copy()
 {
-	CGlobalPropertyNode	*	nodeCopy = new CGlobalPropertyNode( mParseTree, mSetterInstructionID, mGetterInstructionID, mPropertyName, mLineNum );
+	CGlobalPropertyNode	*	nodeCopy = mParseTree->NewNode<CGlobalPropertyNode>( mSetterInstructionID, mGetterInstructionID, mPropertyName, mLineNum );
 	
 	std::vector<CValueNode*>::const_iterator	itty;
 	for( itty = mParams.begin(); itty != mParams.end(); itty++ )
@@ -58,7 +58,7 @@ void	CIfNode::Simplify()
 {
 	CNode	*	originalNode = mCondition;
 	originalNode->Simplify();	// Give subnodes a chance to apply transformations first. Might expose simpler sub-nodes we can then simplify.
-	CNode* newNode = CNodeTransformationBase::Apply( originalNode );	// Returns either originalNode, or a totally new object, in which case we delete the old one.
+	CNode* newNode = CNodeTransformationBase::Apply( originalNode );	// Returns either originalNode, or a totally new object, which replaces it.
 	if( newNode != originalNode )
 	{
 		assert( dynamic_cast<CValueNode*>(newNode) != NULL );
@@ -71,7 +71,7 @@ void	CIfNode::Simplify()
 	{
 		originalNode = mElseBlock;
 		originalNode->Simplify();	// Give subnodes a chance to apply transformations first. Might expose simpler sub-nodes we can then simplify.
-		newNode = CNodeTransformationBase::Apply( originalNode );	// Returns either 'this', or an optimized copy. We get to keep one and delete the other.
+		newNode = CNodeTransformationBase::Apply( originalNode );	// Returns either 'this', or an optimized copy, which replaces it.
 		if( newNode != originalNode )
 		{
 			assert( dynamic_cast<CCodeBlockNode*>(newNode) != NULL );
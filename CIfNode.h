@@ -7,6 +7,8 @@
  *
  */
 
+#pragma once
+
 #include "CCodeBlockNode.h"
 
 namespace Carlson
@@ -16,10 +18,13 @@ class CIfNode : public CCodeBlockNode
 {
 public:
 	CIfNode( CParseTree* inTree, size_t inLineNum, const std::string &inFileName, CCodeBlockNodeBase* owningBlock ) : CCodeBlockNode( inTree, inLineNum, inFileName, owningBlock ), mCondition(NULL), mElseBlock(NULL), mThenLineNum(0), mIfCommandsLineNum(0), mElseLineNum(0), mElseCommandsLineNum(0), mEndIfLineNum(0) {};
-	~CIfNode() { delete mCondition; mCondition = NULL; if( mElseBlock ) { delete mElseBlock; mElseBlock = NULL; } };
 
-	virtual void			SetCondition( CValueNode* inCond )	{ if( mCondition ) delete mCondition; mCondition = inCond; };	// inCond is now owned by the CIfNode.
-	virtual CCodeBlockNode*	CreateElseBlock( size_t inLineNum )	{ mElseBlock = new CCodeBlockNode( mParseTree, inLineNum, mFileName, mOwningBlock ); return mElseBlock; };
+	static const TNodeKind	kNodeKind = EIfNodeKind;
+	virtual TNodeKind		GetNodeKind()						{ return kNodeKind; };
+
+	virtual void			SetCondition( CValueNode* inCond )	{ mCondition = inCond; };
+	virtual CValueNode*		GetCondition()						{ return mCondition; };
+	virtual CCodeBlockNode*	CreateElseBlock( size_t inLineNum )	{ mElseBlock = mParseTree->NewNode<CCodeBlockNode>( inLineNum, mFileName, mOwningBlock ); return mElseBlock; };
 	virtual CCodeBlockNode*	GetElseBlock()						{ return mElseBlock; };	// May return NULL!
 	
 	virtual void			DebugPrint( std::ostream& destStream, size_t indentLevel );
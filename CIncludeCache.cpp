@@ -0,0 +1,146 @@
+//
+//  CIncludeCache.cpp
+//  Forge
+//
+//  Created on 2026-10-18.
+//
+//
+
+#include "CIncludeCache.h"
+#include <cstring>
+
+
+namespace Carlson
+{
+
+uint64_t	HashFileContents( const char* inData, size_t inLength )
+{
+	uint64_t	hash = 14695981039346656037ULL;	// 64-bit FNV-1a.
+	for( size_t x = 0; x < inLength; x++ )
+	{
+		hash ^= (uint8_t) inData[x];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+
+#pragma mark CIncludeCacheEntry
+
+CIncludeCacheEntry::CIncludeCacheEntry( const std::vector<char>& inFileText, bool inWebPageEmbedMode, uint64_t inHash )
+	: mFileText(inFileText), mTokens( mFileText.data(), mFileText.size() -1, inWebPageEmbedMode ), mWebPageEmbedMode(inWebPageEmbedMode), mHash(inHash)
+{
+	mSize = sizeof(*this) + mFileText.capacity() + mTokens.GetMemoryUsage();
+}
+
+
+bool	CIncludeCacheEntry::Matches( const std::vector<char>& inFileText, bool inWebPageEmbedMode, uint64_t inHash ) const
+{
+	return mHash == inHash && mWebPageEmbedMode == inWebPageEmbedMode && mFileText.size() == inFileText.size()
+			&& memcmp( mFileText.data(), inFileText.data(), mFileText.size() ) == 0;
+}
+
+
+#pragma mark - CIncludeCache
+
+CIncludeCache&	CIncludeCache::GetShared()
+{
+	static CIncludeCache	sSharedCache;
+	return sSharedCache;
+}
+
+
+std::shared_ptr<CIncludeCacheEntry>	CIncludeCache::GetEntry( const std::vector<char>& inFileText, bool inWebPageEmbedMode )
+{
+	uint64_t	hash = HashFileContents( inFileText.data(), inFileText.size() );
+
+	{
+		std::lock_guard<std::mutex>	lock( mMutex );
+		auto	foundRange = mEntriesByHash.equal_range( hash );
+		for( auto currEntry = foundRange.first; currEntry != foundRange.second; ++currEntry )
+		{
+			if( (*currEntry->second)->Matches( inFileText, inWebPageEmbedMode, hash ) )
+			{
+				mEntries.splice( mEntries.begin(), mEntries, currEntry->second );	// Move to front, iterator stays valid.
+				return mEntries.front();
+			}
+		}
+	}
+
+	// Tokenize without holding the lock, so other threads can use the cache meanwhile:
+	std::shared_ptr<CIncludeCacheEntry>	newEntry = std::make_shared<CIncludeCacheEntry>( inFileText, inWebPageEmbedMode, hash );
+
+	std::lock_guard<std::mutex>	lock( mMutex );
+	if( newEntry->GetSize() > mMaxSize )
+		return newEntry;	// Too large to cache (or caching is off), just hand it out.
+
+	auto	foundRange = mEntriesByHash.equal_range( hash );
+	for( auto currEntry = foundRange.first; currEntry != foundRange.second; ++currEntry )
+	{
+		if( (*currEntry->second)->Matches( inFileText, inWebPageEmbedMode, hash ) )	// Another thread beat us to it.
+		{
+			mEntries.splice( mEntries.begin(), mEntries, currEntry->second );
+			return mEntries.front();
+		}
+	}
+
+	mEntries.push_front( newEntry );
+	mEntriesByHash.insert( std::make_pair( hash, mEntries.begin() ) );
+	mSize += newEntry->GetSize();
+	DiscardLeastRecentlyUsedEntries();
+
+	return newEntry;
+}
+
+
+void	CIncludeCache::DiscardLeastRecentlyUsedEntries()
+{
+	while( mSize > mMaxSize && !mEntries.empty() )
+	{
+		auto	oldestEntry = std::prev( mEntries.end() );
+		auto	foundRange = mEntriesByHash.equal_range( (*oldestEntry)->GetHash() );
+		for( auto currEntry = foundRange.first; currEntry != foundRange.second; ++currEntry )
+		{
+			if( currEntry->second == oldestEntry )
+			{
+				mEntriesByHash.erase( currEntry );
+				break;
+			}
+		}
+		mSize -= (*oldestEntry)->GetSize();
+		mEntries.erase( oldestEntry );	// Parsers still using it keep it alive through their shared_ptr.
+	}
+}
+
+
+void	CIncludeCache::SetMaxSize( size_t inMaxSize )
+{
+	std::lock_guard<std::mutex>	lock( mMutex );
+	mMaxSize = inMaxSize;
+	DiscardLeastRecentlyUsedEntries();
+}
+
+
+size_t	CIncludeCache::GetMaxSize()
+{
+	std::lock_guard<std::mutex>	lock( mMutex );
+	return mMaxSize;
+}
+
+
+size_t	CIncludeCache::GetSize()
+{
+	std::lock_guard<std::mutex>	lock( mMutex );
+	return mSize;
+}
+
+
+void	CIncludeCache::Clear()
+{
+	std::lock_guard<std::mutex>	lock( mMutex );
+	mEntriesByHash.clear();
+	mEntries.clear();
+	mSize = 0;
+}
+
+} // namespace Carlson
@@ -0,0 +1,93 @@
+//
+//  CIncludeCache.h
+//  Forge
+//
+//  Created on 2026-10-18.
+//
+//
+
+#pragma once
+
+/*
+	CIncludeCache remembers the tokens of files pulled in using the "use"
+	statement, so a library file that a whole folder of web pages uses only
+	gets tokenized once instead of once per page. It is shared by all
+	parsers, on all threads.
+
+	Entries are looked up by the file's contents (and whether it was
+	tokenized in web page mode), not its path, as only the include handler
+	knows how a file name is resolved. Since the include handler is still
+	called each time, an edited file simply gets new contents and thus a new
+	entry, and the stale entry eventually falls out of the cache.
+
+	The cache is bounded by an approximate number of bytes. When it grows
+	beyond that, the least recently used entries are discarded.
+*/
+
+#include "CCompactTokenList.h"
+#include <vector>
+#include <deque>
+#include <list>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+
+
+namespace Carlson
+{
+
+uint64_t	HashFileContents( const char* inData, size_t inLength );	// 64-bit FNV-1a. Also used by the forge tool's page manifests.
+
+
+class CIncludeCacheEntry
+{
+public:
+	CIncludeCacheEntry( const std::vector<char>& inFileText, bool inWebPageEmbedMode, uint64_t inHash );
+
+	const std::vector<char>&	GetFileText() const		{ return mFileText; }	// Includes the terminating NUL the include handler appends.
+	const CCompactTokenList&	GetTokens() const		{ return mTokens; }		// Never changes, so several threads may parse these at once, each through its own CCompactTokenCursor.
+	size_t						GetSize() const			{ return mSize; }
+	uint64_t					GetHash() const			{ return mHash; }
+
+	bool						Matches( const std::vector<char>& inFileText, bool inWebPageEmbedMode, uint64_t inHash ) const;
+
+protected:
+	std::vector<char>		mFileText;
+	CCompactTokenList		mTokens;		// Refers to mFileText, so must be declared after it.
+	bool					mWebPageEmbedMode;
+	uint64_t				mHash;
+	size_t					mSize;			// Approximate number of bytes of memory this entry uses.
+};
+
+
+class CIncludeCache
+{
+public:
+	enum
+	{
+		kDefaultMaxSize = 64 * 1024 * 1024
+	};
+
+	static CIncludeCache&	GetShared();
+
+	std::shared_ptr<CIncludeCacheEntry>	GetEntry( const std::vector<char>& inFileText, bool inWebPageEmbedMode );	// Tokenizes inFileText if it isn't in the cache yet.
+
+	void			SetMaxSize( size_t inMaxSize );	// 0 turns off caching.
+	size_t			GetMaxSize();
+	size_t			GetSize();
+	void			Clear();
+
+protected:
+	CIncludeCache() : mSize(0), mMaxSize(kDefaultMaxSize) {}
+
+	void			DiscardLeastRecentlyUsedEntries();	// Caller must hold mMutex.
+
+	std::mutex											mMutex;
+	std::list<std::shared_ptr<CIncludeCacheEntry>>		mEntries;		// Most recently used first.
+	std::unordered_multimap<uint64_t,std::list<std::shared_ptr<CIncludeCacheEntry>>::iterator>	mEntriesByHash;
+	size_t												mSize;
+	size_t												mMaxSize;
+};
+
+} // namespace Carlson
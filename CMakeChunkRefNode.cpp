@@ -17,7 +17,7 @@ namespace Carlson
 		
 CValueNode*	CMakeChunkRefNode::Copy()
 {
-	CMakeChunkRefNode	*	nodeCopy = new CMakeChunkRefNode( mParseTree, mLineNum );
+	CMakeChunkRefNode	*	nodeCopy = mParseTree->NewNode<CMakeChunkRefNode>( mLineNum );
 	
 	std::vector<CValueNode*>::const_iterator	itty;
 	for( itty = mParams.begin(); itty != mParams.end(); itty++ )
@@ -0,0 +1,266 @@
+//
+//  CNativeHeadersIndex.cpp
+//  Forge
+//
+//  Created on 2026-10-18.
+//
+//
+
+#include "CNativeHeadersIndex.h"
+#include "CParser.h"
+#include <fstream>
+#include <vector>
+#include <stdexcept>
+#include <cstring>
+
+#if WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+
+namespace Carlson
+{
+
+static const char		kNativeHeadersIndexMagic[8] = { 'F', 'o', 'r', 'g', 'e', 'H', 'H', 'I' };
+
+enum
+{
+	kNativeHeadersIndexVersion = 1,
+	kNativeHeadersIndexByteOrderMark = 0x01020304
+};
+
+
+struct CNativeHeadersIndexTableInfo
+{
+	uint32_t	mNumEntries;
+	uint32_t	mEntriesOffset;
+};
+
+
+struct CNativeHeadersIndexHeader
+{
+	char							mMagic[8];
+	uint32_t						mVersion;
+	uint32_t						mByteOrderMark;
+	CNativeHeadersIndexTableInfo	mTables[CNativeHeadersIndex::ETable_Count];
+};
+
+
+struct CNativeHeadersIndexEntry
+{
+	uint32_t	mNameOffset;
+	uint32_t	mHeaderNameOffset;
+	uint32_t	mFrameworkNameOffset;
+	uint32_t	mValueOffset;
+};
+
+
+#pragma mark - Writing
+
+// Collects the strings for the string pool, storing each distinct string only once:
+class CNativeHeadersIndexStringPool
+{
+public:
+	CNativeHeadersIndexStringPool() { AddString( std::string() ); }	// Empty string is at offset 0.
+
+	uint32_t	AddString( const std::string& inString )
+	{
+		std::map<std::string,uint32_t>::iterator	foundString = mOffsets.find( inString );
+		if( foundString != mOffsets.end() )
+			return foundString->second;
+
+		uint32_t	offset = (uint32_t) mData.size();
+		mData.insert( mData.end(), inString.begin(), inString.end() );
+		mData.push_back( 0 );
+		if( mData.size() > UINT32_MAX )
+			throw std::runtime_error( "Native headers are too large for an index." );
+		mOffsets[inString] = offset;
+		return offset;
+	}
+
+	const std::vector<char>&	GetData() const	{ return mData; }
+
+protected:
+	std::vector<char>				mData;
+	std::map<std::string,uint32_t>	mOffsets;
+};
+
+
+void	CNativeHeadersIndex::Write( const char* inFilePath, const std::map<std::string,CObjCMethodEntry>& inObjCMethods,
+									const std::map<std::string,CObjCMethodEntry>& inCFunctions,
+									const std::map<std::string,CObjCMethodEntry>& inCFunctionPointers,
+									const std::map<std::string,std::string>& inSynonymsToTypes,
+									const std::map<std::string,std::string>& inConstantsToValues )
+{
+	CNativeHeadersIndexStringPool			stringPool;
+	std::vector<CNativeHeadersIndexEntry>	entries[ETable_Count];
+
+	// std::map iterates in the same order strcmp() sorts in, so the tables come out sorted:
+	const std::map<std::string,CObjCMethodEntry>*	methodTables[] = { &inObjCMethods, &inCFunctions, &inCFunctionPointers };
+	for( int x = EObjCMethodTable; x <= ECFunctionPointerTable; x++ )
+	{
+		for( const std::pair<const std::string,CObjCMethodEntry>& currMethod : *methodTables[x] )
+		{
+			CNativeHeadersIndexEntry	newEntry = { stringPool.AddString( currMethod.first ), stringPool.AddString( currMethod.second.mHeaderName ),
+													stringPool.AddString( currMethod.second.mFrameworkName ), stringPool.AddString( currMethod.second.mMethodSignature ) };
+			entries[x].push_back( newEntry );
+		}
+	}
+	const std::map<std::string,std::string>*	stringTables[] = { &inSynonymsToTypes, &inConstantsToValues };
+	for( int x = ESynonymToTypeTable; x <= EConstantToValueTable; x++ )
+	{
+		for( const std::pair<const std::string,std::string>& currString : *stringTables[x -ESynonymToTypeTable] )
+		{
+			CNativeHeadersIndexEntry	newEntry = { stringPool.AddString( currString.first ), 0, 0, stringPool.AddString( currString.second ) };
+			entries[x].push_back( newEntry );
+		}
+	}
+
+	// Now that we know how large everything is, work out where it goes:
+	CNativeHeadersIndexHeader	header = {};
+	memcpy( header.mMagic, kNativeHeadersIndexMagic, sizeof(header.mMagic) );
+	header.mVersion = kNativeHeadersIndexVersion;
+	header.mByteOrderMark = kNativeHeadersIndexByteOrderMark;
+	size_t		currOffset = sizeof(header);
+	for( int x = 0; x < ETable_Count; x++ )
+	{
+		header.mTables[x].mNumEntries = (uint32_t) entries[x].size();
+		header.mTables[x].mEntriesOffset = (uint32_t) currOffset;
+		currOffset += entries[x].size() * sizeof(CNativeHeadersIndexEntry);
+	}
+	if( (currOffset + stringPool.GetData().size()) > UINT32_MAX )
+		throw std::runtime_error( "Native headers are too large for an index." );
+	for( int x = 0; x < ETable_Count; x++ )
+	{
+		for( CNativeHeadersIndexEntry& currEntry : entries[x] )
+		{
+			currEntry.mNameOffset += (uint32_t) currOffset;
+			currEntry.mHeaderNameOffset += (uint32_t) currOffset;
+			currEntry.mFrameworkNameOffset += (uint32_t) currOffset;
+			currEntry.mValueOffset += (uint32_t) currOffset;
+		}
+	}
+
+	std::ofstream	indexFile( inFilePath, std::ios::out | std::ios::binary | std::ios::trunc );
+	indexFile.write( (const char*) &header, sizeof(header) );
+	for( int x = 0; x < ETable_Count; x++ )
+		indexFile.write( (const char*) entries[x].data(), entries[x].size() * sizeof(CNativeHeadersIndexEntry) );
+	indexFile.write( stringPool.GetData().data(), stringPool.GetData().size() );
+	if( !indexFile.good() )
+		throw std::runtime_error( std::string("Couldn't write native headers index \"") + inFilePath + "\"." );
+}
+
+
+#pragma mark - Reading
+
+std::shared_ptr<CNativeHeadersIndex>	CNativeHeadersIndex::Open( const char* inFilePath )
+{
+	// Check whether this is an index at all before going to the trouble of mapping it:
+	{
+		std::ifstream	indexFile( inFilePath, std::ios::in | std::ios::binary );
+		char			magic[sizeof(kNativeHeadersIndexMagic)] = {};
+		if( !indexFile.read( magic, sizeof(magic) ) || memcmp( magic, kNativeHeadersIndexMagic, sizeof(magic) ) != 0 )
+			return NULL;
+	}
+
+	std::shared_ptr<CNativeHeadersIndex>	index( new CNativeHeadersIndex );
+#if WIN32
+	HANDLE	fileHandle = CreateFileA( inFilePath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+	if( fileHandle == INVALID_HANDLE_VALUE )
+		throw std::runtime_error( std::string("Couldn't open native headers index \"") + inFilePath + "\"." );
+	index->mFileHandle = fileHandle;
+	LARGE_INTEGER	fileSize = {};
+	if( !GetFileSizeEx( fileHandle, &fileSize ) )
+		throw std::runtime_error( std::string("Couldn't open native headers index \"") + inFilePath + "\"." );
+	index->mDataSize = (size_t) fileSize.QuadPart;
+	HANDLE	mappingHandle = CreateFileMappingA( fileHandle, NULL, PAGE_READONLY, 0, 0, NULL );
+	if( mappingHandle == NULL )
+		throw std::runtime_error( std::string("Couldn't map native headers index \"") + inFilePath + "\" into memory." );
+	index->mMappingHandle = mappingHandle;
+	index->mData = (const char*) MapViewOfFile( mappingHandle, FILE_MAP_READ, 0, 0, 0 );
+	if( index->mData == NULL )
+		throw std::runtime_error( std::string("Couldn't map native headers index \"") + inFilePath + "\" into memory." );
+#else
+	int		fileDescriptor = open( inFilePath, O_RDONLY );
+	if( fileDescriptor < 0 )
+		throw std::runtime_error( std::string("Couldn't open native headers index \"") + inFilePath + "\"." );
+	struct stat	fileInfo = {};
+	if( fstat( fileDescriptor, &fileInfo ) != 0 )
+	{
+		close( fileDescriptor );
+		throw std::runtime_error( std::string("Couldn't open native headers index \"") + inFilePath + "\"." );
+	}
+	index->mDataSize = (size_t) fileInfo.st_size;
+	void*	data = mmap( NULL, index->mDataSize, PROT_READ, MAP_SHARED, fileDescriptor, 0 );
+	close( fileDescriptor );	// The mapping stays valid without it.
+	if( data == MAP_FAILED )
+		throw std::runtime_error( std::string("Couldn't map native headers index \"") + inFilePath + "\" into memory." );
+	index->mData = (const char*) data;
+#endif
+
+	// Make sure we can't read past the end, so a damaged file can't crash us later:
+	const CNativeHeadersIndexHeader*	header = (const CNativeHeadersIndexHeader*) index->mData;
+	if( index->mDataSize < (sizeof(CNativeHeadersIndexHeader) +1) || index->mData[index->mDataSize -1] != 0 )
+		throw std::runtime_error( std::string("Native headers index \"") + inFilePath + "\" is damaged." );
+	if( header->mVersion != kNativeHeadersIndexVersion || header->mByteOrderMark != kNativeHeadersIndexByteOrderMark )
+		throw std::runtime_error( std::string("Native headers index \"") + inFilePath + "\" was made for a different version of Forge or a different CPU." );
+	for( int x = 0; x < ETable_Count; x++ )
+	{
+		uint64_t	tableEnd = header->mTables[x].mEntriesOffset + (uint64_t) header->mTables[x].mNumEntries * sizeof(CNativeHeadersIndexEntry);
+		if( tableEnd > index->mDataSize || (header->mTables[x].mEntriesOffset % sizeof(uint32_t)) != 0 )
+			throw std::runtime_error( std::string("Native headers index \"") + inFilePath + "\" is damaged." );
+	}	// String offsets are checked by StringAtOffset(), so we don't have to touch every page here.
+
+	return index;
+}
+
+
+CNativeHeadersIndex::~CNativeHeadersIndex()
+{
+#if WIN32
+	if( mData )
+		UnmapViewOfFile( mData );
+	if( mMappingHandle )
+		CloseHandle( (HANDLE) mMappingHandle );
+	if( mFileHandle )
+		CloseHandle( (HANDLE) mFileHandle );
+#else
+	if( mData )
+		munmap( (void*) mData, mDataSize );
+#endif
+}
+
+
+bool	CNativeHeadersIndex::FindEntry( TTable inTable, const char* inName, CEntry& outEntry ) const
+{
+	const CNativeHeadersIndexHeader*	header = (const CNativeHeadersIndexHeader*) mData;
+	const CNativeHeadersIndexEntry*		entries = (const CNativeHeadersIndexEntry*) (mData + header->mTables[inTable].mEntriesOffset);
+	size_t								lowIndex = 0, highIndex = header->mTables[inTable].mNumEntries;
+
+	while( lowIndex < highIndex )
+	{
+		size_t	middleIndex = lowIndex + (highIndex -lowIndex) / 2;
+		int		comparison = strcmp( inName, StringAtOffset( entries[middleIndex].mNameOffset ) );
+		if( comparison == 0 )
+		{
+			outEntry.mName = StringAtOffset( entries[middleIndex].mNameOffset );
+			outEntry.mHeaderName = StringAtOffset( entries[middleIndex].mHeaderNameOffset );
+			outEntry.mFrameworkName = StringAtOffset( entries[middleIndex].mFrameworkNameOffset );
+			outEntry.mValue = StringAtOffset( entries[middleIndex].mValueOffset );
+			return true;
+		}
+		else if( comparison < 0 )
+			highIndex = middleIndex;
+		else
+			lowIndex = middleIndex +1;
+	}
+
+	return false;
+}
+
+} // namespace Carlson
@@ -0,0 +1,88 @@
+//
+//  CNativeHeadersIndex.h
+//  Forge
+//
+//  Created on 2026-10-18.
+//
+//
+
+#pragma once
+
+/*
+	A CNativeHeadersIndex is a precompiled form of a frameworkheaders.hhc
+	file. The .hhc file has to be read character by character and turned into
+	several std::maps full of strings each time Forge starts up. An index is
+	instead mapped into memory as-is and searched right where it lies, so
+	opening it costs next to nothing. Since the pages are read-only and backed
+	by the file, all processes using the same index share its memory.
+
+	File layout (all numbers 32 bits, in the byte order of the machine that
+	wrote it, which Open() checks):
+
+		header:			magic, version, byte order mark, then an entry count
+						and file offset for each TTable.
+		entry tables:	one per TTable, sorted by name in strcmp() order, each
+						entry 4 file offsets: name, header, framework, value.
+						Tables that only map a name to a value point header
+						and framework at an empty string.
+		string pool:	NUL-terminated strings the offsets point into. The file
+						always ends in a NUL.
+*/
+
+#include <map>
+#include <memory>
+#include <string>
+#include <stdint.h>
+
+
+namespace Carlson
+{
+
+class CObjCMethodEntry;
+
+
+class CNativeHeadersIndex
+{
+public:
+	typedef enum
+	{
+		EObjCMethodTable = 0,		//!< ObjC method signature -> header, framework and types.
+		ECFunctionTable,			//!< C function name -> header, framework and types.
+		ECFunctionPointerTable,		//!< C function pointer type name -> header, framework and types.
+		ESynonymToTypeTable,		//!< C type synonym name -> real type name.
+		EConstantToValueTable,		//!< C system constant name -> constant value.
+		ETable_Count
+	} TTable;
+
+	class CEntry
+	{
+	public:
+		const char*		mName;
+		const char*		mHeaderName;
+		const char*		mFrameworkName;
+		const char*		mValue;			//!< Method signature, or the value for ESynonymToTypeTable and EConstantToValueTable.
+	};
+
+	~CNativeHeadersIndex();
+
+	static std::shared_ptr<CNativeHeadersIndex>	Open( const char* inFilePath );	//!< Returns NULL if inFilePath isn't an index, throws if it's a damaged one.
+	static void	Write( const char* inFilePath, const std::map<std::string,CObjCMethodEntry>& inObjCMethods,
+						const std::map<std::string,CObjCMethodEntry>& inCFunctions,
+						const std::map<std::string,CObjCMethodEntry>& inCFunctionPointers,
+						const std::map<std::string,std::string>& inSynonymsToTypes,
+						const std::map<std::string,std::string>& inConstantsToValues );
+
+	bool		FindEntry( TTable inTable, const char* inName, CEntry& outEntry ) const;	//!< Strings in outEntry stay valid as long as the index exists.
+
+protected:
+	CNativeHeadersIndex() : mData(NULL), mDataSize(0), mFileHandle(NULL), mMappingHandle(NULL) {}
+
+	const char*		StringAtOffset( uint32_t inOffset ) const	{ return (inOffset < mDataSize) ? (mData + inOffset) : ""; }	// File ends in a NUL, so any offset inside it is a valid string.
+
+	const char*		mData;
+	size_t			mDataSize;
+	void*			mFileHandle;	// Only used on Windows.
+	void*			mMappingHandle;	// Only used on Windows.
+};
+
+} // namespace Carlson
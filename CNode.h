@@ -34,6 +34,24 @@ namespace Carlson
 class CCodeBlock;
 class CParseTree;
 
+
+// What class a node is, as far as CNodeTransformations are concerned. Only
+//	classes that transformations operate on need their own kind, all others
+//	just report the kind of their superclass, ending up at EOtherNodeKind.
+//	Add a new kind when you write a transformation for a class that has none.
+
+typedef enum
+{
+	EOtherNodeKind = 0,
+	EOperatorNodeKind,			// COperatorNode
+	EObjectPropertyNodeKind,	// CObjectPropertyNode
+	EPutCommandNodeKind,		// CPutCommandNode
+	ECodeBlockNodeKind,			// CCodeBlockNode, but not its subclasses
+	EIfNodeKind,				// CIfNode
+	EWhileLoopNodeKind,			// CWhileLoopNode
+	ENodeKind_Count
+} TNodeKind;
+
 // Abstract root class for things in a parse tree:
 //	These are stupid, and can simply be debug-printed or turned into code, and
 //	that is it.
@@ -44,6 +62,8 @@ public:
 	explicit CNode( CParseTree* inTree ) : mParseTree(inTree)					{};
 	virtual ~CNode() {};
 	
+	virtual TNodeKind	GetNodeKind()	{ return EOtherNodeKind; };
+	
 	virtual void	Simplify();	// For optimizing our parse tree before we actually generate code.
 	virtual void	Visit( std::function<void(CNode*)> visitorBlock );
 	
@@ -52,6 +72,7 @@ public:
 	virtual void	DebugPrint( std::ostream& destStream, size_t indentLevel ) = 0;
 	
 	virtual CParseTree*	GetParseTree()	{ return mParseTree; };
+	void				SetParseTree( CParseTree* inTree )	{ mParseTree = inTree; };	// Only for moving nodes to another tree, see CParseTree::TakeNodesFrom().
 	
 protected:
 	CParseTree*		mParseTree;
@@ -0,0 +1,109 @@
+//
+//  CNodeArena.cpp
+//  Forge
+//
+//  Created on 2026-10-18.
+//
+//
+
+#include "CNodeArena.h"
+#include "CNode.h"
+#include <algorithm>
+#include <stdint.h>
+
+
+namespace Carlson
+{
+
+static char*	AlignPointer( char* inPointer, size_t inAlignment )
+{
+	uintptr_t	address = (uintptr_t) inPointer;
+	return inPointer + ((inAlignment - (address % inAlignment)) % inAlignment);
+}
+
+
+void*	CNodeArena::Allocate( size_t inSize, size_t inAlignment, CNode** *outNodeSlot )
+{
+	std::lock_guard<std::mutex>	lock( mMutex );
+
+	char*	record = AlignPointer( mCurrPos, alignof(CRecord) );
+	char*	node = AlignPointer( record + sizeof(CRecord), inAlignment );
+	if( mCurrPos == NULL || (size_t)((node + inSize) - mCurrPos) > mBytesLeft )
+	{
+		size_t	chunkSize = std::max<size_t>( kChunkSize, sizeof(CRecord) + alignof(CRecord) + inAlignment + inSize );
+		mChunks.push_back( new char[chunkSize] );
+		mCurrPos = mChunks.back();
+		mBytesLeft = chunkSize;
+		record = AlignPointer( mCurrPos, alignof(CRecord) );
+		node = AlignPointer( record + sizeof(CRecord), inAlignment );
+	}
+	mBytesLeft -= (node + inSize) - mCurrPos;
+	mCurrPos = node + inSize;
+
+	CRecord*	newRecord = (CRecord*) record;
+	newRecord->mPrevious = mNewestRecord;
+	newRecord->mNode = NULL;
+	mNewestRecord = newRecord;
+	if( !mOldestRecord )
+		mOldestRecord = newRecord;
+
+	*outNodeSlot = &newRecord->mNode;
+	return node;
+}
+
+
+void	CNodeArena::AdoptNode( CNode* inNode )
+{
+	std::lock_guard<std::mutex>	lock( mMutex );
+	mAdoptedNodes.push_back( inNode );
+}
+
+
+void	CNodeArena::TakeNodesFrom( CNodeArena& inArena )
+{
+	std::lock( mMutex, inArena.mMutex );
+	std::lock_guard<std::mutex>	lock( mMutex, std::adopt_lock );
+	std::lock_guard<std::mutex>	otherLock( inArena.mMutex, std::adopt_lock );
+
+	if( inArena.mOldestRecord )
+	{
+		inArena.mOldestRecord->mPrevious = mNewestRecord;
+		mNewestRecord = inArena.mNewestRecord;
+		if( !mOldestRecord )
+			mOldestRecord = inArena.mOldestRecord;
+	}
+	mChunks.insert( mChunks.begin(), inArena.mChunks.begin(), inArena.mChunks.end() );	// Keep filling our current chunk, it stays last.
+	mAdoptedNodes.insert( mAdoptedNodes.end(), inArena.mAdoptedNodes.begin(), inArena.mAdoptedNodes.end() );
+
+	inArena.mChunks.clear();
+	inArena.mAdoptedNodes.clear();
+	inArena.mCurrPos = NULL;
+	inArena.mBytesLeft = 0;
+	inArena.mNewestRecord = NULL;
+	inArena.mOldestRecord = NULL;
+}
+
+
+void	CNodeArena::Release()
+{
+	std::lock_guard<std::mutex>	lock( mMutex );
+
+	for( CRecord* currRecord = mNewestRecord; currRecord != NULL; currRecord = currRecord->mPrevious )
+	{
+		if( currRecord->mNode )
+			currRecord->mNode->~CNode();
+	}
+	for( CNode* currNode : mAdoptedNodes )
+		delete currNode;
+	for( char* currChunk : mChunks )
+		delete [] currChunk;
+
+	mChunks.clear();
+	mAdoptedNodes.clear();
+	mCurrPos = NULL;
+	mBytesLeft = 0;
+	mNewestRecord = NULL;
+	mOldestRecord = NULL;
+}
+
+} // namespace Carlson
@@ -0,0 +1,75 @@
+//
+//  CNodeArena.h
+//  Forge
+//
+//  Created on 2026-10-18.
+//
+//
+
+#pragma once
+
+/*
+	CNodeArena is where a CParseTree allocates its nodes. Instead of asking
+	the system for each node separately, it hands out consecutive pieces of
+	large chunks of memory, and frees all of them at once when the tree goes
+	away. Since nodes contain strings and vectors, their destructors still
+	have to run. So each allocation is preceded by a little record that
+	remembers the node it holds, and Release() walks those records and calls
+	each node's destructor before freeing the chunks.
+
+	This means nodes can't be deleted individually. A node a parser or
+	optimization no longer needs simply stays around until its tree is
+	destroyed, and nodes no longer delete the nodes they contain.
+
+	Code generation may add nodes from several threads at once (see
+	CParseTree::GenerateCodeInParallel()), so allocating is thread-safe.
+*/
+
+#include <vector>
+#include <mutex>
+#include <stddef.h>
+
+
+namespace Carlson
+{
+
+class CNode;
+
+
+class CNodeArena
+{
+public:
+	enum
+	{
+		kChunkSize = 64 * 1024	// Nodes are mostly well under 256 bytes, so this is a few hundred per chunk.
+	};
+
+	CNodeArena() : mCurrPos(NULL), mBytesLeft(0), mNewestRecord(NULL), mOldestRecord(NULL) {}
+	~CNodeArena()	{ Release(); }
+
+	void*	Allocate( size_t inSize, size_t inAlignment, CNode** *outNodeSlot );	// Construct your node in the returned memory, then store it in *outNodeSlot so Release() destructs it.
+	void	AdoptNode( CNode* inNode );		// Take ownership of a node allocated using new, Release() will delete it.
+	void	TakeNodesFrom( CNodeArena& inArena );	// Moves all of inArena's memory and nodes to us.
+	void	Release();	// Destructs all nodes and frees all memory.
+
+protected:
+	struct CRecord
+	{
+		CRecord*	mPrevious;	// Allocated before us.
+		CNode*		mNode;		// NULL if its constructor threw.
+	};
+
+	std::mutex				mMutex;
+	std::vector<char*>		mChunks;
+	char*					mCurrPos;		// Next free byte in the newest chunk.
+	size_t					mBytesLeft;		// Free bytes after mCurrPos.
+	CRecord*				mNewestRecord;
+	CRecord*				mOldestRecord;
+	std::vector<CNode*>		mAdoptedNodes;
+
+private:
+	CNodeArena( const CNodeArena& ) = delete;
+	CNodeArena&	operator =( const CNodeArena& ) = delete;
+};
+
+} // namespace Carlson
@@ -7,24 +7,39 @@
 //
 
 #include "CNodeTransformation.h"
+#include "CParseTree.h"
 
 
 namespace Carlson
 {
 
-std::vector<CNodeTransformationBase*>		sNodeTransformations;
+std::vector<CNodeTransformationBase*>		sNodeTransformations[ENodeKind_Count];
+
+
+void	CNodeTransformationBase::Register( CNodeTransformationBase* inTransformation )
+{
+	sNodeTransformations[inTransformation->GetNodeKind()].push_back( inTransformation );
+}
 
 
 CNode*	CNodeTransformationBase::Apply( CNode* inNode )
 {
-	CNode	*	currNode = inNode;
-	std::vector<CNodeTransformationBase*>::const_iterator	itty;
-	for( itty = sNodeTransformations.begin(); itty != sNodeTransformations.end(); itty++ )
+	CNode										*	currNode = inNode;
+	const std::vector<CNodeTransformationBase*>	*	transformations = &sNodeTransformations[currNode->GetNodeKind()];
+	size_t											x = 0;
+	while( x < transformations->size() )
 	{
-		CNode	*	originalNode = currNode;
-		currNode = (*itty)->Simplify_External( originalNode );
-		if( currNode != originalNode )
-			delete originalNode;
+		CNode	*	newNode = (*transformations)[x]->Simplify_External( currNode );	// A replaced node stays in its parse tree's arena until the tree goes away.
+		if( newNode != currNode )	// Replaced? Run the new node through the transformations for its kind, too, in case it can be simplified further.
+		{
+			if( currNode->GetParseTree() )
+				currNode->GetParseTree()->NodeWasChanged( newNode );
+			currNode = newNode;
+			transformations = &sNodeTransformations[currNode->GetNodeKind()];
+			x = 0;
+		}
+		else
+			x++;
 	}
 	
 	return currNode;
@@ -26,7 +26,15 @@
 	things to do. So instead, the container of a node calls
 	CNodeTransformationBase::Apply and then gets back the same object (in which
 	case the optimization didn't change the object's type) or a new object
-	(in which it is responsible for deleting the original object).
+	(in which case it replaces its reference to the original object with it.
+	The original object stays around until its CParseTree is destroyed).
+	
+	Transformations are registered for the TNodeKind of the class they operate
+	on, so Apply only calls those that could possibly match the given node and
+	nodes that no transformation is interested in cost next to nothing. When
+	a transformation replaces a node, the replacement goes through the
+	transformations for its kind again, so e.g. a concatenation that got
+	folded into a constant can then be folded into its neighbours.
 */
 
 #include "CNode.h"
@@ -44,18 +52,21 @@ class CNodeTransformationBase
 public:
 	virtual ~CNodeTransformationBase() {};
 
-	virtual CNode*	Simplify_External( CNode* inNode ) = 0;	// If it doesn't return 'this', caller will delete 'this' and use the optimized value.
+	virtual TNodeKind	GetNodeKind() = 0;							// Kind of node we want to be called for.
+	virtual CNode*		Simplify_External( CNode* inNode ) = 0;	// If it doesn't return 'this', caller will use the optimized value instead.
 	
-	static CNode*	Apply( CNode* inNode );					// If it doesn't return 'this', caller must delete either 'this' and use the optimized value.
+	static void		Register( CNodeTransformationBase* inTransformation );	// Takes over ownership.
+	static CNode*	Apply( CNode* inNode );					// If it doesn't return 'this', caller must use the optimized value instead.
 };
 
 
-extern std::vector<CNodeTransformationBase*>		sNodeTransformations;
+extern std::vector<CNodeTransformationBase*>		sNodeTransformations[ENodeKind_Count];
 
 
 /*
 	CNodeTransformation is templated based on the class of the node to operate
 	on. Call Initialize some time at startup to register, override Simplify().
+	The class must declare a kNodeKind and return it from GetNodeKind().
 */
 
 template <class c_node_subclass>
@@ -64,19 +75,16 @@ class CNodeTransformation : public CNodeTransformationBase
 public:
 	virtual ~CNodeTransformation() {};
 	
-	virtual CNode*	Simplify( c_node_subclass* inNode ) = 0;	// If it doesn't return 'this', caller will delete 'this' and use the optimized value.
+	virtual CNode*	Simplify( c_node_subclass* inNode ) = 0;	// If it doesn't return 'this', caller will use the optimized value instead.
+	
+	virtual TNodeKind			GetNodeKind()	{ return c_node_subclass::kNodeKind; };
 	
-	virtual CNode*				Simplify_External( CNode* inNode )			// If it doesn't return 'this', caller will delete 'this' and use the optimized value.
+	virtual CNode*				Simplify_External( CNode* inNode )			// If it doesn't return 'this', caller will use the optimized value instead.
 	{
-		c_node_subclass * subclassPtr = dynamic_cast<c_node_subclass*>(inNode);
-		
-		if( subclassPtr )
-			return Simplify( subclassPtr );
-		
-		return inNode;
+		return Simplify( static_cast<c_node_subclass*>(inNode) );	// Apply() only calls us for nodes of our kind.
 	}
 	
-	//static void		Initialize()	{ sNodeTransformations.push_back( new MYCLASSNAME ); };
+	//static void		Initialize()	{ Register( new MYCLASSNAME ); };
 };
 
 
@@ -20,7 +20,7 @@ namespace Carlson
 
 CValueNode*	CObjectPropertyNode::Copy()
 {
-	CObjectPropertyNode	*	nodeCopy = new CObjectPropertyNode( mParseTree, mSymbolName, mLineNum );
+	CObjectPropertyNode	*	nodeCopy = mParseTree->NewNode<CObjectPropertyNode>( mSymbolName, mLineNum );
 	
 	std::vector<CValueNode*>::const_iterator	itty;
 	for( itty = mParams.begin(); itty != mParams.end(); itty++ )
@@ -65,7 +65,7 @@ void	CObjectPropertyNode::Simplify()
 	{
 		CValueNode	*	originalNode = *itty;
 		originalNode->Simplify();	// Give subnodes a chance to apply transformations first. Might expose simpler sub-nodes we can then simplify.
-		CNode* newNode = CNodeTransformationBase::Apply( originalNode );	// Returns either originalNode, or a totally new object, in which case we delete the old one.
+		CNode* newNode = CNodeTransformationBase::Apply( originalNode );	// Returns either originalNode, or a totally new object, which replaces it.
 		if( newNode != originalNode )
 		{
 			assert( dynamic_cast<CValueNode*>(newNode) != NULL );
@@ -106,8 +106,8 @@ CArrayValueNode *	CObjectPropertyNode::CopyPropertyNameValue()
 		return (CArrayValueNode*) mParams[1]->Copy();
 	else
 	{
-		CArrayValueNode * keyPath = new CArrayValueNode(mParseTree,mLineNum);
-		keyPath->AddItem( new CStringValueNode( mParseTree, mSymbolName, mLineNum ) );
+		CArrayValueNode * keyPath = mParseTree->NewNode<CArrayValueNode>( mLineNum);
+		keyPath->AddItem( mParseTree->NewNode<CStringValueNode>( mSymbolName, mLineNum ) );
 		return keyPath;
 	}
 }
@@ -26,6 +26,9 @@ public:
 		: CValueNode(inTree,inLineNum), mSymbolName(inSymbolName) {};
 	virtual ~CObjectPropertyNode() {};
 	
+	static const TNodeKind	kNodeKind = EObjectPropertyNodeKind;
+	virtual TNodeKind	GetNodeKind()									{ return kNodeKind; };
+	
 	virtual void		GetSymbolName( std::string& outSymbolName )		{ outSymbolName = mSymbolName; };
 	virtual size_t		GetParamCount()									{ return mParams.size(); };
 	virtual CValueNode*	GetParamAtIndex( size_t idx )					{ return mParams[idx]; };
@@ -33,7 +36,7 @@ public:
 	virtual void		AddParam( CValueNode* val );
 
 	CArrayValueNode *	CopyPropertyNameValue();
-	void				SetPropertyNameValue( CArrayValueNode * pn )	{ mSymbolName = ""; if( mParams.size() > 1 ) { delete mParams[1]; mParams[1] = pn; } else AddParam(pn); }
+	void				SetPropertyNameValue( CArrayValueNode * pn )	{ mSymbolName = ""; if( mParams.size() > 1 ) { mParams[1] = pn; } else AddParam(pn); }
 	
 	virtual CValueNode*	Copy();
 	
@@ -18,6 +18,9 @@
 namespace Carlson
 {
 
+std::atomic<bool>	COperatorNode::sShortCircuitBooleanOperators( false );
+
+
 void	COperatorNode::DebugPrint( std::ostream& destStream, size_t indentLevel )
 {
 	INDENT_PREPARE(indentLevel);
@@ -65,7 +68,7 @@ void	COperatorNode::SetParamAtIndex( size_t idx, CValueNode* val )
 
 CValueNode*	COperatorNode::Copy()
 {
-	COperatorNode	*	nodeCopy = new COperatorNode( mParseTree, mInstructionID, mLineNum );
+	COperatorNode	*	nodeCopy = mParseTree->NewNode<COperatorNode>( mInstructionID, mLineNum );
 	nodeCopy->SetInstructionParams( mInstructionParam1, mInstructionParam2 );
 	
 	std::vector<CValueNode*>::const_iterator	itty;
@@ -90,7 +93,7 @@ void	COperatorNode::Simplify()
 		if( originalNode == NULL )
 			DebugPrint( std::cerr, 0 );
 		originalNode->Simplify();	// Give subnodes a chance to apply transformations first. Might expose simpler sub-nodes we can then simplify.
-		CNode* newNode = CNodeTransformationBase::Apply( originalNode );	// Returns either originalNode, or a totally new object, in which case we delete the old one.
+		CNode* newNode = CNodeTransformationBase::Apply( originalNode );	// Returns either originalNode, or a totally new object, which replaces it.
 		if( newNode != originalNode )
 		{
 			assert( dynamic_cast<CValueNode*>(newNode) != NULL );
@@ -102,6 +105,12 @@ void	COperatorNode::Simplify()
 
 void	COperatorNode::GenerateCode( CCodeBlock* inCodeBlock )
 {
+	if( sShortCircuitBooleanOperators && CanShortCircuit() )
+	{
+		GenerateShortCircuitCode( inCodeBlock );
+		return;
+	}
+	
 	std::vector<CValueNode*>::iterator itty;
 	
 	// Push all params on stack:
@@ -112,6 +121,71 @@ void	COperatorNode::GenerateCode( CCodeBlock* inCodeBlock )
 }
 
 
+bool	COperatorNode::CanShortCircuit()
+{
+	return( (mInstructionID == AND_INSTR || mInstructionID == OR_INSTR) && mParams.size() == 2 );
+}
+
+
+/*
+	"a and b" becomes:				"a or b" becomes:
+		push a							push a
+		if FALSE, jump to F				if FALSE, jump to R
+		push b							push true
+		if FALSE, jump to F				jump to E
+		push true					R:	push b
+		jump to E						if FALSE, jump to F
+	F:	push false						push true
+	E:									jump to E
+								F:	push false
+								E:
+	
+	The jumps check the values just like AND_INSTR and OR_INSTR would, so
+	the result is still a boolean, and a value that isn't is still an error.
+*/
+
+void	COperatorNode::GenerateShortCircuitCode( CCodeBlock* inCodeBlock )
+{
+	bool					isAnd = (mInstructionID == AND_INSTR);
+	std::vector<int32_t>	jumpToFalseOffsets;
+	std::vector<int32_t>	jumpToEndOffsets;
+	
+	mParams[0]->GenerateCode( inCodeBlock );
+	
+	int32_t	firstCompareOffset = (int32_t) inCodeBlock->GetNextInstructionOffset();
+	inCodeBlock->GenerateJumpRelativeIfFalseInstruction( 0 );
+	if( isAnd )
+		jumpToFalseOffsets.push_back( firstCompareOffset );
+	else
+	{
+		inCodeBlock->GeneratePushBoolInstruction( true );
+		jumpToEndOffsets.push_back( (int32_t) inCodeBlock->GetNextInstructionOffset() );
+		inCodeBlock->GenerateJumpRelativeInstruction( 0 );
+		
+		int32_t	rightSideOffset = (int32_t) inCodeBlock->GetNextInstructionOffset();
+		inCodeBlock->SetJumpAddressOfInstructionAtIndex( firstCompareOffset, rightSideOffset -firstCompareOffset );
+	}
+	
+	mParams[1]->GenerateCode( inCodeBlock );
+	
+	jumpToFalseOffsets.push_back( (int32_t) inCodeBlock->GetNextInstructionOffset() );
+	inCodeBlock->GenerateJumpRelativeIfFalseInstruction( 0 );
+	inCodeBlock->GeneratePushBoolInstruction( true );
+	jumpToEndOffsets.push_back( (int32_t) inCodeBlock->GetNextInstructionOffset() );
+	inCodeBlock->GenerateJumpRelativeInstruction( 0 );
+	
+	// Retroactively fill in the addresses of the "push false" and of the end in the jump instructions:
+	int32_t	pushFalseOffset = (int32_t) inCodeBlock->GetNextInstructionOffset();
+	inCodeBlock->GeneratePushBoolInstruction( false );
+	int32_t	endOffset = (int32_t) inCodeBlock->GetNextInstructionOffset();
+	
+	for( int32_t currJumpOffset : jumpToFalseOffsets )
+		inCodeBlock->SetJumpAddressOfInstructionAtIndex( currJumpOffset, pushFalseOffset -currJumpOffset );
+	for( int32_t currJumpOffset : jumpToEndOffsets )
+		inCodeBlock->SetJumpAddressOfInstructionAtIndex( currJumpOffset, endOffset -currJumpOffset );
+}
+
+
 void	COperatorNode::Visit( std::function<void(CNode*)> visitorBlock )
 {
 	for( auto currParam : mParams )
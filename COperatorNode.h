@@ -11,6 +11,7 @@
 
 #include "CValueNode.h"
 #include <vector>
+#include <atomic>
 extern "C" {
 #include "LEOInterpreter.h"
 }
@@ -28,6 +29,9 @@ public:
 		mInstructionParam1(0), mInstructionParam2(0) {};
 	virtual ~COperatorNode() {};
 	
+	static const TNodeKind	kNodeKind = EOperatorNodeKind;
+	virtual TNodeKind	GetNodeKind()									{ return kNodeKind; };
+	
 	virtual size_t		GetParamCount()									{ return mParams.size(); };
 	virtual CValueNode*	GetParamAtIndex( size_t idx )					{ return mParams[idx]; };
 	virtual void		SetParamAtIndex( size_t idx, CValueNode* val );	// Doesn't free previous value. Takes over ownership of new one.
@@ -45,8 +49,17 @@ public:
 	virtual void		SetInstructionID( LEOInstructionID inID )					{ mInstructionID = inID; };
 	virtual LEOInstructionID	GetInstructionID()									{ return mInstructionID; };
 	virtual void		SetInstructionParams( uint16_t inParam1, uint32_t inParam2 ){ mInstructionParam1 = inParam1; mInstructionParam2 = inParam2; };
+	
+	virtual bool		CanShortCircuit();	// Is this an "and" or "or" whose right side needs no evaluating if the left one decides the result?
+	
+	static void			SetShortCircuitBooleanOperators( bool inShortCircuit )	{ sShortCircuitBooleanOperators = inShortCircuit; };	// Off by default, as the right side's handler calls may have side effects scripts rely on. Set before generating code.
+	static bool			GetShortCircuitBooleanOperators()						{ return sShortCircuitBooleanOperators; };
 
 protected:
+	virtual void		GenerateShortCircuitCode( CCodeBlock* inCodeBlock );
+	
+	static std::atomic<bool>	sShortCircuitBooleanOperators;	// Atomic as handlers may be generated on several threads while a host changes it.
+	
 	LEOInstructionID			mInstructionID;
 	uint16_t					mInstructionParam1;
 	uint32_t					mInstructionParam2;
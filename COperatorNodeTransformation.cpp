@@ -14,13 +14,10 @@ namespace Carlson
 
 CNode*	COperatorNodeTransformation::Simplify_External( CNode* inNode )
 {
-	COperatorNode * subclassPtr = dynamic_cast<COperatorNode*>(inNode);
+	COperatorNode * subclassPtr = static_cast<COperatorNode*>(inNode);	// Apply() only calls us for operator nodes.
 	
-	if( subclassPtr )
-	{
-		if( subclassPtr->GetInstructionID() == GetInstructionID() )
-			return Simplify( subclassPtr );
-	}
+	if( subclassPtr->GetInstructionID() == GetInstructionID() )
+		return Simplify( subclassPtr );
 	
 	return inNode;
 }
@@ -23,9 +23,9 @@ public:
 	
 	virtual LEOInstructionID	GetInstructionID()	{ return 0; };
 	
-	virtual CNode*				Simplify_External( CNode* inNode );	// If it doesn't return 'this', caller will delete 'this' and use the optimized value.
+	virtual CNode*				Simplify_External( CNode* inNode );	// If it doesn't return 'this', caller will use the optimized value instead.
 
-	static void		Initialize()	{ /*sNodeTransformations.push_back( new CLASS_NAME );*/ };
+	static void		Initialize()	{ /*Register( new CLASS_NAME );*/ };
 };
 
 
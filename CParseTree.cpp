@@ -9,8 +9,14 @@
 
 #include "CParseTree.h"
 #include "CNodeTransformation.h"
+#include "CParseTreePass.h"
 #include "CFunctionDefinitionNode.h"
+#include "CCodeBlock.h"
 #include <string>
+#include <algorithm>
+#include <thread>
+#include <exception>
+#include <chrono>
 #include <assert.h>
 
 
@@ -19,7 +25,7 @@ namespace Carlson
 
 
 CParseTree::CParseTree()
-	: mUniqueIdentifierSeed(0)
+	: mUniqueIdentifierSeed(0), mChangeCount(0), mKeepLineMarkersInDeadCode(false)
 {
 
 }
@@ -27,13 +33,7 @@ CParseTree::CParseTree()
 
 CParseTree::~CParseTree()
 {
-	std::deque<CNode*>::iterator itty;
-	
-	for( itty = mNodes.begin(); itty != mNodes.end(); itty++ )
-	{
-		delete *itty;
-		*itty = NULL;
-	}
+	// mNodeArena destructs all our nodes.
 }
 
 
@@ -44,7 +44,65 @@ void	CParseTree::AddFunctionDefinitionNode( CFunctionDefinitionNode* inNode )
 }
 
 
+void	CParseTree::TakeNodesFrom( CParseTree& inTree )
+{
+	for( CNode* currNode : inTree.mNodes )
+	{
+		currNode->Visit( [this]( CNode* inNode ){ inNode->SetParseTree( this ); } );
+		mNodes.push_back( currNode );
+	}
+	inTree.mNodes.clear();
+	mNodeArena.TakeNodesFrom( inTree.mNodeArena );
+	
+	for( auto currFunction : inTree.mFunctionNodes )
+		mFunctionNodes[currFunction.first] = currFunction.second;
+	inTree.mFunctionNodes.clear();
+	
+	mGlobals.insert( inTree.mGlobals.begin(), inTree.mGlobals.end() );
+	mUniqueIdentifierSeed = std::max( mUniqueIdentifierSeed, inTree.mUniqueIdentifierSeed );
+	if( !mGrammar )
+		mGrammar = inTree.mGrammar;
+	mChangeCount++;
+}
+
+
+enum
+{
+	kMaxSimplifyRounds = 8	// If passes keep undoing each other's changes, stop after this many rounds instead of hanging.
+};
+
+
 void	CParseTree::Simplify()
+{
+	const std::vector<CParseTreePass*>&	passes = CParseTreePass::GetPasses();
+	
+	// Usually one round is all it takes. Only if a pass changes something an
+	//	earlier pass could optimize further does that earlier pass run again:
+	for( size_t x = 0; x < kMaxSimplifyRounds; x++ )
+	{
+		bool	ranAPass = false;
+		for( CParseTreePass* currPass : passes )
+		{
+			CParseTreePassRecord&	record = mPassRecords[currPass->GetName()];
+			if( record.mNumRuns > 0 && record.mChangeCountAfterLastRun == mChangeCount )
+				continue;	// Nothing changed since it last ran.
+			
+			size_t	changeCountBefore = mChangeCount;
+			std::chrono::steady_clock::time_point	startTime = std::chrono::steady_clock::now();
+			currPass->Run( *this );
+			record.mSeconds += std::chrono::duration<double>( std::chrono::steady_clock::now() - startTime ).count();
+			record.mNumRuns++;
+			record.mNumNodesChanged += mChangeCount - changeCountBefore;
+			record.mChangeCountAfterLastRun = mChangeCount;
+			ranAPass = true;
+		}
+		if( !ranAPass )
+			break;
+	}
+}
+
+
+void	CParseTree::SimplifyTopLevelNodes()
 {
 	std::deque<CNode*>::iterator itty;
 	
@@ -52,13 +110,27 @@ void	CParseTree::Simplify()
 	{
 		CNode	*	originalNode = *itty;
 		originalNode->Simplify();	// Give subnodes a chance to apply transformations first. Might expose simpler sub-nodes we can then simplify.
-		CNode* newNode = CNodeTransformationBase::Apply( originalNode );	// Returns either originalNode, or a totally new object, in which case we delete the old one.
+		CNode* newNode = CNodeTransformationBase::Apply( originalNode );	// Returns either originalNode, or a totally new object, which replaces it.
 		if( newNode != originalNode )
 			*itty = newNode;
 	}
 }
 
 
+void	CParseTree::PrintPassStatistics( std::ostream& destStream )
+{
+	for( CParseTreePass* currPass : CParseTreePass::GetPasses() )
+	{
+		std::map<std::string,CParseTreePassRecord>::const_iterator	foundRecord = mPassRecords.find( currPass->GetName() );
+		if( foundRecord == mPassRecords.end() )
+			continue;
+		destStream << currPass->GetName() << ": " << foundRecord->second.mNumRuns << " run(s), "
+					<< foundRecord->second.mNumNodesChanged << " node(s) changed, "
+					<< (foundRecord->second.mSeconds * 1000.0) << " ms" << std::endl;
+	}
+}
+
+
 void	CParseTree::Visit( std::function<void(CNode*)> visitorBlock )
 {
 	for( auto currNode : mNodes )
@@ -79,6 +151,72 @@ void	CParseTree::GenerateCode( CCodeBlock* inCodeBlock )
 }
 
 
+enum
+{
+	kMinParallelCodeGenHandlers = 256	// Below this many handlers per thread, starting a thread takes longer than generating their code.
+};
+
+
+void	CParseTree::GenerateCodeInParallel( CCodeBlock* inCodeBlock, size_t inNumThreads )
+{
+	size_t	numThreads = inNumThreads;
+	if( numThreads == 0 )
+		numThreads = std::min<size_t>( std::max<unsigned>( std::thread::hardware_concurrency(), 1 ), mNodes.size() / kMinParallelCodeGenHandlers );
+	numThreads = std::min( numThreads, mNodes.size() );
+	
+	// Each builder holds exactly one handler, so only do this if that's all we have:
+	bool	allNodesAreHandlers = true;
+	for( CNode* currNode : mNodes )
+	{
+		if( dynamic_cast<CFunctionDefinitionNode*>( currNode ) == NULL )
+		{
+			allNodesAreHandlers = false;
+			break;
+		}
+	}
+	if( numThreads < 2 || !allNodesAreHandlers )
+	{
+		GenerateCode( inCodeBlock );
+		return;
+	}
+	
+	// Give each thread a run of handlers to generate into detached builders, the first one on this thread:
+	std::vector<CHandlerBuilder>		builders( mNodes.size() );
+	std::vector<std::exception_ptr>		errors( mNodes.size() );	// Only the first error in each thread's run is set, it stops there.
+	uint16_t							fileID = inCodeBlock->GetFileID();
+	auto	generateNodes = [this, &builders, &errors, fileID]( size_t inStartNode, size_t inEndNode )
+	{
+		for( size_t x = inStartNode; x < inEndNode; x++ )
+		{
+			try
+			{
+				CCodeBlock	block( &builders[x], fileID );
+				mNodes[x]->GenerateCode( &block );
+			}
+			catch( ... )
+			{
+				errors[x] = std::current_exception();
+				break;
+			}
+		}
+	};
+	std::vector<std::thread>	workers;
+	for( size_t x = 1; x < numThreads; x++ )
+		workers.push_back( std::thread( generateNodes, (mNodes.size() * x) / numThreads, (mNodes.size() * (x +1)) / numThreads ) );
+	generateNodes( 0, mNodes.size() / numThreads );
+	for( std::thread& currWorker : workers )
+		currWorker.join();
+	
+	// Now add the handlers to the script in order, stopping at the first error like GenerateCode() would:
+	for( size_t x = 0; x < builders.size(); x++ )
+	{
+		if( errors[x] )
+			std::rethrow_exception( errors[x] );
+		inCodeBlock->AddHandlerFromBuilder( builders[x] );
+	}
+}
+
+
 void	CParseTree::DebugPrint( std::ostream& destStream, size_t indentLevel )
 {
 	INDENT_PREPARE(indentLevel);
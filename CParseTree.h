@@ -11,9 +11,13 @@
 
 #include "CNode.h"
 #include "CVariableEntry.h"
+#include "CNodeArena.h"
 #include <deque>
 #include <map>
 #include <string>
+#include <utility>
+#include <new>
+#include <memory>
 
 
 namespace Carlson
@@ -21,6 +25,20 @@ namespace Carlson
 
 class CParseTree;
 class CFunctionDefinitionNode;
+class CParserGrammar;
+
+
+// What Simplify() remembers about running one CParseTreePass on a tree:
+class CParseTreePassRecord
+{
+public:
+	CParseTreePassRecord() : mNumRuns(0), mNumNodesChanged(0), mSeconds(0.0), mChangeCountAfterLastRun(0) {};
+	
+	size_t		mNumRuns;
+	size_t		mNumNodesChanged;
+	double		mSeconds;					// Wall time of all runs together.
+	size_t		mChangeCountAfterLastRun;	// If the tree's change count is still this, running the pass again would find nothing to do.
+};
 
 
 class CParseTree
@@ -29,26 +47,71 @@ public:
 	CParseTree();
 	virtual ~CParseTree();
 	
-	void				AddNode( CNode* inNode )			{ mNodes.push_back( inNode ); };
+	template<class NodeType, class ...Args>
+	NodeType*			NewNode( Args&& ...inArgs )			//!< Creates a node owned by this tree, passing this tree and inArgs to its constructor. It is destroyed along with the tree.
+	{
+		CNode**		nodeSlot = NULL;
+		void*		storage = mNodeArena.Allocate( sizeof(NodeType), alignof(NodeType), &nodeSlot );
+		NodeType*	newNode = new (storage) NodeType( this, std::forward<Args>(inArgs)... );
+		*nodeSlot = newNode;
+		return newNode;
+	}
+	template<class NodeType, class ...Args>
+	static NodeType*	NewNodeIn( CParseTree* inTree, Args&& ...inArgs )	//!< Like NewNode(), but if inTree is NULL, allocates the node using new. For copying the constants in CParserGrammar, which aren't in any tree.
+	{
+		if( inTree )
+			return inTree->NewNode<NodeType>( std::forward<Args>(inArgs)... );
+		return new NodeType( NULL, std::forward<Args>(inArgs)... );
+	}
+	template<class NodeType>
+	NodeType*			AdoptNode( NodeType* inNode )		//!< Take ownership of a node made by NewNodeIn() with a NULL tree, e.g. a copy of a CParserGrammar constant. Nodes that already belong to a tree are left alone.
+	{
+		if( inNode->GetParseTree() == NULL )
+		{
+			inNode->SetParseTree( this );
+			mNodeArena.AdoptNode( inNode );
+		}
+		return inNode;
+	}
+	
+	void				AddNode( CNode* inNode )			{ mNodes.push_back( inNode ); mChangeCount++; };	//!< Adds a top-level node, e.g. a handler.
 	void				AddFunctionDefinitionNode( CFunctionDefinitionNode* inNode );	//!< Calls AddNode() eventually.
 	void				NodeWasAdded( CNode* inNode )		{ };
+	void				NodeWasChanged( CNode* inNode )		{ mChangeCount++; };	//!< Called by CParseTreePasses and CNodeTransformations when they replace or modify a node.
+	void				TakeNodesFrom( CParseTree& inTree );	//!< Moves all of inTree's nodes to the end of ours, and takes ownership of them.
 	
 	std::map<std::string,CVariableEntry>&	GetGlobals()	{ return mGlobals; };
 	CFunctionDefinitionNode*				GetFunctionDefinition( const std::string& inName )	{ std::map<std::string,CFunctionDefinitionNode*>::iterator found = mFunctionNodes.find(inName); if( found == mFunctionNodes.end() ) return NULL; else return found->second; }
 	
-	virtual void		Simplify();
+	virtual void		Simplify();	//!< Runs all CParseTreePasses in order, skipping those that already ran and would find nothing new to do.
+	void				SimplifyTopLevelNodes();	//!< What the "simplify" pass does: Simplify() each top-level node and apply the CNodeTransformations.
+	const std::map<std::string,CParseTreePassRecord>&	GetPassRecords()	{ return mPassRecords; };	//!< Keyed by pass name. Only contains passes that ran.
+	void				PrintPassStatistics( std::ostream& destStream );
+	bool				GetKeepLineMarkersInDeadCode()						{ return mKeepLineMarkersInDeadCode; };
+	void				SetKeepLineMarkersInDeadCode( bool inKeepLineMarkers )	{ mKeepLineMarkersInDeadCode = inKeepLineMarkers; };	//!< TRUE if code removed by Simplify() as unreachable should leave its line markers behind, e.g. for a debugger. Set it before calling Simplify().
 	void				Visit( std::function<void(CNode*)> visitorBlock );
 	virtual void		GenerateCode( CCodeBlock* inCodeBlock );
+	void				GenerateCodeInParallel( CCodeBlock* inCodeBlock, size_t inNumThreads = 0 );	//!< Same result as GenerateCode(), but generates handlers on several threads. 0 picks the number of threads based on CPU and handler count.
 	
 	virtual void		DebugPrint( std::ostream& destStream, size_t indentLevel );
 	
 	virtual std::string	GetUniqueIdentifierBasedOn( std::string inBaseIdentifier );	// Unique among other identifiers returned by this with the same base identifier.
+	const CParserGrammar*	GetGrammar()	{ return mGrammar.get(); };	//!< Grammar the parser used, or NULL if no parser filled this tree. Lets nodes look up built-ins while generating code without taking the grammar lock.
+	void				SetGrammar( std::shared_ptr<const CParserGrammar> inGrammar )	{ mGrammar = inGrammar; };
+	
+	unsigned long long	GetUniqueIdentifierSeed()								{ return mUniqueIdentifierSeed; };
+	void				SetUniqueIdentifierSeed( unsigned long long inSeed )	{ mUniqueIdentifierSeed = inSeed; };	// Lets trees that will be merged using TakeNodesFrom() generate different identifiers.
 
 protected:
-	std::deque<CNode*>								mNodes;	// The tree owns any nodes you add and will delete them when it goes out of scope.
+	CNodeArena										mNodeArena;	// Owns all nodes created by NewNode(), no matter whether they're added. Declared first so it's destructed last.
+	std::deque<CNode*>								mNodes;	// Top-level nodes, in order.
 	std::map<std::string,CFunctionDefinitionNode*>	mFunctionNodes;	// Some nodes in mNodes get added to this list too, so we can find functions.
 	std::map<std::string,CVariableEntry>			mGlobals;
 	unsigned long long								mUniqueIdentifierSeed;
+	size_t											mChangeCount;	// Incremented whenever nodes get added or changed, so Simplify() can tell whether a pass could find anything new.
+	std::map<std::string,CParseTreePassRecord>		mPassRecords;
+	bool											mKeepLineMarkersInDeadCode;
+	std::shared_ptr<const CParserGrammar>			mGrammar;	// Kept alive for as long as our nodes may look things up in it.
 };
 
 }
@@ -0,0 +1,75 @@
+//
+//  CParseTreePass.cpp
+//  Forge
+//
+//  Created on 2026-10-18.
+//
+//
+
+#include "CParseTreePass.h"
+#include "CParseTree.h"
+#include <set>
+#include <algorithm>
+#include <stdexcept>
+
+
+namespace Carlson
+{
+
+static std::vector<CParseTreePass*>&	RegisteredPasses()
+{
+	static std::vector<CParseTreePass*>	sPasses( 1, new CSimplifyPass );
+	return sPasses;
+}
+
+
+void	CParseTreePass::Register( CParseTreePass* inPass )
+{
+	std::vector<CParseTreePass*>	unscheduledPasses( RegisteredPasses() );
+	unscheduledPasses.push_back( inPass );
+
+	std::set<std::string>	registeredNames;
+	for( CParseTreePass* currPass : unscheduledPasses )
+		registeredNames.insert( currPass->GetName() );
+
+	// Each time, pick the first pass (in the order they were registered) whose dependencies have all been scheduled:
+	std::vector<CParseTreePass*>	sortedPasses;
+	std::set<std::string>			scheduledNames;
+	while( !unscheduledPasses.empty() )
+	{
+		std::vector<CParseTreePass*>::iterator	readyPass = std::find_if( unscheduledPasses.begin(), unscheduledPasses.end(), [&]( CParseTreePass* inCandidate )
+		{
+			for( const std::string& currDependency : inCandidate->GetDependencies() )
+			{
+				if( registeredNames.count( currDependency ) != 0 && scheduledNames.count( currDependency ) == 0 )
+					return false;	// Dependencies that aren't registered (e.g. because optimizations are off) have nothing to wait for.
+			}
+			return true;
+		} );
+		if( readyPass == unscheduledPasses.end() )
+		{
+			std::string	errMsg = std::string("Optimizer pass \"") + inPass->GetName() + "\" would create a dependency cycle.";
+			delete inPass;
+			throw std::runtime_error( errMsg );
+		}
+		scheduledNames.insert( (*readyPass)->GetName() );
+		sortedPasses.push_back( *readyPass );
+		unscheduledPasses.erase( readyPass );
+	}
+
+	RegisteredPasses().swap( sortedPasses );
+}
+
+
+const std::vector<CParseTreePass*>&	CParseTreePass::GetPasses()
+{
+	return RegisteredPasses();
+}
+
+
+void	CSimplifyPass::Run( CParseTree& inTree )
+{
+	inTree.SimplifyTopLevelNodes();
+}
+
+} // namespace Carlson
@@ -0,0 +1,57 @@
+//
+//  CParseTreePass.h
+//  Forge
+//
+//  Created on 2026-10-18.
+//
+//
+
+#pragma once
+
+/*
+	A CParseTreePass is one step of optimizing a CParseTree before we generate
+	code for it. CParseTree::Simplify() runs all registered passes, each one
+	after the passes it depends on, and remembers for each tree which passes
+	ran, how long they took and how many nodes they changed.
+
+	A pass is expected to leave the tree so that running it again right away
+	wouldn't change anything. So if a tree hasn't changed since a pass last
+	ran on it, Simplify() skips that pass. This means calling Simplify()
+	several times on the same tree only costs anything the first time.
+
+	The "simplify" pass, which calls each node's Simplify() and applies the
+	CNodeTransformations to it, is always registered.
+*/
+
+#include <vector>
+#include <string>
+
+
+namespace Carlson
+{
+
+class CParseTree;
+
+
+class CParseTreePass
+{
+public:
+	virtual ~CParseTreePass() {};
+
+	virtual const char*					GetName() = 0;
+	virtual std::vector<std::string>	GetDependencies()	{ return std::vector<std::string>(); };	// Names of the passes that need to run before this one.
+	virtual void						Run( CParseTree& inTree ) = 0;	// Call inTree.NodeWasChanged() for every node you replace or modify.
+
+	static void									Register( CParseTreePass* inPass );	// Takes over ownership. Call at startup, like CNodeTransformation's Initialize().
+	static const std::vector<CParseTreePass*>&	GetPasses();	// In the order they need to run in.
+};
+
+
+class CSimplifyPass : public CParseTreePass
+{
+public:
+	virtual const char*		GetName()	{ return "simplify"; };
+	virtual void			Run( CParseTree& inTree );
+};
+
+} // namespace Carlson
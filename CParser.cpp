@@ -41,6 +41,7 @@
 #include "CDownloadCommandNode.h"
 #include "CParseErrorCommandNode.h"
 #include "CForgeExceptions.h"
+#include "CIncludeCache.h"
 #include "ForgeTypes.h"
 
 extern "C" {
@@ -54,6 +55,9 @@ extern "C" {
 #include <stdexcept>
 #include <string>
 #include <fstream>
+#include <algorithm>
+#include <mutex>
+#include <thread>
 
 
 using namespace Carlson;
@@ -79,16 +83,18 @@ namespace Carlson
 {
 
 // Static ivars:
-int										CVariableEntry::mTempCounterSeed = 0;	// Counter we use for generating unique temp variable names.
+std::atomic<int>						CVariableEntry::mTempCounterSeed( 0 );	// Counter we use for generating unique temp variable names.
 std::map<std::string,CObjCMethodEntry>	CParser::sObjCMethodTable;				// Table of ObjC method signature -> types mappings for calling Cocoa.
 std::map<std::string,CObjCMethodEntry>	CParser::sCFunctionTable;				// Table of C function name -> types mappings for calling native system calls.
 std::map<std::string,CObjCMethodEntry>	CParser::sCFunctionPointerTable;		// Table of C function pointer type name -> types mappings for generating callback trampolines.
 std::map<std::string,std::string>		CParser::sSynonymToTypeTable;			// Table of C type synonym name -> real name mappings.
 std::map<std::string,std::string>		CParser::sConstantToValueTable;			// Table of C system constant name -> constant value mappings.
-LEOFirstNativeCallCallbackPtr			CParser::sFirstNativeCallCallback = NULL;
-
-
-static CFunctionDefinitionNode*			sLastErrorFunction = NULL;
+std::vector<std::shared_ptr<CNativeHeadersIndex>>	CParser::sNativeHeadersIndexes;	// Precompiled native headers, mapped into memory.
+std::vector<CNativeHeadersSection>			CParser::sNativeHeadersSections;	// Sections of .hhc files with a directory, loaded on demand.
+std::map<std::string,size_t>				CParser::sNativeHeadersSymbolSections;	// Symbol name -> index into sNativeHeadersSections.
+static std::mutex							sNativeHeadersMutex;				// Parsers on other threads may load sections while we look up symbols.
+std::atomic<LEOFirstNativeCallCallbackPtr>	CParser::sFirstNativeCallCallback( NULL );
+static std::mutex							sFirstNativeCallMutex;				// Held while sFirstNativeCallCallback runs. Not sNativeHeadersMutex, as the callback usually loads headers.
 
 
 #pragma mark -
@@ -177,6 +183,16 @@ static THostCommandEntry	sDefaultHostFunctions[] =
 	}
 };
 
+static THostCommandEntry	sNoHostCommands[] =	// What CParserGrammar copies while nobody called AddHostCommandsAndOffsetInstructions().
+{
+	{
+		ELastIdentifier_Sentinel, INVALID_INSTR2, 0, 0, '\0', '\0',
+		{
+			{ EHostParam_Sentinel, ELastIdentifier_Sentinel, EHostParameterOptional, INVALID_INSTR2, 0, 0, '\0', '\0' },
+		}
+	}
+};
+
 static TOperatorEntry*			sOperators = NULL;
 
 static TUnaryOperatorEntry*		sUnaryOperators = NULL;
@@ -249,6 +265,44 @@ struct TBuiltInVariableEntry	sDefaultBuiltInVariables[] =
 struct TBuiltInVariableEntry*	sBuiltInVariables = nullptr;
 
 
+#pragma mark [Statement lookup table]
+// First identifier on a line -> parser for the built-in statement it starts:
+struct TStatementEntry
+{
+	TIdentifierSubtype					mType;
+	CParser::TStatementParser			mParser;
+	CParser::THandlerStatementParser	mHandlerParser;	// Used instead of mParser for statements that need the handler name.
+};
+
+
+static TStatementEntry	sStatements[] =
+{
+	{ EPutIdentifier, &CParser::ParsePutStatement, NULL },
+	{ EDownloadIdentifier, NULL, &CParser::ParseDownloadStatement },
+	{ EReturnIdentifier, &CParser::ParseReturnStatement, NULL },
+	{ EPassIdentifier, &CParser::ParsePassStatement, NULL },
+	{ EExitIdentifier, NULL, &CParser::ParseExitStatement },
+	{ ENextIdentifier, &CParser::ParseNextStatement, NULL },
+	{ ERepeatIdentifier, NULL, &CParser::ParseRepeatStatement },
+	{ EIfIdentifier, NULL, &CParser::ParseIfStatement },
+	{ EAddIdentifier, &CParser::ParseAddStatement, NULL },
+	{ ESubtractIdentifier, &CParser::ParseSubtractStatement, NULL },
+	{ EMultiplyIdentifier, &CParser::ParseMultiplyStatement, NULL },
+	{ EDivideIdentifier, &CParser::ParseDivideStatement, NULL },
+	{ EGetIdentifier, &CParser::ParseGetStatement, NULL },
+	{ ESetIdentifier, &CParser::ParseSetStatement, NULL },
+	{ EGlobalIdentifier, &CParser::ParseGlobalStatement, NULL },
+	{ ELastIdentifier_Sentinel, NULL, NULL }
+};
+
+
+// The registered tables above only change while sGrammarMutex is locked. Parsers
+//	use a CParserGrammar with copies of them that never changes:
+static std::mutex								sGrammarMutex;
+
+static std::shared_ptr<const CParserGrammar>	sCurrentGrammar;	// NULL if something was registered since it was made.
+
+
 #pragma mark -
 	
 	
@@ -280,7 +334,39 @@ const std::string CVariableEntry::GetNewTempName()
 // -----------------------------------------------------------------------------
 
 CParser::CParser()
-	: mWebPageEmbedMode(false)
+	: mWebPageEmbedMode(false), mGrammar( CParserGrammar::GetCurrent() ), mLastErrorFunction(NULL), mParseInParallel(false), mNumParallelParseBatches(0), mBufferDiagnostics(false)
+{
+}
+
+
+CParser::CParser( std::shared_ptr<const CParserGrammar> inGrammar )
+	: mWebPageEmbedMode(false), mGrammar( inGrammar ), mLastErrorFunction(NULL), mParseInParallel(false), mNumParallelParseBatches(0), mBufferDiagnostics(false)
+{
+}
+
+
+// -----------------------------------------------------------------------------
+//	CopyTable:
+//		Copy all entries of a registered table into a vector, including the
+//		sentinel at the end.
+// -----------------------------------------------------------------------------
+
+template<class T, class IsSentinel>
+static void	CopyTable( const T* inEntries, IsSentinel isSentinel, std::vector<T>& outTable )
+{
+	size_t	numEntries = 0;
+	while( !isSentinel( inEntries[numEntries] ) )
+		numEntries++;
+	outTable.assign( inEntries, inEntries +numEntries +1 );
+}
+
+
+// -----------------------------------------------------------------------------
+//	CParserGrammar CONSTRUCTOR:
+//		Take a snapshot of all registered tables and index it.
+// -----------------------------------------------------------------------------
+
+CParserGrammar::CParserGrammar()
 {
 	if( !sOperators )
 		sOperators = sDefaultOperators;
@@ -298,6 +384,57 @@ CParser::CParser()
 		sConstants = sDefaultConstants;
 	if( !sBuiltInVariables )
 		sBuiltInVariables = sDefaultBuiltInVariables;
+	
+	CopyTable( sOperators, []( const TOperatorEntry& e ) { return e.mType == ELastIdentifier_Sentinel; }, mOperators );
+	CopyTable( sUnaryOperators, []( const TUnaryOperatorEntry& e ) { return e.mType == ELastIdentifier_Sentinel; }, mUnaryOperators );
+	CopyTable( sPostfixOperators, []( const TUnaryOperatorEntry& e ) { return e.mType == ELastIdentifier_Sentinel; }, mPostfixOperators );
+	CopyTable( sGlobalProperties, []( const TGlobalPropertyEntry& e ) { return e.mType == ELastIdentifier_Sentinel; }, mGlobalProperties );
+	CopyTable( sHostCommands ? sHostCommands : sNoHostCommands, []( const THostCommandEntry& e ) { return e.mType == ELastIdentifier_Sentinel; }, mHostCommands );
+	CopyTable( sHostFunctions, []( const THostCommandEntry& e ) { return e.mType == ELastIdentifier_Sentinel; }, mHostFunctions );
+	CopyTable( sBuiltInFunctions, []( const TBuiltInFunctionEntry& e ) { return e.mType == ELastIdentifier_Sentinel; }, mBuiltInFunctions );
+	CopyTable( sConstants, []( const TConstantEntry& e ) { return e.mType[0] == ELastIdentifier_Sentinel; }, mConstants );
+	CopyTable( sBuiltInVariables, []( const TBuiltInVariableEntry& e ) { return e.mType == ELastIdentifier_Sentinel; }, mBuiltInVariables );
+	
+	for( size_t x = 0; x <= ELastIdentifier_Sentinel; x++ )
+		mStatementsByIdentifier[x] = NULL;
+	for( size_t x = 0; sStatements[x].mType != ELastIdentifier_Sentinel; x++ )
+		mStatementsByIdentifier[ sStatements[x].mType ] = sStatements +x;
+	for( size_t x = 0; mOperators[x].mType != ELastIdentifier_Sentinel; x++ )
+		mOperatorsByIdentifier[ mOperators[x].mType ].push_back( x );
+	for( size_t x = 0; mHostCommands[x].mType != ELastIdentifier_Sentinel; x++ )
+		mHostCommandsByIdentifier[ mHostCommands[x].mType ].push_back( x );
+	for( size_t x = 0; mHostFunctions[x].mType != ELastIdentifier_Sentinel; x++ )
+		mHostFunctionsByIdentifier[ mHostFunctions[x].mType ].push_back( x );
+	for( size_t x = 0; mConstants[x].mType[0] != ELastIdentifier_Sentinel; x++ )
+	{
+		mConstantsByIdentifier[ mConstants[x].mType[0] ].push_back( x );
+		mConstantsBySetName[ mConstants[x].mSetName ].push_back( x );
+	}
+}
+
+
+/*static*/ std::shared_ptr<const CParserGrammar>	CParserGrammar::GetCurrent()
+{
+	std::lock_guard<std::mutex>	lock( sGrammarMutex );
+	if( !sCurrentGrammar )
+		sCurrentGrammar = std::shared_ptr<const CParserGrammar>( new CParserGrammar );
+	
+	return sCurrentGrammar;
+}
+
+
+const TBuiltInFunctionEntry*	CParserGrammar::GetBuiltInFunctionWithName( const std::string& inName ) const
+{
+	TIdentifierSubtype	subType = CToken::IdentifierTypeFromText( inName.c_str() );
+	for( int x = 0; mBuiltInFunctions[x].mType != ELastIdentifier_Sentinel; x++ )
+	{
+		if( mBuiltInFunctions[x].mType == subType )
+		{
+			return( &mBuiltInFunctions[x] );
+		}
+	}
+
+	return nullptr;
 }
 
 
@@ -308,6 +445,9 @@ CParser::CParser()
 
 /*static*/ void	CParser::AddOperatorsAndOffsetInstructions( TOperatorEntry* inEntries, LEOInstructionID firstOperatorInstruction )
 {
+	std::lock_guard<std::mutex>	lock( sGrammarMutex );
+	sCurrentGrammar.reset();	// Make the next CParserGrammar::GetCurrent() pick up the new entries.
+	
 	if( !sOperators )
 		sOperators = sDefaultOperators;
 	
@@ -354,6 +494,9 @@ CParser::CParser()
 
 /*static*/ void	CParser::AddUnaryOperatorsAndOffsetInstructions( TUnaryOperatorEntry* inEntries, LEOInstructionID firstUnaryOperatorInstruction )
 {
+	std::lock_guard<std::mutex>	lock( sGrammarMutex );
+	sCurrentGrammar.reset();	// Make the next CParserGrammar::GetCurrent() pick up the new entries.
+	
 	if( !sUnaryOperators )
 		sUnaryOperators = sDefaultUnaryOperators;
 	
@@ -402,6 +545,9 @@ CParser::CParser()
 
 /*static*/ void	CParser::AddPostfixOperatorsAndOffsetInstructions( TUnaryOperatorEntry* inEntries, LEOInstructionID firstUnaryOperatorInstruction )
 {
+	std::lock_guard<std::mutex>	lock( sGrammarMutex );
+	sCurrentGrammar.reset();	// Make the next CParserGrammar::GetCurrent() pick up the new entries.
+	
 	if( !sPostfixOperators )
 		sPostfixOperators = sDefaultPostfixOperators;
 	
@@ -450,6 +596,9 @@ CParser::CParser()
 
 /*static*/ void	CParser::AddBuiltInFunctionsAndOffsetInstructions( TBuiltInFunctionEntry* inEntries, LEOInstructionID firstGlobalPropertyInstruction )
 {
+	std::lock_guard<std::mutex>	lock( sGrammarMutex );
+	sCurrentGrammar.reset();	// Make the next CParserGrammar::GetCurrent() pick up the new entries.
+	
 	if( !sBuiltInFunctions )
 		sBuiltInFunctions = sDefaultBuiltInFunctions;
 	
@@ -498,6 +647,9 @@ CParser::CParser()
 
 /*static*/ void	CParser::AddGlobalPropertiesAndOffsetInstructions( TGlobalPropertyEntry* inEntries, LEOInstructionID firstGlobalPropertyInstruction )
 {
+	std::lock_guard<std::mutex>	lock( sGrammarMutex );
+	sCurrentGrammar.reset();	// Make the next CParserGrammar::GetCurrent() pick up the new entries.
+	
 	if( !sGlobalProperties )
 		sGlobalProperties = sDefaultGlobalProperties;
 	
@@ -551,6 +703,9 @@ CParser::CParser()
 
 /*static*/ void	CParser::AddHostCommandsAndOffsetInstructions( THostCommandEntry* inEntries, LEOInstructionID firstHostCommandInstruction )
 {
+	std::lock_guard<std::mutex>	lock( sGrammarMutex );
+	sCurrentGrammar.reset();	// Make the next CParserGrammar::GetCurrent() pick up the new entries.
+	
 	size_t		numOldEntries = 0,
 				numNewEntries = 0;
 	
@@ -604,6 +759,9 @@ CParser::CParser()
 
 /*static*/ void	CParser::AddHostFunctionsAndOffsetInstructions( THostCommandEntry* inEntries, LEOInstructionID firstHostCommandInstruction )
 {
+	std::lock_guard<std::mutex>	lock( sGrammarMutex );
+	sCurrentGrammar.reset();	// Make the next CParserGrammar::GetCurrent() pick up the new entries.
+	
 	size_t		numOldEntries = 0,
 				numNewEntries = 0;
 	
@@ -661,6 +819,9 @@ CParser::CParser()
 
 /*static*/ void	CParser::AddStringConstants( TStringConstantEntry* inEntries )
 {
+	std::lock_guard<std::mutex>	lock( sGrammarMutex );
+	sCurrentGrammar.reset();	// Make the next CParserGrammar::GetCurrent() pick up the new entries.
+	
 	size_t		numOldEntries = 0,
 				numNewEntries = 0;
 	
@@ -713,6 +874,9 @@ CParser::CParser()
 
 /*static*/ void	CParser::AddNumberConstants( TNumberConstantEntry* inEntries )
 {
+	std::lock_guard<std::mutex>	lock( sGrammarMutex );
+	sCurrentGrammar.reset();	// Make the next CParserGrammar::GetCurrent() pick up the new entries.
+	
 	size_t		numOldEntries = 0,
 				numNewEntries = 0;
 	
@@ -765,6 +929,9 @@ CParser::CParser()
 
 /*static*/ void	CParser::AddBuiltInVariables( TBuiltInVariableEntry* inEntries )
 {
+	std::lock_guard<std::mutex>	lock( sGrammarMutex );
+	sCurrentGrammar.reset();	// Make the next CParserGrammar::GetCurrent() pick up the new entries.
+	
 	size_t		numOldEntries = 0,
 	numNewEntries = 0;
 	
@@ -809,16 +976,27 @@ CParser::CParser()
 //		the proper parse tree.
 // -----------------------------------------------------------------------------
 
-void	CParser::Parse( const char* fname, std::deque<CToken>& tokens, CParseTree& parseTree, const char* scriptText )
+void	CParser::Parse( const char* fname, CTokenCursor& tokens, CParseTree& parseTree, const char* scriptText )
 {
+	mFileName = fname;
+	parseTree.SetGrammar( mGrammar );
+	
+	if( mParseInParallel && !mWebPageEmbedMode && !mIncludeHandler && tokens.HasAllTokens() && ParseInParallel( fname, tokens, parseTree, scriptText ) )
+		return;
+	
 	// -------------------------------------------------------------------------
 	// First recursively parse our script for top-level constructs:
 	//	(functions, commands, CompileIt-style globals, whatever...)
-	std::deque<CToken>::iterator	tokenItty = tokens.begin();
-	
-	mFileName = fname;
+	CTokenIterator	tokenItty = tokens.begin();
+	ParseTopLevelConstructs( tokenItty, tokens.end(), tokens, parseTree, scriptText );
 	
-	while( tokenItty != tokens.end() )
+	mLastErrorFunction = NULL;
+}
+
+
+void	CParser::ParseTopLevelConstructs( CTokenIterator& tokenItty, CTokenIterator endItty, CTokenCursor& tokens, CParseTree& parseTree, const char* scriptText )
+{
+	while( tokenItty < endItty )
 	{
 		try
 		{
@@ -830,27 +1008,185 @@ void	CParser::Parse( const char* fname, std::deque<CToken>& tokens, CParseTree&
 		}
 		catch( const CForgeParseError& err )
 		{
-			sLastErrorFunction = NULL;
+			mLastErrorFunction = NULL;
 			mMessages.push_back( CMessageEntry( EMessageTypeError, err.what(), mFileName, err.GetLineNum(), err.GetOffset() ) );
 			throw;	// Re-throw, don't really know how to postpone this error until runtime.
 		}
 	}
+}
+
+
+#pragma mark [Parallel parsing]
+
+enum
+{
+	kMinParallelParserHandlers = 256	// Below this many handlers per batch, starting a thread takes longer than parsing.
+};
+
+
+// One run of handlers of a script split up for ParseInParallel(), which
+//	gets parsed by its own CParser into its own CParseTree:
+struct CParserBatch
+{
+	CParserBatch( std::shared_ptr<const CParserGrammar> inGrammar, size_t inStartToken, size_t inEndToken )
+		: mParser( inGrammar ), mStartToken(inStartToken), mEndToken(inEndToken), mSucceeded(false) {}
+	
+	CParser		mParser;
+	CParseTree	mParseTree;
+	size_t		mStartToken;
+	size_t		mEndToken;		// Index of the first token of the next batch.
+	bool		mSucceeded;		// Parsed up to mEndToken exactly like a serial parse would have.
+};
+
+
+// Find the tokens at which handler definitions start, so ParseInParallel()
+//	can split a script up between them. This doesn't have to be exact, e.g.
+//	we don't care about errors, ParseInParallel() checks the parser actually
+//	ended each batch where the next one starts. Returns FALSE if it found
+//	something odd enough that the script should just be parsed serially.
+static bool	FindHandlerStarts( CTokenCursor& tokens, std::vector<size_t>& outHandlerStarts )
+{
+	std::string			currHandlerName;	// Empty when we're not inside a handler.
+	bool				atLineStart = true;
+	for( size_t x = 0; (x +1) < tokens.GetNumTokens(); x++ )
+	{
+		const CToken&	currToken = *tokens.GetTokenAtIndex( x );
+		if( currToken.IsIdentifier( ENewlineOperator ) )
+		{
+			atLineStart = true;
+			continue;
+		}
+		
+		if( atLineStart && currHandlerName.empty() )
+		{
+			if( currToken.IsIdentifier( EFunctionIdentifier ) || currToken.IsIdentifier( EOnIdentifier )
+				|| currToken.IsIdentifier( EWhenIdentifier ) || currToken.IsIdentifier( EToIdentifier ) )
+			{
+				const CToken&	nameToken = *tokens.GetTokenAtIndex( x +1 );
+				if( nameToken.mType != EIdentifierToken || nameToken.IsIdentifier( ENewlineOperator ) )
+					return false;	// Let the serial parse report this.
+				outHandlerStarts.push_back( x );
+				currHandlerName = nameToken.GetOriginalIdentifierText();
+			}
+		}
+		else if( atLineStart && currToken.IsIdentifier( EEndIdentifier ) )
+		{
+			const CToken&	nameToken = *tokens.GetTokenAtIndex( x +1 );
+			if( nameToken.mType != EIdentifierToken )
+				return false;
+			if( strcasecmp( nameToken.GetIdentifierText().c_str(), currHandlerName.c_str() ) == 0 )
+				currHandlerName.clear();
+		}
+		
+		atLineStart = false;
+	}
+	
+	return true;
+}
+
+
+bool	CParser::ParseInParallel( const char* fname, CTokenCursor& tokens, CParseTree& parseTree, const char* scriptText )
+{
+	std::vector<size_t>	handlerStarts;
+	if( !FindHandlerStarts( tokens, handlerStarts ) )
+		return false;
+	size_t				numBatches = mNumParallelParseBatches;
+	if( numBatches == 0 )
+		numBatches = std::min<size_t>( std::max<unsigned>( std::thread::hardware_concurrency(), 1 ), handlerStarts.size() / kMinParallelParserHandlers );
+	numBatches = std::min( numBatches, handlerStarts.size() );
+	if( numBatches < 2 )
+		return false;
+	
+	// Give each batch the same number of handlers. The first one also gets
+	//	anything before the first handler:
+	std::deque<CParserBatch>	batches;
+	for( size_t x = 0; x < numBatches; x++ )
+	{
+		size_t	startToken = (x == 0) ? 0 : handlerStarts[ (handlerStarts.size() * x) / numBatches ];
+		size_t	endToken = ((x +1) < numBatches) ? handlerStarts[ (handlerStarts.size() * (x +1)) / numBatches ] : tokens.GetNumTokens();
+		batches.emplace_back( mGrammar, startToken, endToken );
+		
+		CParserBatch&	currBatch = batches.back();
+		currBatch.mParser.mFileName = fname;
+		currBatch.mParser.mSupportFolderPath = mSupportFolderPath;
+		currBatch.mParser.mBufferDiagnostics = true;	// Only print once we know we're not parsing serially after all.
+		// Each batch generates fewer unique identifiers than it has tokens, so this keeps them unique:
+		currBatch.mParseTree.SetUniqueIdentifierSeed( parseTree.GetUniqueIdentifierSeed() +startToken );
+	}
+	
+	// Parse all batches at the same time, the first one on this thread:
+	auto	parseBatch = [&tokens, scriptText]( CParserBatch* currBatch )	// Only called when tokens.HasAllTokens(), so all threads can read them.
+	{
+		try
+		{
+			CTokenIterator	tokenItty = tokens.begin() +currBatch->mStartToken;
+			currBatch->mParser.ParseTopLevelConstructs( tokenItty, tokens.begin() +currBatch->mEndToken, tokens, currBatch->mParseTree, scriptText );
+			currBatch->mSucceeded = (tokenItty == tokens.begin() +currBatch->mEndToken);
+		}
+		catch( ... )
+		{
+			currBatch->mSucceeded = false;	// The serial parse will report this error.
+		}
+	};
+	std::vector<std::thread>	workers;
+	for( size_t x = 1; x < batches.size(); x++ )
+		workers.push_back( std::thread( parseBatch, &batches[x] ) );
+	parseBatch( &batches[0] );
+	for( std::thread& currWorker : workers )
+		currWorker.join();
+	
+	for( size_t x = 0; x < batches.size(); x++ )
+	{
+		if( !batches[x].mSucceeded )
+			return false;
+		// A handler with an error gets its end line set when the next one starts. If that one is in the next batch, only the serial parse gets that right:
+		if( batches[x].mParser.mLastErrorFunction && (x +1) < batches.size() )
+			return false;
+	}
+	
+	// Now append everything to our results as if we'd parsed the batches one after the other:
+	for( CParserBatch& currBatch : batches )
+	{
+		if( mFirstHandlerName.length() == 0 )
+		{
+			mFirstHandlerName = currBatch.mParser.mFirstHandlerName;
+			mFirstHandlerIsFunction = currBatch.mParser.mFirstHandlerIsFunction;
+		}
+		mMessages.insert( mMessages.end(), currBatch.mParser.mMessages.begin(), currBatch.mParser.mMessages.end() );
+		mHandlerNotes.insert( mHandlerNotes.end(), currBatch.mParser.mHandlerNotes.begin(), currBatch.mParser.mHandlerNotes.end() );
+		mIncludeFiles.insert( mIncludeFiles.end(), currBatch.mParser.mIncludeFiles.begin(), currBatch.mParser.mIncludeFiles.end() );
+		parseTree.TakeNodesFrom( currBatch.mParseTree );
+		PrintDiagnostic( currBatch.mParser.mBufferedDiagnostics );
+	}
+	
+	mFileName = fname;
+	mLastErrorFunction = NULL;
 	
-	sLastErrorFunction = NULL;
+	return true;
+}
+
+
+void	CParser::PrintDiagnostic( const std::string& inMessage )
+{
+	if( mBufferDiagnostics )
+		mBufferedDiagnostics.append( inMessage );
+	else
+		std::cout << inMessage;	// Not printf(), so the command line tool can capture it per job with --jobs.
 }
 
 
-void	CParser::ParseCommandOrExpression( const char* fname, std::deque<CToken>& tokens, CParseTree& parseTree, TAllVarsAreGlobals inAllVarsAreGlobals )
+void	CParser::ParseCommandOrExpression( const char* fname, CTokenCursor& tokens, CParseTree& parseTree, TAllVarsAreGlobals inAllVarsAreGlobals )
 {
 	bool						tryCommand = true;
 	CFunctionDefinitionNode*	currFunctionNode = NULL;
 	try
 	{
-		std::deque<CToken>::iterator	tokenItty = tokens.begin();
+		CTokenIterator	tokenItty = tokens.begin();
 		std::string						handlerName( ":run" );
 		mFileName = fname;
+		parseTree.SetGrammar( mGrammar );
 		
-		currFunctionNode = new CFunctionDefinitionNode( &parseTree, true, handlerName, handlerName, 1, mFileName );
+		currFunctionNode = parseTree.NewNode<CFunctionDefinitionNode>( true, handlerName, handlerName, 1, mFileName );
 		
 		// Make built-in system variables so they get declared below like other local vars:
 		currFunctionNode->AddLocalVar( "result", "result", TVariantTypeEmptyString, false, false, false, false );
@@ -862,8 +1198,6 @@ void	CParser::ParseCommandOrExpression( const char* fname, std::deque<CToken>& t
 		
 		if( tokenItty != tokens.end() )	// Didn't parse all of it? Guess it wasn't a command :-S
 		{
-			if( currFunctionNode )
-				delete currFunctionNode;	// Throw all of this away.
 			tryCommand = true;	// Try parsing a command below.
 		}
 		else	// Parsed all of it! Good, add it to our script properly:
@@ -880,17 +1214,15 @@ void	CParser::ParseCommandOrExpression( const char* fname, std::deque<CToken>& t
 	}
 	catch( const std::exception& err )	// Error? Guess it wasn't an expression after all.
 	{
-		if( currFunctionNode )
-			delete currFunctionNode;	// Throw any previous parse progress away.
 		tryCommand = true;	// Try parsing a command below.
 	}
 	
 	if( tryCommand )
 	{
-		std::deque<CToken>::iterator	tokenItty = tokens.begin();
+		CTokenIterator	tokenItty = tokens.begin();
 		std::string						handlerName( ":run" );
 		
-		currFunctionNode = new CFunctionDefinitionNode( &parseTree, true, handlerName, handlerName, 1, mFileName );
+		currFunctionNode = parseTree.NewNode<CFunctionDefinitionNode>( true, handlerName, handlerName, 1, mFileName );
 		
 		// Make built-in system variables so they get declared below like other local vars:
 		currFunctionNode->AddLocalVar( "result", "result", TVariantTypeEmptyString, false, false, false, false );
@@ -899,8 +1231,8 @@ void	CParser::ParseCommandOrExpression( const char* fname, std::deque<CToken>& t
 		ParseFunctionBody( handlerName, parseTree, currFunctionNode, tokenItty, tokens, NULL, ENewlineOperator );
 		
 		// Add a "return the result" command so we hand on the return value to whoever called us:
-		CCommandNode*	theReturnCommand = new CReturnCommandNode( &parseTree, endLineNum, mFileName );
-		theReturnCommand->AddParam( new CLocalVariableRefValueNode(&parseTree, currFunctionNode, "result", "result", endLineNum) );
+		CCommandNode*	theReturnCommand = parseTree.NewNode<CReturnCommandNode>( endLineNum, mFileName );
+		theReturnCommand->AddParam( parseTree.NewNode<CLocalVariableRefValueNode>( currFunctionNode, "result", "result", endLineNum) );
 		currFunctionNode->AddCommand( theReturnCommand );
 		
 		currFunctionNode->SetEndLineNum( endLineNum );
@@ -917,10 +1249,10 @@ void	CParser::ParseCommandOrExpression( const char* fname, std::deque<CToken>& t
 }
 
 
-void	CParser::ParseTopLevelConstruct( std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens, CParseTree& parseTree, const char* scriptText )
+void	CParser::ParseTopLevelConstruct( CTokenIterator& tokenItty, CTokenCursor& tokens, CParseTree& parseTree, const char* scriptText )
 {
 	if( tokenItty == tokens.end() )
-		printf("End of tokens.\n");
+		return;
 	else if( tokenItty->IsIdentifier( ENewlineOperator ) )
 		CTokenizer::GoNextToken( mFileName, tokenItty, tokens );	// Skip the newline.
 	else if( tokenItty->IsIdentifier( EUseIdentifier ) && mIncludeHandler )
@@ -951,9 +1283,11 @@ void	CParser::ParseTopLevelConstruct( std::deque<CToken>::iterator& tokenItty, s
 		std::vector<char>	fileText;
 		if( mIncludeHandler( innerFileName, oldFileName, fileText ) )
 		{
-			mIncludeFiles.push_back( CIncludeFileEntry(innerFileName,oldFileName,fileText) );
-			std::deque<CToken>	includedTokens = CTokenizer::TokenListFromText( fileText.data(), fileText.size() -1, mWebPageEmbedMode );
-			Parse( innerFileName, includedTokens, parseTree, fileText.data() );	// Changes mFileName to the given file.
+			// Pages of a web site often all use the same files, so only tokenize each of them once:
+			std::shared_ptr<CIncludeCacheEntry>	includedFile = CIncludeCache::GetShared().GetEntry( fileText, mWebPageEmbedMode );
+			mIncludeFiles.push_back( CIncludeFileEntry(innerFileName,oldFileName,std::move(fileText)) );
+			CCompactTokenCursor		includedTokens( includedFile->GetTokens() );
+			Parse( innerFileName, includedTokens, parseTree, includedFile->GetFileText().data() );	// Changes mFileName to the given file.
 			mFileName = oldFileName;	// Restore mFileName so we correctly report errors in continued parsing of this file.
 		}
 		else
@@ -1001,7 +1335,7 @@ void	CParser::ParseTopLevelConstruct( std::deque<CToken>::iterator& tokenItty, s
 		std::stringstream errMsg;
 		errMsg << "Skipping \"" << tokenItty->GetShortDescription();
 		
-		size_t lineNum = tokenItty != tokens.end() ? tokenItty->mLineNum : tokens.back().mLineNum;
+		size_t lineNum = tokenItty != tokens.end() ? tokenItty->mLineNum : tokens.GetLastToken()->mLineNum;
 		CTokenizer::GoNextToken( mFileName, tokenItty, tokens );	// Just skip it, whatever it may be.
 		while( tokenItty != tokens.end() && !tokenItty->IsIdentifier( ENewlineOperator ) )	// Now skip until the end of the line.
 		{
@@ -1015,12 +1349,12 @@ void	CParser::ParseTopLevelConstruct( std::deque<CToken>::iterator& tokenItty, s
 }
 
 
-CFunctionDefinitionNode*	CParser::StartParsingFunctionDefinition( const std::string& handlerName, const std::string& userHandlerName, bool isCommand, size_t fcnLineNum, std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens, const std::string& documentation, CParseTree& parseTree )
+CFunctionDefinitionNode*	CParser::StartParsingFunctionDefinition( const std::string& handlerName, const std::string& userHandlerName, bool isCommand, size_t fcnLineNum, CTokenIterator& tokenItty, CTokenCursor& tokens, const std::string& documentation, CParseTree& parseTree )
 {
-	if( sLastErrorFunction )	// Last function had an error and never ended?
+	if( mLastErrorFunction )	// Last function had an error and never ended?
 	{
-		sLastErrorFunction->SetEndLineNum(fcnLineNum);	// We're now parsing a new function, so make sure we undo its indentation in the code formatter.
-		sLastErrorFunction = NULL;	// All good now.
+		mLastErrorFunction->SetEndLineNum(fcnLineNum);	// We're now parsing a new function, so make sure we undo its indentation in the code formatter.
+		mLastErrorFunction = NULL;	// All good now.
 	}
 	
 	if( mFirstHandlerName.length() == 0 )
@@ -1032,7 +1366,7 @@ CFunctionDefinitionNode*	CParser::StartParsingFunctionDefinition( const std::str
 	mHandlerNotes.push_back( CHandlerNotesEntry(userHandlerName, documentation) );
 	
 	CFunctionDefinitionNode*		currFunctionNode = NULL;
-	currFunctionNode = new CFunctionDefinitionNode( &parseTree, isCommand, handlerName, userHandlerName, fcnLineNum, mFileName );
+	currFunctionNode = parseTree.NewNode<CFunctionDefinitionNode>( isCommand, handlerName, userHandlerName, fcnLineNum, mFileName );
 	parseTree.AddFunctionDefinitionNode( currFunctionNode );
 
 	// Make built-in system variables so they get declared below like other local vars:
@@ -1042,7 +1376,7 @@ CFunctionDefinitionNode*	CParser::StartParsingFunctionDefinition( const std::str
 }
 
 
-void	CParser::ParseFunctionDefinition( bool isCommand, std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens, const std::string& documentation, CParseTree& parseTree )
+void	CParser::ParseFunctionDefinition( bool isCommand, CTokenIterator& tokenItty, CTokenCursor& tokens, const std::string& documentation, CParseTree& parseTree )
 {
 	std::string								handlerName( tokenItty->GetOriginalIdentifierText() );
 	std::string								userHandlerName( tokenItty->GetOriginalIdentifierText() );
@@ -1062,9 +1396,9 @@ void	CParser::ParseFunctionDefinition( bool isCommand, std::deque<CToken>::itera
 		std::string	realVarName( tokenItty->GetIdentifierText() );
 		std::string	varName("var_");
 		varName.append( realVarName );
-		CCommandNode*		theVarCopyCommand = new CGetParamCommandNode( &parseTree, tokenItty->mLineNum, mFileName );
-		theVarCopyCommand->AddParam( new CLocalVariableRefValueNode(&parseTree, currFunctionNode, varName, realVarName, tokenItty->mLineNum) );
-		theVarCopyCommand->AddParam( new CIntValueNode( &parseTree, currParamIdx++, tokenItty->mLineNum ) );
+		CCommandNode*		theVarCopyCommand = parseTree.NewNode<CGetParamCommandNode>( tokenItty->mLineNum, mFileName );
+		theVarCopyCommand->AddParam( parseTree.NewNode<CLocalVariableRefValueNode>( currFunctionNode, varName, realVarName, tokenItty->mLineNum) );
+		theVarCopyCommand->AddParam( parseTree.NewNode<CIntValueNode>( currParamIdx++, tokenItty->mLineNum ) );
 		currFunctionNode->AddCommand( theVarCopyCommand );
 		
 		currFunctionNode->AddLocalVar( varName, realVarName, TVariantTypeEmptyString, false, true, false );	// Create param var and mark as parameter in variable list.
@@ -1101,12 +1435,12 @@ void	CParser::ParseFunctionDefinition( bool isCommand, std::deque<CToken>::itera
 	}
 	catch( const CForgeParseError& err )
 	{
-		sLastErrorFunction = currFunctionNode;
+		mLastErrorFunction = currFunctionNode;
 		mMessages.push_back( CMessageEntry( EMessageTypeError, err.what(), mFileName, err.GetLineNum(), err.GetOffset() ) );
 		
-		printf( "Deferring error to runtime: %s\n", err.what() );
+		PrintDiagnostic( std::string("Deferring error to runtime: ") + err.what() + "\n" );
 		
-		CParseErrorCommandNode	*	theErrorCmd = new CParseErrorCommandNode( &parseTree, err.what(), mFileName, err.GetLineNum(), err.GetOffset() );
+		CParseErrorCommandNode	*	theErrorCmd = parseTree.NewNode<CParseErrorCommandNode>( err.what(), mFileName, err.GetLineNum(), err.GetOffset() );
 		currFunctionNode->AddCommand( theErrorCmd );
 		
 		throw CForgeParseErrorProcessed( err );
@@ -1114,7 +1448,7 @@ void	CParser::ParseFunctionDefinition( bool isCommand, std::deque<CToken>::itera
 }
 
 
-CValueNode	*	CParser::ParseFunctionCall( CParseTree& parseTree, CCodeBlockNodeBase* currFunction, bool isMessagePassing, std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens )
+CValueNode	*	CParser::ParseFunctionCall( CParseTree& parseTree, CCodeBlockNodeBase* currFunction, bool isMessagePassing, CTokenIterator& tokenItty, CTokenCursor& tokens )
 {
 	CValueNode*	theTerm = NULL;
 	std::string	handlerName( tokenItty->GetIdentifierText() );
@@ -1127,10 +1461,10 @@ CValueNode	*	CParser::ParseFunctionCall( CParseTree& parseTree, CCodeBlockNodeBa
 	{
 		CTokenizer::GoNextToken( mFileName, tokenItty, tokens );	// Skip opening bracket.
 		
-		std::map<std::string,CObjCMethodEntry>::iterator funcItty = sCFunctionTable.find( realHandlerName );
-		if( funcItty == sCFunctionTable.end() )	// No native function of that name? Call function handler:
+		CObjCMethodEntry	nativeFunction;
+		if( !FindNativeMethod( CNativeHeadersIndex::ECFunctionTable, realHandlerName, nativeFunction ) )	// No native function of that name? Call function handler:
 		{
-			CFunctionCallNode*	fcall = new CFunctionCallNode( &parseTree, false, handlerName, callLineNum );
+			CFunctionCallNode*	fcall = parseTree.NewNode<CFunctionCallNode>( false, handlerName, callLineNum );
 			if( isMessagePassing )
 				fcall->SetIsMessagePassing(true);
 			theTerm = fcall;
@@ -1139,7 +1473,7 @@ CValueNode	*	CParser::ParseFunctionCall( CParseTree& parseTree, CCodeBlockNodeBa
 			CTokenizer::GoNextToken( mFileName, tokenItty, tokens );	// Skip closing bracket.
 		}
 		else if( !isMessagePassing )	// Native call!
-			theTerm = ParseNativeFunctionCallStartingAtParams( realHandlerName, funcItty->second, parseTree, currFunction, tokenItty, tokens );
+			theTerm = ParseNativeFunctionCallStartingAtParams( realHandlerName, nativeFunction, parseTree, currFunction, tokenItty, tokens );
 	}
 	else
 		CTokenizer::GoPreviousToken( mFileName, tokenItty, tokens );	// Backtrack over what wasn't a bracket.
@@ -1148,7 +1482,7 @@ CValueNode	*	CParser::ParseFunctionCall( CParseTree& parseTree, CCodeBlockNodeBa
 }
 
 void	CParser::ParsePassStatement( CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-									std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens )
+									CTokenIterator& tokenItty, CTokenCursor& tokens )
 {
 	CTokenizer::GoNextToken( mFileName, tokenItty, tokens );	// Skip "pass".
 	
@@ -1160,7 +1494,7 @@ void	CParser::ParsePassStatement( CParseTree& parseTree, CCodeBlockNodeBase* cur
 		ParseHandlerCall( parseTree, currFunction, true, tokenItty, tokens );
 	else
 	{
-		CCommandNode*	theReturnCommand = new CReturnCommandNode( &parseTree, tokenItty->mLineNum, mFileName );
+		CCommandNode*	theReturnCommand = parseTree.NewNode<CReturnCommandNode>( tokenItty->mLineNum, mFileName );
 		CValueNode*		theWhatNode = ParseFunctionCall( parseTree, currFunction, true, tokenItty, tokens );
 		theReturnCommand->AddParam( theWhatNode );
 		
@@ -1169,7 +1503,7 @@ void	CParser::ParsePassStatement( CParseTree& parseTree, CCodeBlockNodeBase* cur
 }
 
 
-void	CParser::ParseHandlerCall( CParseTree& parseTree, CCodeBlockNodeBase* currFunction, bool isMessagePassing, std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens )
+void	CParser::ParseHandlerCall( CParseTree& parseTree, CCodeBlockNodeBase* currFunction, bool isMessagePassing, CTokenIterator& tokenItty, CTokenCursor& tokens )
 {
 	std::string	handlerName;
 	size_t		currLineNum = tokenItty->mLineNum;
@@ -1177,20 +1511,20 @@ void	CParser::ParseHandlerCall( CParseTree& parseTree, CCodeBlockNodeBase* currF
 	handlerName.append( tokenItty->GetIdentifierText() );
 	CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
 
-	CFunctionCallNode*	currFunctionCall = new CFunctionCallNode( &parseTree, true, handlerName, currLineNum );
+	CFunctionCallNode*	currFunctionCall = parseTree.NewNode<CFunctionCallNode>( true, handlerName, currLineNum );
 	ParseParamList( ENewlineOperator, parseTree, currFunction, tokenItty, tokens, currFunctionCall );
 	
 	CCommandNode*			theVarAssignCommand = NULL;
 	if( isMessagePassing )
 	{
 		currFunctionCall->SetIsMessagePassing( true );
-		theVarAssignCommand = new CReturnCommandNode( &parseTree, tokenItty->mLineNum, mFileName );
+		theVarAssignCommand = parseTree.NewNode<CReturnCommandNode>( tokenItty->mLineNum, mFileName );
 		theVarAssignCommand->AddParam( currFunctionCall );
 	}
 	else
 	{
-		theVarAssignCommand = new CAssignCommandNode( &parseTree, currLineNum, mFileName );
-		theVarAssignCommand->AddParam( new CLocalVariableRefValueNode(&parseTree, currFunction, "result", "result", tokenItty->mLineNum) );
+		theVarAssignCommand = parseTree.NewNode<CAssignCommandNode>( currLineNum, mFileName );
+		theVarAssignCommand->AddParam( parseTree.NewNode<CLocalVariableRefValueNode>( currFunction, "result", "result", tokenItty->mLineNum) );
 		theVarAssignCommand->AddParam( currFunctionCall );
 	}
 	currFunction->AddCommand( theVarAssignCommand );
@@ -1200,214 +1534,186 @@ void	CParser::ParseHandlerCall( CParseTree& parseTree, CCodeBlockNodeBase* currF
 void	CParser::FindPrintHostCommand( LEOInstructionID* printInstrID, uint16_t* param1, uint32_t* param2 )
 {
 	// Look for a host command named "put" with exactly 1 parameter & use instruction from that:
-	if( sHostCommands )
+	for( size_t x = 0; mGrammar->mHostCommands[x].mType != ELastIdentifier_Sentinel; x++ )
 	{
-		for( size_t x = 0; sHostCommands[x].mType != ELastIdentifier_Sentinel; x++ )
+		if( mGrammar->mHostCommands[x].mType == EPutIdentifier )
 		{
-			if( sHostCommands[x].mType == EPutIdentifier )
+			*printInstrID = mGrammar->mHostCommands[x].mInstructionID;
+			*param1 = mGrammar->mHostCommands[x].mInstructionParam1;
+			*param2 = mGrammar->mHostCommands[x].mInstructionParam2;
+			if( mGrammar->mHostCommands[x].mParam[0].mType == EHostParamExpression && mGrammar->mHostCommands[x].mParam[1].mType == EHostParam_Sentinel )
 			{
-				*printInstrID = sHostCommands[x].mInstructionID;
-				*param1 = sHostCommands[x].mInstructionParam1;
-				*param2 = sHostCommands[x].mInstructionParam2;
-				if( sHostCommands[x].mParam[0].mType == EHostParamExpression && sHostCommands[x].mParam[1].mType == EHostParam_Sentinel )
+				if( mGrammar->mHostCommands[x].mParam[0].mInstructionID != INVALID_INSTR )
 				{
-					if( sHostCommands[x].mParam[0].mInstructionID != INVALID_INSTR )
-					{
-						*printInstrID = sHostCommands[x].mParam[0].mInstructionID;
-						*param1 = sHostCommands[x].mParam[0].mInstructionParam1;
-						*param2 = sHostCommands[x].mParam[0].mInstructionParam2;
-					}
-					break;
+					*printInstrID = mGrammar->mHostCommands[x].mParam[0].mInstructionID;
+					*param1 = mGrammar->mHostCommands[x].mParam[0].mInstructionParam1;
+					*param2 = mGrammar->mHostCommands[x].mParam[0].mInstructionParam2;
 				}
-				else
-					*printInstrID = INVALID_INSTR;
+				break;
 			}
+			else
+				*printInstrID = INVALID_INSTR;
 		}
 	}
 }
 
 
 void	CParser::ParsePutStatement( CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-								std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens )
+								CTokenIterator& tokenItty, CTokenCursor& tokens )
 {
 	// Put:
 	CCommandNode*			thePutCommand = NULL;
 	CNode*					resultNode = NULL;
 	size_t					startLine = tokenItty->mLineNum;
 	
-	try {
+	CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
+	
+	// What:
+	CValueNode*	whatExpression = ParseExpression( parseTree, currFunction, tokenItty, tokens, ELastIdentifier_Sentinel );
+	
+	// [into|after|before]
+	if( tokenItty->IsIdentifier( EIntoIdentifier ) )
+	{
+		resultNode = thePutCommand = parseTree.NewNode<CPutCommandNode>( startLine, mFileName );
+		thePutCommand->AddParam( whatExpression );
 		CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
 		
-		// What:
-		CValueNode*	whatExpression = ParseExpression( parseTree, currFunction, tokenItty, tokens, ELastIdentifier_Sentinel );
-		
-		// [into|after|before]
-		if( tokenItty->IsIdentifier( EIntoIdentifier ) )
-		{
-			resultNode = thePutCommand = new CPutCommandNode( &parseTree, startLine, mFileName );
-			thePutCommand->AddParam( whatExpression );
-			CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
-			
-			// container:
-			CValueNode*	destContainer = ParseContainer( false, false, parseTree, currFunction, tokenItty, tokens, ELastIdentifier_Sentinel );
-			thePutCommand->AddParam( destContainer );
-			resultNode = thePutCommand;
-		}
-		else if( tokenItty->IsIdentifier( EAfterIdentifier ) )
-		{
-			CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
+		// container:
+		CValueNode*	destContainer = ParseContainer( false, false, parseTree, currFunction, tokenItty, tokens, ELastIdentifier_Sentinel );
+		thePutCommand->AddParam( destContainer );
+		resultNode = thePutCommand;
+	}
+	else if( tokenItty->IsIdentifier( EAfterIdentifier ) )
+	{
+		CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
 
-			CValueNode*	destContainer = ParseContainer( false, false, parseTree, currFunction, tokenItty, tokens, ELastIdentifier_Sentinel );
-			
-			resultNode = thePutCommand = new CPutCommandNode( &parseTree, startLine, mFileName );
-			COperatorNode	*	concatOperation = new COperatorNode( &parseTree, CONCATENATE_VALUES_INSTR, startLine );
-			concatOperation->AddParam( destContainer->Copy() );
-			concatOperation->AddParam( whatExpression );
-			thePutCommand->AddParam( concatOperation );
-			thePutCommand->AddParam( destContainer );
-			resultNode = thePutCommand;
-		}
-		else if( tokenItty->IsIdentifier( EBeforeIdentifier ) )
-		{
-			CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
+		CValueNode*	destContainer = ParseContainer( false, false, parseTree, currFunction, tokenItty, tokens, ELastIdentifier_Sentinel );
+		
+		resultNode = thePutCommand = parseTree.NewNode<CPutCommandNode>( startLine, mFileName );
+		COperatorNode	*	concatOperation = parseTree.NewNode<COperatorNode>( CONCATENATE_VALUES_INSTR, startLine );
+		concatOperation->AddParam( destContainer->Copy() );
+		concatOperation->AddParam( whatExpression );
+		thePutCommand->AddParam( concatOperation );
+		thePutCommand->AddParam( destContainer );
+		resultNode = thePutCommand;
+	}
+	else if( tokenItty->IsIdentifier( EBeforeIdentifier ) )
+	{
+		CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
 
-			CValueNode*	destContainer = ParseContainer( false, false, parseTree, currFunction, tokenItty, tokens, ELastIdentifier_Sentinel );
-			
-			resultNode = thePutCommand = new CPutCommandNode( &parseTree, startLine, mFileName );
-			COperatorNode	*	concatOperation = new COperatorNode( &parseTree, CONCATENATE_VALUES_INSTR, startLine );
-			concatOperation->AddParam( whatExpression );
-			concatOperation->AddParam( destContainer->Copy() );
-			thePutCommand->AddParam( concatOperation );
-			thePutCommand->AddParam( destContainer );
-		}
-		else
-		{
-			// Look for a host command named "put" with exactly 1 parameter & use instruction from that:
-			LEOInstructionID	printInstrID = INVALID_INSTR;
-			uint16_t			param1 = 0;
-			uint32_t			param2 = 0;
-			
-			FindPrintHostCommand( &printInstrID, &param1, &param2 );
-			
-			// Found one?
-			if( printInstrID != INVALID_INSTR )
-			{
-				COperatorNode* opNode = new COperatorNode( &parseTree, printInstrID, startLine );
-				resultNode = opNode;
-				opNode->SetInstructionParams( param1, param2 );
-				if( whatExpression )
-					opNode->AddParam( whatExpression );
-				else
-					printInstrID = INVALID_INSTR;
-			}
-			
-			if( printInstrID == INVALID_INSTR )
-			{
-				ThrowDeferrableError( tokenItty, tokens, "expected \"into\", \"before\" or \"after\" here, found ", tokenItty->GetShortDescription(), "." );
-			}
-		}
+		CValueNode*	destContainer = ParseContainer( false, false, parseTree, currFunction, tokenItty, tokens, ELastIdentifier_Sentinel );
 		
-		currFunction->AddCommand( resultNode );
+		resultNode = thePutCommand = parseTree.NewNode<CPutCommandNode>( startLine, mFileName );
+		COperatorNode	*	concatOperation = parseTree.NewNode<COperatorNode>( CONCATENATE_VALUES_INSTR, startLine );
+		concatOperation->AddParam( whatExpression );
+		concatOperation->AddParam( destContainer->Copy() );
+		thePutCommand->AddParam( concatOperation );
+		thePutCommand->AddParam( destContainer );
 	}
-	catch( ... )
+	else
 	{
-		if( resultNode )
-			delete resultNode;
+		// Look for a host command named "put" with exactly 1 parameter & use instruction from that:
+		LEOInstructionID	printInstrID = INVALID_INSTR;
+		uint16_t			param1 = 0;
+		uint32_t			param2 = 0;
+		
+		FindPrintHostCommand( &printInstrID, &param1, &param2 );
+		
+		// Found one?
+		if( printInstrID != INVALID_INSTR )
+		{
+			COperatorNode* opNode = parseTree.NewNode<COperatorNode>( printInstrID, startLine );
+			resultNode = opNode;
+			opNode->SetInstructionParams( param1, param2 );
+			if( whatExpression )
+				opNode->AddParam( whatExpression );
+			else
+				printInstrID = INVALID_INSTR;
+		}
 		
-		throw;
+		if( printInstrID == INVALID_INSTR )
+		{
+			ThrowDeferrableError( tokenItty, tokens, "expected \"into\", \"before\" or \"after\" here, found ", tokenItty->GetShortDescription(), "." );
+		}
 	}
+	
+	currFunction->AddCommand( resultNode );
 }
 
 
 void	CParser::ParseSetStatement( CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-									std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens )
+									CTokenIterator& tokenItty, CTokenCursor& tokens )
 {
 	// Set:
 	CCommandNode*	thePutCommand = NULL;
 	size_t			startLine = tokenItty->mLineNum;
 	
-	try {
-		CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
-		
-		// container:
-		CValueNode*	destContainer = ParseContainer( false, false, parseTree, currFunction, tokenItty, tokens, EToIdentifier );
-		
-		// to:
-		if( !tokenItty->IsIdentifier( EToIdentifier ) )
-			ThrowDeferrableError( tokenItty, tokens, "Expected \"to\" here, found ", tokenItty->GetShortDescription(), "." );
-		CTokenizer::GoNextToken( mFileName, tokenItty, tokens );	// Skip "to".
+	CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
+	
+	// container:
+	CValueNode*	destContainer = ParseContainer( false, false, parseTree, currFunction, tokenItty, tokens, EToIdentifier );
+	
+	// to:
+	if( !tokenItty->IsIdentifier( EToIdentifier ) )
+		ThrowDeferrableError( tokenItty, tokens, "Expected \"to\" here, found ", tokenItty->GetShortDescription(), "." );
+	CTokenizer::GoNextToken( mFileName, tokenItty, tokens );	// Skip "to".
 
-		// what:
-		CValueNode*	whatExpression = ParseExpression( parseTree, currFunction, tokenItty, tokens, ELastIdentifier_Sentinel );
-		
-		// Just build a put command:
-		thePutCommand = new CPutCommandNode( &parseTree, startLine, mFileName );
-		thePutCommand->AddParam( whatExpression );
-		thePutCommand->AddParam( destContainer );
-		
-		currFunction->AddCommand( thePutCommand );
-	}
-	catch( ... )
-	{
-		if( thePutCommand )
-			delete thePutCommand;
-		
-		// TODO: Don't leak destContainer and whatExpression if error before they're added to command.
-		
-		throw;
-	}
+	// what:
+	CValueNode*	whatExpression = ParseExpression( parseTree, currFunction, tokenItty, tokens, ELastIdentifier_Sentinel );
+	
+	// Just build a put command:
+	thePutCommand = parseTree.NewNode<CPutCommandNode>( startLine, mFileName );
+	thePutCommand->AddParam( whatExpression );
+	thePutCommand->AddParam( destContainer );
+	
+	currFunction->AddCommand( thePutCommand );
 }
 
 
 void	CParser::ParseWebPageContentToken( CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-									std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens )
+									CTokenIterator& tokenItty, CTokenCursor& tokens )
 {
 	COperatorNode*	thePutCommand = NULL;
 	size_t			startLine = tokenItty->mLineNum;
 	
-	try {
-		// Look for a host command named "put" with exactly 1 parameter & use instruction from that:
-		LEOInstructionID	printInstrID = INVALID_INSTR;
-		uint16_t			param1 = 0;
-		uint32_t			param2 = 0;
-		
-		FindPrintHostCommand( &printInstrID, &param1, &param2 );
-		
-		// Found one?
-		if( printInstrID != INVALID_INSTR )
-		{
-			COperatorNode* opNode = new COperatorNode( &parseTree, printInstrID, startLine );
-			thePutCommand = opNode;
-			opNode->SetInstructionParams( param1, param2 );
-			opNode->AddParam( new CStringValueNode( &parseTree, tokenItty->GetOriginalWebPageContentText(), startLine ) );
-		}
-		
-		currFunction->AddCommand( thePutCommand );
-
-		CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
-	}
-	catch( ... )
+	// Look for a host command named "put" with exactly 1 parameter & use instruction from that:
+	LEOInstructionID	printInstrID = INVALID_INSTR;
+	uint16_t			param1 = 0;
+	uint32_t			param2 = 0;
+	
+	FindPrintHostCommand( &printInstrID, &param1, &param2 );
+	
+	// Found one?
+	if( printInstrID != INVALID_INSTR )
 	{
-		if( thePutCommand )
-			delete thePutCommand;
-		
-		throw;
+		COperatorNode* opNode = parseTree.NewNode<COperatorNode>( printInstrID, startLine );
+		thePutCommand = opNode;
+		opNode->SetInstructionParams( param1, param2 );
+		opNode->AddParam( parseTree.NewNode<CStringValueNode>( tokenItty->GetOriginalWebPageContentText(), startLine ) );
 	}
+	
+	currFunction->AddCommand( thePutCommand );
+
+	CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
 }
 
 
 CValueNode*	CParser::ParseHostFunction( CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-									std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens )
+									CTokenIterator& tokenItty, CTokenCursor& tokens )
 {
-	return ParseHostEntityWithTable( parseTree, currFunction, tokenItty, tokens, sHostFunctions );
+	TIdentifierSubtype	firstIdentifier = tokenItty->GetIdentifierSubType();
+	return ParseHostEntityWithTable( parseTree, currFunction, tokenItty, tokens, mGrammar->mHostFunctions,
+										mGrammar->mHostFunctionsByIdentifier[firstIdentifier] );
 }
 
 
 void	CParser::ParseHostCommand( CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-									std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens )
+									CTokenIterator& tokenItty, CTokenCursor& tokens )
 {
+	TIdentifierSubtype	firstIdentifier = tokenItty->GetIdentifierSubType();
 	CNode*	theNode = ParseHostEntityWithTable( parseTree, currFunction,
-												tokenItty, tokens, sHostCommands );
+												tokenItty, tokens, mGrammar->mHostCommands,
+												mGrammar->mHostCommandsByIdentifier[firstIdentifier] );
 	if( theNode )
 		currFunction->AddCommand( theNode );
 	else if( tokenItty != tokens.end() && tokenItty->IsIdentifier(EEndIdentifier) )
@@ -1425,17 +1731,17 @@ void	CParser::ParseHostCommand( CParseTree& parseTree, CCodeBlockNodeBase* currF
 
 
 CValueNode*	CParser::ParseHostEntityWithTable( CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-									std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens,
-									THostCommandEntry* inHostTable )
+									CTokenIterator& tokenItty, CTokenCursor& tokens,
+									const std::vector<THostCommandEntry>& inHostTable, const std::vector<size_t>& inCandidates )
 {
 	CValueNode			*theNode = NULL;
 	TIdentifierSubtype	firstIdentifier = tokenItty->GetIdentifierSubType();
 	
-	if( inHostTable != NULL )
 	{
-		for( size_t commandIdx = 0; inHostTable[commandIdx].mType != ELastIdentifier_Sentinel; commandIdx++ )
+		// inCandidates are the indexes of the entries in inHostTable that start with firstIdentifier:
+		for( size_t candidateIdx = 0; candidateIdx < inCandidates.size(); candidateIdx++ )
 		{
-			THostCommandEntry	*	currCmd = inHostTable +commandIdx;
+			const THostCommandEntry	*	currCmd = &inHostTable[ inCandidates[candidateIdx] ];
 			if( currCmd->mType == firstIdentifier )
 			{
 				HE_PRINT("First identifier match: \"%s\"\n", tokenItty->GetOriginalIdentifierText().c_str());
@@ -1444,8 +1750,8 @@ CValueNode*	CParser::ParseHostEntityWithTable( CParseTree& parseTree, CCodeBlock
 				identifiersToBacktrack++;
 				
 				uint8_t					currMode = currCmd->mInitialMode;
-				THostParameterEntry*	par = currCmd->mParam;
-				COperatorNode*			hostCommand = new COperatorNode( &parseTree, currCmd->mInstructionID, tokenItty->mLineNum );
+				const THostParameterEntry*	par = currCmd->mParam;
+				COperatorNode*			hostCommand = parseTree.NewNode<COperatorNode>( currCmd->mInstructionID, tokenItty->mLineNum );
 				hostCommand->SetInstructionParams( currCmd->mInstructionParam1, currCmd->mInstructionParam2 );
 				theNode = hostCommand;
 				bool	abortThisCommand = false;
@@ -1466,14 +1772,13 @@ CValueNode*	CParser::ParseHostEntityWithTable( CParseTree& parseTree, CCodeBlock
 									HE_PRINT("\t\tNot found\n");
 									if( par->mInstructionID == INVALID_INSTR )
 									{
-										hostCommand->AddParam( new CStringValueNode( &parseTree, "", tokenItty->mLineNum ) );
+										hostCommand->AddParam( parseTree.NewNode<CStringValueNode>( "", tokenItty->mLineNum ) );
 										HE_PRINT("\t\tAdding empty string because no instruction has been set to otherwise indicate this value isn't there.\n");
 									}
 								}
 								else if( !term )
 								{
 									HE_PRINT("\t\tNot found.\n");
-									delete hostCommand;
 									hostCommand = NULL;
 									theNode = NULL;
 									abortThisCommand = true;
@@ -1519,13 +1824,12 @@ CValueNode*	CParser::ParseHostEntityWithTable( CParseTree& parseTree, CCodeBlock
 									HE_PRINT("\t\tNot found.\n");
 									if( par->mInstructionID == INVALID_INSTR )
 									{
-										hostCommand->AddParam( new CStringValueNode( &parseTree, "", tokenItty->mLineNum ) );
+										hostCommand->AddParam( parseTree.NewNode<CStringValueNode>( "", tokenItty->mLineNum ) );
 									}
 								}
 								else if( !term )
 								{
 									HE_PRINT("\t\tNot found.\n");
-									delete hostCommand;
 									hostCommand = NULL;
 									theNode = NULL;
 									abortThisCommand = true;
@@ -1569,12 +1873,11 @@ CValueNode*	CParser::ParseHostEntityWithTable( CParseTree& parseTree, CCodeBlock
 								{
 									HE_PRINT("\t\tNot found.\n");
 									if( par->mInstructionID == INVALID_INSTR )
-										hostCommand->AddParam( new CStringValueNode( &parseTree, "", tokenItty->mLineNum ) );
+										hostCommand->AddParam( parseTree.NewNode<CStringValueNode>( "", tokenItty->mLineNum ) );
 								}
 								else if( !term )
 								{
 									HE_PRINT("\t\tNot found.\n");
-									delete hostCommand;
 									hostCommand = NULL;
 									theNode = NULL;
 									abortThisCommand = true;
@@ -1597,7 +1900,6 @@ CValueNode*	CParser::ParseHostEntityWithTable( CParseTree& parseTree, CCodeBlock
 									{
 										HE_PRINT("\t\tIdentifiers till line end.\n");
 										std::string		theStr = ((CLocalVariableRefValueNode*)term)->GetRealVarName();
-										delete term;
 										term = NULL;
 										for( ; tokenItty != tokens.end() && tokenItty->mType == EIdentifierToken; tokenItty++ )
 										{
@@ -1605,7 +1907,7 @@ CValueNode*	CParser::ParseHostEntityWithTable( CParseTree& parseTree, CCodeBlock
 											theStr.append( tokenItty->GetIdentifierText() );
 										}
 										
-										term = new CStringValueNode( &parseTree, theStr, tokenItty->mLineNum );
+										term = parseTree.NewNode<CStringValueNode>( theStr, tokenItty->mLineNum );
 									}
 
 									hostCommand->AddParam( term );
@@ -1640,7 +1942,7 @@ CValueNode*	CParser::ParseHostEntityWithTable( CParseTree& parseTree, CCodeBlock
 										if( par->mType != EHostParamInvisibleIdentifier )
 										{
 											HE_PRINT("\t\tAdding identifier with this string.\n");
-											hostCommand->AddParam( new CStringValueNode( &parseTree, tokenItty->GetShortDescription(), tokenItty->mLineNum ) );
+											hostCommand->AddParam( parseTree.NewNode<CStringValueNode>( tokenItty->GetShortDescription(), tokenItty->mLineNum ) );
 										}
 										else
 											HE_PRINT("\t\tInvisible identifier accepted.\n");
@@ -1666,7 +1968,7 @@ CValueNode*	CParser::ParseHostEntityWithTable( CParseTree& parseTree, CCodeBlock
 									if( par->mInstructionID == INVALID_INSTR && par->mType != EHostParamInvisibleIdentifier )
 									{
 										HE_PRINT("\t\tSetting empty string parameter.\n");
-										hostCommand->AddParam( new CStringValueNode( &parseTree, "", (tokenItty != tokens.end()) ? tokenItty->mLineNum  : 0) );
+										hostCommand->AddParam( parseTree.NewNode<CStringValueNode>( "", (tokenItty != tokens.end()) ? tokenItty->mLineNum  : 0) );
 									}
 								}
 								else
@@ -1675,7 +1977,6 @@ CValueNode*	CParser::ParseHostEntityWithTable( CParseTree& parseTree, CCodeBlock
 									abortThisCommand = true;
 									if( identifiersToBacktrack < 0 )
 									{
-										delete hostCommand;
 										hostCommand = NULL;
 										theNode = NULL;
 										
@@ -1740,7 +2041,6 @@ CValueNode*	CParser::ParseHostEntityWithTable( CParseTree& parseTree, CCodeBlock
 									if( !term )
 									{
 										HE_PRINT("\t\tNot Found.\n");
-										delete hostCommand;
 										hostCommand = NULL;
 										theNode = NULL;
 										abortThisCommand = true;
@@ -1776,11 +2076,10 @@ CValueNode*	CParser::ParseHostEntityWithTable( CParseTree& parseTree, CCodeBlock
 								else if( par->mIsOptional )
 								{
 									HE_PRINT("\t\tSetting empty string parameter.\n");
-									hostCommand->AddParam( new CStringValueNode( &parseTree, "", tokenItty->mLineNum ) );
+									hostCommand->AddParam( parseTree.NewNode<CStringValueNode>( "", tokenItty->mLineNum ) );
 								}
 								else
 								{
-									delete hostCommand;
 									hostCommand = NULL;
 									theNode = NULL;
 									abortThisCommand = true;
@@ -1810,15 +2109,11 @@ CValueNode*	CParser::ParseHostEntityWithTable( CParseTree& parseTree, CCodeBlock
 								{
 									size_t			constantIdentifiersToBacktrack = 0;
 									
-									for( size_t cx = 0; sConstants[cx].mType[0] != ELastIdentifier_Sentinel; cx++ )
+									// Only look at constants in the requested set, or if param wants *any* constant, those starting with this token:
+									const std::vector<size_t>&	candidateConstants = (par->mIdentifierType != ELastIdentifier_Sentinel) ? mGrammar->mConstantsBySetName[par->mIdentifierType] : mGrammar->mConstantsByIdentifier[tokenItty->mSubType];
+									for( size_t candidateIdx = 0; candidateIdx < candidateConstants.size(); candidateIdx++ )
 									{
-										if( sConstants[cx].mSetName != par->mIdentifierType			// Parameter requested exactly this?
-											&& par->mIdentifierType != ELastIdentifier_Sentinel )	// Param wants *any* constant?
-										{
-											continue;	// Otherwise skip.
-										}
-										
-										TConstantEntry	*	currConst = sConstants +cx;
+										const TConstantEntry	*	currConst = &mGrammar->mConstants[ candidateConstants[candidateIdx] ];
 										for( size_t cix = 0; cix < MAX_CONSTANT_IDENTS; cix ++ )
 										{
 											if( currConst->mType[cix] == ELastIdentifier_Sentinel )
@@ -1841,7 +2136,7 @@ CValueNode*	CParser::ParseHostEntityWithTable( CParseTree& parseTree, CCodeBlock
 										if( constantIdentifiersToBacktrack > 0 )	// Found a match?
 										{
 											HE_PRINT("\t\tComplete match for constant %s.\n", currConst->mValue->GetAsString().c_str() );
-											term = currConst->mValue->Copy();
+											term = parseTree.AdoptNode( currConst->mValue->Copy() );
 											constantIdentifiersToBacktrack = 0;	// Now we've created this value, we can't backtrack or we'll leak it. And once we add it to the hostCommand below, we'll be even less able to backtrack.
 											break;
 										}
@@ -1859,12 +2154,11 @@ CValueNode*	CParser::ParseHostEntityWithTable( CParseTree& parseTree, CCodeBlock
 								{
 									HE_PRINT("\t\tNot found.\n");
 									if( par->mInstructionID == INVALID_INSTR )
-										term = new CStringValueNode( &parseTree, "", tokenItty->mLineNum );
+										term = parseTree.NewNode<CStringValueNode>( "", tokenItty->mLineNum );
 								}
 								else if( !term )
 								{
 									HE_PRINT("\t\tNot found.\n");
-									delete hostCommand;
 									hostCommand = NULL;
 									theNode = NULL;
 									abortThisCommand = true;
@@ -1913,7 +2207,6 @@ CValueNode*	CParser::ParseHostEntityWithTable( CParseTree& parseTree, CCodeBlock
 					HE_PRINT("\tDidn't encounter end mode\n");
 					if( hostCommand )	// Should have one by now, so if none, backtracked.
 					{
-						delete hostCommand;
 						theNode = NULL;
 						hostCommand = NULL;
 					}
@@ -1955,7 +2248,7 @@ CValueNode*	CParser::ParseHostEntityWithTable( CParseTree& parseTree, CCodeBlock
 
 
 void	CParser::ParseGlobalStatement( CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-										std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens )
+										CTokenIterator& tokenItty, CTokenCursor& tokens )
 {
 	CTokenizer::GoNextToken( mFileName, tokenItty, tokens );	// Skip "global".
 	
@@ -1969,9 +2262,9 @@ void	CParser::ParseGlobalStatement( CParseTree& parseTree, CCodeBlockNodeBase* c
 
 
 void	CParser::ParseGetStatement( CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-									std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens )
+									CTokenIterator& tokenItty, CTokenCursor& tokens )
 {
-	CCommandNode*	thePutCommand = new CPutCommandNode( &parseTree, tokenItty->mLineNum, mFileName );
+	CCommandNode*	thePutCommand = parseTree.NewNode<CPutCommandNode>( tokenItty->mLineNum, mFileName );
 	
 	// We map "get" to "put <what> into it":
 	CTokenizer::GoNextToken( mFileName, tokenItty, tokens );	// Skip "get".
@@ -1982,16 +2275,16 @@ void	CParser::ParseGetStatement( CParseTree& parseTree, CCodeBlockNodeBase* curr
 		
 	// Make sure we have an "it":
 	CreateVariable( "var_it", "it", false, currFunction, currFunction->GetAllVarsAreGlobals() );
-	thePutCommand->AddParam( new CLocalVariableRefValueNode( &parseTree, currFunction, "var_it", "it", tokenItty->mLineNum ) );
+	thePutCommand->AddParam( parseTree.NewNode<CLocalVariableRefValueNode>( currFunction, "var_it", "it", tokenItty->mLineNum ) );
 	
 	currFunction->AddCommand( thePutCommand );
 }
 
 
 void	CParser::ParseReturnStatement( CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-										std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens )
+										CTokenIterator& tokenItty, CTokenCursor& tokens )
 {
-	CCommandNode*	theReturnCommand = new CReturnCommandNode( &parseTree, tokenItty->mLineNum, mFileName );
+	CCommandNode*	theReturnCommand = parseTree.NewNode<CReturnCommandNode>( tokenItty->mLineNum, mFileName );
 	
 	// Return:
 	CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
@@ -2006,9 +2299,9 @@ void	CParser::ParseReturnStatement( CParseTree& parseTree, CCodeBlockNodeBase* c
 
 void	CParser::ParseDownloadStatement( const std::string& userHandlerName, CParseTree& parseTree,
 										CCodeBlockNodeBase* currFunction,
-										std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens )
+										CTokenIterator& tokenItty, CTokenCursor& tokens )
 {
-	CDownloadCommandNode*	theDownloadCommand = new CDownloadCommandNode( &parseTree, tokenItty->mLineNum, mFileName );
+	CDownloadCommandNode*	theDownloadCommand = parseTree.NewNode<CDownloadCommandNode>( tokenItty->mLineNum, mFileName );
 	currFunction->AddCommand( theDownloadCommand );
 	
 	// Download:
@@ -2041,7 +2334,7 @@ void	CParser::ParseDownloadStatement( const std::string& userHandlerName, CParse
 			CTokenizer::GoPreviousToken( mFileName, tokenItty, tokens );
 	}
 	
-	std::deque<CToken>::iterator	beforeReturnPos;
+	CTokenIterator	beforeReturnPos;
 	
 	// For each chunk:
 	if( tokenItty->IsIdentifier( EForIdentifier ) )
@@ -2071,9 +2364,9 @@ void	CParser::ParseDownloadStatement( const std::string& userHandlerName, CParse
 		//	containing info like download size (current, total) etc.:
 		std::string	realVarName( "download" );
 		std::string	varName("download");
-		CCommandNode*		theVarCopyCommand = new CGetParamCommandNode( &parseTree, tokenItty->mLineNum, mFileName );
-		theVarCopyCommand->AddParam( new CLocalVariableRefValueNode(&parseTree, progressNode, varName, realVarName, tokenItty->mLineNum) );
-		theVarCopyCommand->AddParam( new CIntValueNode( &parseTree, 0, tokenItty->mLineNum ) );
+		CCommandNode*		theVarCopyCommand = parseTree.NewNode<CGetParamCommandNode>( tokenItty->mLineNum, mFileName );
+		theVarCopyCommand->AddParam( parseTree.NewNode<CLocalVariableRefValueNode>( progressNode, varName, realVarName, tokenItty->mLineNum) );
+		theVarCopyCommand->AddParam( parseTree.NewNode<CIntValueNode>( 0, tokenItty->mLineNum ) );
 		progressNode->AddCommand( theVarCopyCommand );
 		
 		progressNode->AddLocalVar( varName, realVarName, TVariantTypeEmptyString, false, true, false );	// Create param var and mark as parameter in variable list.
@@ -2127,9 +2420,9 @@ void	CParser::ParseDownloadStatement( const std::string& userHandlerName, CParse
 		//	containing info like download size (current, total) etc.:
 		std::string	realVarName( "download" );
 		std::string	varName("download");
-		CCommandNode*		theVarCopyCommand = new CGetParamCommandNode( &parseTree, tokenItty->mLineNum, mFileName );
-		theVarCopyCommand->AddParam( new CLocalVariableRefValueNode(&parseTree, completionNode, varName, realVarName, tokenItty->mLineNum) );
-		theVarCopyCommand->AddParam( new CIntValueNode( &parseTree, 0, tokenItty->mLineNum ) );
+		CCommandNode*		theVarCopyCommand = parseTree.NewNode<CGetParamCommandNode>( tokenItty->mLineNum, mFileName );
+		theVarCopyCommand->AddParam( parseTree.NewNode<CLocalVariableRefValueNode>( completionNode, varName, realVarName, tokenItty->mLineNum) );
+		theVarCopyCommand->AddParam( parseTree.NewNode<CIntValueNode>( 0, tokenItty->mLineNum ) );
 		completionNode->AddCommand( theVarCopyCommand );
 		
 		completionNode->AddLocalVar( varName, realVarName, TVariantTypeEmptyString, false, true, false );	// Create param var and mark as parameter in variable list.
@@ -2190,9 +2483,9 @@ void	CParser::ParseDownloadStatement( const std::string& userHandlerName, CParse
 
 
 void	CParser::ParseAddStatement( CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-										std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens )
+										CTokenIterator& tokenItty, CTokenCursor& tokens )
 {
-	CCommandNode*	theAddCommand = new CAddCommandNode( &parseTree, tokenItty->mLineNum, mFileName );
+	CCommandNode*	theAddCommand = parseTree.NewNode<CAddCommandNode>( tokenItty->mLineNum, mFileName );
 	
 	// Add:
 	CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
@@ -2203,7 +2496,6 @@ void	CParser::ParseAddStatement( CParseTree& parseTree, CCodeBlockNodeBase* curr
 	// To:
 	if( !tokenItty->IsIdentifier( EToIdentifier ) )
 	{
-		delete theWhatNode;
 		ThrowDeferrableError( tokenItty, tokens, "Expected \"to\" here, found ", tokenItty->GetShortDescription(), "." );
 	}
 	CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
@@ -2218,9 +2510,9 @@ void	CParser::ParseAddStatement( CParseTree& parseTree, CCodeBlockNodeBase* curr
 
 
 void	CParser::ParseSubtractStatement( CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-										std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens )
+										CTokenIterator& tokenItty, CTokenCursor& tokens )
 {
-	CCommandNode*	theAddCommand = new CSubtractCommandNode( &parseTree, tokenItty->mLineNum, mFileName );
+	CCommandNode*	theAddCommand = parseTree.NewNode<CSubtractCommandNode>( tokenItty->mLineNum, mFileName );
 	
 	// Subtract:
 	CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
@@ -2245,9 +2537,9 @@ void	CParser::ParseSubtractStatement( CParseTree& parseTree, CCodeBlockNodeBase*
 
 
 void	CParser::ParseMultiplyStatement( CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-										std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens )
+										CTokenIterator& tokenItty, CTokenCursor& tokens )
 {
-	CCommandNode*	theAddCommand = new CMultiplyCommandNode( &parseTree, tokenItty->mLineNum, mFileName );
+	CCommandNode*	theAddCommand = parseTree.NewNode<CMultiplyCommandNode>( tokenItty->mLineNum, mFileName );
 	
 	// Multiply:
 	CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
@@ -2272,9 +2564,9 @@ void	CParser::ParseMultiplyStatement( CParseTree& parseTree, CCodeBlockNodeBase*
 
 
 void	CParser::ParseDivideStatement( CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-										std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens )
+										CTokenIterator& tokenItty, CTokenCursor& tokens )
 {
-	CCommandNode*	theAddCommand = new CDivideCommandNode( &parseTree, tokenItty->mLineNum, mFileName );
+	CCommandNode*	theAddCommand = parseTree.NewNode<CDivideCommandNode>( tokenItty->mLineNum, mFileName );
 	
 	// Divide:
 	CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
@@ -2298,9 +2590,48 @@ void	CParser::ParseDivideStatement( CParseTree& parseTree, CCodeBlockNodeBase* c
 }
 
 
+void	CParser::ParseExitStatement( const std::string& userHandlerName, CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
+										CTokenIterator& tokenItty, CTokenCursor& tokens )
+{
+	CTokenizer::GoNextToken( mFileName, tokenItty, tokens );	// Skip "exit".
+	if( tokenItty->IsIdentifier(ERepeatIdentifier) )
+	{
+		CCommandNode*	theExitRepeatCommand = parseTree.NewNode<CCommandNode>( "ExitRepeat", tokenItty->mLineNum, mFileName );
+		currFunction->AddCommand( theExitRepeatCommand );
+		CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
+	}
+	else if( strcasecmp(tokenItty->GetIdentifierText().c_str(), userHandlerName.c_str()) == 0 )
+	{
+		CCommandNode*	theReturnCommand = parseTree.NewNode<CReturnCommandNode>( tokenItty->mLineNum, mFileName );
+		currFunction->AddCommand( theReturnCommand );
+		theReturnCommand->AddParam( parseTree.NewNode<CStringValueNode>( "", tokenItty->mLineNum) );
+		CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
+	}
+	else
+	{
+		ThrowDeferrableError( tokenItty, tokens, "Expected \"exit repeat\" or \"exit ", userHandlerName, "\", found ", tokenItty->GetShortDescription(), "." );
+	}
+}
+
+
+void	CParser::ParseNextStatement( CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
+										CTokenIterator& tokenItty, CTokenCursor& tokens )
+{
+	CTokenizer::GoNextToken( mFileName, tokenItty, tokens );	// Skip "next".
+	if( tokenItty->IsIdentifier(ERepeatIdentifier) )
+	{
+		CCommandNode*	theNextRepeatCommand = parseTree.NewNode<CCommandNode>( "NextRepeat", tokenItty->mLineNum, mFileName );
+		currFunction->AddCommand( theNextRepeatCommand );
+		CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
+	}
+	else
+		ThrowDeferrableError( tokenItty, tokens, "Expected \"next repeat\", found ", tokenItty->GetShortDescription(), "." );
+}
+
+
 // When you enter this, "repeat for each" has already been parsed, and you should be at the chunk type token:
 void	CParser::ParseRepeatForEachStatement( const std::string& userHandlerName, CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-										std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens )
+										CTokenIterator& tokenItty, CTokenCursor& tokens )
 {
 	// chunk type:
 	bool isArrayEntry = false;
@@ -2345,45 +2676,45 @@ void	CParser::ParseRepeatForEachStatement( const std::string& userHandlerName, C
 	
 	if( isArrayEntry )
 	{
-		CCommandNode*			theVarAssignCommand = new CAssignCommandNode( &parseTree, currLineNum, mFileName );
-		theVarAssignCommand->AddParam( new CLocalVariableRefValueNode(&parseTree, currFunction, tempName, tempName, currLineNum) );
+		CCommandNode*			theVarAssignCommand = parseTree.NewNode<CAssignCommandNode>( currLineNum, mFileName );
+		theVarAssignCommand->AddParam( parseTree.NewNode<CLocalVariableRefValueNode>( currFunction, tempName, tempName, currLineNum) );
 		theVarAssignCommand->AddParam( theExpressionNode );
 		currFunction->AddCommand( theVarAssignCommand );
 	}
 	else
 	{
-		CCommandNode*			theVarChunkListCommand = new CAssignChunkArrayNode( &parseTree, currLineNum, mFileName );
-		theVarChunkListCommand->AddParam( new CLocalVariableRefValueNode(&parseTree, currFunction, tempName, tempName, currLineNum) );
-		theVarChunkListCommand->AddParam( new CIntValueNode(&parseTree, chunkTypeConstant, currLineNum) );
+		CCommandNode*			theVarChunkListCommand = parseTree.NewNode<CAssignChunkArrayNode>( currLineNum, mFileName );
+		theVarChunkListCommand->AddParam( parseTree.NewNode<CLocalVariableRefValueNode>( currFunction, tempName, tempName, currLineNum) );
+		theVarChunkListCommand->AddParam( parseTree.NewNode<CIntValueNode>( chunkTypeConstant, currLineNum) );
 		theVarChunkListCommand->AddParam( theExpressionNode );
 		currFunction->AddCommand( theVarChunkListCommand );
 	}
 	
 	// tempCounterName = 1;
-	CCommandNode*			theVarAssignCommand = new CAssignCommandNode( &parseTree, currLineNum, mFileName );
-	theVarAssignCommand->AddParam( new CLocalVariableRefValueNode(&parseTree, currFunction, tempCounterName, tempCounterName, currLineNum) );
-	theVarAssignCommand->AddParam( new CIntValueNode(&parseTree, 1, currLineNum) );
+	CCommandNode*			theVarAssignCommand = parseTree.NewNode<CAssignCommandNode>( currLineNum, mFileName );
+	theVarAssignCommand->AddParam( parseTree.NewNode<CLocalVariableRefValueNode>( currFunction, tempCounterName, tempCounterName, currLineNum) );
+	theVarAssignCommand->AddParam( parseTree.NewNode<CIntValueNode>( 1, currLineNum) );
 	currFunction->AddCommand( theVarAssignCommand );
 	
 	// tempMaxCountName = GetArrayItemCount( tempName );
-	CGetArrayItemCountNode*	currFunctionCall = new CGetArrayItemCountNode( &parseTree, currLineNum, mFileName );
-	currFunctionCall->AddParam( new CLocalVariableRefValueNode(&parseTree, currFunction, tempMaxCountName, tempMaxCountName, currLineNum) );
-	currFunctionCall->AddParam( new CLocalVariableRefValueNode(&parseTree, currFunction, tempName, tempName, currLineNum) );
+	CGetArrayItemCountNode*	currFunctionCall = parseTree.NewNode<CGetArrayItemCountNode>( currLineNum, mFileName );
+	currFunctionCall->AddParam( parseTree.NewNode<CLocalVariableRefValueNode>( currFunction, tempMaxCountName, tempMaxCountName, currLineNum) );
+	currFunctionCall->AddParam( parseTree.NewNode<CLocalVariableRefValueNode>( currFunction, tempName, tempName, currLineNum) );
 	currFunction->AddCommand( currFunctionCall );
 	
 	// while( tempCounterName <= tempMaxCountName )
-	CWhileLoopNode*		whileLoop = new CWhileLoopNode( &parseTree, currLineNum, mFileName, currFunction );
+	CWhileLoopNode*		whileLoop = parseTree.NewNode<CWhileLoopNode>( currLineNum, mFileName, currFunction );
 	currFunction->AddCommand( whileLoop );
-	COperatorNode	*	opNode = new COperatorNode( &parseTree, LESS_THAN_EQUAL_OPERATOR_INSTR, currLineNum );
+	COperatorNode	*	opNode = parseTree.NewNode<COperatorNode>( LESS_THAN_EQUAL_OPERATOR_INSTR, currLineNum );
 	whileLoop->SetCondition( opNode );
-	opNode->AddParam( new CLocalVariableRefValueNode(&parseTree, currFunction, tempCounterName, tempCounterName, currLineNum) );
-	opNode->AddParam( new CLocalVariableRefValueNode(&parseTree, currFunction, tempMaxCountName, tempMaxCountName, currLineNum) );
+	opNode->AddParam( parseTree.NewNode<CLocalVariableRefValueNode>( currFunction, tempCounterName, tempCounterName, currLineNum) );
+	opNode->AddParam( parseTree.NewNode<CLocalVariableRefValueNode>( currFunction, tempMaxCountName, tempMaxCountName, currLineNum) );
 	
 	// counterVarName = GetArrayItem( tempName, tempCounterName );
-	CGetArrayItemNode*	getItemNode = new CGetArrayItemNode( &parseTree, currLineNum, mFileName );
-	getItemNode->AddParam( new CLocalVariableRefValueNode(&parseTree, currFunction, counterVarName, counterVarName, currLineNum) );
-	getItemNode->AddParam( new CLocalVariableRefValueNode(&parseTree, currFunction, tempCounterName, tempCounterName, currLineNum) );
-	getItemNode->AddParam( new CLocalVariableRefValueNode(&parseTree, currFunction, tempName, tempName, currLineNum) );
+	CGetArrayItemNode*	getItemNode = parseTree.NewNode<CGetArrayItemNode>( currLineNum, mFileName );
+	getItemNode->AddParam( parseTree.NewNode<CLocalVariableRefValueNode>( currFunction, counterVarName, counterVarName, currLineNum) );
+	getItemNode->AddParam( parseTree.NewNode<CLocalVariableRefValueNode>( currFunction, tempCounterName, tempCounterName, currLineNum) );
+	getItemNode->AddParam( parseTree.NewNode<CLocalVariableRefValueNode>( currFunction, tempName, tempName, currLineNum) );
 	whileLoop->AddCommand( getItemNode );
 	
 	whileLoop->SetCommandsLineNum( tokenItty->IsIdentifier(ENewlineOperator) ? (tokenItty->mLineNum + 1) : tokenItty->mLineNum );
@@ -2393,9 +2724,9 @@ void	CParser::ParseRepeatForEachStatement( const std::string& userHandlerName, C
 	}
 	
 	// tempCounterName += 1;	-- increment loop counter.
-	CAddCommandNode	*	theIncrementOperation = new CAddCommandNode( &parseTree, tokenItty->mLineNum, mFileName );
-	theIncrementOperation->AddParam( new CLocalVariableRefValueNode(&parseTree, currFunction, tempCounterName, tempCounterName, tokenItty->mLineNum) );
-	theIncrementOperation->AddParam( new CIntValueNode(&parseTree, 1, tokenItty->mLineNum) );
+	CAddCommandNode	*	theIncrementOperation = parseTree.NewNode<CAddCommandNode>( tokenItty->mLineNum, mFileName );
+	theIncrementOperation->AddParam( parseTree.NewNode<CLocalVariableRefValueNode>( currFunction, tempCounterName, tempCounterName, tokenItty->mLineNum) );
+	theIncrementOperation->AddParam( parseTree.NewNode<CIntValueNode>( 1, tokenItty->mLineNum) );
 	whileLoop->AddCommand( theIncrementOperation );	// TODO: Need to dispose this on exceptions above.
 	
 	CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
@@ -2409,7 +2740,7 @@ void	CParser::ParseRepeatForEachStatement( const std::string& userHandlerName, C
 
 
 void	CParser::ParseRepeatStatement( const std::string& userHandlerName, CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-										std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens )
+										CTokenIterator& tokenItty, CTokenCursor& tokens )
 {
 	size_t		conditionLineNum = tokenItty->mLineNum;
 	
@@ -2422,7 +2753,7 @@ void	CParser::ParseRepeatStatement( const std::string& userHandlerName, CParseTr
 		
 		CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
 		
-		CWhileLoopNode*		whileLoop = new CWhileLoopNode( &parseTree, conditionLineNum, mFileName, currFunction );
+		CWhileLoopNode*		whileLoop = parseTree.NewNode<CWhileLoopNode>( conditionLineNum, mFileName, currFunction );
 		CValueNode*			conditionNode = NULL;
 		
 		currFunction->AddCommand( whileLoop );
@@ -2432,7 +2763,7 @@ void	CParser::ParseRepeatStatement( const std::string& userHandlerName, CParseTr
 
 		if( doUntil )
 		{
-			COperatorNode	*funcNode = new COperatorNode( &parseTree, NEGATE_BOOL_INSTR, conditionLineNum );
+			COperatorNode	*funcNode = parseTree.NewNode<COperatorNode>( NEGATE_BOOL_INSTR, conditionLineNum );
 			funcNode->AddParam( conditionNode );
 			conditionNode = funcNode;
 		}
@@ -2512,24 +2843,24 @@ void	CParser::ParseRepeatStatement( const std::string& userHandlerName, CParseTr
 		std::string		tempName = CVariableEntry::GetNewTempName();
 		currFunction->AddLocalVar( tempName, tempName, TVariantTypeInt );
 		
-		CWhileLoopNode*		whileLoop = new CWhileLoopNode( &parseTree, conditionLineNum, mFileName, currFunction );
+		CWhileLoopNode*		whileLoop = parseTree.NewNode<CWhileLoopNode>( conditionLineNum, mFileName, currFunction );
 		
 		// tempName = startNum;
-		CCommandNode*	theAssignCommand = new CAssignCommandNode( &parseTree, conditionLineNum, mFileName );
-		theAssignCommand->AddParam( new CLocalVariableRefValueNode(&parseTree, currFunction, tempName, tempName, conditionLineNum) );
+		CCommandNode*	theAssignCommand = parseTree.NewNode<CAssignCommandNode>( conditionLineNum, mFileName );
+		theAssignCommand->AddParam( parseTree.NewNode<CLocalVariableRefValueNode>( currFunction, tempName, tempName, conditionLineNum) );
 		theAssignCommand->AddParam( startNumExpr );
 		currFunction->AddCommand( theAssignCommand );
 		
 		// while( tempName <= endNum )
-		COperatorNode*	theComparison = new COperatorNode( &parseTree, compareOp, conditionLineNum );
-		theComparison->AddParam( new CLocalVariableRefValueNode(&parseTree, currFunction, tempName, tempName, conditionLineNum) );
+		COperatorNode*	theComparison = parseTree.NewNode<COperatorNode>( compareOp, conditionLineNum );
+		theComparison->AddParam( parseTree.NewNode<CLocalVariableRefValueNode>( currFunction, tempName, tempName, conditionLineNum) );
 		theComparison->AddParam( endNumExpr );
 		whileLoop->SetCondition( theComparison );
 		
 		// counterVarName = tempName;
-		theAssignCommand = new CPutCommandNode( &parseTree, conditionLineNum, mFileName );
-		theAssignCommand->AddParam( new CLocalVariableRefValueNode(&parseTree, currFunction, tempName, tempName, conditionLineNum) );
-		theAssignCommand->AddParam( new CLocalVariableRefValueNode(&parseTree, currFunction, counterVarName, counterVarName, conditionLineNum) );
+		theAssignCommand = parseTree.NewNode<CPutCommandNode>( conditionLineNum, mFileName );
+		theAssignCommand->AddParam( parseTree.NewNode<CLocalVariableRefValueNode>( currFunction, tempName, tempName, conditionLineNum) );
+		theAssignCommand->AddParam( parseTree.NewNode<CLocalVariableRefValueNode>( currFunction, counterVarName, counterVarName, conditionLineNum) );
 		whileLoop->AddCommand( theAssignCommand );
 		
 		whileLoop->SetCommandsLineNum( tokenItty->IsIdentifier(ENewlineOperator) ? (tokenItty->mLineNum + 1) : tokenItty->mLineNum );
@@ -2551,9 +2882,9 @@ void	CParser::ParseRepeatStatement( const std::string& userHandlerName, CParseTr
 		while( true );
 		
 		// tempName += 1;
-		CAddCommandNode	*	theIncrementOperation = new CAddCommandNode( &parseTree, tokenItty->mLineNum, mFileName );
-		theIncrementOperation->AddParam( new CLocalVariableRefValueNode(&parseTree, currFunction, tempName, tempName, tokenItty->mLineNum) );
-		theIncrementOperation->AddParam( new CIntValueNode(&parseTree, stepSize, tokenItty->mLineNum) );
+		CAddCommandNode	*	theIncrementOperation = parseTree.NewNode<CAddCommandNode>( tokenItty->mLineNum, mFileName );
+		theIncrementOperation->AddParam( parseTree.NewNode<CLocalVariableRefValueNode>( currFunction, tempName, tempName, tokenItty->mLineNum) );
+		theIncrementOperation->AddParam( parseTree.NewNode<CIntValueNode>( stepSize, tokenItty->mLineNum) );
 		whileLoop->AddCommand( theIncrementOperation );	// TODO: Need to dispose this on exceptions above.
 		
 		currFunction->AddCommand( whileLoop );
@@ -2580,9 +2911,9 @@ void	CParser::ParseRepeatStatement( const std::string& userHandlerName, CParseTr
 		
 		// tempName = 0;
 		std::string			tempName = CVariableEntry::GetNewTempName();
-		CCommandNode*		theAssignCommand = new CAssignCommandNode( &parseTree, conditionLineNum, mFileName );
-		theAssignCommand->AddParam( new CLocalVariableRefValueNode(&parseTree, currFunction, tempName, tempName, conditionLineNum) );
-		theAssignCommand->AddParam( new CIntValueNode(&parseTree, 0, tokenItty->mLineNum) );
+		CCommandNode*		theAssignCommand = parseTree.NewNode<CAssignCommandNode>( conditionLineNum, mFileName );
+		theAssignCommand->AddParam( parseTree.NewNode<CLocalVariableRefValueNode>( currFunction, tempName, tempName, conditionLineNum) );
+		theAssignCommand->AddParam( parseTree.NewNode<CIntValueNode>( 0, tokenItty->mLineNum) );
 		currFunction->AddCommand( theAssignCommand );
 		
 		// countNum:
@@ -2592,12 +2923,12 @@ void	CParser::ParseRepeatStatement( const std::string& userHandlerName, CParseTr
 		if( tokenItty->IsIdentifier( ETimesIdentifier ) )
 			CTokenizer::GoNextToken( mFileName, tokenItty, tokens );	// Skip "times".
 		
-		CWhileLoopNode*		whileLoop = new CWhileLoopNode( &parseTree, conditionLineNum, mFileName, currFunction );
+		CWhileLoopNode*		whileLoop = parseTree.NewNode<CWhileLoopNode>( conditionLineNum, mFileName, currFunction );
 		currFunction->AddCommand( whileLoop );
 		
 		// while( tempName < countExpression )
-		COperatorNode*	theComparison = new COperatorNode( &parseTree, LESS_THAN_OPERATOR_INSTR, conditionLineNum );
-		theComparison->AddParam( new CLocalVariableRefValueNode(&parseTree, currFunction, tempName, tempName, conditionLineNum) );
+		COperatorNode*	theComparison = parseTree.NewNode<COperatorNode>( LESS_THAN_OPERATOR_INSTR, conditionLineNum );
+		theComparison->AddParam( parseTree.NewNode<CLocalVariableRefValueNode>( currFunction, tempName, tempName, conditionLineNum) );
 		if( !countExpression )
 			ThrowDeferrableError( tokenItty, tokens, "Expected an expression with the number of repetitions here." );
 		theComparison->AddParam( countExpression );
@@ -2611,9 +2942,9 @@ void	CParser::ParseRepeatStatement( const std::string& userHandlerName, CParseTr
 		}
 		
 		// tempName += 1;
-		CAddCommandNode	*	theIncrementOperation = new CAddCommandNode( &parseTree, tokenItty->mLineNum, mFileName );
-		theIncrementOperation->AddParam( new CLocalVariableRefValueNode(&parseTree, currFunction, tempName, tempName, tokenItty->mLineNum) );
-		theIncrementOperation->AddParam( new CIntValueNode(&parseTree, 1, tokenItty->mLineNum) );
+		CAddCommandNode	*	theIncrementOperation = parseTree.NewNode<CAddCommandNode>( tokenItty->mLineNum, mFileName );
+		theIncrementOperation->AddParam( parseTree.NewNode<CLocalVariableRefValueNode>( currFunction, tempName, tempName, tokenItty->mLineNum) );
+		theIncrementOperation->AddParam( parseTree.NewNode<CIntValueNode>( 1, tokenItty->mLineNum) );
 		whileLoop->AddCommand( theIncrementOperation );
 		
 		CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
@@ -2624,7 +2955,7 @@ void	CParser::ParseRepeatStatement( const std::string& userHandlerName, CParseTr
 }
 
 	
-void CParser::ThrowDeferrableErrorThrow( const std::string& errMsg, std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens )
+void CParser::ThrowDeferrableErrorThrow( const std::string& errMsg, CTokenIterator& tokenItty, CTokenCursor& tokens )
 {
 	size_t lineNum = SIZE_MAX, offset = SIZE_MAX;
 	if( tokenItty != tokens.end() )
@@ -2632,107 +2963,101 @@ void CParser::ThrowDeferrableErrorThrow( const std::string& errMsg, std::deque<C
 		lineNum = tokenItty->mLineNum;
 		offset = tokenItty->mOffset;
 	}
-	else if( tokenItty == tokens.end() && tokens.size() > 0 )
+	else if( tokens.GetLastToken() )
 	{
-		lineNum = tokens.back().mLineNum;
-		offset = tokens.back().mOffset;
+		lineNum = tokens.GetLastToken()->mLineNum;
+		offset = tokens.GetLastToken()->mOffset;
 	}
-	mMessages.push_back( CMessageEntry( EMessageTypeError, errMsg, mFileName, tokenItty->mLineNum ) );
-	throw CForgeParseError( errMsg, tokenItty->mLineNum, tokenItty->mOffset );
+	mMessages.push_back( CMessageEntry( EMessageTypeError, errMsg, mFileName, lineNum ) );
+	throw CForgeParseError( errMsg, lineNum, offset );
 }
 	
 
 void	CParser::ParseIfStatement( const std::string& userHandlerName, CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-										std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens )
+										CTokenIterator& tokenItty, CTokenCursor& tokens )
 {
 	size_t			conditionLineNum = tokenItty->mLineNum;
-	CIfNode*		ifNode = new CIfNode( &parseTree, conditionLineNum, mFileName, currFunction );
-	try
-	{
-		// If:
+	CIfNode*		ifNode = parseTree.NewNode<CIfNode>( conditionLineNum, mFileName, currFunction );
+	// If:
+	CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
+	
+	// Condition:
+	CValueNode*			condition = ParseExpression( parseTree, currFunction, tokenItty, tokens, ELastIdentifier_Sentinel );
+	ifNode->SetCondition( condition );
+	
+	while( tokenItty->IsIdentifier(ENewlineOperator) )
 		CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
-		
-		// Condition:
-		CValueNode*			condition = ParseExpression( parseTree, currFunction, tokenItty, tokens, ELastIdentifier_Sentinel );
-		ifNode->SetCondition( condition );
-		
-		while( tokenItty->IsIdentifier(ENewlineOperator) )
-			CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
-		
-		// Then:
-		tokenItty->ExpectIdentifier( mFileName, EThenIdentifier );
-		ifNode->SetThenLineNum( tokenItty->mLineNum );
+	
+	// Then:
+	tokenItty->ExpectIdentifier( mFileName, EThenIdentifier );
+	ifNode->SetThenLineNum( tokenItty->mLineNum );
+	CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
+	
+	bool	needEndIf = true;
+	
+	if( tokenItty->IsIdentifier( ENewlineOperator ) )
+	{
 		CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
-		
-		bool	needEndIf = true;
-		
-		if( tokenItty->IsIdentifier( ENewlineOperator ) )
+		// Commands:
+		ifNode->SetIfCommandsLineNum( tokenItty->mLineNum );
+		while( !tokenItty->IsIdentifier( EEndIdentifier ) && !tokenItty->IsIdentifier( EElseIdentifier ) )
 		{
-			CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
-			// Commands:
-			ifNode->SetIfCommandsLineNum( tokenItty->mLineNum );
-			while( !tokenItty->IsIdentifier( EEndIdentifier ) && !tokenItty->IsIdentifier( EElseIdentifier ) )
-			{
-				ParseOneLine( userHandlerName, parseTree, ifNode, tokenItty, tokens );
-			}
-		}
-		else
-		{
-			ifNode->SetIfCommandsLineNum( tokenItty->mLineNum );
-			ParseOneLine( userHandlerName, parseTree, ifNode, tokenItty, tokens, true );
-			needEndIf = false;
+			ParseOneLine( userHandlerName, parseTree, ifNode, tokenItty, tokens );
 		}
+	}
+	else
+	{
+		ifNode->SetIfCommandsLineNum( tokenItty->mLineNum );
+		ParseOneLine( userHandlerName, parseTree, ifNode, tokenItty, tokens, true );
+		needEndIf = false;
+	}
+	
+	bool	skippedLineEnd = false;	// In case there's no 'else', we need to leave a line break for ParseOneLine() to parse.
+	while( tokenItty != tokens.end() && tokenItty->IsIdentifier(ENewlineOperator) )
+	{
+		CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
+		skippedLineEnd = true;
+	}
+	
+	// Else:
+	if( tokenItty != tokens.end() && tokenItty->IsIdentifier( EElseIdentifier ) )	// It's an "else"! Parse another block!
+	{
+		ifNode->SetElseLineNum( tokenItty->mLineNum );
+		CCodeBlockNode*		elseNode = ifNode->CreateElseBlock( tokenItty->mLineNum );
 		
-		std::deque<CToken>::iterator	beforeLineEnd = tokenItty;	// Remember position before line end in case there's no 'else'. We need to leave a line break for ParseOneLine() to parse.
-
-		while( tokenItty->IsIdentifier(ENewlineOperator) )
-			CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
+		CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
 		
-		// Else:
-		if( tokenItty->IsIdentifier( EElseIdentifier ) )	// It's an "else"! Parse another block!
+		if( tokenItty->IsIdentifier(ENewlineOperator) )	// Followed by a newline! Multi-line if!
 		{
-			ifNode->SetElseLineNum( tokenItty->mLineNum );
-			CCodeBlockNode*		elseNode = ifNode->CreateElseBlock( tokenItty->mLineNum );
-			
 			CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
-			
-			if( tokenItty->IsIdentifier(ENewlineOperator) )	// Followed by a newline! Multi-line if!
-			{
+			ifNode->SetElseCommandsLineNum( tokenItty->mLineNum );
+			while( tokenItty->IsIdentifier(ENewlineOperator) )
 				CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
-				ifNode->SetElseCommandsLineNum( tokenItty->mLineNum );
-				while( tokenItty->IsIdentifier(ENewlineOperator) )
-					CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
-				while( !tokenItty->IsIdentifier( EEndIdentifier ) )
-				{
-					ParseOneLine( userHandlerName, parseTree, elseNode, tokenItty, tokens );
-				}
-				needEndIf = true;
-			}
-			else
+			while( !tokenItty->IsIdentifier( EEndIdentifier ) )
 			{
-				ifNode->SetElseCommandsLineNum( tokenItty->mLineNum );
-				ifNode->SetEndIfLineNum( tokenItty->mLineNum );
-				ParseOneLine( userHandlerName, parseTree, elseNode, tokenItty, tokens, true );	// Don't swallow return.
-				needEndIf = false;
+				ParseOneLine( userHandlerName, parseTree, elseNode, tokenItty, tokens );
 			}
+			needEndIf = true;
 		}
-		else if( needEndIf == false )
-			tokenItty = beforeLineEnd;	// Leave a return at the end of the line (which the code above skipped) so ParseOneLine() can detect we're really at the end of the line.
-		
-		// End If:
-		if( needEndIf && tokenItty->IsIdentifier( EEndIdentifier ) )
+		else
 		{
-			CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
-			if( !tokenItty->IsIdentifier(EIfIdentifier) )
-				ThrowDeferrableError( tokenItty, tokens, "Expected \"end if\" here, found ", tokenItty->GetShortDescription(), "." );
+			ifNode->SetElseCommandsLineNum( tokenItty->mLineNum );
 			ifNode->SetEndIfLineNum( tokenItty->mLineNum );
-			CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
+			ParseOneLine( userHandlerName, parseTree, elseNode, tokenItty, tokens, true );	// Don't swallow return.
+			needEndIf = false;
 		}
 	}
-	catch( ... )
+	else if( needEndIf == false && skippedLineEnd )
+		CTokenizer::GoPreviousToken( mFileName, tokenItty, tokens );	// Leave a return at the end of the line (which the code above skipped) so ParseOneLine() can detect we're really at the end of the line. The last one will do, ParseOneLine() skips any others, and a CStreamingTokenCursor may not have kept the first one around.
+	
+	// End If:
+	if( needEndIf && tokenItty->IsIdentifier( EEndIdentifier ) )
 	{
-		delete ifNode;
-		throw;
+		CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
+		if( !tokenItty->IsIdentifier(EIfIdentifier) )
+			ThrowDeferrableError( tokenItty, tokens, "Expected \"end if\" here, found ", tokenItty->GetShortDescription(), "." );
+		ifNode->SetEndIfLineNum( tokenItty->mLineNum );
+		CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
 	}
 	
 	currFunction->AddCommand( ifNode );
@@ -2742,7 +3067,7 @@ void	CParser::ParseIfStatement( const std::string& userHandlerName, CParseTree&
 
 
 CValueNode*	CParser::ParseArrayItem( CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-								std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens )
+								CTokenIterator& tokenItty, CTokenCursor& tokens )
 {
 	CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
 	
@@ -2759,19 +3084,19 @@ CValueNode*	CParser::ParseArrayItem( CParseTree& parseTree, CCodeBlockNodeBase*
 	CValueNode*			theTarget = ParseContainer( false, true, parseTree, currFunction, tokenItty, tokens, ELastIdentifier_Sentinel );
 	
 	// put entry <itemNumber> of <container> into temp1
-	CGetArrayItemNode*	getItemNode = new CGetArrayItemNode( &parseTree, containerLineNum, mFileName );
-	getItemNode->AddParam( new CLocalVariableRefValueNode(&parseTree, currFunction, tempName, tempName, containerLineNum) );
+	CGetArrayItemNode*	getItemNode = parseTree.NewNode<CGetArrayItemNode>( containerLineNum, mFileName );
+	getItemNode->AddParam( parseTree.NewNode<CLocalVariableRefValueNode>( currFunction, tempName, tempName, containerLineNum) );
 	getItemNode->AddParam( theIndex );
 	getItemNode->AddParam( theTarget );
 	currFunction->AddCommand( getItemNode );
 	
 	// return temp1
-	return new CLocalVariableRefValueNode(&parseTree, currFunction, tempName, tempName, containerLineNum);	// TODO: delete stuff on exceptions before this.
+	return parseTree.NewNode<CLocalVariableRefValueNode>( currFunction, tempName, tempName, containerLineNum);	// TODO: delete stuff on exceptions before this.
 }
 
 
 CValueNode*	CParser::ParseContainer( bool asPointer, bool initWithName, CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-								std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens, TIdentifierSubtype inEndToken )
+								CTokenIterator& tokenItty, CTokenCursor& tokens, TIdentifierSubtype inEndToken )
 {
 	if( tokenItty == tokens.end() )
 		return nullptr;
@@ -2791,7 +3116,7 @@ CValueNode*	CParser::ParseContainer( bool asPointer, bool initWithName, CParseTr
 	if( tokenItty->IsIdentifier( EMyIdentifier ) )
 	{
 		assert(kFirstPropertyInstruction != 0);
-		COperatorNode*		meContainer = new COperatorNode( &parseTree, kFirstPropertyInstruction +PUSH_ME_INSTR, tokenItty->mLineNum );
+		COperatorNode*		meContainer = parseTree.NewNode<COperatorNode>( kFirstPropertyInstruction +PUSH_ME_INSTR, tokenItty->mLineNum );
 		
 		CTokenizer::GoNextToken( mFileName, tokenItty, tokens );	// skip "my".
 		
@@ -2809,7 +3134,7 @@ CValueNode*	CParser::ParseContainer( bool asPointer, bool initWithName, CParseTr
 		
 		// Look for actual property name:
 		propName.append( tokenItty->GetIdentifierText() );
-		CObjectPropertyNode	*	propExpr = new CObjectPropertyNode( &parseTree, propName, tokenItty->mLineNum );
+		CObjectPropertyNode	*	propExpr = parseTree.NewNode<CObjectPropertyNode>( propName, tokenItty->mLineNum );
 		propExpr->AddParam( meContainer );
 
 		CTokenizer::GoNextToken( mFileName, tokenItty, tokens );	// skip property name.
@@ -2819,7 +3144,7 @@ CValueNode*	CParser::ParseContainer( bool asPointer, bool initWithName, CParseTr
 	else if( tokenItty->IsIdentifier( EMeIdentifier ) )	// A reference to the object owning this script?
 	{
 		assert(kFirstPropertyInstruction != 0);
-		COperatorNode*		hostCommand = new COperatorNode( &parseTree, kFirstPropertyInstruction +PUSH_ME_INSTR, tokenItty->mLineNum );
+		COperatorNode*		hostCommand = parseTree.NewNode<COperatorNode>( kFirstPropertyInstruction +PUSH_ME_INSTR, tokenItty->mLineNum );
 		CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
 		return hostCommand;
 	}
@@ -2836,7 +3161,7 @@ CValueNode*	CParser::ParseContainer( bool asPointer, bool initWithName, CParseTr
 		if( !container && currFunction->LocalVariableExists( varName ) )
 		{
 			CreateVariable( varName, realVarName, initWithName, currFunction, currFunction->GetAllVarsAreGlobals() );
-			container = new CLocalVariableRefValueNode( &parseTree, currFunction, varName, realVarName, tokenItty->mLineNum );
+			container = parseTree.NewNode<CLocalVariableRefValueNode>( currFunction, varName, realVarName, tokenItty->mLineNum );
 			
 			CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
 			
@@ -2862,9 +3187,9 @@ CValueNode*	CParser::ParseContainer( bool asPointer, bool initWithName, CParseTr
 			
 			if( targetObj )
 			{
-				CObjectPropertyNode	*	propExpr = new CObjectPropertyNode( &parseTree, "", lineNum );
+				CObjectPropertyNode	*	propExpr = parseTree.NewNode<CObjectPropertyNode>( "", lineNum );
 				propExpr->AddParam( targetObj );
-				CArrayValueNode * keyPath = new CArrayValueNode( &parseTree, lineNum );
+				CArrayValueNode * keyPath = parseTree.NewNode<CArrayValueNode>( lineNum );
 				keyPath->AddItem( propNameTerm );
 				propExpr->AddParam( keyPath );
 				container = propExpr;
@@ -2881,15 +3206,15 @@ CValueNode*	CParser::ParseContainer( bool asPointer, bool initWithName, CParseTr
 	}
 	
 	// Otherwise try to parse a built-in variable:
-	for( int bivIdx = 0; sBuiltInVariables[bivIdx].mType != ELastIdentifier_Sentinel; ++bivIdx )
+	for( int bivIdx = 0; mGrammar->mBuiltInVariables[bivIdx].mType != ELastIdentifier_Sentinel; ++bivIdx )
 	{
-		TBuiltInVariableEntry* currVar = sBuiltInVariables + bivIdx;
+		const TBuiltInVariableEntry* currVar = &mGrammar->mBuiltInVariables[bivIdx];
 		if( tokenItty->IsIdentifier( currVar->mType ) )
 		{
 			std::string		realDVarName( currVar->mUserVariableName );
 			std::string		dVarName( currVar->mVariableName );
 			CreateVariable( dVarName, realDVarName, initWithName, currFunction, currVar->mIsGlobal || currFunction->GetAllVarsAreGlobals() );
-			container = new CLocalVariableRefValueNode( &parseTree, currFunction, dVarName, realDVarName, tokenItty->mLineNum );
+			container = parseTree.NewNode<CLocalVariableRefValueNode>( currFunction, dVarName, realDVarName, tokenItty->mLineNum );
 			
 			CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
 			return container;
@@ -2931,7 +3256,7 @@ CValueNode*	CParser::ParseContainer( bool asPointer, bool initWithName, CParseTr
 				
 				if( targetObj )
 				{
-					CObjectPropertyNode	*	propExpr = new CObjectPropertyNode( &parseTree, propName, lineNum );
+					CObjectPropertyNode	*	propExpr = parseTree.NewNode<CObjectPropertyNode>( propName, lineNum );
 					propExpr->AddParam( targetObj );
 					container = propExpr;
 				}
@@ -2947,7 +3272,7 @@ CValueNode*	CParser::ParseContainer( bool asPointer, bool initWithName, CParseTr
 	}
 	
 	// Check if it could be a global property expression:
-	if( !container && sGlobalProperties )
+	if( !container )
 	{
 		TIdentifierSubtype		subType = tokenItty->GetIdentifierSubType();
 		TIdentifierSubtype		qualifierType = ELastIdentifier_Sentinel;
@@ -2962,11 +3287,11 @@ CValueNode*	CParser::ParseContainer( bool asPointer, bool initWithName, CParseTr
 		// Find it in our list of global properties:
 		int				x = 0;
 		
-		for( x = 0; sGlobalProperties[x].mType != ELastIdentifier_Sentinel; x++ )
+		for( x = 0; mGrammar->mGlobalProperties[x].mType != ELastIdentifier_Sentinel; x++ )
 		{
-			if( sGlobalProperties[x].mType == subType && sGlobalProperties[x].mPrefixType == qualifierType )
+			if( mGrammar->mGlobalProperties[x].mType == subType && mGrammar->mGlobalProperties[x].mPrefixType == qualifierType )
 			{
-				container = new CGlobalPropertyNode( &parseTree, sGlobalProperties[x].mSetterInstructionID, sGlobalProperties[x].mGetterInstructionID, gIdentifierStrings[subType], tokenItty->mLineNum );
+				container = parseTree.NewNode<CGlobalPropertyNode>( mGrammar->mGlobalProperties[x].mSetterInstructionID, mGrammar->mGlobalProperties[x].mGetterInstructionID, gIdentifierStrings[subType], tokenItty->mLineNum );
 				CTokenizer::GoNextToken( mFileName, tokenItty, tokens );	// Skip the property name.
 				break;
 			}
@@ -2980,7 +3305,7 @@ CValueNode*	CParser::ParseContainer( bool asPointer, bool initWithName, CParseTr
 	if( !container && !tokenItty->IsIdentifier(ENewlineOperator) )
 	{
 		CreateVariable( varName, realVarName, initWithName, currFunction, currFunction->GetAllVarsAreGlobals() );
-		container = new CLocalVariableRefValueNode( &parseTree, currFunction, varName, realVarName, tokenItty->mLineNum );
+		container = parseTree.NewNode<CLocalVariableRefValueNode>( currFunction, varName, realVarName, tokenItty->mLineNum );
 		
 		CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
 	}
@@ -3008,7 +3333,7 @@ void	CParser::CreateVariable( const std::string& varName, const std::string& rea
 
 
 void	CParser::ParseOneLine( const std::string& userHandlerName, CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-								std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens,
+								CTokenIterator& tokenItty, CTokenCursor& tokens,
 								bool dontSwallowReturn )
 {
 	bool	hadWebContentToken = false;
@@ -3016,77 +3341,29 @@ void	CParser::ParseOneLine( const std::string& userHandlerName, CParseTree& pars
 	while( tokenItty != tokens.end() && tokenItty->IsIdentifier(ENewlineOperator) )
 		CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
 	
-	CLineMarkerNode*	lineMarker = new CLineMarkerNode( &parseTree, tokenItty->mLineNum, mFileName );
+	CLineMarkerNode*	lineMarker = parseTree.NewNode<CLineMarkerNode>( tokenItty->mLineNum, mFileName );
 	currFunction->AddCommand( lineMarker );
 	
 	if( tokenItty->mType == EIdentifierToken && tokenItty->mSubType == ELastIdentifier_Sentinel )	// Unknown identifier.
 		ParseHandlerCall( parseTree, currFunction, false, tokenItty, tokens );
-	else if( tokenItty->IsIdentifier(EPutIdentifier) )		// put command.
-		ParsePutStatement( parseTree, currFunction, tokenItty, tokens );
-	else if( tokenItty->IsIdentifier(EDownloadIdentifier) )
-		ParseDownloadStatement( userHandlerName, parseTree, currFunction, tokenItty, tokens );
-	else if( tokenItty->IsIdentifier(EReturnIdentifier) )
-		ParseReturnStatement( parseTree, currFunction, tokenItty, tokens );
-	else if( tokenItty->IsIdentifier(EPassIdentifier) )
-		ParsePassStatement( parseTree, currFunction, tokenItty, tokens );
-	else if( tokenItty->IsIdentifier(EExitIdentifier) )
-	{
-		CTokenizer::GoNextToken( mFileName, tokenItty, tokens );	// Skip "exit".
-		if( tokenItty->IsIdentifier(ERepeatIdentifier) )
-		{
-			CCommandNode*	theExitRepeatCommand = new CCommandNode( &parseTree, "ExitRepeat", tokenItty->mLineNum, mFileName );
-			currFunction->AddCommand( theExitRepeatCommand );
-			CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
-		}
-		else if( strcasecmp(tokenItty->GetIdentifierText().c_str(), userHandlerName.c_str()) == 0 )
-		{
-			CCommandNode*	theReturnCommand = new CReturnCommandNode( &parseTree, tokenItty->mLineNum, mFileName );
-			currFunction->AddCommand( theReturnCommand );
-			theReturnCommand->AddParam( new CStringValueNode(&parseTree, "", tokenItty->mLineNum) );
-			CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
-		}
-		else
-		{
-			ThrowDeferrableError( tokenItty, tokens, "Expected \"exit repeat\" or \"exit ", userHandlerName, "\", found ", tokenItty->GetShortDescription(), "." );
-		}
-	}
-	else if( tokenItty->IsIdentifier(ENextIdentifier) )
-	{
-		CTokenizer::GoNextToken( mFileName, tokenItty, tokens );	// Skip "next".
-		if( tokenItty->IsIdentifier(ERepeatIdentifier) )
-		{
-			CCommandNode*	theNextRepeatCommand = new CCommandNode( &parseTree, "NextRepeat", tokenItty->mLineNum, mFileName );
-			currFunction->AddCommand( theNextRepeatCommand );
-			CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
-		}
-		else
-			ThrowDeferrableError( tokenItty, tokens, "Expected \"next repeat\", found ", tokenItty->GetShortDescription(), "." );
-	}
-	else if( tokenItty->IsIdentifier(ERepeatIdentifier) )
-		ParseRepeatStatement( userHandlerName, parseTree, currFunction, tokenItty, tokens );
-	else if( tokenItty->IsIdentifier(EIfIdentifier) )
-		ParseIfStatement( userHandlerName, parseTree, currFunction, tokenItty, tokens );
-	else if( tokenItty->IsIdentifier(EAddIdentifier) )
-		ParseAddStatement( parseTree, currFunction, tokenItty, tokens );
-	else if( tokenItty->IsIdentifier(ESubtractIdentifier) )
-		ParseSubtractStatement( parseTree, currFunction, tokenItty, tokens );
-	else if( tokenItty->IsIdentifier(EMultiplyIdentifier) )
-		ParseMultiplyStatement( parseTree, currFunction, tokenItty, tokens );
-	else if( tokenItty->IsIdentifier(EDivideIdentifier) )
-		ParseDivideStatement( parseTree, currFunction, tokenItty, tokens );
-	else if( tokenItty->IsIdentifier(EGetIdentifier) )
-		ParseGetStatement( parseTree, currFunction, tokenItty, tokens );
-	else if( tokenItty->IsIdentifier(ESetIdentifier) )
-		ParseSetStatement( parseTree, currFunction, tokenItty, tokens );
-	else if( tokenItty->IsIdentifier(EGlobalIdentifier) )
-		ParseGlobalStatement( parseTree, currFunction, tokenItty, tokens );
 	else if( tokenItty->mType == EWebPageContentToken )
 	{
 		ParseWebPageContentToken( parseTree, currFunction, tokenItty, tokens );
 		hadWebContentToken = true;
 	}
 	else
-		ParseHostCommand( parseTree, currFunction, tokenItty, tokens );
+	{
+		const TStatementEntry*	statement = NULL;
+		if( tokenItty->mType == EIdentifierToken )
+			statement = mGrammar->mStatementsByIdentifier[ tokenItty->GetIdentifierSubType() ];
+		
+		if( statement && statement->mParser )
+			(this->*statement->mParser)( parseTree, currFunction, tokenItty, tokens );
+		else if( statement )
+			(this->*statement->mHandlerParser)( userHandlerName, parseTree, currFunction, tokenItty, tokens );
+		else
+			ParseHostCommand( parseTree, currFunction, tokenItty, tokens );
+	}
 	
 	// End this line:
 	if( !dontSwallowReturn && tokenItty != tokens.end() )
@@ -3102,7 +3379,7 @@ void	CParser::ParseOneLine( const std::string& userHandlerName, CParseTree& pars
 
 void	CParser::ParseFunctionBody( std::string& userHandlerName,
 									CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-									std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens,
+									CTokenIterator& tokenItty, CTokenCursor& tokens,
 								    size_t *outEndLineNum, TIdentifierSubtype endIdentifier, bool parseFirstLineAsReturnExpression )
 {
 	if( parseFirstLineAsReturnExpression && tokenItty != tokens.end() && tokenItty->mType == EIdentifierToken )
@@ -3122,12 +3399,11 @@ void	CParser::ParseFunctionBody( std::string& userHandlerName,
 	
 	if( parseFirstLineAsReturnExpression )
 	{
-		CCommandNode*	theReturnCommand = new CReturnCommandNode( &parseTree, (tokenItty != tokens.end()) ? tokenItty->mLineNum : 1, mFileName );
+		CCommandNode*	theReturnCommand = parseTree.NewNode<CReturnCommandNode>( (tokenItty != tokens.end()) ? tokenItty->mLineNum : 1, mFileName );
 		
 		CValueNode*	theWhatNode = ParseExpression( parseTree, currFunction, tokenItty, tokens, endIdentifier );
 		if( !theWhatNode )	// Empty string passed in?
 		{
-			delete theReturnCommand;
 			return;
 		}
 		theReturnCommand->AddParam( theWhatNode );
@@ -3161,7 +3437,7 @@ void	CParser::ParseFunctionBody( std::string& userHandlerName,
 // Parse a list of expressions separated by commas for passing to a handler as a parameter list:
 void	CParser::ParseParamList( TIdentifierSubtype identifierToEndOn,
 								CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-								std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens,
+								CTokenIterator& tokenItty, CTokenCursor& tokens,
 								CFunctionCallNode* inFCallToAddTo )
 {
 	if( tokenItty == tokens.end() )
@@ -3187,158 +3463,396 @@ void	CParser::ParseParamList( TIdentifierSubtype identifierToEndOn,
 }
 
 
-TIdentifierSubtype	CParser::ParseOperator( std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens, int *outPrecedence, LEOInstructionID *outOpName )
+TIdentifierSubtype	CParser::ParseOperator( CTokenIterator& tokenItty, CTokenCursor& tokens, int *outPrecedence, LEOInstructionID *outOpName )
 {
-	if( tokenItty->mType != EIdentifierToken )
+	if( tokenItty == tokens.end() || tokenItty->mType != EIdentifierToken )
 		return ELastIdentifier_Sentinel;
 	
-	int		x = 0;
-	for( ; sOperators[x].mType != ELastIdentifier_Sentinel; x++ )
-	{
-		if( tokenItty->IsIdentifier( sOperators[x].mType ) )
-		{
-			CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
-			
-			// Is single-token operator and matches?
-			if( sOperators[x].mSecondType == ELastIdentifier_Sentinel )
-			{
-				*outPrecedence = sOperators[x].mPrecedence;
-				*outOpName = sOperators[x].mInstructionID;
-				
-				return sOperators[x].mTypeToReturn;
-			}
-			else if( tokenItty->IsIdentifier(sOperators[x].mSecondType) )
-			{
-				CTokenizer::GoNextToken( mFileName, tokenItty, tokens );	// Swallow second operator token, too.
-				*outPrecedence = sOperators[x].mPrecedence;
-				*outOpName = sOperators[x].mInstructionID;
-				
-				return sOperators[x].mTypeToReturn;
-			}
-			else
-				CTokenizer::GoPreviousToken( mFileName, tokenItty, tokens );	// Backtrack so we don't accidentally swallow the token following this operator.
-		}
-	}
-	
-	return ELastIdentifier_Sentinel;
-}
-
-
-// -----------------------------------------------------------------------------
-//	CollapseExpressionStack ():
-//		Take the passed lists of terms and operators and go over them from
-//		the right end, generating a function call for the rightmost operator/two
-//		terms combination and than pushing that call back on the tree for use
-//		as the rightmost argument of the next operator.
-// -----------------------------------------------------------------------------
-
-CValueNode*	CParser::CollapseExpressionStack( CParseTree& parseTree, std::deque<CValueNode*> &terms, std::deque<LEOInstructionID> &operators )
-{
-	CValueNode*			operandA = NULL;
-	LEOInstructionID	opName = NULL;
-
-	while( terms.size() > 1 )	// More than 1 operand? Process stuff on stack.
+	const std::vector<size_t>&		candidates = mGrammar->mOperatorsByIdentifier[ tokenItty->GetIdentifierSubType() ];
+	CTokenIterator	nextTokenItty = tokenItty +1;
+	for( size_t candidateIdx = 0; candidateIdx < candidates.size(); candidateIdx++ )
 	{
-		CValueNode*			operandB = NULL;
-		
-		opName = operators.back();
-		operators.pop_back();
+		const TOperatorEntry	*	currOp = &mGrammar->mOperators[ candidates[candidateIdx] ];
 		
-		operandB = terms.back();
-		terms.pop_back();
-		
-		operandA = terms.back();
-		terms.pop_back();
+		// Is single-token operator and matches?
+		if( currOp->mSecondType == ELastIdentifier_Sentinel )
+			tokenItty = nextTokenItty;
+		else if( nextTokenItty != tokens.end() && nextTokenItty->IsIdentifier(currOp->mSecondType) )
+			tokenItty = nextTokenItty +1;	// Swallow second operator token, too.
+		else
+			continue;	// Try next operator, we haven't swallowed anything yet.
 		
-		COperatorNode*	currOperation = new COperatorNode( &parseTree, opName, operandA->GetLineNum() );
-		currOperation->AddParam( operandA );
-		currOperation->AddParam( operandB );
+		*outPrecedence = currOp->mPrecedence;
+		*outOpName = currOp->mInstructionID;
 		
-		terms.push_back( currOperation );
+		return currOp->mTypeToReturn;
 	}
 	
-	operandA = terms.back();
-	terms.pop_back();
-	
-//	operandA->DebugPrint( std::cout, 0 );
-	
-	return operandA;
+	return ELastIdentifier_Sentinel;
 }
 
 
 // -----------------------------------------------------------------------------
 //	ParseExpression ():
 //		Parse an expression from the given token stream, adding any variables
-//		and commands needed to the given function. This uses a stack to collect
-//		all terms and operators, and collapses subexpressions whenever the
-//		operator precedence goes down.
+//		and commands needed to the given function.
+//
+//		Operators group to the right as long as their precedence doesn't go
+//		down, so "a + b * c" is "a + (b * c)", but "a - b - c" is also
+//		"a - (b - c)". Once the precedence goes down, everything parsed so far
+//		becomes the left operand of the new operator, e.g. "a * b + c" is
+//		"(a * b) + c". We build this tree in one pass: runRoot is the
+//		operation at the top of the current run of operators, and
+//		openOperation the innermost one of those, which is still waiting for
+//		its right operand.
 // -----------------------------------------------------------------------------
 
 CValueNode*	CParser::ParseExpression( CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-										std::deque<CToken>::iterator& tokenItty,
-										std::deque<CToken>& tokens, TIdentifierSubtype inEndToken )
+										CTokenIterator& tokenItty,
+										CTokenCursor& tokens, TIdentifierSubtype inEndToken )
 {
 	if( tokenItty == tokens.end() )
 		return NULL;
 	
-	std::deque<CValueNode*>			terms;
-	std::deque<LEOInstructionID>	operators;
-	CValueNode*						currArg;
-	TIdentifierSubtype				currOpType = ELastIdentifier_Sentinel;
+	CValueNode*						lastTerm = NULL;
+	CValueNode*						runRoot = NULL;
+	COperatorNode*					openOperation = NULL;
 	int								currPrecedence = 0,
 									prevPrecedence = 0;
 	LEOInstructionID				opName = INVALID_INSTR;
 	
-	currArg = ParseTerm( parseTree, currFunction, tokenItty, tokens, inEndToken );
-	if( !currArg )
+	lastTerm = ParseTerm( parseTree, currFunction, tokenItty, tokens, inEndToken );
+	if( !lastTerm )
 		return NULL;
-	terms.push_back( currArg );
-	currArg = NULL;
 	
-	while( (currOpType = ParseOperator( tokenItty, tokens, &currPrecedence, &opName )) != ELastIdentifier_Sentinel )
+	while( ParseOperator( tokenItty, tokens, &currPrecedence, &opName ) != ELastIdentifier_Sentinel )
 	{
-		if( prevPrecedence > currPrecedence )
+		if( openOperation && prevPrecedence > currPrecedence )	// Precedence went down? Finish this run, it's our new left operand.
 		{
-			CValueNode*	collapsedOp = CollapseExpressionStack( parseTree, terms, operators );
-			terms.push_back( collapsedOp );
+			openOperation->AddParam( lastTerm );
+			lastTerm = runRoot;
+			runRoot = NULL;
+			openOperation = NULL;
 		}
+		
+		COperatorNode*	currOperation = parseTree.NewNode<COperatorNode>( opName, lastTerm->GetLineNum() );
+		currOperation->AddParam( lastTerm );
+		if( openOperation )
+			openOperation->AddParam( currOperation );
+		else
+			runRoot = currOperation;
+		openOperation = currOperation;
 
-		currArg = ParseTerm( parseTree, currFunction, tokenItty, tokens, inEndToken );
-		if( !currArg )
+		lastTerm = ParseTerm( parseTree, currFunction, tokenItty, tokens, inEndToken );
+		if( !lastTerm )
 			ThrowDeferrableError( tokenItty, tokens, "Expected term here, found end of script." );
-		terms.push_back( currArg );
-		currArg = NULL;
-		
-		operators.push_back( opName );
 		
 		prevPrecedence = currPrecedence;
 	}
 	
-	return CollapseExpressionStack( parseTree, terms, operators );
+	if( openOperation )
+	{
+		openOperation->AddParam( lastTerm );
+		lastTerm = runRoot;
+	}
+	
+	return lastTerm;
 }
 	
 	
-TBuiltInFunctionEntry* CParser::GetBuiltInFunctionWithName( const std::string& inName )
+const TBuiltInFunctionEntry* CParser::GetBuiltInFunctionWithName( const std::string& inName )
 {
-	if( !sBuiltInFunctions )
-		return nullptr;
+	return CParserGrammar::GetCurrent()->GetBuiltInFunctionWithName( inName );
+}
+
+
+void	CParser::LoadNativeHeadersFromFile( const char* filepath )
+{
+	std::lock_guard<std::mutex>	lock( sNativeHeadersMutex );
 	
-	TIdentifierSubtype	subType = CToken::IdentifierTypeFromText( inName.c_str() );
-	for( int x = 0; sBuiltInFunctions[x].mType != ELastIdentifier_Sentinel; x++ )
+	std::shared_ptr<CNativeHeadersIndex>	index = CNativeHeadersIndex::Open( filepath );
+	if( index )
 	{
-		if( sBuiltInFunctions[x].mType == subType )
+		sNativeHeadersIndexes.push_back( index );
+		return;
+	}
+	
+	std::ifstream	headerFile( filepath, std::ios::in | std::ios::binary );
+	std::string		firstLine;
+	if( std::getline( headerFile, firstLine ) && firstLine == "!directory" )
+		LoadNativeHeadersDirectory( headerFile, filepath );	// Only remember where each symbol is, load it when a script uses it.
+	else
+	{
+		std::ifstream	wholeHeaderFile( filepath );
+		ParseNativeHeaders( wholeHeaderFile, sObjCMethodTable, sCFunctionTable, sCFunctionPointerTable, sSynonymToTypeTable, sConstantToValueTable );
+	}
+}
+
+
+/*
+	A directory at the start of a .hhc file lets us load only the frameworks
+	a script actually uses. It is made by AddDirectoryToNativeHeadersFile()
+	and looks like this:
+	
+		!directory
+		~synonym,type			All type synonyms, as any framework may use them.
+		$offset,length			One per section, offsets relative to the end of the directory.
+		>symbol,section			The section that defines each function, method or constant.
+		!enddirectory
+		F...					The sections, each one framework's F line and everything up to the next one.
+*/
+void	CParser::LoadNativeHeadersDirectory( std::istream& headerFile, const char* filepath )
+{
+	size_t		firstSection = sNativeHeadersSections.size();
+	std::string	currLine;
+	while( std::getline( headerFile, currLine ) && currLine != "!enddirectory" )
+	{
+		if( currLine.empty() )
+			continue;
+		
+		size_t	commaPos = currLine.find( ',' );
+		if( currLine[0] == '~' && commaPos != std::string::npos )
+		{
+			std::string		typeStr( currLine.substr( commaPos +1 ) );
+			typeStr.erase( std::remove( typeStr.begin(), typeStr.end(), ',' ), typeStr.end() );	// ParseNativeHeaders() drops those too.
+			sSynonymToTypeTable[currLine.substr( 1, commaPos -1 )] = typeStr;
+		}
+		else if( currLine[0] == '$' && commaPos != std::string::npos )
+		{
+			CNativeHeadersSection	newSection;
+			newSection.mFilePath = filepath;
+			newSection.mOffset = strtoll( currLine.c_str() +1, NULL, 10 );
+			newSection.mLength = strtoull( currLine.c_str() +commaPos +1, NULL, 10 );
+			newSection.mLoaded = false;
+			sNativeHeadersSections.push_back( newSection );
+		}
+		else if( currLine[0] == '>' && (commaPos = currLine.rfind( ',' )) != std::string::npos )
 		{
-			return( sBuiltInFunctions +x );
+			size_t	sectionIndex = firstSection + strtoull( currLine.c_str() +commaPos +1, NULL, 10 );
+			if( sectionIndex >= sNativeHeadersSections.size() )
+				throw std::runtime_error( std::string("Directory of native headers file \"") + filepath + "\" is damaged." );
+			sNativeHeadersSymbolSections[currLine.substr( 1, commaPos -1 )] = sectionIndex;
 		}
 	}
+	
+	std::streamoff	sectionsStart = headerFile.tellg();
+	if( sectionsStart < 0 )
+		throw std::runtime_error( std::string("Directory of native headers file \"") + filepath + "\" is damaged." );
+	for( size_t x = firstSection; x < sNativeHeadersSections.size(); x++ )
+		sNativeHeadersSections[x].mOffset += sectionsStart;
+}
 
-	return nullptr;
+
+bool	CParser::LoadNativeHeadersSectionForSymbol( const std::string& inName )
+{
+	std::map<std::string,size_t>::iterator	foundSymbol = sNativeHeadersSymbolSections.find( inName );
+	if( foundSymbol == sNativeHeadersSymbolSections.end() || sNativeHeadersSections[foundSymbol->second].mLoaded )
+		return false;
+	
+	size_t					sectionIndex = foundSymbol->second;
+	CNativeHeadersSection&	section = sNativeHeadersSections[sectionIndex];
+	
+	std::ifstream	headerFile( section.mFilePath, std::ios::in | std::ios::binary );
+	std::string		sectionText( section.mLength, '\0' );
+	if( !headerFile.seekg( section.mOffset ) || !headerFile.read( &sectionText[0], section.mLength ) )
+		throw std::runtime_error( std::string("Couldn't read native headers from \"") + section.mFilePath + "\"." );
+	
+	std::istringstream						sectionStream( sectionText );
+	std::map<std::string,CObjCMethodEntry>	objCMethods, cFunctions, cFunctionPointers;
+	std::map<std::string,std::string>		constantsToValues;
+	ParseNativeHeaders( sectionStream, objCMethods, cFunctions, cFunctionPointers, sSynonymToTypeTable, constantsToValues );
+	section.mLoaded = true;	// Only now, so if reading failed, the next lookup tries again and reports the error again.
+	
+	// Only take symbols the directory says are defined here, so if several frameworks
+	//	define a symbol, the one that would have won loading the whole file wins:
+	auto	isDefinedHere = [sectionIndex]( const std::string& inSymbol )
+	{
+		std::map<std::string,size_t>::iterator	foundSection = sNativeHeadersSymbolSections.find( inSymbol );
+		return foundSection == sNativeHeadersSymbolSections.end() || foundSection->second == sectionIndex;
+	};
+	std::pair<std::map<std::string,CObjCMethodEntry>*,std::map<std::string,CObjCMethodEntry>*>	methodTables[] =
+	{
+		{ &objCMethods, &sObjCMethodTable }, { &cFunctions, &sCFunctionTable }, { &cFunctionPointers, &sCFunctionPointerTable }
+	};
+	for( auto& currTables : methodTables )
+	{
+		for( const std::pair<const std::string,CObjCMethodEntry>& currMethod : *currTables.first )
+		{
+			if( isDefinedHere( currMethod.first ) )
+				(*currTables.second)[currMethod.first] = currMethod.second;
+		}
+	}
+	for( const std::pair<const std::string,std::string>& currConstant : constantsToValues )
+	{
+		if( isDefinedHere( currConstant.first ) )
+			sConstantToValueTable[currConstant.first] = currConstant.second;
+	}
+	
+	return true;
 }
 
 
-void	CParser::LoadNativeHeadersFromFile( const char* filepath )
+void	CParser::AddDirectoryToNativeHeadersFile( const char* inHeadersPath, const char* inOutputPath )
+{
+	std::ifstream	headerFile( inHeadersPath );
+	if( !headerFile )
+		throw std::runtime_error( std::string("Couldn't open native headers file \"") + inHeadersPath + "\"." );
+	
+	std::vector<std::string>		synonymLines;
+	std::vector<std::string>		sections( 1 );	// Anything before the first F line goes in a section of its own.
+	std::map<std::string,size_t>	symbolSections;
+	std::string						currLine;
+	std::string						headerLine;
+	bool							isInOldDirectory = false;
+	while( std::getline( headerFile, currLine ) )
+	{
+		if( currLine.empty() )
+			continue;
+		if( isInOldDirectory && currLine[0] != '~' )	// Already had a directory? Replace it, but keep its synonyms.
+		{
+			isInOldDirectory = (currLine != "!enddirectory");
+			continue;
+		}
+		
+		switch( currLine[0] )
+		{
+			case '!':
+				isInOldDirectory = (currLine == "!directory");
+				continue;
+			
+			case '~':
+				synonymLines.push_back( currLine );
+				continue;
+			
+			case 'F':	// Start a new section. H lines carry over into the next framework, so repeat the current one:
+				sections.push_back( std::string() );
+				if( !headerLine.empty() )
+					sections.back().append( currLine ).append( 1, '\n' ).append( headerLine ).append( 1, '\n' );
+				else
+					sections.back().append( currLine ).append( 1, '\n' );
+				continue;
+			
+			case 'H':
+				if( currLine == headerLine )	// Already in effect, e.g. because we repeated it after the F line last time.
+					continue;
+				headerLine = currLine;
+				break;
+			
+			case '=':
+			case '-':
+			case '+':
+			case '&':
+				symbolSections[currLine.substr( 1, currLine.find( ',' ) -1 )] = sections.size() -1;
+				break;
+			
+			case 'e':	// Constants are "evalue,name", unlike everything else.
+			{
+				size_t	commaPos = currLine.find( ',' );
+				if( commaPos != std::string::npos )
+				{
+					std::string		constantStr( currLine.substr( commaPos +1 ) );
+					constantStr.erase( std::remove( constantStr.begin(), constantStr.end(), ',' ), constantStr.end() );
+					symbolSections[constantStr] = sections.size() -1;
+				}
+				break;
+			}
+		}
+		sections.back().append( currLine ).append( 1, '\n' );
+	}
+	
+	std::ofstream	outputFile( inOutputPath, std::ios::out | std::ios::binary | std::ios::trunc );
+	outputFile << "!directory\n";
+	for( const std::string& currSynonym : synonymLines )
+		outputFile << currSynonym << "\n";
+	size_t	currOffset = 0;
+	for( const std::string& currSection : sections )
+	{
+		outputFile << "$" << currOffset << "," << currSection.size() << "\n";
+		currOffset += currSection.size();
+	}
+	for( const std::pair<const std::string,size_t>& currSymbol : symbolSections )
+		outputFile << ">" << currSymbol.first << "," << currSymbol.second << "\n";
+	outputFile << "!enddirectory\n";
+	for( const std::string& currSection : sections )
+		outputFile << currSection;
+	if( !outputFile.good() )
+		throw std::runtime_error( std::string("Couldn't write native headers file \"") + inOutputPath + "\"." );
+}
+
+
+void	CParser::CompileNativeHeadersFile( const char* inHeadersPath, const char* inIndexPath )
+{
+	std::ifstream							headerFile( inHeadersPath );
+	if( !headerFile )
+		throw std::runtime_error( std::string("Couldn't open native headers file \"") + inHeadersPath + "\"." );
+	
+	std::map<std::string,CObjCMethodEntry>	objCMethods, cFunctions, cFunctionPointers;
+	std::map<std::string,std::string>		synonymsToTypes, constantsToValues;
+	ParseNativeHeaders( headerFile, objCMethods, cFunctions, cFunctionPointers, synonymsToTypes, constantsToValues );
+	CNativeHeadersIndex::Write( inIndexPath, objCMethods, cFunctions, cFunctionPointers, synonymsToTypes, constantsToValues );
+}
+
+
+bool	CParser::FindNativeMethod( CNativeHeadersIndex::TTable inTable, const std::string& inName, CObjCMethodEntry& outEntry )
+{
+	std::lock_guard<std::mutex>							lock( sNativeHeadersMutex );
+	std::map<std::string,CObjCMethodEntry>&				methodTable = (inTable == CNativeHeadersIndex::EObjCMethodTable) ? sObjCMethodTable
+															: ((inTable == CNativeHeadersIndex::ECFunctionTable) ? sCFunctionTable : sCFunctionPointerTable);
+	std::map<std::string,CObjCMethodEntry>::iterator	foundMethod = methodTable.find( inName );
+	if( foundMethod == methodTable.end() && LoadNativeHeadersSectionForSymbol( inName ) )
+		foundMethod = methodTable.find( inName );
+	if( foundMethod != methodTable.end() )
+	{
+		outEntry = foundMethod->second;
+		return true;
+	}
+	
+	CNativeHeadersIndex::CEntry		foundEntry;
+	for( auto currIndex = sNativeHeadersIndexes.rbegin(); currIndex != sNativeHeadersIndexes.rend(); ++currIndex )	// Later files override earlier ones.
+	{
+		if( (*currIndex)->FindEntry( inTable, inName.c_str(), foundEntry ) )
+		{
+			outEntry.mHeaderName = foundEntry.mHeaderName;
+			outEntry.mFrameworkName = foundEntry.mFrameworkName;
+			outEntry.mMethodSignature = foundEntry.mValue;
+			return true;
+		}
+	}
+	
+	return false;
+}
+
+
+bool	CParser::FindNativeConstant( const std::string& inName, std::string& outValue )
+{
+	std::lock_guard<std::mutex>						lock( sNativeHeadersMutex );
+	std::map<std::string,std::string>::iterator		foundConstant = sConstantToValueTable.find( inName );
+	if( foundConstant == sConstantToValueTable.end() && LoadNativeHeadersSectionForSymbol( inName ) )
+		foundConstant = sConstantToValueTable.find( inName );
+	if( foundConstant != sConstantToValueTable.end() )
+	{
+		outValue = foundConstant->second;
+		return true;
+	}
+	
+	CNativeHeadersIndex::CEntry		foundEntry;
+	for( auto currIndex = sNativeHeadersIndexes.rbegin(); currIndex != sNativeHeadersIndexes.rend(); ++currIndex )
+	{
+		if( (*currIndex)->FindEntry( CNativeHeadersIndex::EConstantToValueTable, inName.c_str(), foundEntry ) )
+		{
+			outValue = foundEntry.mValue;
+			return true;
+		}
+	}
+	
+	return false;
+}
+
+
+void	CParser::ParseNativeHeaders( std::istream& headerFile, std::map<std::string,CObjCMethodEntry>& ioObjCMethods,
+									std::map<std::string,CObjCMethodEntry>& ioCFunctions, std::map<std::string,CObjCMethodEntry>& ioCFunctionPointers,
+									std::map<std::string,std::string>& ioSynonymsToTypes, std::map<std::string,std::string>& ioConstantsToValues )
 {
-	std::ifstream		headerFile(filepath);
 	char				theCh = 0;
 	std::string			headerPath;		
 	std::string			frameworkPath;
@@ -3359,6 +3873,9 @@ void	CParser::LoadNativeHeadersFromFile( const char* filepath )
 			case '<':	// protocol class/category implements.
 			case '(':	// category name.
 			case ':':	// superclass.
+			case '!':	// start/end of directory.
+			case '$':	// directory section offset.
+			case '>':	// directory symbol.
 				while( (theCh = headerFile.get()) != std::ifstream::traits_type::eof() && theCh != '\n' )
 					;	// Do nothing, just swallow characters on this line.
 				break;
@@ -3393,7 +3910,7 @@ void	CParser::LoadNativeHeadersFromFile( const char* filepath )
 					else
 						synonymousStr.append( 1, theCh );
 				}
-				sSynonymToTypeTable[synonymousStr] = typeStr;
+				ioSynonymsToTypes[synonymousStr] = typeStr;
 				break;
 			}
 			
@@ -3412,7 +3929,7 @@ void	CParser::LoadNativeHeadersFromFile( const char* filepath )
 					else
 						synonymousStr.append( 1, theCh );
 				}
-				sConstantToValueTable[constantStr] = synonymousStr;
+				ioConstantsToValues[constantStr] = synonymousStr;
 				break;
 			}
 			
@@ -3439,7 +3956,7 @@ void	CParser::LoadNativeHeadersFromFile( const char* filepath )
 							else
 							{
 								std::map<std::string,std::string>::const_iterator foundSynonym;
-								while( (foundSynonym = sSynonymToTypeTable.find(currType)) != sSynonymToTypeTable.end() )
+								while( (foundSynonym = ioSynonymsToTypes.find(currType)) != ioSynonymsToTypes.end() )
 								{
 									currType = foundSynonym->second;
 								}
@@ -3452,7 +3969,7 @@ void	CParser::LoadNativeHeadersFromFile( const char* filepath )
 						case '\n':
 						{
 							std::map<std::string,std::string>::const_iterator foundSynonym;
-							while( (foundSynonym = sSynonymToTypeTable.find(currType)) != sSynonymToTypeTable.end() )
+							while( (foundSynonym = ioSynonymsToTypes.find(currType)) != ioSynonymsToTypes.end() )
 							{
 								currType = foundSynonym->second;
 							}
@@ -3472,11 +3989,11 @@ void	CParser::LoadNativeHeadersFromFile( const char* filepath )
 				}
 				
 				if( isFunction )
-					sCFunctionTable[selectorStr] = CObjCMethodEntry( headerPath, frameworkPath, typesLine );
+					ioCFunctions[selectorStr] = CObjCMethodEntry( headerPath, frameworkPath, typesLine );
 				else if( isFunctionPtr )
-					sCFunctionPointerTable[selectorStr] = CObjCMethodEntry( headerPath, frameworkPath, typesLine );
+					ioCFunctionPointers[selectorStr] = CObjCMethodEntry( headerPath, frameworkPath, typesLine );
 				else
-					sObjCMethodTable[selectorStr] = CObjCMethodEntry( headerPath, frameworkPath, typesLine );
+					ioObjCMethods[selectorStr] = CObjCMethodEntry( headerPath, frameworkPath, typesLine );
 				//std::cout << selectorStr << " = " << typesLine << std::endl;
 				break;
 			}
@@ -3507,7 +4024,7 @@ void	CParser::SetFirstNativeCallCallback( LEOFirstNativeCallCallbackPtr inCallba
 //	chunk expressions.
 
 CValueNode*	CParser::ParseChunkExpression( TChunkType typeConstant, CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-											std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens )
+											CTokenIterator& tokenItty, CTokenCursor& tokens )
 {
 	CTokenizer::GoNextToken( mFileName, tokenItty, tokens );	// Skip "char" or "item" or whatever chunk type token this was.
 	
@@ -3548,9 +4065,9 @@ CValueNode*	CParser::ParseChunkExpression( TChunkType typeConstant, CParseTree&
 	CValueNode*	targetValObj = ParseTerm( parseTree, currFunction, tokenItty, tokens, ELastIdentifier_Sentinel );
 	
 	// Now output code:
-	CMakeChunkRefNode*	currOperation = new CMakeChunkRefNode( &parseTree, lineNum );
+	CMakeChunkRefNode*	currOperation = parseTree.NewNode<CMakeChunkRefNode>( lineNum );
 	currOperation->AddParam( targetValObj );
-	currOperation->AddParam( new CIntValueNode( &parseTree, typeConstant, tokenItty->mLineNum ) );
+	currOperation->AddParam( parseTree.NewNode<CIntValueNode>( typeConstant, tokenItty->mLineNum ) );
 	currOperation->AddParam( startOffsObj );
 	currOperation->AddParam( hadTo ? endOffsObj : startOffsObj->Copy() );
 	
@@ -3562,7 +4079,7 @@ CValueNode*	CParser::ParseChunkExpression( TChunkType typeConstant, CParseTree&
 //	pretty much just fetches the chunk value right then and there.
 
 CValueNode*	CParser::ParseConstantChunkExpression( TChunkType typeConstant, CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-										std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens )
+										CTokenIterator& tokenItty, CTokenCursor& tokens )
 {
 	CTokenizer::GoNextToken( mFileName, tokenItty, tokens );	// Skip "char" or "item" or whatever chunk type token this was.
 	
@@ -3598,9 +4115,9 @@ CValueNode*	CParser::ParseConstantChunkExpression( TChunkType typeConstant, CPar
 	
 	CValueNode*	targetValObj = ParseTerm( parseTree, currFunction, tokenItty, tokens, ELastIdentifier_Sentinel );
 	
-	CMakeChunkConstNode*	currOperation = new CMakeChunkConstNode( &parseTree, currFunction, lineNum );
+	CMakeChunkConstNode*	currOperation = parseTree.NewNode<CMakeChunkConstNode>( currFunction, lineNum );
 	currOperation->AddParam( targetValObj );
-	currOperation->AddParam( new CIntValueNode( &parseTree, typeConstant, tokenItty->mLineNum ) );
+	currOperation->AddParam( parseTree.NewNode<CIntValueNode>( typeConstant, tokenItty->mLineNum ) );
 	currOperation->AddParam( startOffsObj );
 	currOperation->AddParam( hadTo ? endOffsObj : startOffsObj );
 
@@ -3609,16 +4126,21 @@ CValueNode*	CParser::ParseConstantChunkExpression( TChunkType typeConstant, CPar
 
 
 CValueNode*	CParser::ParseObjCMethodCall( CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-										std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens )
+										CTokenIterator& tokenItty, CTokenCursor& tokens )
 {
 	if( kFirstObjCCallInstruction == 0 )	// ObjC call instructions weren't installed.
 		return NULL;
 	
-	if( sFirstNativeCallCallback )
+	if( sFirstNativeCallCallback.load() )
 	{
-		LEOFirstNativeCallCallbackPtr	callback = sFirstNativeCallCallback;
-		sFirstNativeCallCallback = NULL;
-		callback();
+		// Only one thread gets to call it, but all of them wait for it to finish loading headers before they look up symbols:
+		std::lock_guard<std::mutex>		lock( sFirstNativeCallMutex );
+		LEOFirstNativeCallCallbackPtr	callback = sFirstNativeCallCallback.load();
+		if( callback )
+		{
+			callback();
+			sFirstNativeCallCallback = NULL;
+		}
 	}
 	
 	// We parse either a class name or an expression that evaluates to an object
@@ -3627,7 +4149,7 @@ CValueNode*	CParser::ParseObjCMethodCall( CParseTree& parseTree, CCodeBlockNodeB
 	
 	CTokenizer::GoNextToken( mFileName, tokenItty, tokens );	// Skip open bracket.
 	
-	COperatorNode	*	methodCall = new COperatorNode( &parseTree, CALL_OBJC_METHOD_INSTR +kFirstObjCCallInstruction, tokenItty->mLineNum );
+	COperatorNode	*	methodCall = parseTree.NewNode<COperatorNode>( CALL_OBJC_METHOD_INSTR +kFirstObjCCallInstruction, tokenItty->mLineNum );
 	
 	if( tokenItty->IsIdentifier(ELastIdentifier_Sentinel) )	// No reserved word identifier?
 	{
@@ -3638,7 +4160,7 @@ CValueNode*	CParser::ParseObjCMethodCall( CParseTree& parseTree, CCodeBlockNodeB
 
 		if( theContainerItty == currFunction->GetLocals().end() )	// No variable of that name? Must be ObjC class name:
 		{
-			methodCall->AddParam( new CStringValueNode( &parseTree, className, tokenItty->mLineNum ) );
+			methodCall->AddParam( parseTree.NewNode<CStringValueNode>( className, tokenItty->mLineNum ) );
 			CTokenizer::GoNextToken( mFileName, tokenItty, tokens );	// Move past target token.
 		}
 		else	// Otherwise get it out of the expression:
@@ -3647,13 +4169,12 @@ CValueNode*	CParser::ParseObjCMethodCall( CParseTree& parseTree, CCodeBlockNodeB
 	else
 		methodCall->AddParam( ParseExpression( parseTree, currFunction, tokenItty, tokens, ELastIdentifier_Sentinel ) );
 	
-	methodCall->AddParam( new CStringValueNode( &parseTree, "", tokenItty->mLineNum ) );	// Leave space for method name.
-	methodCall->AddParam( new CStringValueNode( &parseTree, "", tokenItty->mLineNum ) );	// Leave space for method signature.
-	methodCall->AddParam( new CStringValueNode( &parseTree, "", tokenItty->mLineNum ) );	// Leave space for framework name.
+	methodCall->AddParam( parseTree.NewNode<CStringValueNode>( "", tokenItty->mLineNum ) );	// Leave space for method name.
+	methodCall->AddParam( parseTree.NewNode<CStringValueNode>( "", tokenItty->mLineNum ) );	// Leave space for method signature.
+	methodCall->AddParam( parseTree.NewNode<CStringValueNode>( "", tokenItty->mLineNum ) );	// Leave space for framework name.
 	
 	if( tokenItty->mType != EIdentifierToken )
 	{
-		delete methodCall;
 		ThrowDeferrableError( tokenItty, tokens, "Expected an identifier as a method name here, found ", tokenItty->GetShortDescription(),"." );
 	}
 	
@@ -3701,16 +4222,16 @@ CValueNode*	CParser::ParseObjCMethodCall( CParseTree& parseTree, CCodeBlockNodeB
 	CTokenizer::GoNextToken( mFileName, tokenItty, tokens );	// Skip close bracket (ECloseSquareBracketOperator).
 
 	// Get data types for this method's params and return value:
-	std::map<std::string,CObjCMethodEntry>::iterator	foundTypes = sObjCMethodTable.find( methodName.str() );
-	if( foundTypes == sObjCMethodTable.end() )
+	CObjCMethodEntry	methodInfo;
+	if( !FindNativeMethod( CNativeHeadersIndex::EObjCMethodTable, methodName.str(), methodInfo ) )
 	{
 		ThrowDeferrableError( tokenItty, tokens, "Couldn't find definition of Objective C method ", methodName.str(), "." );
 	}
 	
 	// Fill out the info we accumulated parsing the parameters:
-	methodCall->SetParamAtIndex( 1, new CStringValueNode( &parseTree, methodName.str(), tokenItty->mLineNum ) );
-	methodCall->SetParamAtIndex( 2, new CStringValueNode( &parseTree, foundTypes->second.mMethodSignature, tokenItty->mLineNum ) );
-	methodCall->SetParamAtIndex( 3, new CStringValueNode( &parseTree, foundTypes->second.mFrameworkName, tokenItty->mLineNum ) );
+	methodCall->SetParamAtIndex( 1, parseTree.NewNode<CStringValueNode>( methodName.str(), tokenItty->mLineNum ) );
+	methodCall->SetParamAtIndex( 2, parseTree.NewNode<CStringValueNode>( methodInfo.mMethodSignature, tokenItty->mLineNum ) );
+	methodCall->SetParamAtIndex( 3, parseTree.NewNode<CStringValueNode>( methodInfo.mFrameworkName, tokenItty->mLineNum ) );
 	
 	methodCall->SetInstructionParams( numParams, 0 );
 	
@@ -3736,7 +4257,7 @@ TChunkType	CParser::GetChunkTypeNameFromIdentifierSubtype( TIdentifierSubtype id
 
 CValueNode*	CParser::ParseNativeFunctionCallStartingAtParams( std::string& methodName, CObjCMethodEntry& methodInfo,
 							CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-							std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens )
+							CTokenIterator& tokenItty, CTokenCursor& tokens )
 {
 //	int						numParams = 0;
 //	std::stringstream		paramsCode;	// temp we compose our params in.
@@ -3813,7 +4334,7 @@ CValueNode*	CParser::ParseNativeFunctionCallStartingAtParams( std::string& metho
 
 
 CValueNode* CParser::ParseAnyFollowingArrayDefinitionWithKey(CValueNode* theTerm, CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-								std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens,
+								CTokenIterator& tokenItty, CTokenCursor& tokens,
 								TIdentifierSubtype inEndIdentifier)
 {
 	if( tokenItty != tokens.end() && tokenItty->IsIdentifier(EColonOperator) && inEndIdentifier != EColonOperator )
@@ -3822,12 +4343,11 @@ CValueNode* CParser::ParseAnyFollowingArrayDefinitionWithKey(CValueNode* theTerm
 		CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
 		
 		CValueNode	*	theParam = theTerm;
-		COperatorNode*	theOperation = new COperatorNode( &parseTree, PUSH_ARRAY_CONSTANT_INSTR, theTerm->GetLineNum() );
+		COperatorNode*	theOperation = parseTree.NewNode<COperatorNode>( PUSH_ARRAY_CONSTANT_INSTR, theTerm->GetLineNum() );
 		theOperation->AddParam( theParam );	// Push first key on stack.
 		theParam = ParseTerm( parseTree, currFunction, tokenItty, tokens, EColonOperator );
 		if( !theParam )
 		{
-			delete theOperation;
 			CTokenizer::GoPreviousToken(mFileName, tokenItty, tokens);	// Backtrack over colon operator.
 			return theTerm;
 		}
@@ -3836,14 +4356,13 @@ CValueNode* CParser::ParseAnyFollowingArrayDefinitionWithKey(CValueNode* theTerm
 		while( tokenItty != tokens.end() && (tokenItty->mType == EStringToken || tokenItty->mType == EIdentifierToken || tokenItty->mType == ENumberToken) )
 		{
 			if( tokenItty->mType == ENumberToken )
-				theParam = new CIntValueNode( &parseTree, tokenItty->mNumberValue, tokenItty->mLineNum );
+				theParam = parseTree.NewNode<CIntValueNode>( tokenItty->mNumberValue, tokenItty->mLineNum );
 			else
-				theParam = new CStringValueNode( &parseTree, tokenItty->mStringValue, tokenItty->mLineNum );
+				theParam = parseTree.NewNode<CStringValueNode>( tokenItty->mStringValue, tokenItty->mLineNum );
 			CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
 			// +++ Check whether the key is a floating point number here (which is tokenized to {integer, period operator, integer}) and optionally generate a key string matching the entire float here.
 			if( tokenItty == tokens.end() || !tokenItty->IsIdentifier(EColonOperator) )	// Not a key followed by a colon and another value?
 			{
-				delete theParam;
 				theParam = NULL;
 				CTokenizer::GoPreviousToken(mFileName, tokenItty, tokens);	// Backtrack over what we thought was another key.
 				break;	// Hit end of list.
@@ -3868,7 +4387,7 @@ CValueNode* CParser::ParseAnyFollowingArrayDefinitionWithKey(CValueNode* theTerm
 	
 	
 CValueNode* CParser::ParseNumberOfExpression( CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-												std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens,
+												CTokenIterator& tokenItty, CTokenCursor& tokens,
 											    TIdentifierSubtype inEndIdentifier )
 {
 	CValueNode * theTerm = nullptr;
@@ -3913,14 +4432,14 @@ CValueNode* CParser::ParseNumberOfExpression( CParseTree& parseTree, CCodeBlockN
 	
 	if( arrayEntry )
 	{
-		COperatorNode*	fcall = new COperatorNode( &parseTree, GET_ARRAY_ITEM_COUNT_INSTR, lineNum );
+		COperatorNode*	fcall = parseTree.NewNode<COperatorNode>( GET_ARRAY_ITEM_COUNT_INSTR, lineNum );
 		fcall->SetInstructionParams( BACK_OF_STACK, 0 );
 		fcall->AddParam( valueObj );
 		theTerm = fcall;
 	}
 	else
 	{
-		COperatorNode*	fcall = new COperatorNode( &parseTree, COUNT_CHUNKS_INSTR, lineNum );
+		COperatorNode*	fcall = parseTree.NewNode<COperatorNode>( COUNT_CHUNKS_INSTR, lineNum );
 		
 		fcall->SetInstructionParams( 0, typeConstant );
 		fcall->AddParam( valueObj );
@@ -3932,7 +4451,7 @@ CValueNode* CParser::ParseNumberOfExpression( CParseTree& parseTree, CCodeBlockN
 
 
 CValueNode*	CParser::ParseTerm( CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-								std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens,
+								CTokenIterator& tokenItty, CTokenCursor& tokens,
 								TIdentifierSubtype inEndIdentifier )
 {
 	CValueNode*	theTerm = NULL;
@@ -3944,7 +4463,7 @@ CValueNode*	CParser::ParseTerm( CParseTree& parseTree, CCodeBlockNodeBase* currF
 	{
 		case EStringToken:
 		{
-			theTerm = new CStringValueNode( &parseTree, tokenItty->mStringValue, tokenItty->mLineNum );
+			theTerm = parseTree.NewNode<CStringValueNode>( tokenItty->mStringValue, tokenItty->mLineNum );
 			CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
 			theTerm = ParseAnyFollowingArrayDefinitionWithKey( theTerm, parseTree, currFunction, tokenItty, tokens, inEndIdentifier );	// If this was a key at the start of an array definition, parse that and turn theTerm into an array, otherwise this just returns theTerm again.
 			break;	// Exit our switch.
@@ -3966,19 +4485,19 @@ CValueNode*	CParser::ParseTerm( CParseTree& parseTree, CCodeBlockNodeBase* currF
 					char*				endPtr = NULL;
 					float				theNum = strtof( numStr.str().c_str(), &endPtr );
 					
-					theTerm = new CFloatValueNode( &parseTree, theNum, tokenItty->mLineNum );
+					theTerm = parseTree.NewNode<CFloatValueNode>( theNum, tokenItty->mLineNum );
 					
 					CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
 				}
 				else	// Backtrack, that period was something else:
 				{
 					CTokenizer::GoPreviousToken( mFileName, tokenItty, tokens );
-					theTerm = new CIntValueNode( &parseTree, theNumber, tokenItty->mLineNum );
+					theTerm = parseTree.NewNode<CIntValueNode>( theNumber, tokenItty->mLineNum );
 				}
 			}
 			else
 			{
-				theTerm = new CIntValueNode( &parseTree, theNumber, tokenItty->mLineNum );
+				theTerm = parseTree.NewNode<CIntValueNode>( theNumber, tokenItty->mLineNum );
 			}
 			
 			// If there's a unit after this number, apply that unit to the term:
@@ -4002,12 +4521,12 @@ CValueNode*	CParser::ParseTerm( CParseTree& parseTree, CCodeBlockNodeBase* currF
 				theTerm = ParseFunctionCall( parseTree, currFunction, false, tokenItty, tokens );
 				if( !theTerm ) 
 				{
-					std::map<std::string,std::string>::iterator		sysConstItty = sConstantToValueTable.find( tokenItty->GetOriginalIdentifierText() );
-					if( sysConstItty == sConstantToValueTable.end() )	// Not a system constant either? Guess it was a variable name:
+					std::string		sysConstValue;
+					if( !FindNativeConstant( tokenItty->GetOriginalIdentifierText(), sysConstValue ) )	// Not a system constant either? Guess it was a variable name:
 						theTerm = ParseContainer( false, true, parseTree, currFunction, tokenItty, tokens, inEndIdentifier );
 					else
 					{
-						theTerm = new CStringValueNode( &parseTree, sysConstItty->second, tokenItty->mLineNum );
+						theTerm = parseTree.NewNode<CStringValueNode>( sysConstValue, tokenItty->mLineNum );
 						CTokenizer::GoNextToken( mFileName, tokenItty, tokens );	// Skip the identifier for the constant we just parsed.
 					}
 					theTerm = ParseAnyFollowingArrayDefinitionWithKey( theTerm, parseTree, currFunction, tokenItty, tokens, inEndIdentifier );	// If this was a key at the start of an array definition, parse that and turn theTerm into an array, otherwise this just returns theTerm again.
@@ -4065,7 +4584,7 @@ CValueNode*	CParser::ParseTerm( CParseTree& parseTree, CCodeBlockNodeBase* currF
 				CTokenizer::GoNextToken( mFileName, tokenItty, tokens );	// Skip handler name.
 				
 				// Now that we know whether it's a function or a handler, store a pointer to it:
-				theTerm = new CFunctionCallNode( &parseTree, false, "vcy_fcn_addr", tokenItty->mLineNum );
+				theTerm = parseTree.NewNode<CFunctionCallNode>( false, "vcy_fcn_addr", tokenItty->mLineNum );
 				break;
 			}
 			else if( tokenItty->mSubType == ENumberIdentifier )		// The identifier "number", i.e. the actual word.
@@ -4128,7 +4647,7 @@ CValueNode*	CParser::ParseTerm( CParseTree& parseTree, CCodeBlockNodeBase* currF
 							CTokenizer::GoNextToken( mFileName, tokenItty, tokens );	// Skip "of".
 							CValueNode	*	targetObj = ParseTerm( parseTree, currFunction, tokenItty, tokens, inEndIdentifier );
 							
-							CObjectPropertyNode	*	propExpr = new CObjectPropertyNode( &parseTree, propName, lineNum );
+							CObjectPropertyNode	*	propExpr = parseTree.NewNode<CObjectPropertyNode>( propName, lineNum );
 							propExpr->AddParam( targetObj );
 							theTerm = propExpr;
 						}
@@ -4142,7 +4661,7 @@ CValueNode*	CParser::ParseTerm( CParseTree& parseTree, CCodeBlockNodeBase* currF
 				}
 				
 				// Check if it could be a global property expression:
-				if( !theTerm && sGlobalProperties )
+				if( !theTerm )
 				{
 					TIdentifierSubtype	subType = tokenItty->mSubType;
 					TIdentifierSubtype	qualifierType = ELastIdentifier_Sentinel;
@@ -4157,11 +4676,11 @@ CValueNode*	CParser::ParseTerm( CParseTree& parseTree, CCodeBlockNodeBase* currF
 					// Find it in our list of global properties:
 					int				x = 0;
 					
-					for( x = 0; sGlobalProperties[x].mType != ELastIdentifier_Sentinel; x++ )
+					for( x = 0; mGrammar->mGlobalProperties[x].mType != ELastIdentifier_Sentinel; x++ )
 					{
-						if( sGlobalProperties[x].mType == subType && (sGlobalProperties[x].mPrefixType == qualifierType) )
+						if( mGrammar->mGlobalProperties[x].mType == subType && (mGrammar->mGlobalProperties[x].mPrefixType == qualifierType) )
 						{
-							theTerm = new CGlobalPropertyNode( &parseTree, sGlobalProperties[x].mSetterInstructionID, sGlobalProperties[x].mGetterInstructionID, gIdentifierStrings[subType], tokenItty->mLineNum );
+							theTerm = parseTree.NewNode<CGlobalPropertyNode>( mGrammar->mGlobalProperties[x].mSetterInstructionID, mGrammar->mGlobalProperties[x].mGetterInstructionID, gIdentifierStrings[subType], tokenItty->mLineNum );
 							CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
 							break;
 						}
@@ -4171,19 +4690,19 @@ CValueNode*	CParser::ParseTerm( CParseTree& parseTree, CCodeBlockNodeBase* currF
 						CTokenizer::GoPreviousToken( mFileName, tokenItty, tokens );
 				}
 								
-				if( !theTerm && sBuiltInFunctions )
+				if( !theTerm )
 				{
 					TIdentifierSubtype	subType = tokenItty->mSubType;
 		
 					// Find it in our list of built-in functions:
 					int				x = 0;
 					
-					for( x = 0; sBuiltInFunctions[x].mType != ELastIdentifier_Sentinel; x++ )
+					for( x = 0; mGrammar->mBuiltInFunctions[x].mType != ELastIdentifier_Sentinel; x++ )
 					{
-						if( sBuiltInFunctions[x].mType == subType && sBuiltInFunctions[x].mParamCount == 0 )
+						if( mGrammar->mBuiltInFunctions[x].mType == subType && mGrammar->mBuiltInFunctions[x].mParamCount == 0 )
 						{
-							COperatorNode* fcall = new COperatorNode( &parseTree, sBuiltInFunctions[x].mInstructionID, tokenItty->mLineNum );
-							fcall->SetInstructionParams( sBuiltInFunctions[x].mParam1, sBuiltInFunctions[x].mParam2 );
+							COperatorNode* fcall = parseTree.NewNode<COperatorNode>( mGrammar->mBuiltInFunctions[x].mInstructionID, tokenItty->mLineNum );
+							fcall->SetInstructionParams( mGrammar->mBuiltInFunctions[x].mParam1, mGrammar->mBuiltInFunctions[x].mParam2 );
 							theTerm = fcall;
 							CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
 							break;
@@ -4211,14 +4730,13 @@ CValueNode*	CParser::ParseTerm( CParseTree& parseTree, CCodeBlockNodeBase* currF
 					hadOpenBracket = true;
 				}
 				
-				COperatorNode*			fcall = new COperatorNode( &parseTree, PARAMETER_INSTR, lineNum );
+				COperatorNode*			fcall = parseTree.NewNode<COperatorNode>( PARAMETER_INSTR, lineNum );
 				fcall->SetInstructionParams( BACK_OF_STACK, 0 );
 				
 				fcall->AddParam( ParseTerm( parseTree, currFunction, tokenItty, tokens, inEndIdentifier ) );
 				
 				if( !tokenItty->IsIdentifier( ECloseBracketOperator ) && hadOpenBracket )	// MUST have close bracket.
 				{
-					delete fcall;
 					
 					ThrowDeferrableError( tokenItty, tokens, "expected \"(\" after function name, found ", tokenItty->GetShortDescription(), "." );
 				}
@@ -4243,19 +4761,19 @@ CValueNode*	CParser::ParseTerm( CParseTree& parseTree, CCodeBlockNodeBase* currF
 			{
 				TIdentifierSubtype	subType = tokenItty->mSubType;
 	
-				if( !theTerm && sBuiltInFunctions )
+				if( !theTerm )
 				{
 					// Find it in our list of built-in functions:
 					int				x = 0;
 					
-					for( x = 0; sBuiltInFunctions[x].mType != ELastIdentifier_Sentinel; x++ )
+					for( x = 0; mGrammar->mBuiltInFunctions[x].mType != ELastIdentifier_Sentinel; x++ )
 					{
-						if( sBuiltInFunctions[x].mType == subType )
+						if( mGrammar->mBuiltInFunctions[x].mType == subType )
 						{
-							if( sBuiltInFunctions[x].mParamCount == 0 )
+							if( mGrammar->mBuiltInFunctions[x].mParamCount == 0 )
 							{
-								COperatorNode* fcall = new COperatorNode( &parseTree, sBuiltInFunctions[x].mInstructionID, tokenItty->mLineNum );
-								fcall->SetInstructionParams( sBuiltInFunctions[x].mParam1, sBuiltInFunctions[x].mParam2 );
+								COperatorNode* fcall = parseTree.NewNode<COperatorNode>( mGrammar->mBuiltInFunctions[x].mInstructionID, tokenItty->mLineNum );
+								fcall->SetInstructionParams( mGrammar->mBuiltInFunctions[x].mParam1, mGrammar->mBuiltInFunctions[x].mParam2 );
 								theTerm = fcall;
 								CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
 								
@@ -4277,14 +4795,14 @@ CValueNode*	CParser::ParseTerm( CParseTree& parseTree, CCodeBlockNodeBase* currF
 					}
 				}
 				
-				if( !theTerm && sGlobalProperties )
+				if( !theTerm )
 				{
 					// Find it in our list of global properties:
-					for( int x = 0; sGlobalProperties[x].mType != ELastIdentifier_Sentinel; x++ )
+					for( int x = 0; mGrammar->mGlobalProperties[x].mType != ELastIdentifier_Sentinel; x++ )
 					{
-						if( sGlobalProperties[x].mType == subType )
+						if( mGrammar->mGlobalProperties[x].mType == subType )
 						{
-							theTerm = new CGlobalPropertyNode( &parseTree, sGlobalProperties[x].mSetterInstructionID, sGlobalProperties[x].mGetterInstructionID, gIdentifierStrings[subType], tokenItty->mLineNum );
+							theTerm = parseTree.NewNode<CGlobalPropertyNode>( mGrammar->mGlobalProperties[x].mSetterInstructionID, mGrammar->mGlobalProperties[x].mGetterInstructionID, gIdentifierStrings[subType], tokenItty->mLineNum );
 							CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
 							break;
 						}
@@ -4314,10 +4832,11 @@ CValueNode*	CParser::ParseTerm( CParseTree& parseTree, CCodeBlockNodeBase* currF
 				
 				// Now try constant:
 				CValueNode		*	constantValue = NULL;
-				TConstantEntry	*	currConst = sConstants;
+				const std::vector<size_t>&	candidateConstants = mGrammar->mConstantsByIdentifier[ (tokenItty->mType == EIdentifierToken) ? tokenItty->GetIdentifierSubType() : ELastIdentifier_Sentinel ];
 				
-				while( currConst->mType[0] != ELastIdentifier_Sentinel )
+				for( size_t candidateIdx = 0; candidateIdx < candidateConstants.size(); candidateIdx++ )
 				{
+					const TConstantEntry	*	currConst = &mGrammar->mConstants[ candidateConstants[candidateIdx] ];
 					for( size_t y = 0; y < MAX_CONSTANT_IDENTS; y++ )
 					{
 						if( currConst->mType[y] != ELastIdentifier_Sentinel
@@ -4339,13 +4858,11 @@ CValueNode*	CParser::ParseTerm( CParseTree& parseTree, CCodeBlockNodeBase* currF
 					
 					if( constantValue )
 						break;
-					
-					currConst++;
 				}
 				
 				if( constantValue )	// Found constant of that name!
 				{
-					theTerm = constantValue->Copy();
+					theTerm = parseTree.AdoptNode( constantValue->Copy() );
 					theTerm->SetLineNum( tokenItty->mLineNum );
 					CTokenizer::GoNextToken( mFileName, tokenItty, tokens );
 					break;
@@ -4355,18 +4872,18 @@ CValueNode*	CParser::ParseTerm( CParseTree& parseTree, CCodeBlockNodeBase* currF
 				LEOInstructionID				operatorCommandName = INVALID_INSTR;
 				int16_t							operatorParam1 = 0;
 				int32_t							operatorParam2 = 0;
-				std::deque<CToken>::iterator	lastTokenItty = tokenItty;
+				CTokenIterator	lastTokenItty = tokenItty;
 				
-				for( int x = 0; sUnaryOperators[x].mType != ELastIdentifier_Sentinel; x++ )
+				for( int x = 0; mGrammar->mUnaryOperators[x].mType != ELastIdentifier_Sentinel; x++ )
 				{
-					std::deque<CToken>::iterator	bestTokenItty = tokenItty;
+					CTokenIterator	bestTokenItty = tokenItty;
 					tokenItty = lastTokenItty;
-					if( CTokenizer::NextTokensAreIdentifiers( mFileName, tokenItty, tokens, sUnaryOperators[x].mType, sUnaryOperators[x].mSecondType, sUnaryOperators[x].mThirdType, sUnaryOperators[x].mFourthType, ELastIdentifier_Sentinel ) && tokenItty > bestTokenItty	)
+					if( CTokenizer::NextTokensAreIdentifiers( mFileName, tokenItty, tokens, mGrammar->mUnaryOperators[x].mType, mGrammar->mUnaryOperators[x].mSecondType, mGrammar->mUnaryOperators[x].mThirdType, mGrammar->mUnaryOperators[x].mFourthType, ELastIdentifier_Sentinel ) && tokenItty > bestTokenItty	)
 					{
 						// Longest match yet!
-						operatorCommandName = sUnaryOperators[x].mInstructionID;
-						operatorParam1 = sUnaryOperators[x].mInstructionParam1;
-						operatorParam2 = sUnaryOperators[x].mInstructionParam2;
+						operatorCommandName = mGrammar->mUnaryOperators[x].mInstructionID;
+						operatorParam1 = mGrammar->mUnaryOperators[x].mInstructionParam1;
+						operatorParam2 = mGrammar->mUnaryOperators[x].mInstructionParam2;
 					}
 					else
 					{
@@ -4374,12 +4891,11 @@ CValueNode*	CParser::ParseTerm( CParseTree& parseTree, CCodeBlockNodeBase* currF
 					}
 				}
 				
-				if( operatorCommandName != INVALID_INSTR )
+				if( operatorCommandName != INVALID_INSTR )	// NextTokensAreIdentifiers() already moved tokenItty past the operator.
 				{
-					size_t	lineNum = tokenItty->mLineNum;
-					CTokenizer::GoNextToken( mFileName, tokenItty, tokens );	// Skip operator token.
+					size_t	lineNum = lastTokenItty->mLineNum;
 					
-					COperatorNode*	opFCall = new COperatorNode( &parseTree, operatorCommandName, lineNum );
+					COperatorNode*	opFCall = parseTree.NewNode<COperatorNode>( operatorCommandName, lineNum );
 					opFCall->AddParam( ParseTerm( parseTree, currFunction, tokenItty, tokens, inEndIdentifier ) );
 					opFCall->SetInstructionParams( operatorParam1, operatorParam2 );
 					theTerm = opFCall;
@@ -4407,7 +4923,7 @@ CValueNode*	CParser::ParseTerm( CParseTree& parseTree, CCodeBlockNodeBase* currF
 
 
 CValueNode*	CParser::ParseAnyPostfixOperatorForTerm( CValueNode* theTerm, CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-								std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens,
+								CTokenIterator& tokenItty, CTokenCursor& tokens,
 								TIdentifierSubtype inEndIdentifier )
 {
 	if( tokenItty != tokens.end() )
@@ -4416,19 +4932,19 @@ CValueNode*	CParser::ParseAnyPostfixOperatorForTerm( CValueNode* theTerm, CParse
 		int16_t				operatorParam1 = 0;
 		int32_t				operatorParam2 = 0;
 		size_t				currCommandLineNum = tokenItty->mLineNum;
-		std::deque<CToken>::iterator originalTokenItty = tokenItty;
+		CTokenIterator originalTokenItty = tokenItty;
 		
-		for( size_t x = 0; sPostfixOperators[x].mType != ELastIdentifier_Sentinel; x++ )
+		for( size_t x = 0; mGrammar->mPostfixOperators[x].mType != ELastIdentifier_Sentinel; x++ )
 		{
-			std::deque<CToken>::iterator bestTokenItty = tokenItty;
+			CTokenIterator bestTokenItty = tokenItty;
 			tokenItty = originalTokenItty;
-			TUnaryOperatorEntry *opEntry = sPostfixOperators + x;
+			const TUnaryOperatorEntry *opEntry = &mGrammar->mPostfixOperators[x];
 			if( CTokenizer::NextTokensAreIdentifiers( mFileName, tokenItty, tokens, opEntry->mType, opEntry->mSecondType, opEntry->mThirdType, opEntry->mFourthType, ELastIdentifier_Sentinel ) && tokenItty > bestTokenItty )
 			{
 				// Longest match yet!
-				operatorCommandName = sPostfixOperators[x].mInstructionID;
-				operatorParam1 = sPostfixOperators[x].mInstructionParam1;
-				operatorParam2 = sPostfixOperators[x].mInstructionParam2;
+				operatorCommandName = mGrammar->mPostfixOperators[x].mInstructionID;
+				operatorParam1 = mGrammar->mPostfixOperators[x].mInstructionParam1;
+				operatorParam2 = mGrammar->mPostfixOperators[x].mInstructionParam2;
 			}
 			else	// This wasn't a longer match than the previous one?
 			{
@@ -4438,7 +4954,7 @@ CValueNode*	CParser::ParseAnyPostfixOperatorForTerm( CValueNode* theTerm, CParse
 		
 		if( operatorCommandName != INVALID_INSTR )
 		{
-			COperatorNode * postfixOpNode = new COperatorNode( &parseTree, operatorCommandName, currCommandLineNum );
+			COperatorNode * postfixOpNode = parseTree.NewNode<COperatorNode>( operatorCommandName, currCommandLineNum );
 			postfixOpNode->AddParam( theTerm );
 			postfixOpNode->SetInstructionParams( operatorParam1, operatorParam2 );
 			theTerm = postfixOpNode;
@@ -20,15 +20,18 @@
 #pragma once
 
 #include <deque>
-#include "CToken.h"
+#include "CTokenCursor.h"
 #include <sstream>
 #include <ios>
 #include <map>
 #include <vector>
+#include <memory>
+#include <atomic>
 
 
 #include "CParseTree.h"
 #include "CCodeBlockNode.h"
+#include "CNativeHeadersIndex.h"
 extern "C" {
 #include "LEOInterpreter.h"
 #include "ForgeTypes.h"
@@ -40,6 +43,7 @@ namespace Carlson
 	class CFunctionDefinitionNode;
 	class CCodeBlockNodeBase;
 	class CFunctionCallNode;
+	struct TStatementEntry;
 	
 	//! An entry in our chunk type look-up table.
 	struct TChunkTypeEntry
@@ -80,6 +84,16 @@ namespace Carlson
 		std::string				mMethodSignature;	//!< The return and parameter types of the method.
 	};
 	
+	//! Part of a .hhc file with a directory that declares one framework's API. See CParser::LoadNativeHeadersDirectory().
+	class CNativeHeadersSection
+	{
+	public:
+		std::string				mFilePath;
+		std::streamoff			mOffset;			//!< From the start of the file.
+		size_t					mLength;
+		bool					mLoaded;
+	};
+	
 	//! Warning/error that the script editor can show in-line or in some asynchronous place.
 	class CMessageEntry
 	{
@@ -115,6 +129,7 @@ namespace Carlson
 		std::vector<char>	mFileData;
 		
 		CIncludeFileEntry( std::string inFileName, std::string inRelativeToFileName, const std::vector<char>& inFileData ) : mFileName(inFileName), mRelativeToFileName(inRelativeToFileName), mFileData(inFileData) {}
+		CIncludeFileEntry( std::string inFileName, std::string inRelativeToFileName, std::vector<char>&& inFileData ) : mFileName(inFileName), mRelativeToFileName(inRelativeToFileName), mFileData(std::move(inFileData)) {}
 	};
 	
 	
@@ -124,6 +139,47 @@ namespace Carlson
 		EVarsAreLocals
 	} TAllVarsAreGlobals;
 	
+	/*!
+		@class CParserGrammar
+		All the parts of the language a host can add to: operators, host
+		commands and functions, constants etc., plus indexes to look them up
+		by identifier. Register additions using CParser's static Add...
+		functions, then get a grammar containing them by calling GetCurrent().
+		A grammar never changes once it has been created, so any number of
+		CParsers on any number of threads can share one.
+	*/
+	
+	class CParserGrammar
+	{
+	public:
+		static std::shared_ptr<const CParserGrammar>	GetCurrent();	//!< Grammar with everything registered so far. Creates a new one only if something was added since the last call.
+		
+		const TBuiltInFunctionEntry*	GetBuiltInFunctionWithName( const std::string& inName ) const;
+		
+	public:
+		// Copies of the registered tables. Like those, each ends in an ELastIdentifier_Sentinel entry:
+		std::vector<TOperatorEntry>			mOperators;
+		std::vector<TUnaryOperatorEntry>	mUnaryOperators;
+		std::vector<TUnaryOperatorEntry>	mPostfixOperators;
+		std::vector<TGlobalPropertyEntry>	mGlobalProperties;
+		std::vector<THostCommandEntry>		mHostCommands;
+		std::vector<THostCommandEntry>		mHostFunctions;
+		std::vector<TBuiltInFunctionEntry>	mBuiltInFunctions;
+		std::vector<TConstantEntry>			mConstants;
+		std::vector<TBuiltInVariableEntry>	mBuiltInVariables;
+		
+		// Indexes into the tables above, grouped by what we look entries up by, in table order:
+		const TStatementEntry*	mStatementsByIdentifier[ELastIdentifier_Sentinel +1];		//!< Built-in statement starting with this identifier, or NULL.
+		std::vector<size_t>		mOperatorsByIdentifier[ELastIdentifier_Sentinel +1];		//!< Keyed by first identifier.
+		std::vector<size_t>		mHostCommandsByIdentifier[ELastIdentifier_Sentinel +1];		//!< Keyed by first identifier.
+		std::vector<size_t>		mHostFunctionsByIdentifier[ELastIdentifier_Sentinel +1];	//!< Keyed by first identifier.
+		std::vector<size_t>		mConstantsByIdentifier[ELastIdentifier_Sentinel +1];		//!< Keyed by first identifier.
+		std::vector<size_t>		mConstantsBySetName[ELastIdentifier_Sentinel +1];			//!< Keyed by mSetName.
+		
+	protected:
+		CParserGrammar();	//!< Copies and indexes the registered tables. Caller must hold the registration lock.
+	};
+	
 	// -------------------------------------------------------------------------
 	
 	typedef std::function<bool(const std::string& inFileName,const std::string& inRelativeToFileName,std::vector<char>&outContents)> CParserIncludeHandler;	//!< Fills outContents with the contents of the requested include file. Returns TRUE on success, FALSE otherwise.
@@ -147,6 +203,12 @@ namespace Carlson
 		std::vector<CHandlerNotesEntry>	mHandlerNotes;			//!< List of documentation comments found in the script.
 		CParserIncludeHandler		mIncludeHandler;			//!< Lambda that is called (if present) to retrieve a file included using the "use" statement in web page mode.
 		std::vector<CIncludeFileEntry>	mIncludeFiles;			//!< List file names included using the "use" statement so debugger can register them as well.
+		std::shared_ptr<const CParserGrammar>	mGrammar;		//!< Operators, host commands etc. we know about.
+		CFunctionDefinitionNode*	mLastErrorFunction;			//!< Handler whose end we didn't find because of a parse error.
+		bool						mParseInParallel;			//!< TRUE if Parse() may split a script up into batches of handlers and parse those on several threads.
+		size_t						mNumParallelParseBatches;	//!< Number of batches to split scripts into if mParseInParallel is TRUE, 0 to pick one based on CPU count and number of handlers.
+		bool						mBufferDiagnostics;			//!< TRUE for ParseInParallel() batches, which mustn't print anything until we know their results get used.
+		std::string					mBufferedDiagnostics;		//!< What PrintDiagnostic() collected while mBufferDiagnostics was TRUE.
 		
 	protected:
 		static std::map<std::string,CObjCMethodEntry>	sObjCMethodTable;		//!< Populated from frameworkheaders.hhc file.
@@ -154,7 +216,18 @@ namespace Carlson
 		static std::map<std::string,CObjCMethodEntry>	sCFunctionPointerTable;	//!< Populated from frameworkheaders.hhc file.
 		static std::map<std::string,std::string>		sSynonymToTypeTable;	//!< Populated from frameworkheaders.hhc file.
 		static std::map<std::string,std::string>		sConstantToValueTable;	//!< Populated from frameworkheaders.hhc file.
-		static LEOFirstNativeCallCallbackPtr			sFirstNativeCallCallback;
+		static std::vector<std::shared_ptr<CNativeHeadersIndex>>	sNativeHeadersIndexes;	//!< Precompiled frameworkheaders.hhc files, most recently loaded last.
+		static std::atomic<LEOFirstNativeCallCallbackPtr>	sFirstNativeCallCallback;
+		static std::vector<CNativeHeadersSection>	sNativeHeadersSections;			//!< Sections of .hhc files with a directory, loaded once a script uses one of their symbols.
+		static std::map<std::string,size_t>			sNativeHeadersSymbolSections;	//!< Symbol name -> index of the section in sNativeHeadersSections that defines it.
+
+		static void		ParseNativeHeaders( std::istream& headerFile, std::map<std::string,CObjCMethodEntry>& ioObjCMethods,
+											std::map<std::string,CObjCMethodEntry>& ioCFunctions, std::map<std::string,CObjCMethodEntry>& ioCFunctionPointers,
+											std::map<std::string,std::string>& ioSynonymsToTypes, std::map<std::string,std::string>& ioConstantsToValues );
+		static void		LoadNativeHeadersDirectory( std::istream& headerFile, const char* filepath );
+		static bool		LoadNativeHeadersSectionForSymbol( const std::string& inName );	//!< Returns FALSE if there is no section to load for inName, or it was already loaded.
+		static bool		FindNativeMethod( CNativeHeadersIndex::TTable inTable, const std::string& inName, CObjCMethodEntry& outEntry );	//!< Looks in the tables loaded from .hhc files, then in the indexes.
+		static bool		FindNativeConstant( const std::string& inName, std::string& outValue );
 
 		template<typename T>
 		void ThrowDeferableErrorAddToStream(std::stringstream& stream, T v) {
@@ -167,124 +240,141 @@ namespace Carlson
 			ThrowDeferableErrorAddToStream(stream, args...);
 		}
 		
-		[[noreturn]] void ThrowDeferrableErrorThrow( const std::string& errMsg, std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens );
+		[[noreturn]] void ThrowDeferrableErrorThrow( const std::string& errMsg, CTokenIterator& tokenItty, CTokenCursor& tokens );
+		
+		void	ParseTopLevelConstructs( CTokenIterator& tokenItty, CTokenIterator endItty, CTokenCursor& tokens, CParseTree& parseTree, const char* scriptText );
+		bool	ParseInParallel( const char* fname, CTokenCursor& tokens, CParseTree& parseTree, const char* scriptText );	//!< Returns FALSE if the script has to be parsed serially, without changing parseTree or our state.
+		void	PrintDiagnostic( const std::string& inMessage );	//!< Prints inMessage, or keeps it in mBufferedDiagnostics if mBufferDiagnostics is TRUE.
 
+	public:
+		typedef void	(CParser::*TStatementParser)( CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
+												CTokenIterator& tokenItty, CTokenCursor& tokens );	//!< Parses a built-in statement, see ParseOneLine().
+		typedef void	(CParser::*THandlerStatementParser)( const std::string& userHandlerName, CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
+												CTokenIterator& tokenItty, CTokenCursor& tokens );	//!< Parses a built-in statement that needs to know what handler it is in.
+		
 	public:
 		CParser();
+		explicit CParser( std::shared_ptr<const CParserGrammar> inGrammar );	//!< Use the given grammar instead of CParserGrammar::GetCurrent().
 		
-		void	Parse( const char* fname, std::deque<CToken>& tokens, CParseTree& parseTree, const char* scriptText );	//!< Parse a complete script consisting of handlers etc.
-		void	ParseCommandOrExpression( const char* fname, std::deque<CToken>& tokens, CParseTree& parseTree, TAllVarsAreGlobals inAllVarsAreGlobals );	//!< Generates a handler named ":run" that returns the given expression.
+		void	Parse( const char* fname, CTokenCursor& tokens, CParseTree& parseTree, const char* scriptText );	//!< Parse a complete script consisting of handlers etc. Scripts are only parsed in parallel if tokens.HasAllTokens().
+		void	Parse( const char* fname, std::deque<CToken>& tokens, CParseTree& parseTree, const char* scriptText )	{ CDequeTokenCursor cursor( tokens ); Parse( fname, cursor, parseTree, scriptText ); };
+		void	ParseCommandOrExpression( const char* fname, CTokenCursor& tokens, CParseTree& parseTree, TAllVarsAreGlobals inAllVarsAreGlobals );	//!< Generates a handler named ":run" that returns the given expression.
+		void	ParseCommandOrExpression( const char* fname, std::deque<CToken>& tokens, CParseTree& parseTree, TAllVarsAreGlobals inAllVarsAreGlobals )	{ CDequeTokenCursor cursor( tokens ); ParseCommandOrExpression( fname, cursor, parseTree, inAllVarsAreGlobals ); };
 		
-		void	ParseTopLevelConstruct( std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens, CParseTree& parseTree, const char* scriptText );
-		void	ParseDocumentation( std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens, CParseTree& parseTree, const char* scriptText );
-		CFunctionDefinitionNode*	StartParsingFunctionDefinition( const std::string& handlerName, const std::string& userHandlerName, bool isCommand, size_t fcnLineNum, std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens, const std::string& documentation, CParseTree& parseTree );	// Called by ParseFunctionDefinition.
-		void	ParseFunctionDefinition( bool isCommand, std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens, const std::string& documentation, CParseTree& parseTree );
-		CValueNode	*	ParseFunctionCall( CParseTree& parseTree, CCodeBlockNodeBase* currFunction, bool isMessagePassing, std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens );
-		void	ParsePassStatement( CParseTree& parseTree, CCodeBlockNodeBase* currFunction, std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens );
-		void	ParseHandlerCall( CParseTree& parseTree, CCodeBlockNodeBase* currFunction, bool isMessagePassing, std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens );
+		void	ParseTopLevelConstruct( CTokenIterator& tokenItty, CTokenCursor& tokens, CParseTree& parseTree, const char* scriptText );
+		void	ParseDocumentation( CTokenIterator& tokenItty, CTokenCursor& tokens, CParseTree& parseTree, const char* scriptText );
+		CFunctionDefinitionNode*	StartParsingFunctionDefinition( const std::string& handlerName, const std::string& userHandlerName, bool isCommand, size_t fcnLineNum, CTokenIterator& tokenItty, CTokenCursor& tokens, const std::string& documentation, CParseTree& parseTree );	// Called by ParseFunctionDefinition.
+		void	ParseFunctionDefinition( bool isCommand, CTokenIterator& tokenItty, CTokenCursor& tokens, const std::string& documentation, CParseTree& parseTree );
+		CValueNode	*	ParseFunctionCall( CParseTree& parseTree, CCodeBlockNodeBase* currFunction, bool isMessagePassing, CTokenIterator& tokenItty, CTokenCursor& tokens );
+		void	ParsePassStatement( CParseTree& parseTree, CCodeBlockNodeBase* currFunction, CTokenIterator& tokenItty, CTokenCursor& tokens );
+		void	ParseHandlerCall( CParseTree& parseTree, CCodeBlockNodeBase* currFunction, bool isMessagePassing, CTokenIterator& tokenItty, CTokenCursor& tokens );
 		void	FindPrintHostCommand( LEOInstructionID* printInstrID, uint16_t* param1, uint32_t* param2 );
 		void	ParsePutStatement( CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-									std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens );
+									CTokenIterator& tokenItty, CTokenCursor& tokens );
 		void	ParseGetStatement( CParseTree& parseTree,
 									CCodeBlockNodeBase* currFunction,
-									std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens );
+									CTokenIterator& tokenItty, CTokenCursor& tokens );
 		void	ParseSetStatement( CParseTree& parseTree,
 									CCodeBlockNodeBase* currFunction,
-									std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens );
+									CTokenIterator& tokenItty, CTokenCursor& tokens );
 		void	ParseWebPageContentToken( CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-									std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens );
+									CTokenIterator& tokenItty, CTokenCursor& tokens );
 		void	ParseHostCommand( CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-									std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens );
+									CTokenIterator& tokenItty, CTokenCursor& tokens );
 		CValueNode*	ParseHostFunction( CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-										std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens );
+										CTokenIterator& tokenItty, CTokenCursor& tokens );
 		CValueNode*	ParseHostEntityWithTable( CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-										std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens,
-										THostCommandEntry* inHostTable );
+										CTokenIterator& tokenItty, CTokenCursor& tokens,
+										const std::vector<THostCommandEntry>& inHostTable, const std::vector<size_t>& inCandidates );
 		void	ParseGlobalStatement( CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-										std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens );
+										CTokenIterator& tokenItty, CTokenCursor& tokens );
 		void	ParseReturnStatement( CParseTree& parseTree,
 										CCodeBlockNodeBase* currFunction,
-										std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens );
+										CTokenIterator& tokenItty, CTokenCursor& tokens );
 		void	ParseDownloadStatement( const std::string& userHandlerName, CParseTree& parseTree,
 										CCodeBlockNodeBase* currFunction,
-										std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens );
+										CTokenIterator& tokenItty, CTokenCursor& tokens );
+		void	ParseExitStatement( const std::string& userHandlerName, CParseTree& parseTree,
+										CCodeBlockNodeBase* currFunction,
+										CTokenIterator& tokenItty, CTokenCursor& tokens );
+		void	ParseNextStatement( CParseTree& parseTree,
+										CCodeBlockNodeBase* currFunction,
+										CTokenIterator& tokenItty, CTokenCursor& tokens );
 		void	ParseRepeatForEachStatement( const std::string& userHandlerName, CParseTree& parseTree,
 										CCodeBlockNodeBase* currFunction,
-										std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens );
+										CTokenIterator& tokenItty, CTokenCursor& tokens );
 		void	ParseRepeatStatement( const std::string& userHandlerName, CParseTree& parseTree,
 										CCodeBlockNodeBase* currFunction,
-										std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens );
+										CTokenIterator& tokenItty, CTokenCursor& tokens );
 		void	ParseIfStatement( const std::string& userHandlerName, CParseTree& parseTree,
 										CCodeBlockNodeBase* currFunction,
-										std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens );
+										CTokenIterator& tokenItty, CTokenCursor& tokens );
 		CValueNode*	ParseContainer( bool asPointer, bool initWithName, CParseTree& parseTree,
 										CCodeBlockNodeBase* currFunction,
-										std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens,
+										CTokenIterator& tokenItty, CTokenCursor& tokens,
 										TIdentifierSubtype inEndToken );
 		CValueNode*	ParseArrayItem( CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-									std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens );
+									CTokenIterator& tokenItty, CTokenCursor& tokens );
 		void	ParseOneLine( const std::string& userHandlerName,
 										CParseTree& parseTree,
 										CCodeBlockNodeBase* currFunction,
-										std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens,
+										CTokenIterator& tokenItty, CTokenCursor& tokens,
 										bool dontSwallowReturn = false );
 		void	ParseFunctionBody( std::string& userHandlerName,
 									CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-									std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens,
+									CTokenIterator& tokenItty, CTokenCursor& tokens,
 									size_t *outEndLineNum = NULL, TIdentifierSubtype endIdentifier = EEndIdentifier,
 									bool parseFirstLineAsReturnExpression = false );
 		void	ParseParamList( TIdentifierSubtype identifierToEndOn,
 								CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-								std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens,
+								CTokenIterator& tokenItty, CTokenCursor& tokens,
 								CFunctionCallNode* inFCallToAddTo );
 		CValueNode*	ParseObjCMethodCall( CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-										std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens );
+										CTokenIterator& tokenItty, CTokenCursor& tokens );
 		CValueNode*	ParseNativeFunctionCallStartingAtParams( std::string& methodName, CObjCMethodEntry& methodInfo,
 										CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-										std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens );
+										CTokenIterator& tokenItty, CTokenCursor& tokens );
 		CValueNode* ParseNumberOfExpression( CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-												std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens,
+												CTokenIterator& tokenItty, CTokenCursor& tokens,
 												TIdentifierSubtype inEndIdentifier );
 		CValueNode*	ParseTerm( CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-										std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens,
+										CTokenIterator& tokenItty, CTokenCursor& tokens,
 										TIdentifierSubtype inEndIdentifier );
 		CValueNode*	ParseAnyFollowingArrayDefinitionWithKey(CValueNode* theTerm, CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-								std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens,
+								CTokenIterator& tokenItty, CTokenCursor& tokens,
 								TIdentifierSubtype inEndIdentifier);	//!< Returns theTerm if it didn't find an array definition after this potential key in theTerm.
 		CValueNode*	ParseAnyPostfixOperatorForTerm( CValueNode* theTerm, CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-								std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens,
+								CTokenIterator& tokenItty, CTokenCursor& tokens,
 								TIdentifierSubtype inEndIdentifier );
 		void	OutputExpressionStack( CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
 										std::deque<std::string>	&terms, std::deque<const char*>	&operators );
 		void	CreateVariable( const std::string& varName, const std::string& realVarName, bool initWithName,
 								CCodeBlockNodeBase* currFunction, bool isGlobal = false );
-		TIdentifierSubtype	ParseOperator( std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens, int *outPrecedence, LEOInstructionID *outOpName );
+		TIdentifierSubtype	ParseOperator( CTokenIterator& tokenItty, CTokenCursor& tokens, int *outPrecedence, LEOInstructionID *outOpName );
 		CValueNode*	ParseChunkExpression( TChunkType typeConstant, CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-										std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens );
+										CTokenIterator& tokenItty, CTokenCursor& tokens );
 		CValueNode*	ParseConstantChunkExpression( TChunkType typeConstant, CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-										std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens );
+										CTokenIterator& tokenItty, CTokenCursor& tokens );
 		CValueNode*	ParseExpression( CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-										std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens, TIdentifierSubtype inEndToken );
+										CTokenIterator& tokenItty, CTokenCursor& tokens, TIdentifierSubtype inEndToken );
 		void	ParseAddStatement( CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-										std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens );
+										CTokenIterator& tokenItty, CTokenCursor& tokens );
 		void	ParseSubtractStatement( CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-										std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens );
+										CTokenIterator& tokenItty, CTokenCursor& tokens );
 		void	ParseMultiplyStatement( CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-										std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens );
+										CTokenIterator& tokenItty, CTokenCursor& tokens );
 		void	ParseDivideStatement( CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-										std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens );
+										CTokenIterator& tokenItty, CTokenCursor& tokens );
 		TChunkType	GetChunkTypeNameFromIdentifierSubtype( TIdentifierSubtype identifierToCheck );
 		void	FillArrayWithComponentsSeparatedBy( const char* typesStr, char delimiter, std::deque<std::string> &destTypesList );
 		void	CreateHandlerTrampolineForFunction( const std::string &handlerName, const std::string& procPtrName,
 														const char* typesStr,
 														std::stringstream& theCode, std::string &outTrampolineName );
 		CValueNode*	ParseColumnRowExpression( CParseTree& parseTree, CCodeBlockNodeBase* currFunction,
-								std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens, TIdentifierSubtype inEndToken );
-		
-		CValueNode*	CollapseExpressionStack( CParseTree& parseTree, std::deque<CValueNode*> &terms, std::deque<LEOInstructionID> &operators );
+								CTokenIterator& tokenItty, CTokenCursor& tokens, TIdentifierSubtype inEndToken );
 		
 		template<typename... Args>
-		[[noreturn]] void ThrowDeferrableError( std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens, Args... args ) {
+		[[noreturn]] void ThrowDeferrableError( CTokenIterator& tokenItty, CTokenCursor& tokens, Args... args ) {
 			std::stringstream stream;
 			ThrowDeferableErrorAddToStream(stream, args...);
 			ThrowDeferrableErrorThrow(stream.str(), tokenItty, tokens);
@@ -299,6 +389,7 @@ namespace Carlson
 		
 		void		LoadNativeHeaders();
 		void		SetWebPageEmbedMode( bool inState )	{ mWebPageEmbedMode = inState; }
+		void		SetParseInParallel( bool inState, size_t inNumBatches = 0 )	{ mParseInParallel = inState; mNumParallelParseBatches = inNumBatches; }	//!< Messages, handler notes and the parse tree come out the same either way. Ignored in web page embed mode and if there is an include handler, as that need not be thread-safe.
 		void		SetIncludeHandler( CParserIncludeHandler inIncludeHandler ) { mIncludeHandler = inIncludeHandler; };
 		
 		const std::vector<CMessageEntry>&		GetMessages()		{ return mMessages; };
@@ -306,8 +397,10 @@ namespace Carlson
 		const std::vector<CIncludeFileEntry>&	GetIncludedFiles()	{ return mIncludeFiles; }
 		
 	// statics:
-		static TBuiltInFunctionEntry* GetBuiltInFunctionWithName( const std::string& inName );
-		static void		LoadNativeHeadersFromFile( const char* filepath );	//!< Used to load OS-native API signatures and names from the frameworkheaders.hhc file.
+		static const TBuiltInFunctionEntry* GetBuiltInFunctionWithName( const std::string& inName );	//!< Looks in CParserGrammar::GetCurrent().
+		static void		LoadNativeHeadersFromFile( const char* filepath );	//!< Used to load OS-native API signatures and names from the frameworkheaders.hhc file, or an index made from one using CompileNativeHeadersFile().
+		static void		CompileNativeHeadersFile( const char* inHeadersPath, const char* inIndexPath );	//!< Turn a .hhc file into an index that LoadNativeHeadersFromFile() can map into memory instead of parsing it.
+		static void		AddDirectoryToNativeHeadersFile( const char* inHeadersPath, const char* inOutputPath );	//!< Write a copy of a .hhc file of which LoadNativeHeadersFromFile() only loads the frameworks scripts actually use.
 		static void		SetFirstNativeCallCallback( LEOFirstNativeCallCallbackPtr inCallback );	//!< Callback to be invoked when the user actually triggers execution of the first OS-native API. Allows lazy-loading some parts of the system headers.
 		static void		AddOperatorsAndOffsetInstructions( TOperatorEntry* inEntries, LEOInstructionID firstOperatorInstruction );
 		static void		AddUnaryOperatorsAndOffsetInstructions( TUnaryOperatorEntry* inEntries, LEOInstructionID firstUnaryOperatorInstruction );
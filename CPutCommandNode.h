@@ -17,6 +17,9 @@ class CPutCommandNode : public CCommandNode
 public:
 	CPutCommandNode( CParseTree* inTree, size_t inLineNum, std::string inFileName ) : CCommandNode( inTree, "Put", inLineNum, inFileName ) {};
 
+	static const TNodeKind	kNodeKind = EPutCommandNodeKind;
+	virtual TNodeKind	GetNodeKind()	{ return kNodeKind; };
+
 	virtual void	GenerateCode( CCodeBlock* inCodeBlock );
 };
 
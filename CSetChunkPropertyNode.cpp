@@ -16,7 +16,7 @@ namespace Carlson
 		
 CValueNode*	CSetChunkPropertyNode::Copy()
 {
-	CSetChunkPropertyNode	*	nodeCopy = new CSetChunkPropertyNode( mParseTree, mLineNum );
+	CSetChunkPropertyNode	*	nodeCopy = mParseTree->NewNode<CSetChunkPropertyNode>( mLineNum );
 	
 	std::vector<CValueNode*>::const_iterator	itty;
 	for( itty = mParams.begin(); itty != mParams.end(); itty++ )
@@ -14,8 +14,23 @@
 #include <sstream>
 #include <string>
 #include <cstdarg>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
+#include <exception>
 #include "UTF8UTF32Utilities.h"
 #include "CForgeExceptions.h"
+#include "CTokenCursor.h"
+#if __SSE2__ || _M_X64 || (_M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TOKENIZER_USE_SSE2			1
+#else
+#define TOKENIZER_USE_SSE2			0
+#endif
 
 
 #define VERBOSE_TOKEN_PARSING		0
@@ -57,45 +72,400 @@ TIdentifierSubtype	gIdentifierSynonyms[ELastIdentifier_Sentinel +1] =
 	ELastIdentifier_Sentinel
 };
 
-#pragma mark -
+#pragma mark Case folding
 
+	// UTF32CharacterToLower() for the Basic Multilingual Plane, looked up in a
+	//	table instead of calculated each time. Only the few 256-character pages
+	//	that contain characters with a lowercase form get a table of their own.
+	
+	class CLowercaseTable
+	{
+	public:
+		CLowercaseTable();
+		
+		uint32_t	ToLower( uint32_t inChar ) const
+		{
+			if( inChar > 0xFFFF )
+				return UTF32CharacterToLower( inChar );
+			uint8_t	pageIndex = mPageIndexForHighByte[inChar >> 8];
+			if( pageIndex == 0 )
+				return inChar;
+			return mPages[ (pageIndex -1) * 256 + (inChar & 0xFF) ];
+		}
+		
+	protected:
+		uint8_t					mPageIndexForHighByte[256];	// 0 means nothing on this page changes.
+		std::vector<uint32_t>	mPages;
+	};
+	
+	
+	CLowercaseTable::CLowercaseTable()
+	{
+		memset( mPageIndexForHighByte, 0, sizeof(mPageIndexForHighByte) );
+		
+		for( uint32_t currPage = 0; currPage < 256; currPage++ )
+		{
+			uint32_t	lowercasedPage[256];
+			bool		pageChanges = false;
+			for( uint32_t x = 0; x < 256; x++ )
+			{
+				lowercasedPage[x] = UTF32CharacterToLower( (currPage << 8) | x );
+				pageChanges = pageChanges || lowercasedPage[x] != ((currPage << 8) | x);
+			}
+			if( pageChanges )
+			{
+				mPages.insert( mPages.end(), lowercasedPage, lowercasedPage +256 );
+				mPageIndexForHighByte[currPage] = (uint8_t) (mPages.size() / 256);
+			}
+		}
+	}
+	
+	
+	static const CLowercaseTable&	GetLowercaseTable()
+	{
+		static const CLowercaseTable	sLowercaseTable;	// Built on first use.
+		return sLowercaseTable;
+	}
+	
+	
 	std::string	ToLowerString( const std::string& inUTF8String )
 	{
+		const CLowercaseTable&	lowercaseTable = GetLowercaseTable();
 		std::string		outStr;
 		size_t			x = 0,
 						theLen = inUTF8String.length();
 		const char*		inUTF8Bytes = inUTF8String.c_str();
 		
+		outStr.reserve( theLen );
 		while( x < theLen )
 		{
+			if( (inUTF8Bytes[x] & 0x80) == 0 )	// ASCII? No need to decode and re-encode:
+			{
+				outStr.append( 1, (char) lowercaseTable.ToLower( (uint8_t) inUTF8Bytes[x] ) );
+				++x;
+				continue;
+			}
+			
 			uint32_t	currUTF32Char = UTF8StringParseUTF32CharacterAtOffset( inUTF8Bytes, theLen, &x );
 			char		outUTF8Bytes[6];
 			size_t		bytesLength = 0;
-			UTF8BytesForUTF32Character( UTF32CharacterToLower( currUTF32Char ), outUTF8Bytes, &bytesLength );
+			UTF8BytesForUTF32Character( lowercaseTable.ToLower( currUTF32Char ), outUTF8Bytes, &bytesLength );
 			outStr.append( outUTF8Bytes, bytesLength );
 		}
 		
 		return outStr;
 	}
+	
+	
+	// Like ToLowerString( a ).compare( ToLowerString( b ) ), but returns -1, 0 or 1 and doesn't allocate:
+	static int	CompareLowercased( const std::string& a, const std::string& b )
+	{
+		const CLowercaseTable&	lowercaseTable = GetLowercaseTable();
+		size_t					aX = 0,
+								bX = 0;
+		while( aX < a.length() && bX < b.length() )
+		{
+			uint32_t	aCh = lowercaseTable.ToLower( UTF8StringParseUTF32CharacterAtOffset( a.c_str(), a.length(), &aX ) );
+			uint32_t	bCh = lowercaseTable.ToLower( UTF8StringParseUTF32CharacterAtOffset( b.c_str(), b.length(), &bX ) );
+			if( aCh != bCh )
+				return (aCh < bCh) ? -1 : 1;	// UTF-8 sorts the same as the code points it encodes.
+		}
+		
+		if( aX < a.length() )
+			return 1;
+		else if( bX < b.length() )
+			return -1;
+		return 0;
+	}
 
-#pragma mark -
+#pragma mark Identifier atoms
+
+	// Lowercased text of every non-keyword identifier we've seen, numbered in the order we first
+	//	saw it. Names are never removed and live in fixed-size chunks that never move, so once a
+	//	thread has an atom, it can look up its name without taking the lock.
 	
-	TIdentifierSubtype	CToken::IdentifierTypeFromText( const char* inLowercasedString )
+	class CIdentifierAtomTable
 	{
-		size_t		x = (size_t) ELastIdentifier_Sentinel;
+	public:
+		enum
+		{
+			kChunkSize = 4096,
+			kMaxChunks = 4096
+		};
 		
-		while( true )
+		CIdentifierAtomTable()	{ for( size_t x = 0; x < kMaxChunks; x++ ) mChunks[x] = NULL; }
+		
+		TIdentifierAtom		AtomForLowercasedText( const std::string& inText );
+		const std::string&	TextForAtom( TIdentifierAtom inAtom ) const
 		{
-			--x;
-			
-			if( strcmp( gIdentifierStrings[x], inLowercasedString ) == 0 )
-				return (TIdentifierSubtype) x;
-			
-			if( x == 0 )
+			size_t	index = inAtom - (kNoIdentifierAtom +1);
+			return mChunks[index / kChunkSize].load( std::memory_order_acquire )[index % kChunkSize];
+		}
+		
+	protected:
+		std::mutex									mMutex;
+		std::unordered_map<std::string,TIdentifierAtom>	mAtomsByText;
+		std::atomic<std::string*>					mChunks[kMaxChunks];
+		size_t										mNumAtoms = 0;
+	};
+	
+	
+	TIdentifierAtom	CIdentifierAtomTable::AtomForLowercasedText( const std::string& inText )
+	{
+		std::lock_guard<std::mutex>	lock( mMutex );
+		
+		std::unordered_map<std::string,TIdentifierAtom>::const_iterator	foundAtom = mAtomsByText.find( inText );
+		if( foundAtom != mAtomsByText.end() )
+			return foundAtom->second;
+		
+		if( mNumAtoms >= (size_t(kChunkSize) * kMaxChunks) )
+			throw std::runtime_error( "Too many different identifiers." );
+		
+		std::string*	chunk = mChunks[mNumAtoms / kChunkSize].load( std::memory_order_relaxed );
+		if( !chunk )
+		{
+			chunk = new std::string[kChunkSize];
+			mChunks[mNumAtoms / kChunkSize].store( chunk, std::memory_order_release );
+		}
+		chunk[mNumAtoms % kChunkSize] = inText;
+		
+		TIdentifierAtom	newAtom = (TIdentifierAtom) (mNumAtoms + kNoIdentifierAtom +1);
+		++mNumAtoms;
+		mAtomsByText[inText] = newAtom;
+		
+		return newAtom;
+	}
+	
+	
+	static CIdentifierAtomTable&	GetIdentifierAtomTable()
+	{
+		static CIdentifierAtomTable*	sAtomTable = new CIdentifierAtomTable;	// Never destroyed, tokens in static objects may still use it at exit.
+		return *sAtomTable;
+	}
+	
+	
+	TIdentifierAtom	CToken::AtomFromOriginalText( const std::string& str )
+	{
+		// Most identifiers are spelled the same way every time, so remember each spelling's atom
+		//	per thread. That way we only lowercase and take the lock the first time we see a spelling:
+		static thread_local std::unordered_map<std::string,TIdentifierAtom>	sAtomsBySpelling;
+		
+		std::unordered_map<std::string,TIdentifierAtom>::const_iterator	foundAtom = sAtomsBySpelling.find( str );
+		if( foundAtom != sAtomsBySpelling.end() )
+			return foundAtom->second;
+		
+		TIdentifierAtom	atom = GetIdentifierAtomTable().AtomForLowercasedText( ToLowerString( str ) );
+		sAtomsBySpelling[str] = atom;
+		return atom;
+	}
+	
+	
+	const std::string&	CToken::TextFromAtom( TIdentifierAtom inAtom )
+	{
+		static const std::vector<std::string>	sIdentifierStrings( gIdentifierStrings, gIdentifierStrings +ELastIdentifier_Sentinel );
+		
+		if( inAtom < kNoIdentifierAtom )
+			return sIdentifierStrings[inAtom];
+		else if( inAtom == kNoIdentifierAtom )
+			throw std::runtime_error( "Not an identifier atom." );
+		return GetIdentifierAtomTable().TextForAtom( inAtom );
+	}
+	
+#pragma mark Identifier lookup
+
+	// A DFA over the bytes of all strings in gIdentifierStrings, so we can
+	//	classify a (lowercased) word in one pass over its bytes without doing
+	//	any string compares. Bytes that occur in no identifier all share
+	//	character class 0, which is never a valid transition, so the table only
+	//	needs one column per byte that actually occurs in an identifier.
+	
+	class CIdentifierLookupTable
+	{
+	public:
+		CIdentifierLookupTable();
+		
+		TIdentifierSubtype	IdentifierTypeFromText( const char* inLowercasedString ) const;
+		TIdentifierSubtype	IdentifierTypeFromASCIIText( const char* inString, size_t inLength ) const;	// inString may contain uppercase, but only ASCII.
+		
+	protected:
+		uint8_t							mClassForByte[256];
+		uint8_t							mClassForASCIIByte[128];	// Like mClassForByte, but uppercase characters share their lowercase counterpart's class.
+		size_t							mNumClasses;
+		std::vector<uint16_t>			mTransitions;		// mNumClasses entries per state. State 0 is the start state, so it also serves as "no match".
+		std::vector<TIdentifierSubtype>	mAcceptedSubtypes;	// One per state. ELastIdentifier_Sentinel if a word can't end in this state.
+	};
+	
+	
+	CIdentifierLookupTable::CIdentifierLookupTable()
+		: mNumClasses(1)
+	{
+		memset( mClassForByte, 0, sizeof(mClassForByte) );
+		for( size_t x = 0; x < ELastIdentifier_Sentinel; x++ )
+		{
+			for( const uint8_t* currCh = (const uint8_t*) gIdentifierStrings[x]; *currCh != 0; currCh++ )
+			{
+				if( mClassForByte[*currCh] == 0 )
+					mClassForByte[*currCh] = (uint8_t) mNumClasses++;
+			}
+		}
+		
+		const CLowercaseTable&	lowercaseTable = GetLowercaseTable();
+		for( uint32_t x = 0; x < 128; x++ )
+		{
+			uint32_t	lowercasedCh = lowercaseTable.ToLower( x );
+			mClassForASCIIByte[x] = (lowercasedCh < 128) ? mClassForByte[lowercasedCh] : 0;
+		}
+		
+		mTransitions.resize( mNumClasses, 0 );
+		mAcceptedSubtypes.push_back( ELastIdentifier_Sentinel );
+		
+		for( size_t x = 0; x < ELastIdentifier_Sentinel; x++ )
+		{
+			size_t	currState = 0;
+			for( const uint8_t* currCh = (const uint8_t*) gIdentifierStrings[x]; *currCh != 0; currCh++ )
+			{
+				size_t	transitionIndex = currState * mNumClasses + mClassForByte[*currCh];
+				if( mTransitions[transitionIndex] == 0 )
+				{
+					mTransitions[transitionIndex] = (uint16_t) mAcceptedSubtypes.size();
+					mTransitions.resize( mTransitions.size() + mNumClasses, 0 );
+					mAcceptedSubtypes.push_back( ELastIdentifier_Sentinel );
+				}
+				currState = mTransitions[transitionIndex];
+			}
+			mAcceptedSubtypes[currState] = (TIdentifierSubtype) x;
+		}
+		
+		if( mAcceptedSubtypes.size() > UINT16_MAX )
+			throw std::logic_error( "Too many identifiers for lookup table." );
+	}
+	
+	
+	TIdentifierSubtype	CIdentifierLookupTable::IdentifierTypeFromText( const char* inLowercasedString ) const
+	{
+		size_t	currState = 0;
+		for( const uint8_t* currCh = (const uint8_t*) inLowercasedString; *currCh != 0; currCh++ )
+		{
+			currState = mTransitions[ currState * mNumClasses + mClassForByte[*currCh] ];
+			if( currState == 0 )
 				return ELastIdentifier_Sentinel;
 		}
 		
-		return ELastIdentifier_Sentinel;
+		return mAcceptedSubtypes[currState];
+	}
+	
+	
+	TIdentifierSubtype	CIdentifierLookupTable::IdentifierTypeFromASCIIText( const char* inString, size_t inLength ) const
+	{
+		size_t	currState = 0;
+		for( size_t x = 0; x < inLength && inString[x] != 0; x++ )	// Stop at NUL like IdentifierTypeFromText().
+		{
+			currState = mTransitions[ currState * mNumClasses + mClassForASCIIByte[(uint8_t) inString[x]] ];
+			if( currState == 0 )
+				return ELastIdentifier_Sentinel;
+		}
+		
+		return mAcceptedSubtypes[currState];
+	}
+
+#pragma mark ASCII fast path
+
+	// Most of a script (and nearly all of a web page's content) is plain ASCII
+	//	that only gets appended to the current token. These helpers find the end
+	//	of such runs so TokenListFromText() can copy them in one go instead of
+	//	decoding and appending one code point at a time. Runs always stop at
+	//	non-ASCII bytes, so those still go through the regular UTF-8 path.
+	
+	// Returns the offset of the first byte at or after x that is non-ASCII
+	//	or one of the given stop characters (or len if there is none):
+	static size_t	FindASCIIRunEnd( const char* str, size_t x, size_t len, char stopCh1, char stopCh2, char stopCh3 )
+	{
+#if TOKENIZER_USE_SSE2
+		const __m128i	stop1 = _mm_set1_epi8( stopCh1 ),
+						stop2 = _mm_set1_epi8( stopCh2 ),
+						stop3 = _mm_set1_epi8( stopCh3 );
+		while( (x + 16) <= len )
+		{
+			__m128i	bytes = _mm_loadu_si128( (const __m128i*) (str + x) );
+			__m128i	stops = _mm_or_si128( _mm_or_si128( _mm_cmpeq_epi8( bytes, stop1 ), _mm_cmpeq_epi8( bytes, stop2 ) ), _mm_cmpeq_epi8( bytes, stop3 ) );
+			int		mask = _mm_movemask_epi8( _mm_or_si128( stops, bytes ) );	// High bit of a byte is set for non-ASCII bytes.
+			if( mask != 0 )
+			{
+				while( (mask & 1) == 0 )
+				{
+					mask >>= 1;
+					++x;
+				}
+				return x;
+			}
+			x += 16;
+		}
+#endif
+		while( x < len )
+		{
+			char	currCh = str[x];
+			if( (currCh & 0x80) || currCh == stopCh1 || currCh == stopCh2 || currCh == stopCh3 )
+				break;
+			++x;
+		}
+		return x;
+	}
+	
+	
+	class CTokenizerByteClasses
+	{
+	public:
+		CTokenizerByteClasses()
+		{
+			for( int currCh = 0; currCh < 256; currCh++ )
+			{
+				char	opstr[2] = { (char) currCh, 0 };
+				mContinuesIdentifier[currCh] = currCh <= 127 && currCh != ' ' && currCh != '\t' && currCh != '\n' && currCh != '\r'
+												&& currCh != '-' && currCh != '(' && currCh != '?'	// Might start a comment or end the code section, depending on next char.
+												&& (isalnum(currCh) || CToken::IdentifierTypeFromText(opstr) == ELastIdentifier_Sentinel);
+				mIsWhitespace[currCh] = (currCh == ' ' || currCh == '\t');
+				mIsDigit[currCh] = currCh <= 127 && isdigit(currCh);
+			}
+		}
+		
+		bool	mContinuesIdentifier[256];	// ASCII chars that TokenListFromText() would just append to an identifier.
+		bool	mIsWhitespace[256];
+		bool	mIsDigit[256];
+	};
+	
+	
+	static size_t	FindByteClassRunEnd( const char* str, size_t x, size_t len, const bool inByteClass[256] )
+	{
+		while( x < len && inByteClass[(uint8_t)str[x]] )
+			++x;
+		return x;
+	}
+
+#pragma mark -
+
+	
+	static const CIdentifierLookupTable&	GetIdentifierLookupTable()
+	{
+		static const CIdentifierLookupTable	sIdentifierLookupTable;	// Built on first use, from gIdentifierStrings.
+		return sIdentifierLookupTable;
+	}
+	
+	
+	TIdentifierSubtype	CToken::IdentifierTypeFromText( const char* inLowercasedString )
+	{
+		return GetIdentifierLookupTable().IdentifierTypeFromText( inLowercasedString );
+	}
+	
+	
+	TIdentifierSubtype	CToken::IdentifierTypeFromOriginalText( const std::string& inString )
+	{
+		for( size_t x = 0; x < inString.length(); x++ )
+		{
+			if( inString[x] & 0x80 )	// Non-ASCII? Lowercase the slow way:
+				return GetIdentifierLookupTable().IdentifierTypeFromText( ToLowerString( inString ).c_str() );
+		}
+		
+		return GetIdentifierLookupTable().IdentifierTypeFromASCIIText( inString.data(), inString.length() );
 	}
 	
 	void CTokenizer::StartCommentToken( const char* str, size_t len, size_t x, TTokenType newType, size_t &newX, TTokenType& currType, std::string& currText, std::string& collectedCommentText )
@@ -113,20 +483,345 @@ TIdentifierSubtype	gIdentifierSynonyms[ELastIdentifier_Sentinel +1] =
 			++newX;
 	}
 	
+	class CTokenDequeSink : public CTokenSink
+	{
+	public:
+		virtual void	AddToken( TTokenType type, TIdentifierSubtype subtype, size_t offs, size_t lineN, const std::string& str, const std::string& comment, long long n = 0 )
+		{
+			mTokens.push_back( CToken( type, subtype, offs, lineN, str, comment, n ) );
+		}
+		
+		std::deque<CToken>	mTokens;
+	};
+	
+	
 	std::deque<CToken>	CTokenizer::TokenListFromText( const char* str, size_t len, bool webPageEmbedMode )
 	{
-		size_t				x = 0,
-							currStartOffs = 0;
-		TTokenType			currType = webPageEmbedMode ? EWebPageContentToken : EInvalidToken;	// Invalid == we're in whitespace. WebPage == keep the literal text and make it a token that turns into a print command, for PHP-style code embedded in web pages.
-		std::string			currText;
-		std::deque<CToken>	tokenList;
-		size_t				currLineNum = 1;
-		size_t				lastCROffset = SIZE_MAX;
-		int					currNestingDepth = 0;	// Nesting depth for nestable quotes.
-		std::string			collectedCommentText;
+		CTokenDequeSink		tokenList;
+		TokenizeText( str, len, webPageEmbedMode, tokenList );
+		return std::move( tokenList.mTokens );
+	}
+	
+	
+	void	CTokenizer::TokenizeText( const char* str, size_t len, bool webPageEmbedMode, CTokenSink& outTokens )
+	{
+		CTokenizerState		tokenizer( str, len, webPageEmbedMode );
+		tokenizer.TokenizeMore( outTokens, false );
+	}
+	
+	
+	// Tokens the tokenizer is guaranteed to have started in whitespace state
+	//	with the token's comment collected, so we can restart it there:
+	static bool	IsSafeRestartToken( TTokenType type, TIdentifierSubtype subtype, const std::string& str )
+	{
+		if( type == ENumberToken )
+			return true;
+		return type == EIdentifierToken && subtype != ENewlineOperator && str.length() > 0 && str[0] != '\r';
+	}
+	
+	
+	// Collects the tokens re-tokenized after an edit, until they match up
+	//	with the old tokens after the edit again:
+	class CRetokenizingSink : public CTokenSink
+	{
+	public:
+		CRetokenizingSink( const std::deque<CToken>& inOldTokens, size_t inFirstOldToken, size_t inEditEndOffset, size_t inOldEditEndOffset )
+			: mOldTokens(inOldTokens), mOldTokenIndex(inFirstOldToken), mEditEndOffset(inEditEndOffset), mOldEditEndOffset(inOldEditEndOffset), mLineNumDelta(0), mSynced(false) {}
 		
-		while( x < len )
+		virtual void	AddToken( TTokenType type, TIdentifierSubtype subtype, size_t offs, size_t lineN, const std::string& str, const std::string& comment, long long n = 0 )
+		{
+			if( mSynced )
+				return;
+			
+			// Same token at the same spot in the unchanged text after the edit? Everything after it will be the same, too:
+			if( offs >= mEditEndOffset && IsSafeRestartToken( type, subtype, str ) )
+			{
+				size_t	oldOffs = offs -mEditEndOffset +mOldEditEndOffset;
+				while( mOldTokenIndex < mOldTokens.size() && mOldTokens[mOldTokenIndex].mOffset < oldOffs )
+					++mOldTokenIndex;
+				if( mOldTokenIndex < mOldTokens.size() )
+				{
+					const CToken&	oldToken = mOldTokens[mOldTokenIndex];
+					if( oldToken.mOffset == oldOffs && oldToken.mType == type && oldToken.mSubType == subtype
+						&& oldToken.mNumberValue == n && oldToken.mStringValue == str && oldToken.mComment == comment )
+					{
+						mLineNumDelta = lineN -oldToken.mLineNum;	// May wrap around, but adding it to the old line numbers will wrap back.
+						mSynced = true;
+						return;
+					}
+				}
+			}
+			
+			mNewTokens.push_back( CToken( type, subtype, offs, lineN, str, comment, n ) );
+		}
+		
+		const std::deque<CToken>&	mOldTokens;
+		size_t						mOldTokenIndex;		// Once mSynced, the first old token we can keep.
+		size_t						mEditEndOffset;
+		size_t						mOldEditEndOffset;
+		size_t						mLineNumDelta;
+		bool						mSynced;
+		std::vector<CToken>			mNewTokens;
+	};
+	
+	
+	void	CTokenizer::RetokenizeAfterEdit( std::deque<CToken>& ioTokens, const char* str, size_t len, bool webPageEmbedMode, size_t editOffset, size_t removedLength, size_t insertedLength )
+	{
+		// Find the last token before the edit we can restart at, preferably the first on its line:
+		std::deque<CToken>::iterator	editItty = std::lower_bound( ioTokens.begin(), ioTokens.end(), editOffset, []( const CToken& inToken, size_t inOffset ) { return inToken.mOffset < inOffset; } );
+		size_t							restartIndex = editItty -ioTokens.begin();
+		bool							foundRestartToken = false;
+		while( restartIndex > 0 && !foundRestartToken )
+		{
+			--restartIndex;
+			const CToken&	currToken = ioTokens[restartIndex];
+			foundRestartToken = currToken.mOffset < editOffset && IsSafeRestartToken( currToken.mType, currToken.mSubType, currToken.mStringValue );
+		}
+		if( foundRestartToken )
+		{
+			for( size_t x = restartIndex; x > 0 && ioTokens[x -1].mLineNum == ioTokens[restartIndex].mLineNum; x-- )
+			{
+				const CToken&	currToken = ioTokens[x -1];
+				if( IsSafeRestartToken( currToken.mType, currToken.mSubType, currToken.mStringValue ) )
+					restartIndex = x -1;
+			}
+		}
+		else
+			restartIndex = 0;
+		
+		CRetokenizingSink	newTokens( ioTokens, restartIndex, editOffset +insertedLength, editOffset +removedLength );
+		if( foundRestartToken )
+		{
+			const CToken&		restartToken = ioTokens[restartIndex];
+			CTokenizerState		tokenizer( str, len, restartToken.mOffset, restartToken.mLineNum, restartToken.mComment );
+			while( !newTokens.mSynced && tokenizer.TokenizeMore( newTokens ) )
+				;
+		}
+		else
+		{
+			CTokenizerState		tokenizer( str, len, webPageEmbedMode );
+			while( !newTokens.mSynced && tokenizer.TokenizeMore( newTokens ) )
+				;
+		}
+		
+		// Replace the tokens that changed and shift the ones after them:
+		size_t	firstKeptIndex = newTokens.mSynced ? newTokens.mOldTokenIndex : ioTokens.size();
+		ioTokens.erase( ioTokens.begin() +restartIndex, ioTokens.begin() +firstKeptIndex );
+		ioTokens.insert( ioTokens.begin() +restartIndex, newTokens.mNewTokens.begin(), newTokens.mNewTokens.end() );
+		
+		size_t	offsetDelta = insertedLength -removedLength;	// May wrap around, see mLineNumDelta.
+		for( std::deque<CToken>::iterator currItty = ioTokens.begin() +restartIndex +newTokens.mNewTokens.size(); currItty != ioTokens.end(); currItty++ )
+		{
+			currItty->mOffset += offsetDelta;
+			currItty->mLineNum += newTokens.mLineNumDelta;
+		}
+	}
+	
+	
+	enum
+	{
+		kMinParallelTokenizerChunkSize = 128 * 1024	// Below this, starting a thread takes longer than tokenizing.
+	};
+	
+	
+	// One piece of a text split up for TokenListFromTextInParallel(). Except
+	//	for the first one, we can only guess what state the tokenizer would be
+	//	in at the start of a chunk, so its tokens may be wrong until they match
+	//	up with the tokens the tokenizer finds when it gets there:
+	class CTokenizerChunk
+	{
+	public:
+		CTokenizerChunk( const char* str, size_t len, bool webPageEmbedMode, size_t inStartOffset, size_t inEndOffset )
+			: mTokenizer( (inStartOffset == 0) ? CTokenizerState( str, len, webPageEmbedMode ) : CTokenizerState( str, len, inStartOffset, 1, std::string(), webPageEmbedMode ) ),
+			mStartOffset(inStartOffset)
+		{
+			mTokenizer.SetStopOffset( inEndOffset );
+		}
+		
+		void	Tokenize()
+		{
+			try
+			{
+				mTokenizer.TokenizeMore( mTokens, false );
+			}
+			catch( ... )
+			{
+				mError = std::current_exception();
+			}
+		}
+		
+		CTokenizerState		mTokenizer;
+		CTokenDequeSink		mTokens;
+		size_t				mStartOffset;
+		std::exception_ptr	mError;
+	};
+	
+	
+	std::deque<CToken>	CTokenizer::TokenListFromTextInParallel( const char* str, size_t len, bool webPageEmbedMode, size_t inNumChunks )
+	{
+		if( inNumChunks == 0 )
+			inNumChunks = std::min<size_t>( std::max<unsigned>( std::thread::hardware_concurrency(), 1 ), len / kMinParallelTokenizerChunkSize );
+		
+		// Split the text into chunks at line breaks:
+		std::vector<size_t>	chunkStarts( 1, 0 );
+		for( size_t x = 1; x < inNumChunks; x++ )
 		{
+			size_t		searchStart = std::max( (len / inNumChunks) * x, chunkStarts.back() );
+			const char*	lineBreak = (const char*) memchr( str +searchStart, '\n', len -searchStart );
+			if( !lineBreak || (size_t)(lineBreak -str) +1 >= len )
+				break;
+			chunkStarts.push_back( (lineBreak -str) +1 );
+		}
+		if( chunkStarts.size() < 2 )
+			return TokenListFromText( str, len, webPageEmbedMode );
+		
+		std::deque<CTokenizerChunk>	chunks;
+		for( size_t x = 0; x < chunkStarts.size(); x++ )
+			chunks.push_back( CTokenizerChunk( str, len, webPageEmbedMode, chunkStarts[x], ((x +1) < chunkStarts.size()) ? chunkStarts[x +1] : len ) );
+		
+		// Tokenize all chunks at the same time, the first one on this thread:
+		std::vector<std::thread>	workers;
+		for( size_t x = 1; x < chunks.size(); x++ )
+		{
+			CTokenizerChunk*	currChunk = &chunks[x];
+			workers.push_back( std::thread( [currChunk](){ currChunk->Tokenize(); } ) );
+		}
+		chunks[0].Tokenize();
+		for( std::thread& currWorker : workers )
+			currWorker.join();
+		for( const CTokenizerChunk& currChunk : chunks )
+		{
+			if( currChunk.mError )
+				std::rethrow_exception( currChunk.mError );
+		}
+		
+		// Now continue the first chunk's tokenizer into each following chunk
+		//	until its tokens match that chunk's, then take the rest from there:
+		std::deque<CToken>	tokens( std::move( chunks[0].mTokens.mTokens ) );
+		CTokenizerState*	tokenizer = &chunks[0].mTokenizer;
+		for( size_t x = 1; x < chunks.size(); x++ )
+		{
+			CTokenizerChunk&	currChunk = chunks[x];
+			CRetokenizingSink	fixedTokens( currChunk.mTokens.mTokens, 0, currChunk.mStartOffset, currChunk.mStartOffset );
+			tokenizer->SetStopOffset( ((x +1) < chunks.size()) ? chunks[x +1].mStartOffset : len );
+			while( !fixedTokens.mSynced && tokenizer->TokenizeMore( fixedTokens ) )
+				;
+			
+			for( CToken& currToken : fixedTokens.mNewTokens )
+				tokens.push_back( std::move( currToken ) );
+			if( fixedTokens.mSynced )
+			{
+				std::deque<CToken>&	chunkTokens = currChunk.mTokens.mTokens;
+				for( size_t y = fixedTokens.mOldTokenIndex; y < chunkTokens.size(); y++ )
+				{
+					chunkTokens[y].mLineNum += fixedTokens.mLineNumDelta;
+					tokens.push_back( std::move( chunkTokens[y] ) );
+				}
+				currChunk.mTokenizer.AddToLineNumber( fixedTokens.mLineNumDelta );
+				tokenizer = &currChunk.mTokenizer;	// From here on, this chunk's tokenizer is where the serial one would be.
+			}
+		}
+		
+		return tokens;
+	}
+	
+	
+	class CTokenCountingSink : public CTokenSink
+	{
+	public:
+		explicit CTokenCountingSink( CTokenSink& inSink ) : mSink(inSink), mNumTokensAdded(0) {}
+		
+		virtual void	AddToken( TTokenType type, TIdentifierSubtype subtype, size_t offs, size_t lineN, const std::string& str, const std::string& comment, long long n = 0 )
+		{
+			mSink.AddToken( type, subtype, offs, lineN, str, comment, n );
+			++mNumTokensAdded;
+		}
+		
+		CTokenSink&		mSink;
+		size_t			mNumTokensAdded;
+	};
+	
+	
+	CTokenizerState::CTokenizerState( const char* str, size_t len, bool webPageEmbedMode )
+		: mText(str), mLength(len), mStopOffset(len), mOffset(0), mCurrStartOffs(0),
+		mCurrType( webPageEmbedMode ? EWebPageContentToken : EInvalidToken ),	// Invalid == we're in whitespace. WebPage == keep the literal text and make it a token that turns into a print command, for PHP-style code embedded in web pages.
+		mCurrLineNum(1), mLastCROffset(SIZE_MAX), mCurrNestingDepth(0), mFinished(false)
+	{
+		
+	}
+	
+	
+	CTokenizerState::CTokenizerState( const char* str, size_t len, size_t inStartOffset, size_t inLineNum, const std::string& inCommentText, bool inWebPageContent )
+		: mText(str), mLength(len), mStopOffset(len), mOffset(inStartOffset), mCurrStartOffs(inStartOffset), mCurrType( inWebPageContent ? EWebPageContentToken : EInvalidToken ),
+		mCurrLineNum(inLineNum), mLastCROffset(SIZE_MAX), mCurrNestingDepth(0), mCollectedCommentText(inCommentText), mFinished(false)
+	{
+		
+	}
+	
+	
+	bool	CTokenizerState::TokenizeMore( CTokenSink& inTokens, bool stopAfterFirstToken )
+	{
+		if( mFinished )
+			return false;
+		
+		// Work on local copies of our state, and write them back once we're done:
+		CTokenCountingSink	outTokens( inTokens );
+		const char*			str = mText;
+		size_t				len = mLength;
+		size_t				stopOffset = std::min( mStopOffset, mLength );
+		size_t				x = mOffset,
+							currStartOffs = mCurrStartOffs;
+		TTokenType			currType = mCurrType;
+		std::string&		currText = mCurrText;
+		size_t				currLineNum = mCurrLineNum;
+		size_t				lastCROffset = mLastCROffset;
+		int					currNestingDepth = mCurrNestingDepth;	// Nesting depth for nestable quotes.
+		std::string&		collectedCommentText = mCollectedCommentText;
+		static const CTokenizerByteClasses	sByteClasses;
+		
+		while( x < stopOffset && (!stopAfterFirstToken || outTokens.mNumTokensAdded == 0) )
+		{
+			// Copy runs of ASCII characters that don't change the tokenizer state in bulk:
+			size_t			runEnd = x;
+			switch( currType )
+			{
+				case EInvalidToken:
+					runEnd = FindByteClassRunEnd( str, x, stopOffset, sByteClasses.mIsWhitespace );
+					if( runEnd > x )
+					{
+						currStartOffs = runEnd -1;
+						x = runEnd;
+						continue;
+					}
+					break;
+				case EWebPageContentToken:
+					runEnd = FindASCIIRunEnd( str, x, stopOffset, '<', '\r', '\n' );
+					break;
+				case EStringToken:
+					runEnd = FindASCIIRunEnd( str, x, stopOffset, '\"', '\r', '\n' );
+					break;
+				case ECommentPseudoToken:
+					runEnd = FindASCIIRunEnd( str, x, stopOffset, '\r', '\n', '\n' );
+					break;
+				case EMultilineCommentPseudoToken:
+					runEnd = FindASCIIRunEnd( str, x, stopOffset, '*', '\r', '\n' );
+					break;
+				case EIdentifierToken:
+					runEnd = FindByteClassRunEnd( str, x, stopOffset, sByteClasses.mContinuesIdentifier );
+					break;
+				case ENumberToken:
+					runEnd = FindByteClassRunEnd( str, x, stopOffset, sByteClasses.mIsDigit );
+					break;
+				default:
+					break;
+			}
+			if( runEnd > x )
+			{
+				currText.append( str +x, runEnd -x );
+				x = runEnd;
+				continue;
+			}
+			
 			size_t			newX = x;
 			uint32_t		currCh = UTF8StringParseUTF32CharacterAtOffset( str, len, &newX );
 			size_t			nextNewX = newX;
@@ -197,11 +892,11 @@ TIdentifierSubtype	gIdentifierSynonyms[ELastIdentifier_Sentinel +1] =
 					}
 					else if( currCh == '-' && nextCh == '-' )
 					{
-						StartCommentToken( str, len, x, ECommentPseudoToken, newX, currType, currText, collectedCommentText );
+						CTokenizer::StartCommentToken( str, len, x, ECommentPseudoToken, newX, currType, currText, collectedCommentText );
 					}
 					else if( currCh == '(' && nextCh == '*' )
 					{
-						StartCommentToken( str, len, x, EMultilineCommentPseudoToken, newX, currType, currText, collectedCommentText );
+						CTokenizer::StartCommentToken( str, len, x, EMultilineCommentPseudoToken, newX, currType, currText, collectedCommentText );
 					}
 					else
 					{
@@ -210,7 +905,7 @@ TIdentifierSubtype	gIdentifierSynonyms[ELastIdentifier_Sentinel +1] =
 						TIdentifierSubtype subtype = (currCh <= 127 && isalnum(currCh)) ? ELastIdentifier_Sentinel : CToken::IdentifierTypeFromText(opstr);	// Don't interrupt a token on a short identifier like "a".
 						if( subtype != ELastIdentifier_Sentinel )
 						{
-							tokenList.push_back( CToken( EIdentifierToken, subtype, x, currLineNum, std::string(opstr), (subtype != ENewlineOperator) ? collectedCommentText : "" ) );
+							outTokens.AddToken( EIdentifierToken, subtype, x, currLineNum, std::string(opstr), (subtype != ENewlineOperator) ? collectedCommentText : "" );
 							
 							if( subtype != ENewlineOperator )
 								collectedCommentText.erase();
@@ -243,7 +938,7 @@ TIdentifierSubtype	gIdentifierSynonyms[ELastIdentifier_Sentinel +1] =
 								{
 									if( currText.length() > 0 )
 									{
-										tokenList.push_back( CToken( EWebPageContentToken, ELastIdentifier_Sentinel, currStartOffs, currLineNum, currText, "" ) );
+										outTokens.AddToken( EWebPageContentToken, ELastIdentifier_Sentinel, currStartOffs, currLineNum, currText, "" );
 									}
 
 									newX = nextNewX;
@@ -268,7 +963,7 @@ TIdentifierSubtype	gIdentifierSynonyms[ELastIdentifier_Sentinel +1] =
 				case ECommentPseudoToken:
 					if( currCh == '\n' || currCh == '\r' )
 					{
-						tokenList.push_back( CToken( EIdentifierToken, ENewlineOperator, x, currLineNum, std::string("\n"), "" ) );
+						outTokens.AddToken( EIdentifierToken, ENewlineOperator, x, currLineNum, std::string("\n"), "" );
 						currText.append("\n");
 						collectedCommentText.append(currText);
 						currText.clear();
@@ -303,7 +998,7 @@ TIdentifierSubtype	gIdentifierSynonyms[ELastIdentifier_Sentinel +1] =
 					{
 						char*		endPtr = NULL;
 						long long	num = strtoll( currText.c_str(), &endPtr, 10 );
-						tokenList.push_back( CToken( ENumberToken, ELastIdentifier_Sentinel, currStartOffs, currLineNum, currText, collectedCommentText, num ) );
+						outTokens.AddToken( ENumberToken, ELastIdentifier_Sentinel, currStartOffs, currLineNum, currText, collectedCommentText, num );
 						collectedCommentText.erase();
 						currText.clear();
 						currType = EInvalidToken;
@@ -316,11 +1011,11 @@ TIdentifierSubtype	gIdentifierSynonyms[ELastIdentifier_Sentinel +1] =
 						}
 						else if( currCh == '-' && nextCh == '-' )
 						{
-							StartCommentToken( str, len, x, ECommentPseudoToken, newX, currType, currText, collectedCommentText );
+							CTokenizer::StartCommentToken( str, len, x, ECommentPseudoToken, newX, currType, currText, collectedCommentText );
 						}
 						else if( currCh == '(' && nextCh == '*' )
 						{
-							StartCommentToken( str, len, x, EMultilineCommentPseudoToken, newX, currType, currText, collectedCommentText );
+							CTokenizer::StartCommentToken( str, len, x, EMultilineCommentPseudoToken, newX, currType, currText, collectedCommentText );
 						}
 						else if( currCh == '?' && nextCh == '>' )
 						{
@@ -366,7 +1061,7 @@ TIdentifierSubtype	gIdentifierSynonyms[ELastIdentifier_Sentinel +1] =
 							TIdentifierSubtype subtype = (currCh <= 127 && isalnum(currCh)) ? ELastIdentifier_Sentinel : CToken::IdentifierTypeFromText(opstr);	// Don't interrupt a token on a short identifier like "a".
 							if( subtype != ELastIdentifier_Sentinel )
 							{
-								tokenList.push_back( CToken( EIdentifierToken, subtype, x, currLineNum, std::string(opstr), collectedCommentText ) );
+								outTokens.AddToken( EIdentifierToken, subtype, x, currLineNum, std::string(opstr), collectedCommentText );
 								collectedCommentText.erase();
 								currText.clear();
 								currType = EInvalidToken;
@@ -391,17 +1086,17 @@ TIdentifierSubtype	gIdentifierSynonyms[ELastIdentifier_Sentinel +1] =
 					endThisToken = endThisToken || (subtype != ELastIdentifier_Sentinel) || (currCh == '-' && nextCh == '-') || (currCh == '(' && nextCh == '*') || (currCh == '?' && nextCh == '>') || currCh == 0x00AC;
 					if( endThisToken )
 					{
-						tokenList.push_back( CToken( EIdentifierToken, CToken::IdentifierTypeFromText( ToLowerString( currText ).c_str() ), currStartOffs, currLineNum, currText, collectedCommentText ) );
+						outTokens.AddToken( EIdentifierToken, CToken::IdentifierTypeFromOriginalText( currText ), currStartOffs, currLineNum, currText, collectedCommentText );
 						collectedCommentText.erase();
 						currType = EInvalidToken;
 						
 						if( currCh == '-' && nextCh == '-' )	// Comment!
 						{
-							StartCommentToken( str, len, x, ECommentPseudoToken, newX, currType, currText, collectedCommentText );
+							CTokenizer::StartCommentToken( str, len, x, ECommentPseudoToken, newX, currType, currText, collectedCommentText );
 						}
 						else if( currCh == '(' && nextCh == '*' )
 						{
-							StartCommentToken( str, len, x, EMultilineCommentPseudoToken, newX, currType, currText, collectedCommentText );
+							CTokenizer::StartCommentToken( str, len, x, EMultilineCommentPseudoToken, newX, currType, currText, collectedCommentText );
 						}
 						else if( currCh == '?' && nextCh == '>' )	// Back to webpage content.
 						{
@@ -431,7 +1126,7 @@ TIdentifierSubtype	gIdentifierSynonyms[ELastIdentifier_Sentinel +1] =
 							++currLineNum;
 						}
 						else if( subtype != ELastIdentifier_Sentinel )
-							tokenList.push_back( CToken( EIdentifierToken, subtype, x, currLineNum, std::string(opstr), collectedCommentText ) );
+							outTokens.AddToken( EIdentifierToken, subtype, x, currLineNum, std::string(opstr), collectedCommentText );
 						
 						currText.clear();
 						currStartOffs = x;
@@ -444,7 +1139,7 @@ TIdentifierSubtype	gIdentifierSynonyms[ELastIdentifier_Sentinel +1] =
 				case EStringToken:
 					if( currCh == '\"' )
 					{
-						tokenList.push_back( CToken( EStringToken, ELastIdentifier_Sentinel, currStartOffs, currLineNum, currText, collectedCommentText ) );
+						outTokens.AddToken( EStringToken, ELastIdentifier_Sentinel, currStartOffs, currLineNum, currText, collectedCommentText );
 						currText.clear();
 						currStartOffs = x;
 						currType = EInvalidToken;
@@ -468,7 +1163,7 @@ TIdentifierSubtype	gIdentifierSynonyms[ELastIdentifier_Sentinel +1] =
 						}
 						else	// Final closing quote? End string.
 						{
-							tokenList.push_back( CToken( EStringToken, ELastIdentifier_Sentinel, currStartOffs, currLineNum, currText, collectedCommentText ) );
+							outTokens.AddToken( EStringToken, ELastIdentifier_Sentinel, currStartOffs, currLineNum, currText, collectedCommentText );
 							currText.clear();
 							currStartOffs = x;
 							currType = EInvalidToken;
@@ -493,7 +1188,7 @@ TIdentifierSubtype	gIdentifierSynonyms[ELastIdentifier_Sentinel +1] =
 						}
 						else	// Final closing quote? End string.
 						{
-							tokenList.push_back( CToken( EStringToken, ELastIdentifier_Sentinel, currStartOffs, currLineNum, currText, collectedCommentText ) );
+							outTokens.AddToken( EStringToken, ELastIdentifier_Sentinel, currStartOffs, currLineNum, currText, collectedCommentText );
 							currText.clear();
 							currStartOffs = x;
 							currType = EInvalidToken;
@@ -521,29 +1216,40 @@ TIdentifierSubtype	gIdentifierSynonyms[ELastIdentifier_Sentinel +1] =
 			x = newX;
 		}
 		
-		if( currType != EInvalidToken )	// We have an unfinished token waiting to be ended!
+		if( x >= len )
 		{
-			long	num = 0;
-			char*	endPtr = NULL;
-			if( currType == ENumberToken )
-				num = strtol( currText.c_str(), &endPtr, 10 );
-			tokenList.push_back( CToken( currType, CToken::IdentifierTypeFromText( ToLowerString( currText ).c_str() ), currStartOffs, currLineNum, currText, collectedCommentText, num ) );
-			collectedCommentText.erase();
+			if( currType != EInvalidToken )	// We have an unfinished token waiting to be ended!
+			{
+				long	num = 0;
+				char*	endPtr = NULL;
+				if( currType == ENumberToken )
+					num = strtol( currText.c_str(), &endPtr, 10 );
+				outTokens.AddToken( currType, CToken::IdentifierTypeFromOriginalText( currText ), currStartOffs, currLineNum, currText, collectedCommentText, num );
+				collectedCommentText.erase();
+			}
+			mFinished = true;
 		}
 		
-		return tokenList;
+		mOffset = x;
+		mCurrStartOffs = currStartOffs;
+		mCurrType = currType;
+		mCurrLineNum = currLineNum;
+		mLastCROffset = lastCROffset;
+		mCurrNestingDepth = currNestingDepth;
+		
+		return outTokens.mNumTokensAdded > 0;
 	}
 
-	/*static*/ bool		CTokenizer::NextTokensAreIdentifiers( const char* fname, std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens, int /*TIdentifierSubtype*/ inFirstType, ... )
+	/*static*/ bool		CTokenizer::NextTokensAreIdentifiers( const char* fname, CTokenIterator& tokenItty, CTokenCursor& tokens, int /*TIdentifierSubtype*/ inFirstType, ... )
 	{
 		if( tokenItty == tokens.end() )
 		{
 			return false;
 		}
 
-		std::deque<CToken>::iterator	originalTokenItty = tokenItty;
-		bool							fullMatch = true;
-		va_list							ap;
+		CTokenIterator	originalTokenItty = tokenItty;
+		bool			fullMatch = true;
+		va_list			ap;
 		
 		va_start( ap, inFirstType );
 			TIdentifierSubtype currType = (TIdentifierSubtype)inFirstType;
@@ -633,7 +1339,7 @@ TIdentifierSubtype	gIdentifierSynonyms[ELastIdentifier_Sentinel +1] =
 	
 	bool	CToken::IsIdentifier( TIdentifierSubtype subType ) const
 	{
-		return( mType == EIdentifierToken && gIdentifierSynonyms[mSubType] == subType );
+		return( mAtom < kNoIdentifierAtom && gIdentifierSynonyms[mAtom] == subType );
 	}
 	
 	TIdentifierSubtype	CToken::GetIdentifierSubType() const
@@ -644,15 +1350,12 @@ TIdentifierSubtype	gIdentifierSynonyms[ELastIdentifier_Sentinel +1] =
 		return gIdentifierSynonyms[mSubType];
 	}
 	
-	const std::string	CToken::GetIdentifierText() const
+	const std::string&	CToken::GetIdentifierText() const
 	{
 		if( mType != EIdentifierToken )
 			throw CForgeParseError( "Expected identifier here.", mLineNum, mOffset );
 		
-		if( mSubType == ELastIdentifier_Sentinel )
-			return ToLowerString(mStringValue);
-		else
-			return std::string(gIdentifierStrings[mSubType]);
+		return TextFromAtom( mAtom );
 	}
 	
 	const std::string	CToken::GetOriginalIdentifierText() const
@@ -681,12 +1384,10 @@ TIdentifierSubtype	gIdentifierSynonyms[ELastIdentifier_Sentinel +1] =
 		
 		if( mType == EStringToken )
 		{
-			std::string	myStr( ToLowerString(mStringValue) );
-			std::string	otherStr( ToLowerString(other.mStringValue) );
-			same = same && ( otherStr.compare(myStr) == 0 );
+			same = same && ( CompareLowercased( other.mStringValue, mStringValue ) == 0 );
 		}
 		else if( mType == EIdentifierToken && mSubType == ELastIdentifier_Sentinel )
-			same = same && ( other.mStringValue.compare(mStringValue) == 0 );
+			same = same && ( other.mAtom == mAtom );
 		else if( mType == ENumberToken )
 			same = same && ( mNumberValue == other.mNumberValue );
 		
@@ -707,12 +1408,10 @@ TIdentifierSubtype	gIdentifierSynonyms[ELastIdentifier_Sentinel +1] =
 		
 		if( mType == EStringToken )
 		{
-			std::string	myStr( ToLowerString(mStringValue) );
-			std::string	otherStr( ToLowerString(other.mStringValue) );
-			same = same && ( otherStr.compare(myStr) == 1 );
+			same = same && ( CompareLowercased( other.mStringValue, mStringValue ) == 1 );
 		}
 		else if( mType == EIdentifierToken && mSubType == ELastIdentifier_Sentinel )
-			same = same && ( other.mStringValue.compare(mStringValue) == 1 );
+			same = same && ( other.mAtom < mAtom );
 		else if( mType == ENumberToken )
 			same = same && ( mNumberValue > other.mNumberValue );
 		
@@ -728,12 +1427,10 @@ TIdentifierSubtype	gIdentifierSynonyms[ELastIdentifier_Sentinel +1] =
 		
 		if( mType == EStringToken )
 		{
-			std::string	myStr( ToLowerString(mStringValue) );
-			std::string	otherStr( ToLowerString(other.mStringValue) );
-			same = same && ( otherStr.compare(myStr) == -1 );
+			same = same && ( CompareLowercased( other.mStringValue, mStringValue ) == -1 );
 		}
 		else if( mType == EIdentifierToken && mSubType == ELastIdentifier_Sentinel )
-			same = same && ( other.mStringValue.compare(mStringValue) == -1 );
+			same = same && ( other.mAtom > mAtom );
 		else if( mType == ENumberToken )
 			same = same && ( mNumberValue < other.mNumberValue );
 		
@@ -749,12 +1446,10 @@ TIdentifierSubtype	gIdentifierSynonyms[ELastIdentifier_Sentinel +1] =
 		
 		if( mType == EStringToken )
 		{
-			std::string	myStr( ToLowerString(mStringValue) );
-			std::string	otherStr( ToLowerString(other.mStringValue) );
-			same = same && ( otherStr.compare(myStr) >= 0 );
+			same = same && ( CompareLowercased( other.mStringValue, mStringValue ) >= 0 );
 		}
 		else if( mType == EIdentifierToken && mSubType == ELastIdentifier_Sentinel )
-			same = same && ( other.mStringValue.compare(mStringValue) >= 0 );
+			same = same && ( other.mAtom <= mAtom );
 		else if( mType == ENumberToken )
 			same = same && ( mNumberValue >= other.mNumberValue );
 		
@@ -770,12 +1465,10 @@ TIdentifierSubtype	gIdentifierSynonyms[ELastIdentifier_Sentinel +1] =
 		
 		if( mType == EStringToken )
 		{
-			std::string	myStr( ToLowerString(mStringValue) );
-			std::string	otherStr( ToLowerString(other.mStringValue) );
-			same = same && ( otherStr.compare(myStr) <= 0 );
+			same = same && ( CompareLowercased( other.mStringValue, mStringValue ) <= 0 );
 		}
 		else if( mType == EIdentifierToken && mSubType == ELastIdentifier_Sentinel )
-			same = same && ( other.mStringValue.compare(mStringValue) <= 0 );
+			same = same && ( other.mAtom >= mAtom );
 		else if( mType == ENumberToken )
 			same = same && ( mNumberValue <= other.mNumberValue );
 		
@@ -783,14 +1476,10 @@ TIdentifierSubtype	gIdentifierSynonyms[ELastIdentifier_Sentinel +1] =
 	}
 
 
-	void	CTokenizer::GoNextToken( const char* fname, std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens )
+	void	CTokenizer::GoNextToken( const char* fname, CTokenIterator& tokenItty, CTokenCursor& tokens )
 	{
 		if( tokenItty == tokens.end() )
-		{
-			std::stringstream	errMsg;
-			errMsg << fname << ":" << tokenItty->mLineNum << ": error: Premature end of file.";
-			throw CForgeParseError( errMsg.str(), tokenItty->mLineNum, tokenItty->mOffset );
-		}
+			tokens.ThrowError( fname, CTokenIterator::kEndIndex, "Premature end of file." );
 		else
 			tokenItty++;
 		
@@ -803,14 +1492,10 @@ TIdentifierSubtype	gIdentifierSynonyms[ELastIdentifier_Sentinel +1] =
 	}
 	
 	
-	void	CTokenizer::GoPreviousToken( const char* fname, std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens )
+	void	CTokenizer::GoPreviousToken( const char* fname, CTokenIterator& tokenItty, CTokenCursor& tokens )
 	{
 		if( tokenItty == tokens.begin() )
-		{
-			std::stringstream	errMsg;
-			errMsg << fname << ":" << tokenItty->mLineNum << ": error: Parser backtracking beyond start of file.";
-			throw CForgeParseError( errMsg.str(), tokenItty->mLineNum, tokenItty->mOffset );
-		}
+			tokens.ThrowError( fname, tokenItty.GetIndex(), "Parser backtracking beyond start of file." );
 		else
 			tokenItty--;
 		
@@ -819,7 +1504,7 @@ TIdentifierSubtype	gIdentifierSynonyms[ELastIdentifier_Sentinel +1] =
 		#endif
 	}
 
-	void	CToken::ExpectIdentifier( const std::string& inFileName, TIdentifierSubtype subType, TIdentifierSubtype precedingIdent )
+	void	CToken::ExpectIdentifier( const std::string& inFileName, TIdentifierSubtype subType, TIdentifierSubtype precedingIdent ) const
 	{
 		if( !IsIdentifier( subType ) )
 		{
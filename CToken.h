@@ -14,6 +14,7 @@ extern "C" {
 }
 #include <deque>
 #include <string>
+#include <stdint.h>
 
 
 namespace Carlson
@@ -36,6 +37,19 @@ namespace Carlson
 		ELastToken_Sentinel
 	} TTokenType;
 
+	class CTokenIterator;
+	class CTokenCursor;
+	
+	// Identifiers are interned as atoms, so they can be compared without looking at their text.
+	//	A keyword's atom is its TIdentifierSubtype, any other identifier gets a number past
+	//	ELastIdentifier_Sentinel for its lowercased text that stays the same for the whole run:
+	typedef uint32_t	TIdentifierAtom;
+	
+	enum
+	{
+		kNoIdentifierAtom = ELastIdentifier_Sentinel	// Strings, numbers etc. aren't identifiers.
+	};
+	
 	// These two need to be kept in sync with constants above:
 	extern const char*		gTokenTypeStrings[ELastToken_Sentinel];
 	extern const char*		gIdentifierStrings[ELastIdentifier_Sentinel];
@@ -48,6 +62,9 @@ namespace Carlson
 	
 	public:
 		static TIdentifierSubtype	IdentifierTypeFromText( const char* str );
+		static TIdentifierSubtype	IdentifierTypeFromOriginalText( const std::string& str );	// Like IdentifierTypeFromText(), but str doesn't have to be lowercased yet.
+		static TIdentifierAtom		AtomFromOriginalText( const std::string& str );		// Atom for a non-keyword identifier. Creates it if needed. str doesn't have to be lowercased.
+		static const std::string&	TextFromAtom( TIdentifierAtom inAtom );				// Lowercased text, like GetIdentifierText(). Safe to call from any thread.
 	
 	// Instance:
 	public:
@@ -58,6 +75,7 @@ namespace Carlson
 		std::string				mStringValue;	// String representation of this token.
 		long long				mNumberValue;	// Number representation of this token.
 		std::string				mComment;		// Comment that preceded this token (i.e. docs).
+		TIdentifierAtom			mAtom;			// Lowercased identifier text as an atom. kNoIdentifierAtom if this isn't an identifier.
 		
 	public:
 		CToken( TTokenType type, TIdentifierSubtype subtype, size_t offs, size_t lineN, const std::string& str, const std::string& comment, long long n = 0 )
@@ -69,15 +87,23 @@ namespace Carlson
 			mNumberValue = n;
 			mLineNum = lineN;
 			mComment = comment;
+			mAtom = kNoIdentifierAtom;
+			if( type == EIdentifierToken )
+				mAtom = (subtype == ELastIdentifier_Sentinel) ? AtomFromOriginalText( str ) : (TIdentifierAtom) subtype;
+		}
+		CToken( TTokenType type, TIdentifierSubtype subtype, TIdentifierAtom atom, size_t offs, size_t lineN, const std::string& str, const std::string& comment, long long n )	// For token lists that already know the atom.
+			: mType(type), mSubType(subtype), mOffset(offs), mLineNum(lineN), mStringValue(str), mNumberValue(n), mComment(comment), mAtom(atom)
+		{
 		}
 		
-		void			ExpectIdentifier( const std::string& inFileName, TIdentifierSubtype subType, TIdentifierSubtype precedingIdent = ELastIdentifier_Sentinel );
+		void			ExpectIdentifier( const std::string& inFileName, TIdentifierSubtype subType, TIdentifierSubtype precedingIdent = ELastIdentifier_Sentinel ) const;
 		
 		std::string		GetDescription() const;			// All attributes of this token.
 		std::string		GetShortDescription() const;	// The token, pretty much in the form the user would see it.
 
 		// Operator overloads for use with std::map:
 		//	ignores offset during comparisons, case-insensitively compares strings.
+		//	Identifiers are compared by atom, so they sort in the order they were first seen, not alphabetically.
 		bool	operator==( const CToken& other );
 		bool	operator!=( const CToken& other );
 		bool	operator>( const CToken& other );
@@ -86,7 +112,8 @@ namespace Carlson
 		bool	operator<=( const CToken& other );
 		
 		bool				IsIdentifier( TIdentifierSubtype subType ) const;
-		const std::string	GetIdentifierText() const;			// Lowercased and otherwise normalised for easier compares.
+		const std::string&	GetIdentifierText() const;			// Lowercased and otherwise normalised for easier compares.
+		TIdentifierAtom		GetIdentifierAtom() const			{ return mAtom; }	// Same for all identifiers with the same GetIdentifierText().
 		TIdentifierSubtype	GetIdentifierSubType() const;		// Like mSubType, but throws if this isn't an identifier.
 		const std::string	GetOriginalIdentifierText() const;	// Original string as entered by user.
 		const std::string	GetOriginalWebPageContentText() const;	// Original string as entered by user.
@@ -94,15 +121,58 @@ namespace Carlson
 		const std::string	GetComment() const { return mComment; }
 	};
 	
+	// Receives each token as the tokenizer finds it, so it can be stored in
+	//	whatever form the caller needs (e.g. into a std::deque<CToken>, or a CStreamingTokenCursor's window):
+	class CTokenSink
+	{
+	public:
+		virtual ~CTokenSink() {};
+		
+		virtual void	AddToken( TTokenType type, TIdentifierSubtype subtype, size_t offs, size_t lineN, const std::string& str, const std::string& comment, long long n = 0 ) = 0;
+	};
+	
+	// The tokenizer's state while it is working its way through a text, so it
+	//	can hand out tokens bit by bit (e.g. to CStreamingTokenCursor) instead of
+	//	tokenizing the whole text in one go. The text must outlive this object.
+	class CTokenizerState
+	{
+	public:
+		CTokenizerState( const char* str, size_t len, bool webPageEmbedMode = false );
+		CTokenizerState( const char* str, size_t len, size_t inStartOffset, size_t inLineNum, const std::string& inCommentText, bool inWebPageContent = false );	// Start in the middle of a script's code (or web page content), at the start of a token.
+		
+		bool	TokenizeMore( CTokenSink& outTokens, bool stopAfterFirstToken = true );	// Returns FALSE if there were no more tokens to add.
+		bool	IsFinished() const	{ return mFinished; }
+		
+		void	SetStopOffset( size_t inOffset )			{ mStopOffset = inOffset; }	// TokenizeMore() stops here (without ending the current token) until you move this further.
+		void	AddToLineNumber( size_t inLineNumDelta )	{ mCurrLineNum += inLineNumDelta; }
+		
+	protected:
+		const char*		mText;
+		size_t			mLength;
+		size_t			mStopOffset;
+		size_t			mOffset;
+		size_t			mCurrStartOffs;
+		TTokenType		mCurrType;
+		std::string		mCurrText;
+		size_t			mCurrLineNum;
+		size_t			mLastCROffset;
+		int				mCurrNestingDepth;
+		std::string		mCollectedCommentText;
+		bool			mFinished;
+	};
+	
 	class CTokenizer
 	{
 	public:
 		static std::deque<CToken>	TokenListFromText( const char* str, size_t len, bool webPageEmbedMode = false );
-		static bool					NextTokensAreIdentifiers( const char* fname, std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens, int /*TIdentifierSubtype*/ inFirstType, ... );
+		static void					TokenizeText( const char* str, size_t len, bool webPageEmbedMode, CTokenSink& outTokens );
+		static std::deque<CToken>	TokenListFromTextInParallel( const char* str, size_t len, bool webPageEmbedMode = false, size_t inNumChunks = 0 );	// Same tokens as TokenListFromText(). inNumChunks = 0 picks a number based on CPU count and text length.
+		static void					RetokenizeAfterEdit( std::deque<CToken>& ioTokens, const char* str, size_t len, bool webPageEmbedMode, size_t editOffset, size_t removedLength, size_t insertedLength );	// str/len are the text after the edit, ioTokens the tokens for the text before it.
+		static bool					NextTokensAreIdentifiers( const char* fname, CTokenIterator& tokenItty, CTokenCursor& tokens, int /*TIdentifierSubtype*/ inFirstType, ... );
 		static void					StartCommentToken( const char* str, size_t len, size_t x, TTokenType newType, size_t &newX, TTokenType& currType, std::string& currText, std::string& collectedCommentText );
 
-		static void	GoNextToken( const char* fname, std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens );
-		static void	GoPreviousToken( const char* fname, std::deque<CToken>::iterator& tokenItty, std::deque<CToken>& tokens );
+		static void	GoNextToken( const char* fname, CTokenIterator& tokenItty, CTokenCursor& tokens );
+		static void	GoPreviousToken( const char* fname, CTokenIterator& tokenItty, CTokenCursor& tokens );
 	};
 
 	std::string	ToLowerString( const std::string& str );
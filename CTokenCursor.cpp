@@ -0,0 +1,128 @@
+//
+//  CTokenCursor.cpp
+//  Forge
+//
+//  Created on 2026-10-17.
+//
+//
+
+#include "CTokenCursor.h"
+#include "CForgeExceptions.h"
+#include <sstream>
+#include <algorithm>
+
+
+namespace Carlson
+{
+
+#pragma mark CTokenCursor
+
+void	CTokenCursor::ThrowError( const char* fname, size_t inIndex, const char* inMessage )
+{
+	const CToken*		errToken = (inIndex == CTokenIterator::kEndIndex) ? NULL : GetTokenAtIndex( inIndex );
+	if( !errToken )
+		errToken = GetLastToken();
+	size_t				lineNum = errToken ? errToken->mLineNum : 1;
+	size_t				offset = errToken ? errToken->mOffset : 0;
+	std::stringstream	errMsg;
+	if( fname )
+		errMsg << fname << ":" << lineNum << ": error: ";
+	errMsg << inMessage;
+	throw CForgeParseError( errMsg.str(), lineNum, offset );
+}
+
+
+#pragma mark - CStreamingTokenCursor
+
+CStreamingTokenCursor::CStreamingTokenCursor( const char* str, size_t len, bool webPageEmbedMode, size_t inWindowSize )
+	: CTokenCursor( &mWindow ), mTokenizer( str, len, webPageEmbedMode ), mWindowSize( std::max<size_t>( inWindowSize, 4 ) )
+{
+
+}
+
+
+void	CStreamingTokenCursor::AddToken( TTokenType type, TIdentifierSubtype subtype, size_t offs, size_t lineN, const std::string& str, const std::string& comment, long long n )
+{
+	mWindow.push_back( CToken( type, subtype, offs, lineN, str, comment, n ) );
+	if( mWindow.size() > mWindowSize )	// Window full? Forget the oldest token:
+	{
+		mWindow.pop_front();
+		++mFirstIndex;
+	}
+}
+
+
+const CToken*	CStreamingTokenCursor::LoadTokenAtIndex( size_t inIndex )
+{
+	while( inIndex >= (mFirstIndex +mWindow.size()) )
+	{
+		if( !mTokenizer.TokenizeMore( *this ) )
+			return NULL;
+	}
+
+	if( inIndex < mFirstIndex )
+	{
+		std::stringstream	errMsg;
+		errMsg << "Parser backtracking beyond the last " << mWindowSize << " tokens.";
+		ThrowError( NULL, mFirstIndex, errMsg.str().c_str() );
+	}
+
+	return &mWindow[ inIndex -mFirstIndex ];
+}
+
+
+size_t	CStreamingTokenCursor::GetNumTokens()
+{
+	while( mTokenizer.TokenizeMore( *this, false ) )
+		;
+
+	return CTokenCursor::GetNumTokens();
+}
+
+
+#pragma mark - CCompactTokenCursor
+
+CCompactTokenCursor::CCompactTokenCursor( const CCompactTokenList& inTokens, size_t inWindowSize )
+	: CTokenCursor( &mWindow ), mList( inTokens ), mWindowSize( std::max<size_t>( inWindowSize, 4 ) )
+{
+
+}
+
+
+const CToken*	CCompactTokenCursor::LoadTokenAtIndex( size_t inIndex )
+{
+	if( inIndex >= mList.size() )
+		return NULL;
+
+	if( mWindow.empty() )
+		mFirstIndex = inIndex;
+
+	if( inIndex < mFirstIndex )	// Backing up? Make the tokens before the window, but keep the ones after it, the parser may still be looking at them:
+	{
+		while( inIndex < mFirstIndex )
+			mWindow.push_front( mList.MakeToken( --mFirstIndex ) );
+	}
+	else
+	{
+		while( inIndex >= (mFirstIndex +mWindow.size()) )
+			mWindow.push_back( mList.MakeToken( mFirstIndex +mWindow.size() ) );
+		while( mWindow.size() > mWindowSize )	// Window full? Forget the oldest tokens:
+		{
+			mWindow.pop_front();
+			++mFirstIndex;
+		}
+	}
+
+	return &mWindow[ inIndex -mFirstIndex ];
+}
+
+
+const CToken*	CCompactTokenCursor::GetLastToken()
+{
+	if( !mLastToken && mList.size() > 0 )
+		mLastToken.reset( new CToken( mList.MakeToken( mList.size() -1 ) ) );
+
+	return mLastToken.get();
+}
+
+} // namespace Carlson
@@ -0,0 +1,206 @@
+//
+//  CTokenCursor.h
+//  Forge
+//
+//  Created on 2026-10-17.
+//
+//
+
+#pragma once
+
+/*
+	A CTokenCursor is where the parser gets a script's tokens from. The parser
+	walks them using CTokenIterators, which work like the
+	std::deque<CToken>::iterator it used to take, and can back up to any
+	token the cursor still has.
+
+	CDequeTokenCursor hands out the tokens of an already tokenized
+	std::deque<CToken>, so it can go back as far as it likes, and several
+	threads can read it at once. CStreamingTokenCursor tokenizes lazily as the
+	parser advances and only keeps a window of tokens around, so tokenizing
+	and parsing overlap and memory use doesn't grow with the length of the
+	script. Since tokens that fell out of the window are gone, the parser can
+	only back up to the oldest token still in it.
+
+	CCompactTokenCursor reads a CCompactTokenList, which keeps all tokens of a
+	script in a fraction of the memory of a std::deque<CToken>. It only keeps
+	CTokens for a window of tokens around the parser's position, but can make
+	them again from the list when the parser backs up further.
+*/
+
+#include "CToken.h"
+#include "CCompactTokenList.h"
+#include <deque>
+#include <memory>
+
+
+namespace Carlson
+{
+
+class CTokenCursor;
+
+
+class CTokenIterator
+{
+public:
+	enum { kEndIndex = SIZE_MAX };	// Index of end(), which we only know once the tokenizer is finished.
+
+	CTokenIterator() : mCursor(NULL), mIndex(kEndIndex) {};
+	CTokenIterator( CTokenCursor* inCursor, size_t inIndex ) : mCursor(inCursor), mIndex(inIndex) {};
+
+	const CToken&		operator*() const		{ return GetToken(); }
+	const CToken*		operator->() const		{ return &GetToken(); }
+
+	CTokenIterator&		operator++()			{ if( mIndex != kEndIndex ) ++mIndex; return *this; }
+	CTokenIterator		operator++( int )		{ CTokenIterator oldPos( *this ); ++(*this); return oldPos; }
+	CTokenIterator&		operator--()			{ mIndex = GetIndex() -1; return *this; }
+	CTokenIterator		operator--( int )		{ CTokenIterator oldPos( *this ); mIndex = GetIndex() -1; return oldPos; }
+	CTokenIterator&		operator+=( size_t n )	{ mIndex = GetIndex() +n; return *this; }
+	CTokenIterator&		operator-=( size_t n )	{ mIndex = GetIndex() -n; return *this; }
+	CTokenIterator		operator+( size_t n ) const	{ return CTokenIterator( mCursor, GetIndex() +n ); }
+	CTokenIterator		operator-( size_t n ) const	{ return CTokenIterator( mCursor, GetIndex() -n ); }
+
+	bool	operator==( const CTokenIterator& inOther ) const;	// Any position past the last token equals end().
+	bool	operator!=( const CTokenIterator& inOther ) const	{ return !(*this == inOther); }
+	bool	operator<( const CTokenIterator& inOther ) const;
+	bool	operator>( const CTokenIterator& inOther ) const	{ return inOther < *this; }
+	bool	operator<=( const CTokenIterator& inOther ) const	{ return !(inOther < *this); }
+	bool	operator>=( const CTokenIterator& inOther ) const	{ return !(*this < inOther); }
+
+	bool				IsAtEnd() const;
+	size_t				GetIndex() const;	// Tokenizes the whole script if this is end().
+
+protected:
+	const CToken&		GetToken() const;	// Throws if IsAtEnd().
+
+	CTokenCursor*	mCursor;
+	size_t			mIndex;
+};
+
+
+class CTokenCursor
+{
+public:
+	virtual ~CTokenCursor() {};
+
+	const CToken*			GetTokenAtIndex( size_t inIndex )	// NULL if the script has fewer tokens. Throws if we already dropped that token.
+	{
+		if( inIndex >= mFirstIndex && (inIndex -mFirstIndex) < mTokens->size() )
+			return &(*mTokens)[ inIndex -mFirstIndex ];
+		return LoadTokenAtIndex( inIndex );
+	}
+	virtual const CToken*	GetLastToken()		{ return mTokens->empty() ? NULL : &mTokens->back(); }	// Last token tokenized so far, or NULL. Used for line numbers in errors at the end of the file.
+	virtual size_t			GetNumTokens()		{ return mFirstIndex +mTokens->size(); }	// Tokenizes the rest of the script if needed.
+	virtual bool			HasAllTokens()		{ return false; }	// TRUE if all tokens are in memory and never change, so several threads may read them at once.
+
+	CTokenIterator			begin()				{ return CTokenIterator( this, 0 ); }
+	CTokenIterator			end()				{ return CTokenIterator( this, CTokenIterator::kEndIndex ); }
+
+	[[noreturn]] void		ThrowError( const char* fname, size_t inIndex, const char* inMessage );	// inIndex is the token to report the error at.
+
+protected:
+	CTokenCursor( std::deque<CToken>* inTokens ) : mTokens(inTokens), mFirstIndex(0) {};
+
+	virtual const CToken*	LoadTokenAtIndex( size_t )	{ return NULL; }	// Called by GetTokenAtIndex() for tokens not in mTokens.
+
+	std::deque<CToken>*		mTokens;		// Tokens mFirstIndex to mFirstIndex +mTokens->size() -1.
+	size_t					mFirstIndex;	// Index of the oldest token still in mTokens.
+};
+
+
+// The parser does this for every token it looks at, so let the compiler inline it:
+
+inline bool	CTokenIterator::IsAtEnd() const
+{
+	return mIndex == kEndIndex || mCursor->GetTokenAtIndex( mIndex ) == NULL;
+}
+
+
+inline size_t	CTokenIterator::GetIndex() const
+{
+	return (mIndex == kEndIndex) ? mCursor->GetNumTokens() : mIndex;
+}
+
+
+inline const CToken&	CTokenIterator::GetToken() const
+{
+	const CToken*	theToken = (mIndex == kEndIndex) ? NULL : mCursor->GetTokenAtIndex( mIndex );
+	if( !theToken )
+		mCursor->ThrowError( NULL, mIndex, "Premature end of file." );
+
+	return *theToken;
+}
+
+
+inline bool	CTokenIterator::operator==( const CTokenIterator& inOther ) const
+{
+	if( mIndex == kEndIndex )
+		return inOther.IsAtEnd();
+	else if( inOther.mIndex == kEndIndex )
+		return IsAtEnd();
+
+	return mIndex == inOther.mIndex;
+}
+
+
+inline bool	CTokenIterator::operator<( const CTokenIterator& inOther ) const
+{
+	if( mIndex == kEndIndex )
+		return false;
+	else if( inOther.mIndex == kEndIndex )	// Don't make a streaming cursor tokenize everything just to find out where the end is:
+		return !IsAtEnd();
+
+	return mIndex < inOther.mIndex;
+}
+
+
+class CDequeTokenCursor : public CTokenCursor
+{
+public:
+	explicit CDequeTokenCursor( std::deque<CToken>& inTokens ) : CTokenCursor( &inTokens ) {};
+
+	virtual bool			HasAllTokens()		{ return true; }
+};
+
+
+class CStreamingTokenCursor : public CTokenCursor, protected CTokenSink
+{
+public:
+	enum { kDefaultWindowSize = 256 };	// Far more than the parser ever backs up or looks ahead.
+
+	CStreamingTokenCursor( const char* str, size_t len, bool webPageEmbedMode = false, size_t inWindowSize = kDefaultWindowSize );	// str must outlive the cursor.
+
+	virtual size_t			GetNumTokens();
+
+	size_t					GetWindowSize() const	{ return mWindowSize; }
+
+protected:
+	virtual const CToken*	LoadTokenAtIndex( size_t inIndex );
+	virtual void			AddToken( TTokenType type, TIdentifierSubtype subtype, size_t offs, size_t lineN, const std::string& str, const std::string& comment, long long n = 0 );
+
+	CTokenizerState			mTokenizer;
+	std::deque<CToken>		mWindow;		// Our mTokens. Dropping the oldest token doesn't move the others, so references to them stay valid.
+	size_t					mWindowSize;
+};
+
+
+class CCompactTokenCursor : public CTokenCursor
+{
+public:
+	enum { kDefaultWindowSize = 256 };
+
+	explicit CCompactTokenCursor( const CCompactTokenList& inTokens, size_t inWindowSize = kDefaultWindowSize );	// inTokens must outlive the cursor.
+
+	virtual size_t			GetNumTokens()		{ return mList.size(); }
+	virtual const CToken*	GetLastToken();
+
+protected:
+	virtual const CToken*	LoadTokenAtIndex( size_t inIndex );
+
+	const CCompactTokenList&	mList;
+	std::deque<CToken>			mWindow;		// Our mTokens. Only ever grows or shrinks at the ends, so the parser's references to tokens stay valid for a while.
+	size_t						mWindowSize;
+	std::unique_ptr<CToken>		mLastToken;		// Made on demand by GetLastToken().
+};
+
+} // namespace Carlson
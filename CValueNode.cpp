@@ -94,6 +94,15 @@ void	CArrayValueNode::Simplify()
 	CNode::Simplify();
 }
 
+
+void	CArrayValueNode::Visit( std::function<void(CNode*)> visitorBlock )
+{
+	for( CValueNode * currValue : mArray )
+		currValue->Visit( visitorBlock );
+	
+	CValueNode::Visit( visitorBlock );
+}
+
 	
 void	CArrayValueNode::GenerateCode( Carlson::CCodeBlock *inCodeBlock )
 {
@@ -110,7 +119,7 @@ void	CArrayValueNode::GenerateCode( Carlson::CCodeBlock *inCodeBlock )
 	
 CArrayValueNode*	CArrayValueNode::Copy()
 {
-	CArrayValueNode * array = new CArrayValueNode( mParseTree, mLineNum );
+	CArrayValueNode * array = mParseTree->NewNode<CArrayValueNode>( mLineNum );
 	for( CValueNode * currValue : mArray )
 	{
 		array->AddItem( currValue->Copy() );
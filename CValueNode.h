@@ -14,6 +14,7 @@
 // -----------------------------------------------------------------------------
 
 #include "CNode.h"
+#include "CParseTree.h"
 #include <math.h>
 #include "CForgeExceptions.h"
 #include "LEOValue.h"
@@ -83,7 +84,7 @@ public:
 
 	virtual bool			IsConstant()	{ return true; };
 
-	virtual CIntValueNode*	Copy()			{ CIntValueNode* theNode = new CIntValueNode( mParseTree, mIntValue, mLineNum ); theNode->SetUnit(GetUnit()); return theNode; };
+	virtual CIntValueNode*	Copy()			{ CIntValueNode* theNode = CParseTree::NewNodeIn<CIntValueNode>( mParseTree, mIntValue, mLineNum ); theNode->SetUnit(GetUnit()); return theNode; };
 
 	virtual void			DebugPrint( std::ostream& destStream, size_t indentLevel )
 	{
@@ -112,7 +113,7 @@ public:
 
 	virtual bool				IsConstant()		{ return true; };
 
-	virtual CFloatValueNode*	Copy()		{ CFloatValueNode* theNode = new CFloatValueNode( mParseTree, mFloatValue, mLineNum ); theNode->SetUnit(GetUnit()); return theNode; };
+	virtual CFloatValueNode*	Copy()		{ CFloatValueNode* theNode = CParseTree::NewNodeIn<CFloatValueNode>( mParseTree, mFloatValue, mLineNum ); theNode->SetUnit(GetUnit()); return theNode; };
 
 	virtual void				DebugPrint( std::ostream& destStream, size_t indentLevel )
 	{
@@ -146,7 +147,7 @@ public:
 	
 	virtual bool				IsConstant()		{ return true; };
 
-	virtual CBoolValueNode*		Copy()		{ return new CBoolValueNode( mParseTree, mBoolValue, mLineNum ); };
+	virtual CBoolValueNode*		Copy()		{ return CParseTree::NewNodeIn<CBoolValueNode>( mParseTree, mBoolValue, mLineNum ); };
 
 	virtual void				DebugPrint( std::ostream& destStream, size_t indentLevel )
 	{
@@ -172,7 +173,7 @@ public:
 	
 	virtual bool				IsConstant()		{ return true; };
 
-	virtual CStringValueNode*	Copy()				{ return new CStringValueNode( mParseTree, mStringValue, mLineNum ); };
+	virtual CStringValueNode*	Copy()				{ return CParseTree::NewNodeIn<CStringValueNode>( mParseTree, mStringValue, mLineNum ); };
 
 	virtual void				DebugPrint( std::ostream& destStream, size_t indentLevel )
 	{
@@ -205,7 +206,7 @@ public:
 	
 	virtual bool				IsConstant()		{ return true; };
 
-	virtual CUnsetValueNode*	Copy()				{ return new CUnsetValueNode( mParseTree, mLineNum ); };
+	virtual CUnsetValueNode*	Copy()				{ return CParseTree::NewNodeIn<CUnsetValueNode>( mParseTree, mLineNum ); };
 
 	virtual void				DebugPrint( std::ostream& destStream, size_t indentLevel )
 	{
@@ -231,7 +232,7 @@ public:
 	virtual void				Simplify();
 	virtual void				GenerateCode( CCodeBlock* inCodeBlock );	// Generate the actual bytecode so it leaves the result on the stack.
 	
-	virtual CLocalVariableRefValueNode*	Copy()							{ return new CLocalVariableRefValueNode( mParseTree, mCodeBlockNode, mVarName, mRealVarName, mLineNum ); };
+	virtual CLocalVariableRefValueNode*	Copy()							{ return mParseTree->NewNode<CLocalVariableRefValueNode>( mCodeBlockNode, mVarName, mRealVarName, mLineNum ); };
 	
 	virtual void				DebugPrint( std::ostream& destStream, size_t indentLevel )
 	{
@@ -256,16 +257,16 @@ class CArrayValueNode : public CValueNode
 {
 public:
 	CArrayValueNode( CParseTree* inTree, size_t inLineNum ) : CValueNode(inTree,inLineNum) {}
-	virtual ~CArrayValueNode() { for( CValueNode * currItem : mArray ) { if( currItem ) delete currItem; } }
 	
-	virtual void			AddItem( CValueNode * inNode )	{ mArray.push_back(inNode); }	// Takes over ownership.
-	virtual void			SetItemAtIndex( CValueNode * inNode, size_t idx )	{ mArray[idx] = inNode; }	// Takes over ownership.
+	virtual void			AddItem( CValueNode * inNode )	{ mArray.push_back(inNode); }
+	virtual void			SetItemAtIndex( CValueNode * inNode, size_t idx )	{ mArray[idx] = inNode; }
 	virtual size_t			GetItemCount()					{ return mArray.size(); }
 	virtual CValueNode *	GetItem( size_t idx )			{ return mArray[idx]; }
 
 	virtual void				GenerateCode( CCodeBlock* inCodeBlock );	// Generate the actual bytecode so it leaves the result on the stack.
 
 	virtual void				Simplify();
+	virtual void				Visit( std::function<void(CNode*)> visitorBlock );
 	virtual CArrayValueNode*	Copy();
 
 	virtual void			DebugPrint( std::ostream& destStream, size_t indentLevel )
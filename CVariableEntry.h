@@ -11,6 +11,7 @@
 
 #include <string>
 #include <climits>
+#include <atomic>
 
 
 namespace Carlson
@@ -78,7 +79,7 @@ public:
 	std::string		mRealName;			// Real name as the user sees it. User-defined variables internally get a prefix "var_" to avoid collisions with built-in system vars.
 	TVariantType	mVariableType;		// Type for this variable.
 	int16_t			mBPRelativeOffset;	// Backpointer-relative offset of this variable, so we can find it.
-	static int		mTempCounterSeed;
+	static std::atomic<int>	mTempCounterSeed;
 	
 public:
 	CVariableEntry( const std::string& realName, TVariantType theType, bool initWithName = false, bool isParam = false, bool isGlobal = false, bool dontDispose = false )
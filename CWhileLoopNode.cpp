@@ -25,7 +25,7 @@ void	CWhileLoopNode::GenerateCode( CCodeBlock* inBlock )
 	}
 	
 	int32_t	lineMarkerInstructionOffset = (int32_t) inBlock->GetNextInstructionOffset();
-	inBlock->GenerateLineMarkerInstruction( (int32_t) mLineNum, LEOFileIDForFileName(mFileName.c_str()) );	// Make sure debugger indicates condition as current line on every iteration.
+	inBlock->GenerateLineMarkerInstruction( (uint32_t) mLineNum, mFileName );	// Make sure debugger indicates condition as current line on every iteration.
 	
 	// Push condition:
 	mCondition->GenerateCode(inBlock);
@@ -54,7 +54,7 @@ void	CWhileLoopNode::Simplify()
 	
 	CValueNode	*	originalNode = mCondition;
 	originalNode->Simplify();	// Give subnodes a chance to apply transformations first. Might expose simpler sub-nodes we can then simplify.
-	CNode* newNode = CNodeTransformationBase::Apply( originalNode );	// Returns either originalNode, or a totally new object, in which case we delete the old one.
+	CNode* newNode = CNodeTransformationBase::Apply( originalNode );	// Returns either originalNode, or a totally new object, which replaces it.
 	if( newNode != originalNode )
 	{
 		assert( dynamic_cast<CValueNode*>(newNode) != NULL );
@@ -7,6 +7,8 @@
  *
  */
 
+#pragma once
+
 #include "CCodeBlockNode.h"
 
 
@@ -17,9 +19,12 @@ class CWhileLoopNode : public CCodeBlockNode
 {
 public:
 	CWhileLoopNode( CParseTree* inTree, size_t inLineNum, const std::string &inFileName, CCodeBlockNodeBase* owningBlock ) : CCodeBlockNode( inTree, inLineNum, inFileName, owningBlock ), mCondition(NULL), mCommandsLineNum(0), mEndRepeatLineNum(0) {};
-	~CWhileLoopNode() { if( mCondition) delete mCondition; mCondition = NULL; };
 
-	virtual void	SetCondition( CValueNode* inCond )	{ if( mCondition ) delete mCondition; mCondition = inCond; };	// inCond is now owned by the CWhileLoopNode.
+	static const TNodeKind	kNodeKind = EWhileLoopNodeKind;
+	virtual TNodeKind	GetNodeKind()	{ return kNodeKind; };
+
+	virtual void	SetCondition( CValueNode* inCond )	{ mCondition = inCond; };
+	virtual CValueNode*	GetCondition()					{ return mCondition; };	// May return NULL!
 	
 	virtual void	GenerateCode( CCodeBlock* inBlock );
 	virtual void	Simplify();
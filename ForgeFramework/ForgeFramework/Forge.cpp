@@ -12,19 +12,25 @@ extern "C" {
 }
 
 #include "CToken.h"
+#include "CTokenCursor.h"
 #include "CParser.h"
 #include "CParseTree.h"
 #include "CCodeBlock.h"
 #include "CChunkPropertyNodeTransformation.h"
 #include "CConcatOperatorNodeTransformation.h"
 #include "CConcatSpaceOperatorNodeTransformation.h"
+#include "CConstantFoldingNodeTransformation.h"
+#include "CDeadCodeNodeTransformation.h"
 #include "CFunctionDefinitionNode.h"
 #include "CWhileLoopNode.h"
 #include "CIfNode.h"
+#include "COperatorNode.h"
 #include "CDownloadCommandNode.h"
 #include "AnsiStrings.h"
 
 #include <iostream>
+#include <mutex>
+#include <atomic>
 
 using namespace Carlson;
 
@@ -32,46 +38,97 @@ using namespace Carlson;
 extern "C" void LEOInitializeNodeTransformationsIfNeeded( void );
 
 
+static std::atomic<bool>	sKeepLineMarkersInDeadCode( false );	// Default for new compile sessions, see LEOSetKeepLineMarkersInDeadCode().
+
+
 extern "C" void LEOInitializeNodeTransformationsIfNeeded( void )
 {
-	static bool	sAlreadyInitializedThem = false;
-	if( !sAlreadyInitializedThem )
+	static std::once_flag	sInitializeOnce;	// Several threads may start compiling at the same time.
+	std::call_once( sInitializeOnce, []()
 	{
 		CConcatOperatorNodeTransformation::Initialize();
 		CConcatSpaceOperatorNodeTransformation::Initialize();
 		CChunkPropertyNodeTransformation::Initialize();
 		CChunkPropertyPutNodeTransformation::Initialize();
-		
-		sAlreadyInitializedThem = true;
-	}
+		CConstantFoldingNodeTransformation::Initialize();
+		CDeadIfNodeTransformation::Initialize();
+		CDeadWhileLoopNodeTransformation::Initialize();
+		CUnreachableCodePass::Initialize();
+	});
 }
 
 
-char							gLEOLastErrorString[1024] = { 0 };
-size_t							gLEOLastErrorOffset = SIZE_MAX;
-size_t							gLEOLastErrorLineNum = SIZE_MAX;
-std::vector<CMessageEntry>		gMessages;
-std::vector<CHandlerNotesEntry>	gHandlerNotes;
+struct LEOCompileSession
+{
+	LEOCompileSession() : mLastErrorOffset(SIZE_MAX), mLastErrorLineNum(SIZE_MAX), mTokenizeWhileParsing(false), mKeepLineMarkersInDeadCode(sKeepLineMarkersInDeadCode) { mLastErrorString[0] = 0; };
+	
+	char							mLastErrorString[1024];
+	size_t							mLastErrorOffset;
+	size_t							mLastErrorLineNum;
+	bool							mTokenizeWhileParsing;	// See LEOCompileSessionSetTokenizeWhileParsing().
+	bool							mKeepLineMarkersInDeadCode;	// See LEOCompileSessionSetKeepLineMarkersInDeadCode().
+	std::vector<CMessageEntry>		mMessages;
+	std::vector<CHandlerNotesEntry>	mHandlerNotes;
+};
+
 
+static LEOCompileSession	sDefaultSession;	// Used by all the calls that don't take a session.
 
-extern "C" LEOParseTree*	LEOParseTreeCreateFromUTF8Characters( const char* inCode, size_t codeLength, uint16_t inFileID )
+
+extern "C" LEOCompileSession*	LEOCompileSessionCreate( void )
+{
+	LEOInitializeNodeTransformationsIfNeeded();
+	
+	return new LEOCompileSession;
+}
+
+
+extern "C" void		LEOCleanUpCompileSession( LEOCompileSession* inSession )
+{
+	delete inSession;
+}
+
+
+extern "C" void		LEOCompileSessionSetTokenizeWhileParsing( LEOCompileSession* inSession, bool inTokenizeWhileParsing )
+{
+	inSession->mTokenizeWhileParsing = inTokenizeWhileParsing;
+}
+
+
+extern "C" void		LEOCompileSessionSetKeepLineMarkersInDeadCode( LEOCompileSession* inSession, bool inKeepLineMarkers )
+{
+	inSession->mKeepLineMarkersInDeadCode = inKeepLineMarkers;
+}
+
+
+extern "C" LEOParseTree*	LEOParseTreeCreateFromUTF8CharactersInSession( LEOCompileSession* inSession, const char* inCode, size_t codeLength, uint16_t inFileID )
 {
 	LEOInitializeNodeTransformationsIfNeeded();
 	
 	CParseTree	*	parseTree = NULL;
-	gLEOLastErrorString[0] = 0;
-	gLEOLastErrorOffset = SIZE_MAX;
-	gLEOLastErrorLineNum = SIZE_MAX;
+	inSession->mLastErrorString[0] = 0;
+	inSession->mLastErrorOffset = SIZE_MAX;
+	inSession->mLastErrorLineNum = SIZE_MAX;
 	
 	try
 	{
 		parseTree = new CParseTree;
+		parseTree->SetKeepLineMarkersInDeadCode( inSession->mKeepLineMarkersInDeadCode );
 		CParser				parser;
-		std::deque<CToken>	tokens = CTokenizer::TokenListFromText( inCode, codeLength );
-		parser.Parse( LEOFileNameForFileID( inFileID ), tokens, *parseTree, inCode );
+		if( inSession->mTokenizeWhileParsing )
+		{
+			CStreamingTokenCursor	tokens( inCode, codeLength );	// Only keeps the last few tokens around.
+			parser.Parse( LEOFileNameForFileID( inFileID ), tokens, *parseTree, inCode );
+		}
+		else
+		{
+			CCompactTokenList		compactTokens( inCode, codeLength );
+			CCompactTokenCursor		tokens( compactTokens );
+			parser.Parse( LEOFileNameForFileID( inFileID ), tokens, *parseTree, inCode );
+		}
 		
-		gMessages.assign( parser.GetMessages().begin(), parser.GetMessages().end() );
-		gHandlerNotes.assign( parser.GetHandlerNotes().begin(), parser.GetHandlerNotes().end() );
+		inSession->mMessages.assign( parser.GetMessages().begin(), parser.GetMessages().end() );
+		inSession->mHandlerNotes.assign( parser.GetHandlerNotes().begin(), parser.GetHandlerNotes().end() );
 		
 		#if 0
 		parseTree->DebugPrint( std::cout, 0 );
@@ -85,9 +142,9 @@ extern "C" LEOParseTree*	LEOParseTreeCreateFromUTF8Characters( const char* inCod
 	}
 	catch( CForgeParseError& ferr )
 	{
-		strlcpy( gLEOLastErrorString, ferr.what(), sizeof(gLEOLastErrorString) );
-		gLEOLastErrorLineNum = ferr.GetLineNum();
-		gLEOLastErrorOffset = ferr.GetOffset();
+		strlcpy( inSession->mLastErrorString, ferr.what(), sizeof(inSession->mLastErrorString) );
+		inSession->mLastErrorLineNum = ferr.GetLineNum();
+		inSession->mLastErrorOffset = ferr.GetOffset();
 		#if 0
 		parseTree->DebugPrint( std::cout, 0 );
 		#endif
@@ -97,7 +154,7 @@ extern "C" LEOParseTree*	LEOParseTreeCreateFromUTF8Characters( const char* inCod
 	}
 	catch( std::exception& err )
 	{
-		strlcpy( gLEOLastErrorString, err.what(), sizeof(gLEOLastErrorString));
+		strlcpy( inSession->mLastErrorString, err.what(), sizeof(inSession->mLastErrorString));
 		#if 0
 		parseTree->DebugPrint( std::cout, 0 );
 		#endif
@@ -107,7 +164,7 @@ extern "C" LEOParseTree*	LEOParseTreeCreateFromUTF8Characters( const char* inCod
 	}
 	catch( ... )
 	{
-		strlcpy( gLEOLastErrorString, "Unknown error.", sizeof(gLEOLastErrorString));
+		strlcpy( inSession->mLastErrorString, "Unknown error.", sizeof(inSession->mLastErrorString));
 		if( parseTree )
 			delete parseTree;
 		parseTree = NULL;
@@ -117,18 +174,25 @@ extern "C" LEOParseTree*	LEOParseTreeCreateFromUTF8Characters( const char* inCod
 }
 
 
-extern "C" LEOParseTree*	LEOParseTreeCreateForCommandOrExpressionFromUTF8Characters( const char* inCode, size_t codeLength, uint16_t inFileID )
+extern "C" LEOParseTree*	LEOParseTreeCreateFromUTF8Characters( const char* inCode, size_t codeLength, uint16_t inFileID )
+{
+	return LEOParseTreeCreateFromUTF8CharactersInSession( &sDefaultSession, inCode, codeLength, inFileID );
+}
+
+
+extern "C" LEOParseTree*	LEOParseTreeCreateForCommandOrExpressionFromUTF8CharactersInSession( LEOCompileSession* inSession, const char* inCode, size_t codeLength, uint16_t inFileID )
 {
 	LEOInitializeNodeTransformationsIfNeeded();
 	
 	CParseTree	*	parseTree = NULL;
-	gLEOLastErrorString[0] = 0;
-	gLEOLastErrorOffset = SIZE_MAX;
-	gLEOLastErrorLineNum = SIZE_MAX;
+	inSession->mLastErrorString[0] = 0;
+	inSession->mLastErrorOffset = SIZE_MAX;
+	inSession->mLastErrorLineNum = SIZE_MAX;
 	
 	try
 	{
 		parseTree = new CParseTree;
+		parseTree->SetKeepLineMarkersInDeadCode( inSession->mKeepLineMarkersInDeadCode );
 		CParser				parser;
 		std::deque<CToken>	tokens = CTokenizer::TokenListFromText( inCode, codeLength );
 		parser.ParseCommandOrExpression( LEOFileNameForFileID( inFileID ), tokens, *parseTree, EAllVarsAreGlobals );
@@ -141,23 +205,23 @@ extern "C" LEOParseTree*	LEOParseTreeCreateForCommandOrExpressionFromUTF8Charact
 	}
 	catch( CForgeParseError& ferr )
 	{
-		strlcpy( gLEOLastErrorString, ferr.what(), sizeof(gLEOLastErrorString));
-		gLEOLastErrorLineNum = ferr.GetLineNum();
-		gLEOLastErrorOffset = ferr.GetOffset();
+		strlcpy( inSession->mLastErrorString, ferr.what(), sizeof(inSession->mLastErrorString));
+		inSession->mLastErrorLineNum = ferr.GetLineNum();
+		inSession->mLastErrorOffset = ferr.GetOffset();
 		if( parseTree )
 			delete parseTree;
 		parseTree = NULL;
 	}
 	catch( std::exception& err )
 	{
-		strlcpy( gLEOLastErrorString, err.what(), sizeof(gLEOLastErrorString));
+		strlcpy( inSession->mLastErrorString, err.what(), sizeof(inSession->mLastErrorString));
 		if( parseTree )
 			delete parseTree;
 		parseTree = NULL;
 	}
 	catch( ... )
 	{
-		strlcpy( gLEOLastErrorString, "Unknown error.", sizeof(gLEOLastErrorString));
+		strlcpy( inSession->mLastErrorString, "Unknown error.", sizeof(inSession->mLastErrorString));
 		if( parseTree )
 			delete parseTree;
 		parseTree = NULL;
@@ -167,6 +231,139 @@ extern "C" LEOParseTree*	LEOParseTreeCreateForCommandOrExpressionFromUTF8Charact
 }
 
 
+extern "C" LEOParseTree*	LEOParseTreeCreateForCommandOrExpressionFromUTF8Characters( const char* inCode, size_t codeLength, uint16_t inFileID )
+{
+	return LEOParseTreeCreateForCommandOrExpressionFromUTF8CharactersInSession( &sDefaultSession, inCode, codeLength, inFileID );
+}
+
+
+extern "C" LEOTokenList*	LEOTokenListCreateFromUTF8CharactersInSession( LEOCompileSession* inSession, const char* inCode, size_t codeLength )
+{
+	std::deque<CToken>	*	tokens = NULL;
+	inSession->mLastErrorString[0] = 0;
+	inSession->mLastErrorOffset = SIZE_MAX;
+	inSession->mLastErrorLineNum = SIZE_MAX;
+	
+	try
+	{
+		tokens = new std::deque<CToken>( CTokenizer::TokenListFromText( inCode, codeLength ) );
+	}
+	catch( std::exception& err )
+	{
+		strlcpy( inSession->mLastErrorString, err.what(), sizeof(inSession->mLastErrorString) );
+		if( tokens )
+			delete tokens;
+		tokens = NULL;
+	}
+	catch( ... )
+	{
+		strlcpy( inSession->mLastErrorString, "Unknown error.", sizeof(inSession->mLastErrorString) );
+		if( tokens )
+			delete tokens;
+		tokens = NULL;
+	}
+	
+	return (LEOTokenList*)tokens;
+}
+
+
+extern "C" LEOTokenList*	LEOTokenListCreateFromUTF8Characters( const char* inCode, size_t codeLength )
+{
+	return LEOTokenListCreateFromUTF8CharactersInSession( &sDefaultSession, inCode, codeLength );
+}
+
+
+extern "C" void		LEOTokenListUpdateForEditInSession( LEOCompileSession* inSession, LEOTokenList* inTokens, const char* inCode, size_t codeLength, size_t inEditOffset, size_t inRemovedLength, size_t inInsertedLength )
+{
+	std::deque<CToken>&	tokens = *(std::deque<CToken>*)inTokens;
+	inSession->mLastErrorString[0] = 0;
+	inSession->mLastErrorOffset = SIZE_MAX;
+	inSession->mLastErrorLineNum = SIZE_MAX;
+	
+	try
+	{
+		CTokenizer::RetokenizeAfterEdit( tokens, inCode, codeLength, false, inEditOffset, inRemovedLength, inInsertedLength );
+	}
+	catch( std::exception& err )
+	{
+		strlcpy( inSession->mLastErrorString, err.what(), sizeof(inSession->mLastErrorString) );
+		tokens = CTokenizer::TokenListFromText( inCode, codeLength );
+	}
+	catch( ... )
+	{
+		strlcpy( inSession->mLastErrorString, "Unknown error.", sizeof(inSession->mLastErrorString) );
+		tokens = CTokenizer::TokenListFromText( inCode, codeLength );
+	}
+}
+
+
+extern "C" void		LEOTokenListUpdateForEdit( LEOTokenList* inTokens, const char* inCode, size_t codeLength, size_t inEditOffset, size_t inRemovedLength, size_t inInsertedLength )
+{
+	LEOTokenListUpdateForEditInSession( &sDefaultSession, inTokens, inCode, codeLength, inEditOffset, inRemovedLength, inInsertedLength );
+}
+
+
+extern "C" LEOParseTree*	LEOParseTreeCreateFromTokenListInSession( LEOCompileSession* inSession, LEOTokenList* inTokens, const char* inCode, uint16_t inFileID )
+{
+	LEOInitializeNodeTransformationsIfNeeded();
+	
+	CParseTree	*	parseTree = NULL;
+	inSession->mLastErrorString[0] = 0;
+	inSession->mLastErrorOffset = SIZE_MAX;
+	inSession->mLastErrorLineNum = SIZE_MAX;
+	
+	try
+	{
+		parseTree = new CParseTree;
+		parseTree->SetKeepLineMarkersInDeadCode( inSession->mKeepLineMarkersInDeadCode );
+		CParser				parser;
+		parser.Parse( LEOFileNameForFileID( inFileID ), *(std::deque<CToken>*)inTokens, *parseTree, inCode );
+		
+		inSession->mMessages.assign( parser.GetMessages().begin(), parser.GetMessages().end() );
+		inSession->mHandlerNotes.assign( parser.GetHandlerNotes().begin(), parser.GetHandlerNotes().end() );
+		
+		parseTree->Simplify();
+	}
+	catch( CForgeParseError& ferr )
+	{
+		strlcpy( inSession->mLastErrorString, ferr.what(), sizeof(inSession->mLastErrorString) );
+		inSession->mLastErrorLineNum = ferr.GetLineNum();
+		inSession->mLastErrorOffset = ferr.GetOffset();
+		if( parseTree )
+			delete parseTree;
+		parseTree = NULL;
+	}
+	catch( std::exception& err )
+	{
+		strlcpy( inSession->mLastErrorString, err.what(), sizeof(inSession->mLastErrorString) );
+		if( parseTree )
+			delete parseTree;
+		parseTree = NULL;
+	}
+	catch( ... )
+	{
+		strlcpy( inSession->mLastErrorString, "Unknown error.", sizeof(inSession->mLastErrorString) );
+		if( parseTree )
+			delete parseTree;
+		parseTree = NULL;
+	}
+	
+	return (LEOParseTree*)parseTree;
+}
+
+
+extern "C" LEOParseTree*	LEOParseTreeCreateFromTokenList( LEOTokenList* inTokens, const char* inCode, uint16_t inFileID )
+{
+	return LEOParseTreeCreateFromTokenListInSession( &sDefaultSession, inTokens, inCode, inFileID );
+}
+
+
+extern "C" void		LEOCleanUpTokenList( LEOTokenList* inTokens )
+{
+	delete (std::deque<CToken>*)inTokens;
+}
+
+
 extern "C" void		LEOCleanUpParseTree( LEOParseTree* inTree )
 {
 	try
@@ -429,33 +626,51 @@ extern "C" void		LEODebugPrintDisplayInfoTable(LEODisplayInfoTable* inTable)
 }
 
 
-extern "C" const char*	LEOParserGetLastErrorMessage()
+extern "C" const char*	LEOCompileSessionGetLastErrorMessage( LEOCompileSession* inSession )
 {
-	if( gLEOLastErrorString[0] == 0 )
+	if( inSession->mLastErrorString[0] == 0 )
 		return NULL;
-	return gLEOLastErrorString;
+	return inSession->mLastErrorString;
+}
+
+
+extern "C" size_t	LEOCompileSessionGetLastErrorLineNum( LEOCompileSession* inSession )
+{
+	return inSession->mLastErrorLineNum;
+}
+
+
+extern "C" size_t	LEOCompileSessionGetLastErrorOffset( LEOCompileSession* inSession )
+{
+	return inSession->mLastErrorOffset;
+}
+
+
+extern "C" const char*	LEOParserGetLastErrorMessage()
+{
+	return LEOCompileSessionGetLastErrorMessage( &sDefaultSession );
 }
 
 
 extern "C" size_t	LEOParserGetLastErrorLineNum()
 {
-	return gLEOLastErrorLineNum;
+	return LEOCompileSessionGetLastErrorLineNum( &sDefaultSession );
 }
 
 
 extern "C" size_t	LEOParserGetLastErrorOffset()
 {
-	return gLEOLastErrorOffset;
+	return LEOCompileSessionGetLastErrorOffset( &sDefaultSession );
 }
 
 
-extern "C" void		LEOScriptCompileAndAddParseTree( LEOScript* inScript, LEOContextGroup* inGroup, LEOParseTree* inTree, uint16_t inFileID )
+extern "C" void		LEOScriptCompileAndAddParseTreeInSession( LEOCompileSession* inSession, LEOScript* inScript, LEOContextGroup* inGroup, LEOParseTree* inTree, uint16_t inFileID )
 {
 	LEOInitializeNodeTransformationsIfNeeded();
 	
-	gLEOLastErrorString[0] = 0;
-	gLEOLastErrorOffset = SIZE_MAX;
-	gLEOLastErrorLineNum = SIZE_MAX;
+	inSession->mLastErrorString[0] = 0;
+	inSession->mLastErrorOffset = SIZE_MAX;
+	inSession->mLastErrorLineNum = SIZE_MAX;
 	
 	try
 	{
@@ -465,13 +680,13 @@ extern "C" void		LEOScriptCompileAndAddParseTree( LEOScript* inScript, LEOContex
 		((CParseTree*)inTree)->DebugPrint( std::cout, 0 );
 		#endif
 		
-		((CParseTree*)inTree)->Simplify();
+		((CParseTree*)inTree)->Simplify();	// Only does something if the tree wasn't simplified when it was created.
 		
 		#if 0
 		((CParseTree*)inTree)->DebugPrint( std::cout, 0 );
 		#endif
 		
-		((CParseTree*)inTree)->GenerateCode( &block );
+		((CParseTree*)inTree)->GenerateCodeInParallel( &block );
 		
 		#if 0
 		((CParseTree*)inTree)->DebugPrint( std::cout, 0 );
@@ -480,9 +695,9 @@ extern "C" void		LEOScriptCompileAndAddParseTree( LEOScript* inScript, LEOContex
 	}
 	catch( CForgeParseError& ferr )
 	{
-		strlcpy( gLEOLastErrorString, ferr.what(), sizeof(gLEOLastErrorString));
-		gLEOLastErrorLineNum = ferr.GetLineNum();
-		gLEOLastErrorOffset = ferr.GetOffset();
+		strlcpy( inSession->mLastErrorString, ferr.what(), sizeof(inSession->mLastErrorString));
+		inSession->mLastErrorLineNum = ferr.GetLineNum();
+		inSession->mLastErrorOffset = ferr.GetOffset();
 		
 		#if 0
 		((CParseTree*)inTree)->DebugPrint( std::cout, 0 );
@@ -490,7 +705,7 @@ extern "C" void		LEOScriptCompileAndAddParseTree( LEOScript* inScript, LEOContex
 	}
 	catch( std::exception& err )
 	{
-		strlcpy( gLEOLastErrorString, err.what(), sizeof(gLEOLastErrorString));
+		strlcpy( inSession->mLastErrorString, err.what(), sizeof(inSession->mLastErrorString));
 		
 		#if 0
 		((CParseTree*)inTree)->DebugPrint( std::cout, 0 );
@@ -498,16 +713,22 @@ extern "C" void		LEOScriptCompileAndAddParseTree( LEOScript* inScript, LEOContex
 	}
 	catch( ... )
 	{
-		strlcpy( gLEOLastErrorString, "Unknown error.", sizeof(gLEOLastErrorString));
+		strlcpy( inSession->mLastErrorString, "Unknown error.", sizeof(inSession->mLastErrorString));
 	}
 }
 
 
+extern "C" void		LEOScriptCompileAndAddParseTree( LEOScript* inScript, LEOContextGroup* inGroup, LEOParseTree* inTree, uint16_t inFileID )
+{
+	LEOScriptCompileAndAddParseTreeInSession( &sDefaultSession, inScript, inGroup, inTree, inFileID );
+}
+
+
 extern "C" void	LEOAddOperatorsAndOffsetInstructions( struct TOperatorEntry* inEntries, LEOInstructionID firstOperatorInstruction )
 {
-	gLEOLastErrorString[0] = 0;
-	gLEOLastErrorOffset = SIZE_MAX;
-	gLEOLastErrorLineNum = SIZE_MAX;
+	sDefaultSession.mLastErrorString[0] = 0;
+	sDefaultSession.mLastErrorOffset = SIZE_MAX;
+	sDefaultSession.mLastErrorLineNum = SIZE_MAX;
 	
 	try
 	{
@@ -515,26 +736,26 @@ extern "C" void	LEOAddOperatorsAndOffsetInstructions( struct TOperatorEntry* inE
 	}
 	catch( CForgeParseError& ferr )
 	{
-		strlcpy( gLEOLastErrorString, ferr.what(), sizeof(gLEOLastErrorString) );
-		gLEOLastErrorLineNum = ferr.GetLineNum();
-		gLEOLastErrorOffset = ferr.GetOffset();
+		strlcpy( sDefaultSession.mLastErrorString, ferr.what(), sizeof(sDefaultSession.mLastErrorString) );
+		sDefaultSession.mLastErrorLineNum = ferr.GetLineNum();
+		sDefaultSession.mLastErrorOffset = ferr.GetOffset();
 	}
 	catch( std::exception& err )
 	{
-		strlcpy( gLEOLastErrorString, err.what(), sizeof(gLEOLastErrorString) );
+		strlcpy( sDefaultSession.mLastErrorString, err.what(), sizeof(sDefaultSession.mLastErrorString) );
 	}
 	catch( ... )
 	{
-		strlcpy( gLEOLastErrorString, "Unknown error.", sizeof(gLEOLastErrorString) );
+		strlcpy( sDefaultSession.mLastErrorString, "Unknown error.", sizeof(sDefaultSession.mLastErrorString) );
 	}
 }
 
 
 extern "C" void	LEOAddUnaryOperatorsAndOffsetInstructions( struct TUnaryOperatorEntry* inEntries, LEOInstructionID firstUnaryOperatorInstruction )
 {
-	gLEOLastErrorString[0] = 0;
-	gLEOLastErrorOffset = SIZE_MAX;
-	gLEOLastErrorLineNum = SIZE_MAX;
+	sDefaultSession.mLastErrorString[0] = 0;
+	sDefaultSession.mLastErrorOffset = SIZE_MAX;
+	sDefaultSession.mLastErrorLineNum = SIZE_MAX;
 	
 	try
 	{
@@ -542,26 +763,26 @@ extern "C" void	LEOAddUnaryOperatorsAndOffsetInstructions( struct TUnaryOperator
 	}
 	catch( CForgeParseError& ferr )
 	{
-		strlcpy( gLEOLastErrorString, ferr.what(), sizeof(gLEOLastErrorString) );
-		gLEOLastErrorLineNum = ferr.GetLineNum();
-		gLEOLastErrorOffset = ferr.GetOffset();
+		strlcpy( sDefaultSession.mLastErrorString, ferr.what(), sizeof(sDefaultSession.mLastErrorString) );
+		sDefaultSession.mLastErrorLineNum = ferr.GetLineNum();
+		sDefaultSession.mLastErrorOffset = ferr.GetOffset();
 	}
 	catch( std::exception& err )
 	{
-		strlcpy( gLEOLastErrorString, err.what(), sizeof(gLEOLastErrorString) );
+		strlcpy( sDefaultSession.mLastErrorString, err.what(), sizeof(sDefaultSession.mLastErrorString) );
 	}
 	catch( ... )
 	{
-		strlcpy( gLEOLastErrorString, "Unknown error.", sizeof(gLEOLastErrorString) );
+		strlcpy( sDefaultSession.mLastErrorString, "Unknown error.", sizeof(sDefaultSession.mLastErrorString) );
 	}
 }
 
 
 extern "C" void	LEOAddBuiltInFunctionsAndOffsetInstructions( struct TBuiltInFunctionEntry* inEntries, LEOInstructionID firstGlobalPropertyInstruction )
 {
-	gLEOLastErrorString[0] = 0;
-	gLEOLastErrorOffset = SIZE_MAX;
-	gLEOLastErrorLineNum = SIZE_MAX;
+	sDefaultSession.mLastErrorString[0] = 0;
+	sDefaultSession.mLastErrorOffset = SIZE_MAX;
+	sDefaultSession.mLastErrorLineNum = SIZE_MAX;
 	
 	try
 	{
@@ -569,26 +790,26 @@ extern "C" void	LEOAddBuiltInFunctionsAndOffsetInstructions( struct TBuiltInFunc
 	}
 	catch( CForgeParseError& ferr )
 	{
-		strlcpy( gLEOLastErrorString, ferr.what(), sizeof(gLEOLastErrorString) );
-		gLEOLastErrorLineNum = ferr.GetLineNum();
-		gLEOLastErrorOffset = ferr.GetOffset();
+		strlcpy( sDefaultSession.mLastErrorString, ferr.what(), sizeof(sDefaultSession.mLastErrorString) );
+		sDefaultSession.mLastErrorLineNum = ferr.GetLineNum();
+		sDefaultSession.mLastErrorOffset = ferr.GetOffset();
 	}
 	catch( std::exception& err )
 	{
-		strlcpy( gLEOLastErrorString, err.what(), sizeof(gLEOLastErrorString) );
+		strlcpy( sDefaultSession.mLastErrorString, err.what(), sizeof(sDefaultSession.mLastErrorString) );
 	}
 	catch( ... )
 	{
-		strlcpy( gLEOLastErrorString, "Unknown error.", sizeof(gLEOLastErrorString) );
+		strlcpy( sDefaultSession.mLastErrorString, "Unknown error.", sizeof(sDefaultSession.mLastErrorString) );
 	}
 }
 
 
 extern "C" void	LEOAddGlobalPropertiesAndOffsetInstructions( struct TGlobalPropertyEntry* inEntries, LEOInstructionID firstGlobalPropertyInstruction )
 {
-	gLEOLastErrorString[0] = 0;
-	gLEOLastErrorOffset = SIZE_MAX;
-	gLEOLastErrorLineNum = SIZE_MAX;
+	sDefaultSession.mLastErrorString[0] = 0;
+	sDefaultSession.mLastErrorOffset = SIZE_MAX;
+	sDefaultSession.mLastErrorLineNum = SIZE_MAX;
 	
 	try
 	{
@@ -596,26 +817,26 @@ extern "C" void	LEOAddGlobalPropertiesAndOffsetInstructions( struct TGlobalPrope
 	}
 	catch( CForgeParseError& ferr )
 	{
-		strlcpy( gLEOLastErrorString, ferr.what(), sizeof(gLEOLastErrorString));
-		gLEOLastErrorLineNum = ferr.GetLineNum();
-		gLEOLastErrorOffset = ferr.GetOffset();
+		strlcpy( sDefaultSession.mLastErrorString, ferr.what(), sizeof(sDefaultSession.mLastErrorString));
+		sDefaultSession.mLastErrorLineNum = ferr.GetLineNum();
+		sDefaultSession.mLastErrorOffset = ferr.GetOffset();
 	}
 	catch( std::exception& err )
 	{
-		strlcpy( gLEOLastErrorString, err.what(), sizeof(gLEOLastErrorString));
+		strlcpy( sDefaultSession.mLastErrorString, err.what(), sizeof(sDefaultSession.mLastErrorString));
 	}
 	catch( ... )
 	{
-		strlcpy( gLEOLastErrorString, "Unknown error.", sizeof(gLEOLastErrorString));
+		strlcpy( sDefaultSession.mLastErrorString, "Unknown error.", sizeof(sDefaultSession.mLastErrorString));
 	}
 }
 
 
 extern "C" void	LEOAddHostCommandsAndOffsetInstructions( struct THostCommandEntry* inEntries, LEOInstructionID firstHostCommandInstruction )
 {
-	gLEOLastErrorString[0] = 0;
-	gLEOLastErrorOffset = SIZE_MAX;
-	gLEOLastErrorLineNum = SIZE_MAX;
+	sDefaultSession.mLastErrorString[0] = 0;
+	sDefaultSession.mLastErrorOffset = SIZE_MAX;
+	sDefaultSession.mLastErrorLineNum = SIZE_MAX;
 	
 	try
 	{
@@ -623,26 +844,26 @@ extern "C" void	LEOAddHostCommandsAndOffsetInstructions( struct THostCommandEntr
 	}
 	catch( CForgeParseError& ferr )
 	{
-		strlcpy( gLEOLastErrorString, ferr.what(), sizeof(gLEOLastErrorString) );
-		gLEOLastErrorLineNum = ferr.GetLineNum();
-		gLEOLastErrorOffset = ferr.GetOffset();
+		strlcpy( sDefaultSession.mLastErrorString, ferr.what(), sizeof(sDefaultSession.mLastErrorString) );
+		sDefaultSession.mLastErrorLineNum = ferr.GetLineNum();
+		sDefaultSession.mLastErrorOffset = ferr.GetOffset();
 	}
 	catch( std::exception& err )
 	{
-		strlcpy( gLEOLastErrorString, err.what(), sizeof(gLEOLastErrorString) );
+		strlcpy( sDefaultSession.mLastErrorString, err.what(), sizeof(sDefaultSession.mLastErrorString) );
 	}
 	catch( ... )
 	{
-		strlcpy( gLEOLastErrorString, "Unknown error.", sizeof(gLEOLastErrorString) );
+		strlcpy( sDefaultSession.mLastErrorString, "Unknown error.", sizeof(sDefaultSession.mLastErrorString) );
 	}
 }
 
 
 extern "C" void	LEOAddHostFunctionsAndOffsetInstructions( struct THostCommandEntry* inEntries, LEOInstructionID firstHostFunctionInstruction )
 {
-	gLEOLastErrorString[0] = 0;
-	gLEOLastErrorOffset = SIZE_MAX;
-	gLEOLastErrorLineNum = SIZE_MAX;
+	sDefaultSession.mLastErrorString[0] = 0;
+	sDefaultSession.mLastErrorOffset = SIZE_MAX;
+	sDefaultSession.mLastErrorLineNum = SIZE_MAX;
 	
 	try
 	{
@@ -650,26 +871,26 @@ extern "C" void	LEOAddHostFunctionsAndOffsetInstructions( struct THostCommandEnt
 	}
 	catch( CForgeParseError& ferr )
 	{
-		strlcpy( gLEOLastErrorString, ferr.what(), sizeof(gLEOLastErrorString) );
-		gLEOLastErrorLineNum = ferr.GetLineNum();
-		gLEOLastErrorOffset = ferr.GetOffset();
+		strlcpy( sDefaultSession.mLastErrorString, ferr.what(), sizeof(sDefaultSession.mLastErrorString) );
+		sDefaultSession.mLastErrorLineNum = ferr.GetLineNum();
+		sDefaultSession.mLastErrorOffset = ferr.GetOffset();
 	}
 	catch( std::exception& err )
 	{
-		strlcpy( gLEOLastErrorString, err.what(), sizeof(gLEOLastErrorString) );
+		strlcpy( sDefaultSession.mLastErrorString, err.what(), sizeof(sDefaultSession.mLastErrorString) );
 	}
 	catch( ... )
 	{
-		strlcpy( gLEOLastErrorString, "Unknown error.", sizeof(gLEOLastErrorString) );
+		strlcpy( sDefaultSession.mLastErrorString, "Unknown error.", sizeof(sDefaultSession.mLastErrorString) );
 	}
 }
 
 
 extern "C" void	LEOAddStringConstants( struct TStringConstantEntry* inEntries )
 {
-	gLEOLastErrorString[0] = 0;
-	gLEOLastErrorOffset = SIZE_MAX;
-	gLEOLastErrorLineNum = SIZE_MAX;
+	sDefaultSession.mLastErrorString[0] = 0;
+	sDefaultSession.mLastErrorOffset = SIZE_MAX;
+	sDefaultSession.mLastErrorLineNum = SIZE_MAX;
 	
 	try
 	{
@@ -677,26 +898,26 @@ extern "C" void	LEOAddStringConstants( struct TStringConstantEntry* inEntries )
 	}
 	catch( CForgeParseError& ferr )
 	{
-		strlcpy( gLEOLastErrorString, ferr.what(), sizeof(gLEOLastErrorString) );
-		gLEOLastErrorLineNum = ferr.GetLineNum();
-		gLEOLastErrorOffset = ferr.GetOffset();
+		strlcpy( sDefaultSession.mLastErrorString, ferr.what(), sizeof(sDefaultSession.mLastErrorString) );
+		sDefaultSession.mLastErrorLineNum = ferr.GetLineNum();
+		sDefaultSession.mLastErrorOffset = ferr.GetOffset();
 	}
 	catch( std::exception& err )
 	{
-		strlcpy( gLEOLastErrorString, err.what(), sizeof(gLEOLastErrorString) );
+		strlcpy( sDefaultSession.mLastErrorString, err.what(), sizeof(sDefaultSession.mLastErrorString) );
 	}
 	catch( ... )
 	{
-		strlcpy( gLEOLastErrorString, "Unknown error.", sizeof(gLEOLastErrorString) );
+		strlcpy( sDefaultSession.mLastErrorString, "Unknown error.", sizeof(sDefaultSession.mLastErrorString) );
 	}
 }
 
 
 extern "C" void	LEOAddNumberConstants( struct TNumberConstantEntry* inEntries )
 {
-	gLEOLastErrorString[0] = 0;
-	gLEOLastErrorOffset = SIZE_MAX;
-	gLEOLastErrorLineNum = SIZE_MAX;
+	sDefaultSession.mLastErrorString[0] = 0;
+	sDefaultSession.mLastErrorOffset = SIZE_MAX;
+	sDefaultSession.mLastErrorLineNum = SIZE_MAX;
 	
 	try
 	{
@@ -704,26 +925,26 @@ extern "C" void	LEOAddNumberConstants( struct TNumberConstantEntry* inEntries )
 	}
 	catch( CForgeParseError& ferr )
 	{
-		strlcpy( gLEOLastErrorString, ferr.what(), sizeof(gLEOLastErrorString) );
-		gLEOLastErrorLineNum = ferr.GetLineNum();
-		gLEOLastErrorOffset = ferr.GetOffset();
+		strlcpy( sDefaultSession.mLastErrorString, ferr.what(), sizeof(sDefaultSession.mLastErrorString) );
+		sDefaultSession.mLastErrorLineNum = ferr.GetLineNum();
+		sDefaultSession.mLastErrorOffset = ferr.GetOffset();
 	}
 	catch( std::exception& err )
 	{
-		strlcpy( gLEOLastErrorString, err.what(), sizeof(gLEOLastErrorString) );
+		strlcpy( sDefaultSession.mLastErrorString, err.what(), sizeof(sDefaultSession.mLastErrorString) );
 	}
 	catch( ... )
 	{
-		strlcpy( gLEOLastErrorString, "Unknown error.", sizeof(gLEOLastErrorString) );
+		strlcpy( sDefaultSession.mLastErrorString, "Unknown error.", sizeof(sDefaultSession.mLastErrorString) );
 	}
 }
 
 
 extern "C" void	LEOAddBuiltInVariables( struct TBuiltInVariableEntry* inEntries )
 {
-	gLEOLastErrorString[0] = 0;
-	gLEOLastErrorOffset = SIZE_MAX;
-	gLEOLastErrorLineNum = SIZE_MAX;
+	sDefaultSession.mLastErrorString[0] = 0;
+	sDefaultSession.mLastErrorOffset = SIZE_MAX;
+	sDefaultSession.mLastErrorLineNum = SIZE_MAX;
 	
 	try
 	{
@@ -731,26 +952,26 @@ extern "C" void	LEOAddBuiltInVariables( struct TBuiltInVariableEntry* inEntries
 	}
 	catch( CForgeParseError& ferr )
 	{
-		strlcpy( gLEOLastErrorString, ferr.what(), sizeof(gLEOLastErrorString) );
-		gLEOLastErrorLineNum = ferr.GetLineNum();
-		gLEOLastErrorOffset = ferr.GetOffset();
+		strlcpy( sDefaultSession.mLastErrorString, ferr.what(), sizeof(sDefaultSession.mLastErrorString) );
+		sDefaultSession.mLastErrorLineNum = ferr.GetLineNum();
+		sDefaultSession.mLastErrorOffset = ferr.GetOffset();
 	}
 	catch( std::exception& err )
 	{
-		strlcpy( gLEOLastErrorString, err.what(), sizeof(gLEOLastErrorString) );
+		strlcpy( sDefaultSession.mLastErrorString, err.what(), sizeof(sDefaultSession.mLastErrorString) );
 	}
 	catch( ... )
 	{
-		strlcpy( gLEOLastErrorString, "Unknown error.", sizeof(gLEOLastErrorString) );
+		strlcpy( sDefaultSession.mLastErrorString, "Unknown error.", sizeof(sDefaultSession.mLastErrorString) );
 	}
 }
 
 
 extern "C" void	LEOLoadNativeHeadersFromFile( const char* filepath )
 {
-	gLEOLastErrorString[0] = 0;
-	gLEOLastErrorOffset = SIZE_MAX;
-	gLEOLastErrorLineNum = SIZE_MAX;
+	sDefaultSession.mLastErrorString[0] = 0;
+	sDefaultSession.mLastErrorOffset = SIZE_MAX;
+	sDefaultSession.mLastErrorLineNum = SIZE_MAX;
 	
 	try
 	{
@@ -758,17 +979,38 @@ extern "C" void	LEOLoadNativeHeadersFromFile( const char* filepath )
 	}
 	catch( CForgeParseError& ferr )
 	{
-		strlcpy( gLEOLastErrorString, ferr.what(), sizeof(gLEOLastErrorString) );
-		gLEOLastErrorLineNum = ferr.GetLineNum();
-		gLEOLastErrorOffset = ferr.GetOffset();
+		strlcpy( sDefaultSession.mLastErrorString, ferr.what(), sizeof(sDefaultSession.mLastErrorString) );
+		sDefaultSession.mLastErrorLineNum = ferr.GetLineNum();
+		sDefaultSession.mLastErrorOffset = ferr.GetOffset();
 	}
 	catch( std::exception& err )
 	{
-		strlcpy( gLEOLastErrorString, err.what(), sizeof(gLEOLastErrorString) );
+		strlcpy( sDefaultSession.mLastErrorString, err.what(), sizeof(sDefaultSession.mLastErrorString) );
 	}
 	catch( ... )
 	{
-		strlcpy( gLEOLastErrorString, "Unknown error.", sizeof(gLEOLastErrorString) );
+		strlcpy( sDefaultSession.mLastErrorString, "Unknown error.", sizeof(sDefaultSession.mLastErrorString) );
+	}
+}
+
+
+extern "C" void	LEOCompileNativeHeadersFile( const char* inHeadersPath, const char* inIndexPath )
+{
+	sDefaultSession.mLastErrorString[0] = 0;
+	sDefaultSession.mLastErrorOffset = SIZE_MAX;
+	sDefaultSession.mLastErrorLineNum = SIZE_MAX;
+	
+	try
+	{
+		CParser::CompileNativeHeadersFile( inHeadersPath, inIndexPath );
+	}
+	catch( std::exception& err )
+	{
+		strlcpy( sDefaultSession.mLastErrorString, err.what(), sizeof(sDefaultSession.mLastErrorString) );
+	}
+	catch( ... )
+	{
+		strlcpy( sDefaultSession.mLastErrorString, "Unknown error.", sizeof(sDefaultSession.mLastErrorString) );
 	}
 }
 
@@ -779,30 +1021,55 @@ extern "C" void	LEOSetFirstNativeCallCallback( LEOFirstNativeCallCallbackPtr inC
 }
 
 
-extern "C" void	LEOParserGetNonFatalErrorMessageAtIndex( size_t inIndex, const char** outErrMsg, size_t *outLineNum, size_t *outOffset, TMessageType *outType )
+extern "C" void	LEOSetShortCircuitBooleanOperators( bool inShortCircuit )
+{
+	COperatorNode::SetShortCircuitBooleanOperators( inShortCircuit );
+}
+
+
+extern "C" void	LEOSetKeepLineMarkersInDeadCode( bool inKeepLineMarkers )
+{
+	sKeepLineMarkersInDeadCode = inKeepLineMarkers;
+	sDefaultSession.mKeepLineMarkersInDeadCode = inKeepLineMarkers;
+}
+
+
+extern "C" void	LEOCompileSessionGetNonFatalErrorMessageAtIndex( LEOCompileSession* inSession, size_t inIndex, const char** outErrMsg, size_t *outLineNum, size_t *outOffset, TMessageType *outType )
 {
-	if( inIndex >= gMessages.size() )
+	if( inIndex >= inSession->mMessages.size() )
 	{
 		*outErrMsg = NULL;
 		return;
 	}
 	
-	*outErrMsg = gMessages[inIndex].mMessage.c_str();
-	*outLineNum = gMessages[inIndex].mLineNum;
-	*outOffset = gMessages[inIndex].mOffset;
-	*outType = gMessages[inIndex].mType;
+	*outErrMsg = inSession->mMessages[inIndex].mMessage.c_str();
+	*outLineNum = inSession->mMessages[inIndex].mLineNum;
+	*outOffset = inSession->mMessages[inIndex].mOffset;
+	*outType = inSession->mMessages[inIndex].mType;
 }
 
 
-extern "C" void	LEOParserGetHandlerNoteAtIndex( size_t inIndex, const char** outHandlerName, const char** outNote )
+extern "C" void	LEOCompileSessionGetHandlerNoteAtIndex( LEOCompileSession* inSession, size_t inIndex, const char** outHandlerName, const char** outNote )
 {
-	if( inIndex >= gHandlerNotes.size() )
+	if( inIndex >= inSession->mHandlerNotes.size() )
 	{
 		*outHandlerName = NULL;
 		return;
 	}
 	
-	*outHandlerName = gHandlerNotes[inIndex].mHandlerName.c_str();
-	*outNote = gHandlerNotes[inIndex].mNotes.c_str();
+	*outHandlerName = inSession->mHandlerNotes[inIndex].mHandlerName.c_str();
+	*outNote = inSession->mHandlerNotes[inIndex].mNotes.c_str();
+}
+
+
+extern "C" void	LEOParserGetNonFatalErrorMessageAtIndex( size_t inIndex, const char** outErrMsg, size_t *outLineNum, size_t *outOffset, TMessageType *outType )
+{
+	LEOCompileSessionGetNonFatalErrorMessageAtIndex( &sDefaultSession, inIndex, outErrMsg, outLineNum, outOffset, outType );
+}
+
+
+extern "C" void	LEOParserGetHandlerNoteAtIndex( size_t inIndex, const char** outHandlerName, const char** outNote )
+{
+	LEOCompileSessionGetHandlerNoteAtIndex( &sDefaultSession, inIndex, outHandlerName, outNote );
 }
 
@@ -56,9 +56,23 @@ extern "C" {
 typedef struct LEOParseTree	LEOParseTree;
 
 
+/*! LEOTokenList is a private, internal data structure holding a script's text
+	split up into tokens. Script editors can keep one around and update it as the
+	user edits, instead of having the whole script re-tokenized on every keystroke. */
+typedef struct LEOTokenList	LEOTokenList;
+
+
 typedef struct LEODisplayInfoTable LEODisplayInfoTable;
 
 
+/*! LEOCompileSession is a private, internal data structure that holds the errors,
+	non-fatal messages and handler notes resulting from parsing and compiling a script.
+	The calls that don't take a session all share one default session, so only one
+	thread may use those at a time. If you want to compile scripts on several threads
+	at once, give each thread its own session. */
+typedef struct LEOCompileSession	LEOCompileSession;
+
+
 struct TGlobalPropertyEntry;
 struct THostCommandEntry;
 
@@ -86,6 +100,26 @@ LEOParseTree*	LEOParseTreeCreateFromUTF8Characters( const char* inCode, size_t c
 	@seealso //leo_ref/c/func/LEOCleanUpParseTree	LEOCleanUpParseTree */
 LEOParseTree*	LEOParseTreeCreateForCommandOrExpressionFromUTF8Characters( const char* inCode, size_t codeLength, uint16_t inFileID );
 
+
+/*! Split the given script text specified by <tt>inCode</tt> and <tt>codeLength</tt> into tokens. Call <tt>LEOTokenListUpdateForEdit</tt> whenever the text changes, and <tt>LEOParseTreeCreateFromTokenList</tt> to parse it. Once you are done with the token list, call <tt>LEOCleanUpTokenList</tt> to free the memory associated with it.
+	@seealso //leo_ref/c/func/LEOTokenListUpdateForEdit	LEOTokenListUpdateForEdit
+	@seealso //leo_ref/c/func/LEOParseTreeCreateFromTokenList	LEOParseTreeCreateFromTokenList
+	@seealso //leo_ref/c/func/LEOCleanUpTokenList	LEOCleanUpTokenList */
+LEOTokenList*	LEOTokenListCreateFromUTF8Characters( const char* inCode, size_t codeLength );
+
+/*! Update a token list after <tt>inRemovedLength</tt> bytes at <tt>inEditOffset</tt> in its script text were replaced with <tt>inInsertedLength</tt> new bytes. <tt>inCode</tt> and <tt>codeLength</tt> are the complete script text <em>after</em> the edit. Only the tokens from the start of the edited line up to where the tokens after the edit are the same as before are tokenized again, the tokens after that are just moved.
+	@seealso //leo_ref/c/func/LEOTokenListCreateFromUTF8Characters	LEOTokenListCreateFromUTF8Characters */
+void			LEOTokenListUpdateForEdit( LEOTokenList* inTokens, const char* inCode, size_t codeLength, size_t inEditOffset, size_t inRemovedLength, size_t inInsertedLength );
+
+/*! Like <tt>LEOParseTreeCreateFromUTF8Characters</tt>, but parses the tokens in the given token list. <tt>inCode</tt> must be the script text the token list is currently up to date with.
+	@seealso //leo_ref/c/func/LEOParseTreeCreateFromUTF8Characters	LEOParseTreeCreateFromUTF8Characters
+	@seealso //leo_ref/c/func/LEOTokenListCreateFromUTF8Characters	LEOTokenListCreateFromUTF8Characters */
+LEOParseTree*	LEOParseTreeCreateFromTokenList( LEOTokenList* inTokens, const char* inCode, uint16_t inFileID );
+
+/*! Free the memory for a token list created by <tt>LEOTokenListCreateFromUTF8Characters</tt>.
+	@seealso //leo_ref/c/func/LEOTokenListCreateFromUTF8Characters	LEOTokenListCreateFromUTF8Characters */
+void			LEOCleanUpTokenList( LEOTokenList* inTokens );
+
 /*! Free the memory for a parse tree created by <tt>LEOParseTreeCreateFromUTF8Characters</tt> or <tt>LEOParseTreeCreateForCommandOrExpressionFromUTF8Characters</tt>.
 	@seealso //leo_ref/c/func/LEOParseTreeCreateFromUTF8Characters	LEOParseTreeCreateFromUTF8Characters
 	@seealso //leo_ref/c/func/LEOParseTreeCreateForCommandOrExpressionFromUTF8Characters	LEOParseTreeCreateForCommandOrExpressionFromUTF8Characters */
@@ -259,16 +293,89 @@ void	LEOAddBuiltInVariables( struct TBuiltInVariableEntry* inEntries );
 
 
 /*! Load syntax for 'native calls' (i.e. native operating system APIs as you would call them from C, Objective C, C# or Pascal) from the specified .hhc header file, so the functions and methods in it become available to the parser as if they were handlers (just that they can return pointers and you might have to manage memory handed into or returned from them).
+	You can also pass the path of an index created using <tt>LEOCompileNativeHeadersFile</tt>, which will be mapped into memory instead of being read and parsed.
+	If the .hhc file starts with a directory (as written by the forge tool's <tt>--lazynativeheaders</tt> option), only the directory is read right away, and each framework's declarations are loaded the first time a script uses one of them.
 	@seealso //leo_ref/c/func/LEOSetFirstNativeCallCallback	LEOSetFirstNativeCallCallback
+	@seealso //leo_ref/c/func/LEOCompileNativeHeadersFile	LEOCompileNativeHeadersFile
 */
 void	LEOLoadNativeHeadersFromFile( const char* filepath );
 
 
+/*! Turn the .hhc header file at <tt>inHeadersPath</tt> into an index at <tt>inIndexPath</tt>. Loading the index using <tt>LEOLoadNativeHeadersFromFile</tt> takes next to no time, and all processes that load it share its memory. Do this as part of your build, indexes are specific to the version of Forge and kind of CPU that made them.
+	@seealso //leo_ref/c/func/LEOLoadNativeHeadersFromFile	LEOLoadNativeHeadersFromFile
+*/
+void	LEOCompileNativeHeadersFile( const char* inHeadersPath, const char* inIndexPath );
+
+
 /*! Since loading the headers for 'native calls' (i.e. native operating system APIs as you would call them from C, Objective C, C# or Pascal) may take a while, this callback is provided, which gets called the first time Forge needs to parse a native call, so you can lazily load the headers only when a script actually uses native calls and not incur the overhead otherwise.
 	@seealso //leo_ref/c/func/LEOLoadNativeHeadersFromFile	LEOLoadNativeHeadersFromFile
 */
 void	LEOSetFirstNativeCallCallback( LEOFirstNativeCallCallbackPtr inCallback );
 
+
+/*! Pass <tt>true</tt> to have the "and" and "or" operators only evaluate their right side if the left side doesn't already decide the result, e.g. so <tt>if x is not empty and expensiveCheck(x)</tt> doesn't call <tt>expensiveCheck</tt> when <tt>x</tt> is empty. This is off by default, as existing scripts may rely on handlers on the right side always being called. Only affects scripts compiled after you change it.
+*/
+void	LEOSetShortCircuitBooleanOperators( bool inShortCircuit );
+
+
+/*! Pass <tt>true</tt> if you are going to run scripts in a debugger. Forge removes code that can never run, like the body of an <tt>if false</tt> or the commands after a <tt>return</tt>. This makes it leave the line markers of that code behind, so the debugger still sees every line of the script. This is off by default. This sets it for the calls that don't take a compile session, and for sessions you create afterwards.
+	@seealso //leo_ref/c/func/LEOCompileSessionSetKeepLineMarkersInDeadCode	LEOCompileSessionSetKeepLineMarkersInDeadCode
+*/
+void	LEOSetKeepLineMarkersInDeadCode( bool inKeepLineMarkers );
+
+
+// -----------------------------------------------------------------------------
+//	Compile sessions:
+// -----------------------------------------------------------------------------
+
+/*! Create a new compile session. Each of the ...InSession calls below works like the call of the same
+	name without the suffix, but records its errors, non-fatal messages and handler notes in the given session
+	instead of the shared default session. Different threads may use different sessions at the same time,
+	but register all operators, host commands etc. before you start compiling. Once you are done with the
+	session, call <tt>LEOCleanUpCompileSession</tt> to free the memory associated with it.
+	@seealso //leo_ref/c/func/LEOCleanUpCompileSession	LEOCleanUpCompileSession */
+LEOCompileSession*	LEOCompileSessionCreate( void );
+
+/*! Free the memory for a compile session created by <tt>LEOCompileSessionCreate</tt>. Any strings you got from
+	the session are freed along with it.
+	@seealso //leo_ref/c/func/LEOCompileSessionCreate	LEOCompileSessionCreate */
+void			LEOCleanUpCompileSession( LEOCompileSession* inSession );
+
+/*! Pass <tt>true</tt> to have <tt>LEOParseTreeCreateFromUTF8CharactersInSession</tt> tokenize the script while
+	parsing it and only keep the last few hundred tokens in memory, instead of keeping a compact list of all tokens.
+	This saves a little more memory on very large scripts. The parser can't back up further than the tokens
+	it kept, so an unusual script may fail to parse this way that would parse fine otherwise. Off by default.
+	@seealso //leo_ref/c/func/LEOCompileSessionCreate	LEOCompileSessionCreate */
+void			LEOCompileSessionSetTokenizeWhileParsing( LEOCompileSession* inSession, bool inTokenizeWhileParsing );
+
+/*! Like <tt>LEOSetKeepLineMarkersInDeadCode</tt>, but only for the scripts compiled using <tt>inSession</tt>, so you
+	can e.g. keep the line markers only for the scripts you are about to debug. New sessions start out with whatever
+	was last passed to <tt>LEOSetKeepLineMarkersInDeadCode</tt>.
+	@seealso //leo_ref/c/func/LEOSetKeepLineMarkersInDeadCode	LEOSetKeepLineMarkersInDeadCode */
+void			LEOCompileSessionSetKeepLineMarkersInDeadCode( LEOCompileSession* inSession, bool inKeepLineMarkers );
+
+LEOParseTree*	LEOParseTreeCreateFromUTF8CharactersInSession( LEOCompileSession* inSession, const char* inCode, size_t codeLength, uint16_t inFileID );
+LEOParseTree*	LEOParseTreeCreateForCommandOrExpressionFromUTF8CharactersInSession( LEOCompileSession* inSession, const char* inCode, size_t codeLength, uint16_t inFileID );
+LEOTokenList*	LEOTokenListCreateFromUTF8CharactersInSession( LEOCompileSession* inSession, const char* inCode, size_t codeLength );
+void			LEOTokenListUpdateForEditInSession( LEOCompileSession* inSession, LEOTokenList* inTokens, const char* inCode, size_t codeLength, size_t inEditOffset, size_t inRemovedLength, size_t inInsertedLength );
+LEOParseTree*	LEOParseTreeCreateFromTokenListInSession( LEOCompileSession* inSession, LEOTokenList* inTokens, const char* inCode, uint16_t inFileID );
+void			LEOScriptCompileAndAddParseTreeInSession( LEOCompileSession* inSession, LEOScript* inScript, LEOContextGroup* inGroup, LEOParseTree* inTree, uint16_t inFileID );
+
+/*! Like <tt>LEOParserGetLastErrorMessage</tt>, but returns the error from the last call made with this session. */
+const char*		LEOCompileSessionGetLastErrorMessage( LEOCompileSession* inSession );
+
+/*! Like <tt>LEOParserGetLastErrorLineNum</tt>, but for the last call made with this session. */
+size_t			LEOCompileSessionGetLastErrorLineNum( LEOCompileSession* inSession );
+
+/*! Like <tt>LEOParserGetLastErrorOffset</tt>, but for the last call made with this session. */
+size_t			LEOCompileSessionGetLastErrorOffset( LEOCompileSession* inSession );
+
+/*! Like <tt>LEOParserGetNonFatalErrorMessageAtIndex</tt>, but for the last script parsed with this session. */
+void			LEOCompileSessionGetNonFatalErrorMessageAtIndex( LEOCompileSession* inSession, size_t inIndex, const char** outErrMsg, size_t *outLineNum, size_t *outOffset, TMessageType *outType );
+
+/*! Like <tt>LEOParserGetHandlerNoteAtIndex</tt>, but for the last script parsed with this session. */
+void			LEOCompileSessionGetHandlerNoteAtIndex( LEOCompileSession* inSession, size_t inIndex, const char** outHandlerName, const char** outNote );
+
 #if __cplusplus
 }
 #endif
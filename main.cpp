@@ -1,7 +1,9 @@
 #include <iostream>
 #include <stdexcept>
 #include "CToken.h"
+#include "CTokenCursor.h"
 #include "CParser.h"
+#include "CIncludeCache.h"
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <time.h>
@@ -20,10 +22,27 @@ extern "C" {
 #include "CConcatOperatorNodeTransformation.h"
 #include "CConcatSpaceOperatorNodeTransformation.h"
 #include "CChunkPropertyNodeTransformation.h"
+#include "CConstantFoldingNodeTransformation.h"
+#include "CDeadCodeNodeTransformation.h"
+#include "COperatorNode.h"
+#include "CFunctionCallNode.h"
 #include "LEOMsgInstructionsGeneric.h"
 
 #include <fstream>
+#include <sstream>
+#include <chrono>
+#include <algorithm>
+#include <regex>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <random>
 #include "AnsiFiles.h"
+#if __APPLE__
+#include <mach-o/dyld.h>
+#include <limits.h>
+#endif
 
 
 using namespace Carlson;
@@ -66,6 +85,8 @@ struct ForgeToolOptions
 	bool			printTokens = false;
 	bool			printParseTree = false;
 	bool			printOptimizedParseTree = false;
+	bool			printPassStatistics = false;
+	bool			printShortCircuitStatistics = false;
 	bool			printIndented = false;
 	bool			verbose = false;
 	bool			doOptimize = true;
@@ -74,16 +95,75 @@ struct ForgeToolOptions
 	bool			webPageEmbedMode = false;
 	const char*		debuggerHost = NULL;
 	const char*		messageName = nullptr;
+	long			tokenizerBenchmarkIterations = 0;	// If > 0, only tokenize each file this many times and report how long that took.
+	bool			checkTokenizer = false;				// Only check that tokenizing each file in parallel gives the same tokens as tokenizing it serially.
+	bool			checkParser = false;				// Only check that parsing each file in parallel gives the same results as parsing it serially.
+	long			constantFoldingCheckCount = 0;		// If > 0, only check that this many random constant expressions give the same result with and without constant folding.
+	long			numJobs = 1;						// How many files of a --folder build to process at the same time.
+	bool			incrementalBuild = false;			// Skip web pages whose manifest says nothing they depend on changed.
+	std::string		buildOptionsHash;					// Fingerprint of this tool and the options that change what a page builds, for incremental builds.
 	int				argc = 0;
 	char * const *	argv = nullptr;
 	int				fnameIdx = 0;
 	bool			postbuild = false;	// Ignore passed arc/argv and instead pass the resources as parameters.
 	std::vector<ForgeToolResourceEntry>	resources;
 	std::vector<ForgeToolSummaryEntry>	summaries;
+	size_t			numShortCircuitOperators = 0;		// Totals of all files processed so far, for --printshortcircuit.
+	size_t			numShortCircuitHandlerCalls = 0;
 };
 
 
 int	ProcessOneScriptFile( const std::string& inFilePathString, ForgeToolOptions& toolOptions );
+int	ProcessScriptFilesInParallel( const std::vector<std::string>& inFilePaths, ForgeToolOptions& toolOptions );
+int	CheckConstantFolding( ForgeToolOptions& toolOptions );
+static std::string	GetBuildOptionsHash( const ForgeToolOptions& toolOptions );
+static void	PrintShortCircuitStatistics( const char* inLabel, size_t numOperators, size_t numSkippableHandlerCalls, std::ostream& destStream );
+void	AddResourceEntryIfUnique( const ForgeToolResourceEntry& inResourceToAdd, ForgeToolOptions& toolOptions );
+
+
+// We install these in std::cout (which Leonie also uses for message output)
+//	and std::cerr. They forward to whatever buffer the current thread asked
+//	for, so scripts that are run at the same time can each capture their own
+//	output:
+class ForgeToolPerThreadStreamBuf : public std::streambuf
+{
+public:
+	enum
+	{
+		EConsoleOutput = 0,
+		EConsoleError,
+		EConsole_Count
+	};
+	
+	ForgeToolPerThreadStreamBuf( std::streambuf* inDefaultBuf, int inConsole ) : mDefaultBuf(inDefaultBuf), mConsole(inConsole) {}
+	
+	std::streambuf*			GetThreadBuf()							{ return sThreadBufs[mConsole]; }
+	void					SetThreadBuf( std::streambuf* inBuf )	{ sThreadBufs[mConsole] = inBuf; }	// NULL means write to the default buffer.
+	
+protected:
+	std::streambuf*			GetTargetBuf()	{ return sThreadBufs[mConsole] ? sThreadBufs[mConsole] : mDefaultBuf; }
+	
+	virtual int_type		overflow( int_type inChar ) override
+	{
+		if( traits_type::eq_int_type( inChar, traits_type::eof() ) )
+			return traits_type::not_eof( inChar );
+		return GetTargetBuf()->sputc( traits_type::to_char_type( inChar ) );
+	}
+	virtual std::streamsize	xsputn( const char* inChars, std::streamsize inCount ) override	{ return GetTargetBuf()->sputn( inChars, inCount ); }
+	virtual int				sync() override													{ return GetTargetBuf()->pubsync(); }
+	
+	std::streambuf*						mDefaultBuf;
+	int									mConsole;
+	static thread_local std::streambuf*	sThreadBufs[EConsole_Count];
+};
+
+
+thread_local std::streambuf*	ForgeToolPerThreadStreamBuf::sThreadBufs[EConsole_Count] = {};
+
+static ForgeToolPerThreadStreamBuf*	sConsoleOutputBuf = NULL;
+static ForgeToolPerThreadStreamBuf*	sConsoleErrorBuf = NULL;
+
+static std::mutex				sLeonieGlobalsLock;	// Leonie's list of file names is shared by all scripts we compile, so we take turns generating code.
 
 
 static bool GetFileContents( const std::string& fname, std::vector<char>& outFileContents )
@@ -93,7 +173,7 @@ static bool GetFileContents( const std::string& fname, std::vector<char>& outFil
 	if( !theFile )
 	{
 		char theWD[1024];
-		printf("ERROR: Can't open file \"%s/%s\".\n", getcwd(theWD, sizeof(theWD)), fname.c_str());
+		std::cout << "ERROR: Can't open file \"" << getcwd(theWD, sizeof(theWD)) << "/" << fname << "\"." << std::endl;
 		return false;
 	}
 	
@@ -110,7 +190,7 @@ static bool GetFileContents( const std::string& fname, std::vector<char>& outFil
 	{
 		fclose( theFile );
 		char theWD[1024];
-		printf("ERROR: Couldn't read from file \"%s/%s\" (%ld bytes read).\n", getcwd(theWD, sizeof(theWD)), fname.c_str(),readbytes);
+		std::cout << "ERROR: Couldn't read from file \"" << getcwd(theWD, sizeof(theWD)) << "/" << fname << "\" (" << readbytes << " bytes read)." << std::endl;
 		return false;
 	}
 	outFileContents[len] = 0;	// Terminate string.
@@ -135,6 +215,9 @@ int main( int argc, char * const argv[] )
 #endif
 	
 	bool		fnameIsFolder = false;
+	bool		rebuildAll = false;
+	const char*	nativeHeadersIndexPath = NULL;
+	const char*	lazyNativeHeadersPath = NULL;
 	for( int x = 1; x < argc; )
 	{
 		if( argv[x][0] == PARAM_INDICATOR)
@@ -170,6 +253,14 @@ int main( int argc, char * const argv[] )
 			{
 				toolOptions.printOptimizedParseTree = true;
 			}
+			else if( strcmp( argv[x], PARAM_PREFIX "printpasses" ) == 0 )
+			{
+				toolOptions.printPassStatistics = true;
+			}
+			else if( strcmp( argv[x], PARAM_PREFIX "printshortcircuit" ) == 0 )
+			{
+				toolOptions.printShortCircuitStatistics = true;
+			}
 			else if( strcmp( argv[x], PARAM_PREFIX "printindented" ) == 0 )
 			{
 				toolOptions.printIndented = true;
@@ -196,8 +287,87 @@ int main( int argc, char * const argv[] )
 				toolOptions.messageName = argv[x+1];
 				x++;
 			}
+			else if( strcmp( argv[x], PARAM_PREFIX "checktokenizer" ) == 0 )
+			{
+				toolOptions.checkTokenizer = true;
+			}
+			else if( strcmp( argv[x], PARAM_PREFIX "checkparser" ) == 0 )
+			{
+				toolOptions.checkParser = true;
+			}
+			else if( strcmp( argv[x], PARAM_PREFIX "checkconstantfolding" ) == 0 )
+			{
+				if( (argc -1) < (x +1) )	// No parameter after checkconstantfolding option?
+				{
+					std::cerr << "Error: Expected expression count after " PARAM_PREFIX "checkconstantfolding option." << std::endl;
+					return 11;
+				}
+				toolOptions.constantFoldingCheckCount = strtol( argv[x+1], NULL, 10 );
+				if( toolOptions.constantFoldingCheckCount <= 0 )
+				{
+					std::cerr << "Error: Expression count after " PARAM_PREFIX "checkconstantfolding option must be a positive number." << std::endl;
+					return 11;
+				}
+				x++;
+			}
+			else if( strcmp( argv[x], PARAM_PREFIX "benchmarktokenizer" ) == 0 )
+			{
+				if( (argc -1) < (x +1) )	// No parameter after benchmark option?
+				{
+					std::cerr << "Error: Expected iteration count after " PARAM_PREFIX "benchmarktokenizer option." << std::endl;
+					return 8;
+				}
+				toolOptions.tokenizerBenchmarkIterations = strtol( argv[x+1], NULL, 10 );
+				if( toolOptions.tokenizerBenchmarkIterations <= 0 )
+				{
+					std::cerr << "Error: Iteration count after " PARAM_PREFIX "benchmarktokenizer option must be a positive number." << std::endl;
+					return 8;
+				}
+				x++;
+			}
+			else if( strcmp( argv[x], PARAM_PREFIX "jobs" ) == 0 )
+			{
+				if( (argc -1) < (x +1) )	// No parameter after jobs option?
+				{
+					std::cerr << "Error: Expected number of jobs after " PARAM_PREFIX "jobs option." << std::endl;
+					return 9;
+				}
+				toolOptions.numJobs = strtol( argv[x+1], NULL, 10 );
+				if( toolOptions.numJobs < 0 )
+				{
+					std::cerr << "Error: Number of jobs after " PARAM_PREFIX "jobs option must not be negative." << std::endl;
+					return 9;
+				}
+				if( toolOptions.numJobs == 0 )
+					toolOptions.numJobs = std::max<unsigned>( std::thread::hardware_concurrency(), 1 );
+				x++;
+			}
+			else if( strcmp( argv[x], PARAM_PREFIX "compilenativeheaders" ) == 0 )
+			{
+				if( (argc -1) < (x +1) )	// No parameter after compilenativeheaders option?
+				{
+					std::cerr << "Error: Expected index file path after " PARAM_PREFIX "compilenativeheaders option." << std::endl;
+					return 10;
+				}
+				nativeHeadersIndexPath = argv[x+1];
+				x++;
+			}
+			else if( strcmp( argv[x], PARAM_PREFIX "lazynativeheaders" ) == 0 )
+			{
+				if( (argc -1) < (x +1) )	// No parameter after lazynativeheaders option?
+				{
+					std::cerr << "Error: Expected output file path after " PARAM_PREFIX "lazynativeheaders option." << std::endl;
+					return 10;
+				}
+				lazyNativeHeadersPath = argv[x+1];
+				x++;
+			}
+			else if( strcmp( argv[x], PARAM_PREFIX "rebuild" ) == 0 )
+				rebuildAll = true;
 			else if( strcmp( argv[x], PARAM_PREFIX "dont-optimize" ) == 0 )
 				toolOptions.doOptimize = false;
+			else if( strcmp( argv[x], PARAM_PREFIX "shortcircuit" ) == 0 )
+				COperatorNode::SetShortCircuitBooleanOperators( true );
 			else if( strcmp( argv[x], PARAM_PREFIX "folder" ) == 0 )
 				fnameIsFolder = true;
 			else if( strcmp( argv[x], PARAM_PREFIX "webpage" ) == 0 )
@@ -217,6 +387,28 @@ int main( int argc, char * const argv[] )
 		x++;
 	}
 	
+	if( nativeHeadersIndexPath || lazyNativeHeadersPath )
+	{
+		if( toolOptions.fnameIdx == 0 )
+		{
+			std::cerr << "Error: Expected the path of a .hhc file to compile." << std::endl;
+			return 10;
+		}
+		try
+		{
+			if( nativeHeadersIndexPath )
+				CParser::CompileNativeHeadersFile( argv[toolOptions.fnameIdx], nativeHeadersIndexPath );
+			if( lazyNativeHeadersPath )
+				CParser::AddDirectoryToNativeHeadersFile( argv[toolOptions.fnameIdx], lazyNativeHeadersPath );
+		}
+		catch( std::exception& err )
+		{
+			std::cerr << err.what() << std::endl;
+			return 10;
+		}
+		return EXIT_SUCCESS;
+	}
+	
 	if( toolOptions.messageName == nullptr )
 	{
 		if( toolOptions.webPageEmbedMode )
@@ -232,6 +424,10 @@ int main( int argc, char * const argv[] )
 		CConcatOperatorNodeTransformation::Initialize();
 		CConcatSpaceOperatorNodeTransformation::Initialize();
 		CChunkPropertyNodeTransformation::Initialize();
+		CConstantFoldingNodeTransformation::Initialize();
+		CDeadIfNodeTransformation::Initialize();
+		CDeadWhileLoopNodeTransformation::Initialize();
+		CUnreachableCodePass::Initialize();
 	}
 	
 	LEOAddInstructionsToInstructionArray( gMsgInstructions, LEO_NUMBER_OF_MSG_INSTRUCTIONS, &kFirstMsgInstruction );
@@ -253,9 +449,24 @@ int main( int argc, char * const argv[] )
 		LEOAddBuiltInVariables( gBuiltInVariables );
 	}
 
+	// Never deleted, as std::cout and std::cerr still get flushed after we return:
+	sConsoleOutputBuf = new ForgeToolPerThreadStreamBuf( std::cout.rdbuf(), ForgeToolPerThreadStreamBuf::EConsoleOutput );
+	std::cout.rdbuf( sConsoleOutputBuf );
+	sConsoleErrorBuf = new ForgeToolPerThreadStreamBuf( std::cerr.rdbuf(), ForgeToolPerThreadStreamBuf::EConsoleError );
+	std::cerr.rdbuf( sConsoleErrorBuf );
+	gLEOMsgOutputStream = &std::cout;
+	
+	if( toolOptions.constantFoldingCheckCount > 0 )
+		return CheckConstantFolding( toolOptions );
+	
 	char*	filename = (toolOptions.fnameIdx > 0) ? argv[toolOptions.fnameIdx] : NULL;
 	if( filename && fnameIsFolder )
 	{
+		toolOptions.incrementalBuild = toolOptions.webPageEmbedMode && toolOptions.runCode && !rebuildAll;
+		if( toolOptions.incrementalBuild )
+			toolOptions.buildOptionsHash = GetBuildOptionsHash( toolOptions );
+		
+		std::vector<std::string>		filePaths;
 		filesystem::directory_iterator	currFile(filename);
 		for( ; currFile != filesystem::directory_iterator(); ++currFile )
 		{
@@ -266,12 +477,28 @@ int main( int argc, char * const argv[] )
 			if( fname.rfind(".hc") != fname.length() -3 )
 				continue;
 			
-			int errNum = ProcessOneScriptFile( (*currFile).path().string(), toolOptions );
+			filePaths.push_back( (*currFile).path().string() );
+		}
+		
+		if( toolOptions.numJobs > 1 && !toolOptions.debuggerOn )
+		{
+			int errNum = ProcessScriptFilesInParallel( filePaths, toolOptions );
 			if( errNum != EXIT_SUCCESS )
 			{
 				return errNum;
 			}
 		}
+		else
+		{
+			for( const std::string& currPath : filePaths )
+			{
+				int errNum = ProcessOneScriptFile( currPath, toolOptions );
+				if( errNum != EXIT_SUCCESS )
+				{
+					return errNum;
+				}
+			}
+		}
 		
 		if( toolOptions.webPageEmbedMode )
 		{
@@ -286,6 +513,9 @@ int main( int argc, char * const argv[] )
 				}
 			}
 		}
+		
+		if( toolOptions.printShortCircuitStatistics )
+			PrintShortCircuitStatistics( "short-circuit total", toolOptions.numShortCircuitOperators, toolOptions.numShortCircuitHandlerCalls, std::cout );
 	}
 	else if( filename )
 	{
@@ -314,6 +544,713 @@ void	AddResourceEntryIfUnique( const ForgeToolResourceEntry& inResourceToAdd, Fo
 }
 
 
+// One file of a --folder build that ProcessScriptFilesInParallel() processes:
+struct ForgeToolJob
+{
+	ForgeToolJob( const std::string& inFilePath, const ForgeToolOptions& inToolOptions )
+		: mFilePath(inFilePath), mToolOptions(inToolOptions), mResult(EXIT_SUCCESS), mFinished(false)
+	{
+		mToolOptions.resources.clear();	// Only collect what this file adds, we merge them in order later.
+		mToolOptions.summaries.clear();
+		mToolOptions.numShortCircuitOperators = 0;
+		mToolOptions.numShortCircuitHandlerCalls = 0;
+	}
+	
+	std::string			mFilePath;
+	ForgeToolOptions	mToolOptions;
+	std::stringstream	mOutput;		// Everything processing this file printed to std::cout.
+	std::stringstream	mErrorOutput;	// Everything processing this file printed to std::cerr.
+	int					mResult;
+	bool				mFinished;
+};
+
+
+int	ProcessScriptFilesInParallel( const std::vector<std::string>& inFilePaths, ForgeToolOptions& toolOptions )
+{
+	std::deque<ForgeToolJob>	jobs;
+	for( const std::string& currPath : inFilePaths )
+		jobs.emplace_back( currPath, toolOptions );
+	
+	std::mutex				jobsLock;
+	std::condition_variable	jobFinishedCondition;
+	std::atomic<size_t>		nextJob(0);
+	std::atomic<bool>		hadError(false);
+	auto	processJobs = [&]()
+	{
+		size_t	jobIndex = 0;
+		// Jobs get started in order, so when one fails all jobs before it still finish:
+		while( !hadError && (jobIndex = nextJob++) < jobs.size() )
+		{
+			ForgeToolJob&	currJob = jobs[jobIndex];
+			sConsoleOutputBuf->SetThreadBuf( currJob.mOutput.rdbuf() );
+			sConsoleErrorBuf->SetThreadBuf( currJob.mErrorOutput.rdbuf() );
+			int	result = ProcessOneScriptFile( currJob.mFilePath, currJob.mToolOptions );
+			sConsoleOutputBuf->SetThreadBuf( NULL );
+			sConsoleErrorBuf->SetThreadBuf( NULL );
+			if( result != EXIT_SUCCESS )
+				hadError = true;
+			
+			std::lock_guard<std::mutex>	lock( jobsLock );
+			currJob.mResult = result;
+			currJob.mFinished = true;
+			jobFinishedCondition.notify_all();
+		}
+	};
+	std::vector<std::thread>	workers;
+	for( long x = 0; x < toolOptions.numJobs; x++ )
+		workers.push_back( std::thread( processJobs ) );
+	
+	// Print each file's output and collect its resources and summaries in
+	//	the same order as a serial build, as soon as it is done:
+	int		errNum = EXIT_SUCCESS;
+	for( ForgeToolJob& currJob : jobs )
+	{
+		{
+			std::unique_lock<std::mutex>	lock( jobsLock );
+			jobFinishedCondition.wait( lock, [&currJob](){ return currJob.mFinished; } );
+		}
+		
+		std::cout << currJob.mOutput.str() << std::flush;
+		std::cerr << currJob.mErrorOutput.str() << std::flush;
+		for( const ForgeToolResourceEntry& currResource : currJob.mToolOptions.resources )
+			AddResourceEntryIfUnique( currResource, toolOptions );
+		toolOptions.summaries.insert( toolOptions.summaries.end(), currJob.mToolOptions.summaries.begin(), currJob.mToolOptions.summaries.end() );
+		toolOptions.numShortCircuitOperators += currJob.mToolOptions.numShortCircuitOperators;
+		toolOptions.numShortCircuitHandlerCalls += currJob.mToolOptions.numShortCircuitHandlerCalls;
+		
+		if( currJob.mResult != EXIT_SUCCESS )
+		{
+			errNum = currJob.mResult;
+			break;
+		}
+	}
+	
+	for( std::thread& currWorker : workers )
+		currWorker.join();
+	
+	return errNum;
+}
+
+
+static size_t	WalkTokens( CTokenCursor& inCursor, const std::string& inFilePathString )
+{
+	size_t			numTokens = 0;
+	CTokenIterator	tokenItty = inCursor.begin();
+	while( tokenItty != inCursor.end() )
+	{
+		++numTokens;
+		CTokenizer::GoNextToken( inFilePathString.c_str(), tokenItty, inCursor );
+	}
+	return numTokens;
+}
+
+
+int	BenchmarkTokenizer( const std::string& inFilePathString, const std::vector<char>& code, ForgeToolOptions& toolOptions )
+{
+	size_t	numTokens = 0;
+	try
+	{
+		auto	startTime = std::chrono::steady_clock::now();
+		for( long x = 0; x < toolOptions.tokenizerBenchmarkIterations; x++ )
+		{
+			std::deque<CToken>	tokens = CTokenizer::TokenListFromText( code.data(), code.size(), toolOptions.webPageEmbedMode );
+			CDequeTokenCursor	cursor( tokens );
+			numTokens = WalkTokens( cursor, inFilePathString );
+		}
+		auto	dequeElapsed = std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now() - startTime );
+		
+		startTime = std::chrono::steady_clock::now();
+		for( long x = 0; x < toolOptions.tokenizerBenchmarkIterations; x++ )
+		{
+			CStreamingTokenCursor	cursor( code.data(), code.size(), toolOptions.webPageEmbedMode );
+			WalkTokens( cursor, inFilePathString );
+		}
+		auto	streamingElapsed = std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now() - startTime );
+		
+		startTime = std::chrono::steady_clock::now();
+		for( long x = 0; x < toolOptions.tokenizerBenchmarkIterations; x++ )
+		{
+			std::deque<CToken>	tokens = CTokenizer::TokenListFromTextInParallel( code.data(), code.size(), toolOptions.webPageEmbedMode );
+		}
+		auto	parallelElapsed = std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now() - startTime );
+		
+		std::cout << inFilePathString << ": " << (code.size() -1) << " bytes, " << numTokens << " tokens, "
+			<< toolOptions.tokenizerBenchmarkIterations << " iterations in " << dequeElapsed.count() << " us ("
+			<< (dequeElapsed.count() / (double)toolOptions.tokenizerBenchmarkIterations) << " us per iteration), streaming "
+			<< streamingElapsed.count() << " us (" << (streamingElapsed.count() / (double)toolOptions.tokenizerBenchmarkIterations)
+			<< " us per iteration), parallel " << parallelElapsed.count() << " us ("
+			<< (parallelElapsed.count() / (double)toolOptions.tokenizerBenchmarkIterations) << " us per iteration)." << std::endl;
+	}
+	catch( std::exception& err )
+	{
+		std::cerr << err.what() << std::endl;
+		return 3;
+	}
+	
+	return EXIT_SUCCESS;
+}
+
+
+static bool	TokensAreIdentical( const CToken& inToken, const CToken& inOtherToken )
+{
+	return inToken.mType == inOtherToken.mType && inToken.mSubType == inOtherToken.mSubType
+		&& inToken.mOffset == inOtherToken.mOffset && inToken.mLineNum == inOtherToken.mLineNum
+		&& inToken.mStringValue == inOtherToken.mStringValue && inToken.mNumberValue == inOtherToken.mNumberValue
+		&& inToken.mComment == inOtherToken.mComment;
+}
+
+
+int	CheckParallelTokenizer( const std::string& inFilePathString, const std::vector<char>& code, ForgeToolOptions& toolOptions )
+{
+	std::deque<CToken>	serialTokens = CTokenizer::TokenListFromText( code.data(), code.size(), toolOptions.webPageEmbedMode );
+	size_t				numLines = std::count( code.begin(), code.end(), '\n' );
+	
+	// Our test scripts are small, so split them up much more than we normally would:
+	for( size_t numChunks : { (size_t)2, (size_t)4, (size_t)16, numLines } )
+	{
+		std::deque<CToken>	parallelTokens = CTokenizer::TokenListFromTextInParallel( code.data(), code.size(), toolOptions.webPageEmbedMode, numChunks );
+		for( size_t x = 0; x < std::max( serialTokens.size(), parallelTokens.size() ); x++ )
+		{
+			if( x >= serialTokens.size() || x >= parallelTokens.size() || !TokensAreIdentical( serialTokens[x], parallelTokens[x] ) )
+			{
+				std::cerr << inFilePathString << ": error: Token " << x << " differs when tokenizing in " << numChunks << " chunks: "
+					<< ((x < serialTokens.size()) ? serialTokens[x].GetDescription() : "<none>") << " vs. "
+					<< ((x < parallelTokens.size()) ? parallelTokens[x].GetDescription() : "<none>") << std::endl;
+				return 3;
+			}
+		}
+	}
+	
+	std::cout << inFilePathString << ": " << serialTokens.size() << " tokens, parallel tokenizer OK." << std::endl;
+	
+	return EXIT_SUCCESS;
+}
+
+
+// Temp variables and download blocks get numbered names that depend on what
+//	was parsed before and on how a script was split up, so ignore the numbers:
+static std::string	GetParseTreeDescription( CParseTree& inTree )
+{
+	std::stringstream	description;
+	inTree.DebugPrint( description, 1 );
+	return std::regex_replace( description.str(), std::regex( "(temp|::downloadProgress:|::downloadCompletion:)[0-9]+" ), "$1#" );
+}
+
+
+static bool	MessagesAreIdentical( const std::vector<CMessageEntry>& inMessages, const std::vector<CMessageEntry>& inOtherMessages )
+{
+	if( inMessages.size() != inOtherMessages.size() )
+		return false;
+	for( size_t x = 0; x < inMessages.size(); x++ )
+	{
+		if( inMessages[x].mType != inOtherMessages[x].mType || inMessages[x].mMessage != inOtherMessages[x].mMessage
+			|| inMessages[x].mFileName != inOtherMessages[x].mFileName || inMessages[x].mLineNum != inOtherMessages[x].mLineNum
+			|| inMessages[x].mOffset != inOtherMessages[x].mOffset )
+			return false;
+	}
+	return true;
+}
+
+
+static bool	HandlerNotesAreIdentical( const std::vector<CHandlerNotesEntry>& inNotes, const std::vector<CHandlerNotesEntry>& inOtherNotes )
+{
+	if( inNotes.size() != inOtherNotes.size() )
+		return false;
+	for( size_t x = 0; x < inNotes.size(); x++ )
+	{
+		if( inNotes[x].mHandlerName != inOtherNotes[x].mHandlerName || inNotes[x].mNotes != inOtherNotes[x].mNotes )
+			return false;
+	}
+	return true;
+}
+
+
+int	CheckParallelParser( const std::string& inFilePathString, const std::vector<char>& code, ForgeToolOptions& toolOptions )
+{
+	std::deque<CToken>	tokens = CTokenizer::TokenListFromText( code.data(), code.size(), toolOptions.webPageEmbedMode );
+	CParser				serialParser;
+	CParseTree			serialParseTree;
+	std::string			serialError;
+	try
+	{
+		serialParser.Parse( inFilePathString.c_str(), tokens, serialParseTree, code.data() );
+	}
+	catch( std::exception& err )
+	{
+		serialError = err.what();
+	}
+	std::string			serialDescription = GetParseTreeDescription( serialParseTree );
+	
+	// Our test scripts are small, so split them up much more than we normally would:
+	for( size_t numBatches : { (size_t)2, (size_t)4, (size_t)16, tokens.size() } )
+	{
+		CParser		parallelParser;
+		CParseTree	parallelParseTree;
+		std::string	parallelError;
+		parallelParser.SetParseInParallel( true, numBatches );
+		try
+		{
+			parallelParser.Parse( inFilePathString.c_str(), tokens, parallelParseTree, code.data() );
+		}
+		catch( std::exception& err )
+		{
+			parallelError = err.what();
+		}
+		
+		const char*	difference = NULL;
+		if( parallelError != serialError )
+			difference = "Error";
+		else if( !MessagesAreIdentical( serialParser.GetMessages(), parallelParser.GetMessages() ) )
+			difference = "Messages";
+		else if( !HandlerNotesAreIdentical( serialParser.GetHandlerNotes(), parallelParser.GetHandlerNotes() ) )
+			difference = "Handler notes";
+		else if( GetParseTreeDescription( parallelParseTree ) != serialDescription )
+			difference = "Parse tree";
+		if( difference )
+		{
+			std::cerr << inFilePathString << ": error: " << difference << " differs when parsing in " << numBatches << " batches." << std::endl;
+			return 3;
+		}
+	}
+	
+	// Also parse through the other kinds of CTokenCursor, keeping as few tokens around as we can:
+	auto	differenceWithCursor = [&]( CTokenCursor& inTokens ) -> const char*
+	{
+		CParser		cursorParser;
+		CParseTree	cursorParseTree;
+		std::string	cursorError;
+		try
+		{
+			cursorParser.Parse( inFilePathString.c_str(), inTokens, cursorParseTree, code.data() );
+		}
+		catch( std::exception& err )
+		{
+			cursorError = err.what();
+		}
+		
+		if( cursorError != serialError )
+			return "Error";
+		else if( !MessagesAreIdentical( serialParser.GetMessages(), cursorParser.GetMessages() ) )
+			return "Messages";
+		else if( !HandlerNotesAreIdentical( serialParser.GetHandlerNotes(), cursorParser.GetHandlerNotes() ) )
+			return "Handler notes";
+		else if( GetParseTreeDescription( cursorParseTree ) != serialDescription )
+			return "Parse tree";
+		return NULL;
+	};
+	CCompactTokenList	compactTokens( code.data(), code.size(), toolOptions.webPageEmbedMode );
+	for( size_t windowSize : { (size_t)4, (size_t)CStreamingTokenCursor::kDefaultWindowSize } )
+	{
+		CStreamingTokenCursor	streamingTokens( code.data(), code.size(), toolOptions.webPageEmbedMode, windowSize );
+		const char*				difference = differenceWithCursor( streamingTokens );
+		if( difference )
+		{
+			std::cerr << inFilePathString << ": error: " << difference << " differs when tokenizing while parsing with a window of " << windowSize << " tokens." << std::endl;
+			return 3;
+		}
+		
+		CCompactTokenCursor		compactCursor( compactTokens, windowSize );
+		difference = differenceWithCursor( compactCursor );
+		if( difference )
+		{
+			std::cerr << inFilePathString << ": error: " << difference << " differs when parsing compact tokens with a window of " << windowSize << " tokens." << std::endl;
+			return 3;
+		}
+	}
+	
+	std::cout << inFilePathString << ": " << serialParser.GetHandlerNotes().size() << " handlers, parallel parser OK." << std::endl;
+	
+	return EXIT_SUCCESS;
+}
+
+
+// Builds a random expression out of number and boolean constants and the
+//	operators CConstantFoldingNodeTransformation folds:
+static std::string	RandomConstantExpression( std::mt19937& ioRandom, int inDepth )
+{
+	static const char*				sNumbers[] = { "0", "1", "2", "3", "7", "10", "255", "65536", "0.5", "1.25", "3.75", "1000000.5",
+													"2147483647", "2147483648", "4611686018427387904", "9223372036854775807" };	// Last few are close to the integer limits.
+	static const char*				sOperators[] = { "+", "-", "*", "/", "mod", "^", "=", "is not", "<", "<=", ">", ">=", "and", "or" };
+	static const TIdentifierSubtype	sUnitIdentifiers[] =
+	{
+		#define X4(constName,stringSuffix,identifierSubtype,unitGroup)	identifierSubtype,
+		LEO_UNITS
+		#undef X4
+	};
+	const size_t	numNumbers = sizeof(sNumbers) / sizeof(sNumbers[0]);
+	const size_t	numOperators = sizeof(sOperators) / sizeof(sOperators[0]);
+	const size_t	numUnits = sizeof(sUnitIdentifiers) / sizeof(sUnitIdentifiers[0]);	// The first one is kLEOUnitNone.
+	
+	if( inDepth <= 0 || (ioRandom() % 4) == 0 )
+	{
+		switch( ioRandom() % 5 )
+		{
+			case 0:
+				return (ioRandom() % 2) ? "true" : "false";
+			case 1:
+				if( numUnits > 1 )
+					return std::string( sNumbers[ioRandom() % numNumbers] ) + " " + gIdentifierStrings[sUnitIdentifiers[1 + (ioRandom() % (numUnits -1))]];
+				// No units? Fall through to a plain number:
+			default:
+				return sNumbers[ioRandom() % numNumbers];
+		}
+	}
+	
+	switch( ioRandom() % 6 )
+	{
+		case 0:
+			return "-(" + RandomConstantExpression( ioRandom, inDepth -1 ) + ")";
+		case 1:
+			return "not (" + RandomConstantExpression( ioRandom, inDepth -1 ) + ")";
+		default:
+		{
+			std::string	leftOperand = RandomConstantExpression( ioRandom, inDepth -1 );
+			std::string	rightOperand = RandomConstantExpression( ioRandom, inDepth -1 );
+			return "(" + leftOperand + ") " + sOperators[ioRandom() % numOperators] + " (" + rightOperand + ")";
+		}
+	}
+}
+
+
+// Compiles and runs inScript's startUp handler, returning its result, or the error it failed with:
+static std::string	GetConstantFoldingCheckResult( const std::string& inScript, bool inSimplify, size_t& outNumNodesChanged )
+{
+	std::vector<char>	code( inScript.begin(), inScript.end() );
+	code.push_back( 0 );
+	const char*			fileName = "checkconstantfolding.hc";
+	CParseTree			parseTree;
+	try
+	{
+		std::deque<CToken>	tokens = CTokenizer::TokenListFromText( code.data(), code.size() -1 );
+		CParser				parser;
+		parser.Parse( fileName, tokens, parseTree, code.data() );
+		if( inSimplify )
+		{
+			parseTree.Simplify();
+			for( const std::pair<const std::string,CParseTreePassRecord>& currRecord : parseTree.GetPassRecords() )
+				outNumNodesChanged += currRecord.second.mNumNodesChanged;
+		}
+	}
+	catch( std::exception& err )
+	{
+		return std::string("parse error: ") + err.what();
+	}
+	
+	LEOScript		*	script = LEOScriptCreateForOwner( 0, 0, NULL );
+	LEOContextGroup	*	group = LEOContextGroupCreate( NULL, NULL );
+	{
+		CCodeBlock		block( group, script, LEOFileIDForFileName( fileName ) );
+		parseTree.GenerateCode( &block );
+	}
+	
+	std::string		result;
+	LEOHandlerID	handlerID = LEOContextGroupHandlerIDForHandlerName( group, "startUp" );
+	LEOHandler*		theHandler = LEOScriptFindCommandHandlerWithID( script, handlerID );
+	if( theHandler == NULL )
+		result = "error: No startUp handler.";
+	else
+	{
+		LEOContext	*	ctx = LEOContextCreate( group, NULL, NULL );
+		LEOPushUnsetValueOnStack( ctx );	// Reserve space for return value.
+		LEOPushIntegerOnStack( ctx, 0, kLEOUnitNone );	// Parameter count.
+		LEOContextPushHandlerScriptReturnAddressAndBasePtr( ctx, theHandler, script, NULL, NULL );
+		LEORunInContext( theHandler->instructions, ctx );
+		if( ctx->errMsg[0] != 0 )
+			result = std::string("error: ") + ctx->errMsg;
+		else
+		{
+			LEOCleanUpStackToPtr( ctx, ctx->stackEndPtr -1 );	// Remove parameter count.
+			char		str[256] = {};
+			result = LEOGetValueAsString( ctx->stack, str, sizeof(str), ctx );
+		}
+		LEOContextRelease( ctx );
+	}
+	
+	LEOScriptRelease( script );
+	LEOContextGroupRelease( group );
+	
+	return result;
+}
+
+
+int	CheckConstantFolding( ForgeToolOptions& toolOptions )
+{
+	if( !toolOptions.doOptimize )
+	{
+		std::cerr << "Error: The " PARAM_PREFIX "checkconstantfolding option can't be combined with " PARAM_PREFIX "dont-optimize." << std::endl;
+		return 11;
+	}
+	
+	std::mt19937	random( 1 );	// Generate the same expressions each time, so failures can be reproduced.
+	size_t			numNodesChanged = 0;
+	for( long x = 0; x < toolOptions.constantFoldingCheckCount; x++ )
+	{
+		std::string	expression = RandomConstantExpression( random, 4 );
+		std::string	script = "on startUp\n\treturn " + expression + "\nend startUp\n";
+		std::string	unfoldedResult = GetConstantFoldingCheckResult( script, false, numNodesChanged );
+		std::string	foldedResult = GetConstantFoldingCheckResult( script, true, numNodesChanged );
+		if( foldedResult != unfoldedResult )
+		{
+			std::cerr << "error: " << expression << " gives \"" << foldedResult << "\" when folded, but \"" << unfoldedResult << "\" when not." << std::endl;
+			return 3;
+		}
+	}
+	
+	std::cout << toolOptions.constantFoldingCheckCount << " expressions, " << numNodesChanged << " nodes simplified, constant folding OK." << std::endl;
+	
+	return EXIT_SUCCESS;
+}
+
+
+static void	PrintShortCircuitStatistics( const char* inLabel, size_t numOperators, size_t numSkippableHandlerCalls, std::ostream& destStream )
+{
+	destStream << inLabel << ": " << numOperators << " and/or operator(s), " << numSkippableHandlerCalls << " with a handler call on the right side, "
+				<< (COperatorNode::GetShortCircuitBooleanOperators() ? "short-circuited" : "not short-circuited (use " PARAM_PREFIX "shortcircuit)") << std::endl;
+}
+
+
+// Counts the "and"s and "or"s in inTree, and how many of them call a handler
+//	on their right side that short-circuiting skips whenever the left side
+//	already decides the result, and adds them to the totals in ioToolOptions:
+static void	PrintShortCircuitStatistics( CParseTree& inTree, ForgeToolOptions& ioToolOptions, std::ostream& destStream )
+{
+	size_t	numOperators = 0;
+	size_t	numSkippableHandlerCalls = 0;
+	inTree.Visit( [&numOperators,&numSkippableHandlerCalls]( CNode* inNode )
+	{
+		COperatorNode*	operatorNode = dynamic_cast<COperatorNode*>( inNode );
+		if( !operatorNode || !operatorNode->CanShortCircuit() )
+			return;
+		numOperators++;
+		bool	callsHandler = false;
+		operatorNode->GetParamAtIndex(1)->Visit( [&callsHandler]( CNode* inRightSideNode )
+		{
+			if( dynamic_cast<CFunctionCallNode*>( inRightSideNode ) != NULL )
+				callsHandler = true;
+		} );
+		if( callsHandler )
+			numSkippableHandlerCalls++;
+	} );
+	
+	PrintShortCircuitStatistics( "short-circuit", numOperators, numSkippableHandlerCalls, destStream );
+	ioToolOptions.numShortCircuitOperators += numOperators;
+	ioToolOptions.numShortCircuitHandlerCalls += numSkippableHandlerCalls;
+}
+
+
+// What building one page of an incremental --folder --webpage build
+//	depended on and produced, so we can skip it next time if none of its
+//	files changed:
+struct ForgeToolPageManifest
+{
+	std::string											mSourceHash;
+	std::string											mOptionsHash;	// ForgeToolOptions::buildOptionsHash the page was built with.
+	std::vector<std::pair<std::string,std::string>>		mIncludes;		// Path and hash of each file the page pulled in using "use".
+	std::string											mOutputFile;	// Empty if the page didn't write a file.
+	std::vector<ForgeToolResourceEntry>					mResources;
+	std::vector<ForgeToolSummaryEntry>					mSummaries;
+};
+
+
+static std::string	GetContentsHash( const char* inData, size_t inLength )
+{
+	std::stringstream	hashStr;
+	hashStr << std::hex << HashFileContents( inData, inLength );
+	return hashStr.str();
+}
+
+
+static bool	GetFileHash( const std::string& inFilePath, std::string& outHash )
+{
+	std::ifstream	theFile( inFilePath, std::ios::in | std::ios::binary );
+	if( !theFile )
+		return false;
+	
+	std::stringstream	contents;
+	contents << theFile.rdbuf();
+	std::string			contentsStr( contents.str() );
+	outHash = GetContentsHash( contentsStr.data(), contentsStr.size() );
+	
+	return true;
+}
+
+
+// The include handler resolves the name after a "use" statement relative to the including file:
+static std::string	GetIncludePath( const std::string& inFileName, const std::string& inRelativeToFileName )
+{
+	std::string includePath;
+	size_t namestart = inRelativeToFileName.find_last_of('/');
+	if( namestart == std::string::npos )
+		namestart = 0;
+	includePath = inRelativeToFileName.substr( 0, namestart );
+	if( namestart != 0 )
+		includePath.append(1,'/');
+	includePath.append(inFileName);
+	
+	return includePath;
+}
+
+
+// Manifests live in a hidden folder next to the scripts, so --folder doesn't try to run them:
+static std::string	GetManifestPath( const std::string& inFilePathString )
+{
+	size_t		namestart = inFilePathString.find_last_of('/');
+	std::string	manifestPath;
+	if( namestart == std::string::npos )
+		namestart = 0;
+	else
+		manifestPath = inFilePathString.substr( 0, ++namestart );
+	manifestPath.append( ".forgemanifests/" );
+	manifestPath.append( inFilePathString.substr( namestart ) );
+	manifestPath.append( ".manifest" );
+	
+	return manifestPath;
+}
+
+
+// Manifests are tab-separated lines, so escape anything that would break those up:
+static std::string	EscapeManifestField( const std::string& inString )
+{
+	std::string		escapedString;
+	for( char currCh : inString )
+	{
+		switch( currCh )
+		{
+			case '\\':	escapedString.append( "\\\\" );	break;
+			case '\t':	escapedString.append( "\\t" );	break;
+			case '\n':	escapedString.append( "\\n" );	break;
+			case '\r':	escapedString.append( "\\r" );	break;
+			default:	escapedString.append( 1, currCh );
+		}
+	}
+	return escapedString;
+}
+
+
+static std::vector<std::string>	SplitManifestLine( const std::string& inLine )
+{
+	std::vector<std::string>	fields( 1 );
+	for( size_t x = 0; x < inLine.size(); x++ )
+	{
+		if( inLine[x] == '\t' )
+			fields.push_back( std::string() );
+		else if( inLine[x] == '\\' && (x +1) < inLine.size() )
+		{
+			char	escapedCh = inLine[++x];
+			fields.back().append( 1, (escapedCh == 't') ? '\t' : (escapedCh == 'n') ? '\n' : (escapedCh == 'r') ? '\r' : escapedCh );
+		}
+		else
+			fields.back().append( 1, inLine[x] );
+	}
+	return fields;
+}
+
+
+static bool	ReadPageManifest( const std::string& inManifestPath, ForgeToolPageManifest& outManifest )
+{
+	std::ifstream	manifestFile( inManifestPath );
+	std::string		currLine;
+	if( !std::getline( manifestFile, currLine ) || currLine != "forgemanifest\t1" )
+		return false;
+	
+	while( std::getline( manifestFile, currLine ) )
+	{
+		std::vector<std::string>	fields = SplitManifestLine( currLine );
+		if( fields[0] == "source" && fields.size() == 2 )
+			outManifest.mSourceHash = fields[1];
+		else if( fields[0] == "options" && fields.size() == 2 )
+			outManifest.mOptionsHash = fields[1];
+		else if( fields[0] == "use" && fields.size() == 3 )
+			outManifest.mIncludes.push_back( std::make_pair( fields[1], fields[2] ) );
+		else if( fields[0] == "output" && fields.size() == 2 )
+			outManifest.mOutputFile = fields[1];
+		else if( fields[0] == "resource" && fields.size() == 3 )
+			outManifest.mResources.push_back( ForgeToolResourceEntry( fields[1], fields[2] ) );
+		else if( fields[0] == "summary" && fields.size() == 5 )
+			outManifest.mSummaries.push_back( ForgeToolSummaryEntry( fields[1], fields[2], fields[3], fields[4] ) );
+		else
+			return false;	// Written by a different version? Just rebuild.
+	}
+	
+	return outManifest.mSourceHash.length() > 0;
+}
+
+
+static bool	WritePageManifest( const std::string& inManifestPath, const ForgeToolPageManifest& inManifest )
+{
+	filesystem::create_directories( filesystem::path(inManifestPath).parent_path() );
+	
+	std::ofstream	manifestFile( inManifestPath );
+	manifestFile << "forgemanifest\t1" << std::endl;
+	manifestFile << "source\t" << inManifest.mSourceHash << std::endl;
+	manifestFile << "options\t" << inManifest.mOptionsHash << std::endl;
+	for( const std::pair<std::string,std::string>& currInclude : inManifest.mIncludes )
+		manifestFile << "use\t" << EscapeManifestField( currInclude.first ) << "\t" << currInclude.second << std::endl;
+	if( inManifest.mOutputFile.length() > 0 )
+		manifestFile << "output\t" << EscapeManifestField( inManifest.mOutputFile ) << std::endl;
+	for( const ForgeToolResourceEntry& currResource : inManifest.mResources )
+		manifestFile << "resource\t" << EscapeManifestField( currResource.mSourceFile ) << "\t" << EscapeManifestField( currResource.mDestFile ) << std::endl;
+	for( const ForgeToolSummaryEntry& currSummary : inManifest.mSummaries )
+		manifestFile << "summary\t" << EscapeManifestField( currSummary.mFileName ) << "\t" << EscapeManifestField( currSummary.mSummary )
+					<< "\t" << EscapeManifestField( currSummary.mModified ) << "\t" << EscapeManifestField( currSummary.mCreated ) << std::endl;
+	
+	return manifestFile.good();
+}
+
+
+static bool	PageManifestIsUpToDate( const ForgeToolPageManifest& inManifest, const std::string& inSourceHash, const std::string& inOptionsHash )
+{
+	if( inManifest.mSourceHash != inSourceHash || inManifest.mOptionsHash != inOptionsHash )
+		return false;
+	if( inManifest.mOutputFile.length() > 0 && !filesystem::exists( filesystem::path(inManifest.mOutputFile) ) )
+		return false;
+	for( const std::pair<std::string,std::string>& currInclude : inManifest.mIncludes )
+	{
+		std::string		includeHash;
+		if( !GetFileHash( currInclude.first, includeHash ) || includeHash != currInclude.second )
+			return false;
+	}
+	
+	return true;
+}
+
+
+// Where the running forge tool's executable is, so we can tell when it changed:
+static std::string	GetToolExecutablePath( const char* inArgv0 )
+{
+#if __APPLE__
+	char		path[PATH_MAX] = {};
+	uint32_t	pathSize = sizeof(path);
+	if( _NSGetExecutablePath( path, &pathSize ) == 0 )
+		return path;
+#elif __linux__
+	return "/proc/self/exe";
+#endif
+	return inArgv0;
+}
+
+
+// Anything besides a page's own files that changes what building it produces.
+//	A page whose manifest has a different hash than this is rebuilt:
+static std::string	GetBuildOptionsHash( const ForgeToolOptions& toolOptions )
+{
+	std::string		toolHash;
+	if( !GetFileHash( GetToolExecutablePath( toolOptions.argv[0] ), toolHash ) )
+		toolHash = __DATE__ " " __TIME__;	// Can't read our executable? Use when this file was compiled instead.
+	
+	std::stringstream	options;
+	options << "tool\t" << toolHash << "\n"
+			<< "optimize\t" << toolOptions.doOptimize << "\n"
+			<< "shortcircuit\t" << COperatorNode::GetShortCircuitBooleanOperators() << "\n"
+			<< "message\t" << EscapeManifestField( toolOptions.messageName ) << "\n";
+	for( int x = toolOptions.fnameIdx +1; x < toolOptions.argc; x++ )
+		options << "arg\t" << EscapeManifestField( toolOptions.argv[x] ) << "\n";
+	
+	std::string		optionsStr( options.str() );
+	return GetContentsHash( optionsStr.data(), optionsStr.size() );
+}
+
+
 int	ProcessOneScriptFile( const std::string& inFilePathString, ForgeToolOptions& toolOptions )
 {
 	// Do actual work:
@@ -323,34 +1260,55 @@ int	ProcessOneScriptFile( const std::string& inFilePathString, ForgeToolOptions&
 		std::cerr << "error: Couldn't find file \"" << inFilePathString << "\"." << std::endl;
 		return 2;
 	}
+	
+	if( toolOptions.tokenizerBenchmarkIterations > 0 )
+		return BenchmarkTokenizer( inFilePathString, code, toolOptions );
+	if( toolOptions.checkTokenizer )
+		return CheckParallelTokenizer( inFilePathString, code, toolOptions );
+	if( toolOptions.checkParser )
+		return CheckParallelParser( inFilePathString, code, toolOptions );
+
+	// Nothing this page depends on changed since we last built it? Just replay what it produced:
+	bool					writeManifest = toolOptions.incrementalBuild && !toolOptions.postbuild;
+	ForgeToolPageManifest	pageManifest;
+	if( writeManifest )
+	{
+		std::string				sourceHash = GetContentsHash( code.data(), code.size() -1 );	// Minus terminator GetFileContents() added.
+		ForgeToolPageManifest	oldManifest;
+		if( ReadPageManifest( GetManifestPath( inFilePathString ), oldManifest ) && PageManifestIsUpToDate( oldManifest, sourceHash, toolOptions.buildOptionsHash ) )
+		{
+			if( toolOptions.verbose )
+				std::cout << "Unchanged file: " << inFilePathString << std::endl;
+			for( const ForgeToolResourceEntry& currResource : oldManifest.mResources )
+				AddResourceEntryIfUnique( currResource, toolOptions );
+			toolOptions.summaries.insert( toolOptions.summaries.end(), oldManifest.mSummaries.begin(), oldManifest.mSummaries.end() );
+			return EXIT_SUCCESS;
+		}
+		pageManifest.mSourceHash = sourceHash;
+		pageManifest.mOptionsHash = toolOptions.buildOptionsHash;
+	}
+	bool					pageRanSuccessfully = false;
 
 	std::deque<CToken>	tokens;
 	CParser				parser;
 	parser.SetWebPageEmbedMode(toolOptions.webPageEmbedMode);
+	parser.SetParseInParallel( true );
 	if( toolOptions.webPageEmbedMode )
 	{
 		parser.SetIncludeHandler([](const std::string& inFileName, const std::string& inRelativeToFileName, std::vector<char>&outContents)
 		{
-			std::string includePath;
-			size_t namestart = inRelativeToFileName.find_last_of('/');
-			if( namestart == std::string::npos )
-				namestart = 0;
-			includePath = inRelativeToFileName.substr( 0, namestart );
-			if( namestart != 0 )
-				includePath.append(1,'/');
-			includePath.append(inFileName);
-			
-			return GetFileContents( includePath, outContents );
+			return GetFileContents( GetIncludePath( inFileName, inRelativeToFileName ), outContents );
 		});
 	}
 	
 	try
 	{
 		CParseTree				parseTree;
+		parseTree.SetKeepLineMarkersInDeadCode( toolOptions.debuggerOn );	// So the debugger still sees every line.
 		
 		if( toolOptions.verbose )
 			std::cout << "Tokenizing file \"" << inFilePathString << "\"..." << std::endl;
-		tokens = CTokenizer::TokenListFromText( code.data(), code.size(), toolOptions.webPageEmbedMode );
+		tokens = CTokenizer::TokenListFromTextInParallel( code.data(), code.size(), toolOptions.webPageEmbedMode );
 		if( toolOptions.printTokens )
 		{
 			for( std::deque<CToken>::iterator currToken = tokens.begin(); currToken != tokens.end(); currToken++ )
@@ -414,6 +1372,7 @@ int	ProcessOneScriptFile( const std::string& inFilePathString, ForgeToolOptions&
 			}
 		}
 		
+		std::unique_lock<std::mutex>	leonieGlobalsLock( sLeonieGlobalsLock );
 		uint16_t 			fileID = LEOFileIDForFileName(inFilePathString.c_str());
 		LEOScript		*	script = LEOScriptCreateForOwner( 0, 0, NULL );
 		LEOContextGroup	*	group = LEOContextGroupCreate( NULL, NULL );
@@ -421,10 +1380,17 @@ int	ProcessOneScriptFile( const std::string& inFilePathString, ForgeToolOptions&
 		
 		parseTree.Simplify();
 		
+		if( toolOptions.printPassStatistics )
+			parseTree.PrintPassStatistics( std::cout );
+		
+		if( toolOptions.printShortCircuitStatistics )
+			PrintShortCircuitStatistics( parseTree, toolOptions, std::cout );
+		
 		if( toolOptions.printOptimizedParseTree )
 			parseTree.DebugPrint( std::cout, 1 );
 
-		parseTree.GenerateCode( &block );
+		parseTree.GenerateCodeInParallel( &block );
+		leonieGlobalsLock.unlock();
 		
 		if( toolOptions.printInstructions )
 			LEODebugPrintScript( group, script );
@@ -432,13 +1398,9 @@ int	ProcessOneScriptFile( const std::string& inFilePathString, ForgeToolOptions&
 		if( toolOptions.runCode )
 		{
 			std::stringstream	capturedOutput;
-			if( toolOptions.webPageEmbedMode && !toolOptions.postbuild )
-			{
-				gLEOMsgOutputStream = &capturedOutput;
-			}
 			
 			if( toolOptions.verbose )
-				printf( "\nRun the code:\n" );
+				std::cout << "\nRun the code:" << std::endl;
 			
 			const char*		handlerName = toolOptions.postbuild ? "buildEnded" : toolOptions.messageName;
 			LEOHandlerID	handlerID = LEOContextGroupHandlerIDForHandlerName( group, handlerName );
@@ -446,7 +1408,7 @@ int	ProcessOneScriptFile( const std::string& inFilePathString, ForgeToolOptions&
 			
 			if( theHandler == NULL )
 			{
-				printf( "ERROR: Could not find handler \"%s\" to run!", handlerName );
+				std::cout << "ERROR: Could not find handler \"" << handlerName << "\" to run!" << std::flush;
 			}
 			else
 			{
@@ -518,31 +1480,39 @@ int	ProcessOneScriptFile( const std::string& inFilePathString, ForgeToolOptions&
 				}
 				
 				LEOContextPushHandlerScriptReturnAddressAndBasePtr( ctx, theHandler, script, NULL, NULL );	// NULL return address is same as exit to top. basePtr is set to NULL as well on exit.
+				std::streambuf*		outputBuf = sConsoleOutputBuf->GetThreadBuf();
+				if( toolOptions.webPageEmbedMode && !toolOptions.postbuild )
+				{
+					sConsoleOutputBuf->SetThreadBuf( capturedOutput.rdbuf() );
+				}
 				LEORunInContext( theHandler->instructions, ctx );
+				sConsoleOutputBuf->SetThreadBuf( outputBuf );
 				if( ctx->errMsg[0] != 0 )
-					printf("ERROR: %s\n", ctx->errMsg );
+					std::cout << "ERROR: " << ctx->errMsg << std::endl;
+				else
+					pageRanSuccessfully = true;
 				if( toolOptions.printresult )
 				{
 					// Remove all parameters from the stack:
 					LEOCleanUpStackToPtr( ctx, ctx->stackEndPtr -paramCount -1 );
 					
 					if( ctx->stack == ctx->stackEndPtr )
-						printf("WARNING: No result left on stack. Bad code generated?\n");
+						std::cout << "WARNING: No result left on stack. Bad code generated?" << std::endl;
 					long	numResults = ctx->stackEndPtr -ctx->stack;
 					if( numResults > 1 )
 					{
-						printf("WARNING: %ld results left on stack, expected 1. Bad code generated?\n", numResults);
+						std::cout << "WARNING: " << numResults << " results left on stack, expected 1. Bad code generated?" << std::endl;
 						LEODebugPrintContext( ctx );
 					}
 					else if( numResults > 0 )
 					{
 						if( LEOGetValueIsUnset( ctx->stack, ctx ) )
-							printf("Result: --\n");
+							std::cout << "Result: --" << std::endl;
 						else
 						{
 							char		str[256] = {};
 							const char* theResultAsString = LEOGetValueAsString( ctx->stack, str, sizeof(str), ctx );
-							printf("Result: \"%s\"\n", theResultAsString);
+							std::cout << "Result: \"" << theResultAsString << "\"" << std::endl;
 						}
 					}
 				}
@@ -596,6 +1566,7 @@ int	ProcessOneScriptFile( const std::string& inFilePathString, ForgeToolOptions&
 						
 						if( filenameRequested )
 						{
+							pageManifest.mOutputFile = desiredFilename.str();
 							std::cout << "Writing file: " << desiredFilename.str() << std::endl;
 							filesystem::create_directories( filesystem::path(desiredFilename.str()).parent_path() );
 							
@@ -639,7 +1610,8 @@ int	ProcessOneScriptFile( const std::string& inFilePathString, ForgeToolOptions&
 											currResourceDestStr = LEOGetValueAsString( currResourceDestValue, currResourceDestStrBuf, sizeof(currResourceDestStrBuf), ctx );
 										}
 										
-										AddResourceEntryIfUnique( ForgeToolResourceEntry( currResourceFilenameStr, currResourceDestStr ), toolOptions );
+										pageManifest.mResources.push_back( ForgeToolResourceEntry( currResourceFilenameStr, currResourceDestStr ) );
+										AddResourceEntryIfUnique( pageManifest.mResources.back(), toolOptions );
 										
 										if( currResourceDestValue == &currResourceDestTmp )
 										{
@@ -693,6 +1665,7 @@ int	ProcessOneScriptFile( const std::string& inFilePathString, ForgeToolOptions&
 						}
 						
 						toolOptions.summaries.push_back( ForgeToolSummaryEntry( desiredFilename.str(), currSummaryStr ? currSummaryStr : "", currModifiedStr ? currModifiedStr : "", currCreatedStr ? currCreatedStr : "" ) );
+						pageManifest.mSummaries.push_back( toolOptions.summaries.back() );
 						
 						if( theValue == &tmp3 )
 						{
@@ -713,15 +1686,22 @@ int	ProcessOneScriptFile( const std::string& inFilePathString, ForgeToolOptions&
 				
 				LEOContextRelease( ctx );
 			}
-			
-			if( toolOptions.webPageEmbedMode && !toolOptions.postbuild )
-			{
-				gLEOMsgOutputStream = &std::cout;
-			}
 		}
 		
 		LEOScriptRelease( script );
 		LEOContextGroupRelease( group );
+		
+		// Pages with errors or warnings get rebuilt every time, so those get reported again:
+		if( writeManifest && pageRanSuccessfully && parser.GetMessages().empty() )
+		{
+			for( const CIncludeFileEntry& currInclude : parser.GetIncludedFiles() )
+			{
+				std::string		includePath = GetIncludePath( currInclude.mFileName, currInclude.mRelativeToFileName );
+				pageManifest.mIncludes.push_back( std::make_pair( includePath, GetContentsHash( currInclude.mFileData.data(), currInclude.mFileData.size() -1 ) ) );
+			}
+			if( !WritePageManifest( GetManifestPath( inFilePathString ), pageManifest ) )
+				std::cerr << "warning: Couldn't write build manifest for \"" << inFilePathString << "\"." << std::endl;
+		}
 	}
 	catch( std::exception& err )
 	{